@@ -0,0 +1,367 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef CID_TABLE_H
+#define CID_TABLE_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif // __SSE2__
+
+#include <ngtcp2/ngtcp2.h>
+
+namespace ngtcp2 {
+
+// CIDTable is an open addressing hash table which maps a Connection
+// ID to a value of type T.  A Connection ID is stored in the slot
+// itself, so that insert, erase, and find never allocate memory.  The
+// slot array is only reallocated when the table grows.
+//
+// The table is laid out like SwissTable: each slot has a 1 byte
+// control which is either empty, deleted, or the lower 7 bits of the
+// hash of its Connection ID.  The controls are probed 16 at a time,
+// and only the slots whose controls match are compared with the key.
+// The hash is seeded per table because the client chooses the
+// Destination Connection ID of its first Initial packet.
+template <typename T> class CIDTable {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+  explicit CIDTable(uint64_t seed) : seed_(seed) {}
+
+  // insert associates |cid| with |value|.  It returns false if |cid|
+  // is already in the table, or |cid| is longer than
+  // NGTCP2_MAX_CIDLEN.  In that case, the table is not changed.
+  bool insert(std::span<const uint8_t> cid, T value) {
+    Key key;
+    if (!make_key(key, cid)) {
+      return false;
+    }
+
+    auto h = hash(key);
+    if (find_slot(key, h)) {
+      return false;
+    }
+
+    if (size_ + ndeleted_ >= max_load(capacity_)) {
+      grow();
+    }
+
+    auto idx = find_free_slot(h);
+    if (ctrl_[idx] == CTRL_DELETED) {
+      --ndeleted_;
+    }
+
+    set_slot(idx, h, key, value);
+    ++size_;
+
+    return true;
+  }
+
+  // find returns the pointer to the value associated with |cid|, or
+  // nullptr if there is no such value.
+  T *find(std::span<const uint8_t> cid) {
+    Key key;
+    if (!make_key(key, cid)) {
+      return nullptr;
+    }
+
+    auto slot = find_slot(key, hash(key));
+    if (!slot) {
+      return nullptr;
+    }
+
+    return &slot->value;
+  }
+
+  // erase removes |cid|.  It returns false if |cid| is not found.
+  // Erasing never moves the other entries.
+  bool erase(std::span<const uint8_t> cid) {
+    Key key;
+    if (!make_key(key, cid)) {
+      return false;
+    }
+
+    auto slot = find_slot(key, hash(key));
+    if (!slot) {
+      return false;
+    }
+
+    auto idx = static_cast<size_t>(slot - slots_.get());
+    auto group = idx & ~(GROUP_WIDTH - 1);
+
+    // If the group still has an empty control, no probe sequence has
+    // gone past this group, and the slot can be reused as empty.
+    if (match_empty(group)) {
+      ctrl_[idx] = CTRL_EMPTY;
+    } else {
+      ctrl_[idx] = CTRL_DELETED;
+      ++ndeleted_;
+    }
+
+    --size_;
+
+    return true;
+  }
+
+  // for_each calls |f| with the value of each entry.  |f| may erase
+  // entries from the table, but must not insert any.
+  template <typename F> void for_each(F &&f) {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (ctrl_[i] >= 0) {
+        f(slots_[i].value);
+      }
+    }
+  }
+
+  // reserve makes room for |n| entries so that the table does not
+  // grow until it has |n| entries.
+  void reserve(size_t n) {
+    auto cap = capacity_ ? capacity_ : GROUP_WIDTH;
+    while (max_load(cap) < n) {
+      cap *= 2;
+    }
+
+    if (cap != capacity_) {
+      rehash(cap);
+    }
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+private:
+  // GROUP_WIDTH is the number of controls that are probed at once.
+  static constexpr size_t GROUP_WIDTH = 16;
+  static constexpr int8_t CTRL_EMPTY = -128;
+  static constexpr int8_t CTRL_DELETED = -2;
+
+  // Key is a Connection ID padded with zeros so that keys can be
+  // compared by a fixed length memcmp.
+  struct Key {
+    uint8_t datalen;
+    uint8_t data[NGTCP2_MAX_CIDLEN];
+  };
+
+  struct Slot {
+    Key key;
+    T value;
+  };
+
+  static bool make_key(Key &key, std::span<const uint8_t> cid) {
+    if (cid.size() > NGTCP2_MAX_CIDLEN) {
+      return false;
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.datalen = static_cast<uint8_t>(cid.size());
+    if (!cid.empty()) {
+      memcpy(key.data, cid.data(), cid.size());
+    }
+
+    return true;
+  }
+
+  static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+
+    return x;
+  }
+
+  uint64_t hash(const Key &key) const {
+    uint64_t w[3]{};
+
+    static_assert(sizeof(key) <= sizeof(w));
+
+    memcpy(w, &key, sizeof(key));
+
+    auto h = seed_;
+
+    for (auto x : w) {
+      h = mix(h ^ x);
+    }
+
+    return h;
+  }
+
+  static size_t max_load(size_t cap) { return cap - cap / 8; }
+
+  static int8_t h2(uint64_t h) { return static_cast<int8_t>(h & 0x7f); }
+
+  // probe_start returns the index of the first group to probe for |h|.
+  size_t probe_start(uint64_t h) const {
+    return static_cast<size_t>(h >> 7) & (capacity_ - 1) &
+           ~(GROUP_WIDTH - 1);
+  }
+
+  // match returns the bitmask of the controls in the group at |group|
+  // which are equal to |c|.
+  uint32_t match(size_t group, int8_t c) const {
+#ifdef __SSE2__
+    auto ctrl =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(&ctrl_[group]));
+
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c))));
+#else  // !__SSE2__
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+      mask |= static_cast<uint32_t>(ctrl_[group + i] == c) << i;
+    }
+
+    return mask;
+#endif // !__SSE2__
+  }
+
+  uint32_t match_empty(size_t group) const { return match(group, CTRL_EMPTY); }
+
+  // match_free returns the bitmask of the controls in the group at
+  // |group| which are either empty or deleted.
+  uint32_t match_free(size_t group) const {
+#ifdef __SSE2__
+    auto ctrl =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(&ctrl_[group]));
+
+    return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+#else  // !__SSE2__
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+      mask |= static_cast<uint32_t>(ctrl_[group + i] < 0) << i;
+    }
+
+    return mask;
+#endif // !__SSE2__
+  }
+
+  Slot *find_slot(const Key &key, uint64_t h) const {
+    if (capacity_ == 0) {
+      return nullptr;
+    }
+
+    auto group = probe_start(h);
+    auto c = h2(h);
+
+    // The groups are probed in triangular order which visits every
+    // group because the number of groups is a power of 2.
+    for (size_t i = 1;; ++i) {
+      for (auto mask = match(group, c); mask; mask &= mask - 1) {
+        auto idx = group + static_cast<size_t>(__builtin_ctz(mask));
+        if (memcmp(&slots_[idx].key, &key, sizeof(key)) == 0) {
+          return &slots_[idx];
+        }
+      }
+
+      if (match_empty(group)) {
+        return nullptr;
+      }
+
+      group = (group + i * GROUP_WIDTH) & (capacity_ - 1);
+    }
+  }
+
+  size_t find_free_slot(uint64_t h) const {
+    auto group = probe_start(h);
+
+    for (size_t i = 1;; ++i) {
+      if (auto mask = match_free(group); mask) {
+        return group + static_cast<size_t>(__builtin_ctz(mask));
+      }
+
+      group = (group + i * GROUP_WIDTH) & (capacity_ - 1);
+    }
+  }
+
+  void set_slot(size_t idx, uint64_t h, const Key &key, T value) {
+    ctrl_[idx] = h2(h);
+    slots_[idx].key = key;
+    slots_[idx].value = value;
+  }
+
+  // grow makes room for at least one more entry.  If the table is
+  // mostly occupied by deleted controls, it is rehashed in place
+  // without doubling.
+  void grow() {
+    if (capacity_ == 0) {
+      rehash(GROUP_WIDTH);
+      return;
+    }
+
+    rehash(size_ >= capacity_ / 2 ? capacity_ * 2 : capacity_);
+  }
+
+  void rehash(size_t cap) {
+    auto old_ctrl = std::move(ctrl_);
+    auto old_slots = std::move(slots_);
+    auto old_cap = capacity_;
+
+    ctrl_ = std::make_unique<int8_t[]>(cap);
+    slots_ = std::make_unique<Slot[]>(cap);
+    capacity_ = cap;
+    ndeleted_ = 0;
+
+    memset(ctrl_.get(), CTRL_EMPTY, cap);
+
+    for (size_t i = 0; i < old_cap; ++i) {
+      if (old_ctrl[i] < 0) {
+        continue;
+      }
+
+      auto &slot = old_slots[i];
+      auto h = hash(slot.key);
+
+      set_slot(find_free_slot(h), h, slot.key, slot.value);
+    }
+  }
+
+  std::unique_ptr<int8_t[]> ctrl_;
+  std::unique_ptr<Slot[]> slots_;
+  // capacity_ is the number of slots.  It is 0 or a power of 2 which
+  // is not less than GROUP_WIDTH.
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  // ndeleted_ is the number of deleted controls.  They are not empty
+  // for probing, and count towards the load.
+  size_t ndeleted_ = 0;
+  uint64_t seed_;
+};
+
+} // namespace ngtcp2
+
+#endif // CID_TABLE_H
@@ -0,0 +1,221 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "cid_table_test.h"
+
+#include <array>
+#include <vector>
+#include <algorithm>
+
+#include "cid_table.h"
+
+namespace ngtcp2 {
+
+namespace {
+const MunitTest tests[]{
+    munit_void_test(test_cid_table_insert),
+    munit_void_test(test_cid_table_erase),
+    munit_void_test(test_cid_table_grow),
+    munit_void_test(test_cid_table_churn),
+    munit_void_test(test_cid_table_for_each),
+    munit_test_end(),
+};
+} // namespace
+
+const MunitSuite cid_table_suite{
+    "/cid_table", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE,
+};
+
+namespace {
+// make_cid returns an 8 bytes Connection ID which encodes |n|.
+std::array<uint8_t, 8> make_cid(uint64_t n) {
+  std::array<uint8_t, 8> cid;
+
+  for (auto &c : cid) {
+    c = static_cast<uint8_t>(n);
+    n >>= 8;
+  }
+
+  return cid;
+}
+} // namespace
+
+void test_cid_table_insert() {
+  CIDTable<int> t(0);
+  std::array<uint8_t, 3> cid{1, 2, 3};
+  std::array<uint8_t, NGTCP2_MAX_CIDLEN + 1> long_cid{};
+
+  assert_true(t.empty());
+  assert_null(t.find(cid));
+
+  assert_true(t.insert(cid, 100));
+  assert_size(1, ==, t.size());
+  assert_int(100, ==, *t.find(cid));
+
+  // Duplicate is not inserted.
+  assert_false(t.insert(cid, 200));
+  assert_size(1, ==, t.size());
+  assert_int(100, ==, *t.find(cid));
+
+  // Prefix of a key is a different key.
+  assert_null(t.find({cid.data(), 2}));
+  assert_true(t.insert({cid.data(), 2}, 300));
+  assert_int(300, ==, *t.find({cid.data(), 2}));
+  assert_int(100, ==, *t.find(cid));
+
+  // Zero length Connection ID is a valid key.
+  assert_true(t.insert({}, 400));
+  assert_int(400, ==, *t.find({}));
+
+  // Too long Connection ID is rejected.
+  assert_false(t.insert(long_cid, 500));
+  assert_null(t.find(long_cid));
+  assert_size(3, ==, t.size());
+
+  // Value can be updated through the returned pointer.
+  *t.find(cid) = 600;
+  assert_int(600, ==, *t.find(cid));
+}
+
+void test_cid_table_erase() {
+  CIDTable<int> t(0);
+  std::array<uint8_t, 4> cid{1, 2, 3, 4};
+
+  assert_false(t.erase(cid));
+
+  assert_true(t.insert(cid, 1));
+  assert_true(t.erase(cid));
+  assert_true(t.empty());
+  assert_null(t.find(cid));
+  assert_false(t.erase(cid));
+
+  assert_true(t.insert(cid, 2));
+  assert_int(2, ==, *t.find(cid));
+}
+
+void test_cid_table_grow() {
+  CIDTable<uint64_t> t(0x0123456789abcdefull);
+  constexpr uint64_t n = 100000;
+
+  for (uint64_t i = 0; i < n; ++i) {
+    auto cid = make_cid(i);
+
+    assert_true(t.insert(cid, i));
+  }
+
+  assert_size(n, ==, t.size());
+
+  for (uint64_t i = 0; i < n; ++i) {
+    auto cid = make_cid(i);
+    auto v = t.find(cid);
+
+    assert_not_null(v);
+    assert_uint64(i, ==, *v);
+  }
+
+  for (uint64_t i = 0; i < n; i += 2) {
+    auto cid = make_cid(i);
+
+    assert_true(t.erase(cid));
+  }
+
+  assert_size(n / 2, ==, t.size());
+
+  for (uint64_t i = 0; i < n; ++i) {
+    auto cid = make_cid(i);
+    auto v = t.find(cid);
+
+    if (i & 1) {
+      assert_not_null(v);
+      assert_uint64(i, ==, *v);
+    } else {
+      assert_null(v);
+    }
+  }
+
+  auto cid = make_cid(n);
+
+  assert_null(t.find(cid));
+}
+
+void test_cid_table_churn() {
+  CIDTable<uint64_t> t(1);
+  constexpr uint64_t window = 100;
+
+  // Keeping the number of entries small while inserting and erasing
+  // many keys leaves deleted controls behind.  They must be purged
+  // without losing live entries.
+  for (uint64_t i = 0; i < 100000; ++i) {
+    auto cid = make_cid(i);
+
+    assert_true(t.insert(cid, i));
+
+    if (i >= window) {
+      auto old = make_cid(i - window);
+
+      assert_true(t.erase(old));
+    }
+  }
+
+  assert_size(window, ==, t.size());
+
+  for (uint64_t i = 100000 - window; i < 100000; ++i) {
+    auto cid = make_cid(i);
+    auto v = t.find(cid);
+
+    assert_not_null(v);
+    assert_uint64(i, ==, *v);
+  }
+}
+
+void test_cid_table_for_each() {
+  CIDTable<uint64_t> t(2);
+  std::vector<uint64_t> seen;
+
+  for (uint64_t i = 0; i < 1000; ++i) {
+    auto cid = make_cid(i);
+
+    t.insert(cid, i);
+  }
+
+  // Erasing entries from the callback is allowed.
+  t.for_each([&t, &seen](uint64_t v) {
+    auto cid = make_cid(v);
+
+    seen.push_back(v);
+
+    t.erase(cid);
+  });
+
+  assert_true(t.empty());
+  assert_size(1000, ==, seen.size());
+
+  std::sort(std::begin(seen), std::end(seen));
+
+  for (uint64_t i = 0; i < 1000; ++i) {
+    assert_uint64(i, ==, seen[i]);
+  }
+}
+
+} // namespace ngtcp2
@@ -0,0 +1,265 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+// cidtablebench measures the cost of looking up a Connection ID in
+// CIDTable, and compares it with std::unordered_map keyed by
+// std::string which the example server used to use.  For each table
+// size, it measures finding existing keys in random order, finding
+// missing keys, and inserting and erasing a key.  The result is
+// written to stdout as a JSON object per line:
+//
+// {"name":"cid_table_find","n":1048576,"ops":1048576,"rounds":5,
+//  "ns_per_op_min":...,"ns_per_op_median":...}
+//
+// Usage: cidtablebench [-r ROUNDS] [-n MAX_ENTRIES]
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <array>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
+
+#include "cid_table.h"
+
+using namespace ngtcp2;
+
+namespace {
+// CIDLEN is the length of Connection ID that the example server
+// generates.
+constexpr size_t CIDLEN = 18;
+constexpr size_t MAX_ROUNDS = 64;
+
+using CID = std::array<uint8_t, CIDLEN>;
+
+// sink is updated by benchmarks so that the compiler does not
+// eliminate the measured code.
+volatile uint64_t sink;
+
+uint64_t now() {
+  timespec tp;
+
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+
+  return static_cast<uint64_t>(tp.tv_sec) * NGTCP2_SECONDS +
+         static_cast<uint64_t>(tp.tv_nsec);
+}
+
+// next_rand returns a pseudo random number.  The sequence is fixed
+// so that each run measures the same workload.
+uint64_t next_rand(uint64_t &state) {
+  auto x = state;
+
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+
+  return state = x;
+}
+
+std::vector<CID> make_cids(size_t n, uint64_t seed) {
+  std::vector<CID> cids(n);
+
+  for (auto &cid : cids) {
+    for (size_t i = 0; i < cid.size(); i += sizeof(uint64_t)) {
+      auto x = next_rand(seed);
+
+      memcpy(cid.data() + i, &x, std::min(sizeof(x), cid.size() - i));
+    }
+  }
+
+  return cids;
+}
+
+struct string_hash {
+  using is_transparent = void;
+
+  size_t operator()(const std::string_view &s) const {
+    return std::hash<std::string_view>{}(s);
+  }
+
+  size_t operator()(const std::string &s) const {
+    return std::hash<std::string>{}(s);
+  }
+};
+
+std::string_view as_key(const CID &cid) {
+  return {reinterpret_cast<const char *>(cid.data()), cid.size()};
+}
+
+struct CIDTableBench {
+  CIDTable<void *> t{0x9e3779b97f4a7c15ull};
+
+  void insert(const CID &cid, void *v) { t.insert(cid, v); }
+  void *find(const CID &cid) {
+    auto p = t.find(cid);
+    return p ? *p : nullptr;
+  }
+  void erase(const CID &cid) { t.erase(cid); }
+};
+
+// MapBench is the std::unordered_map based table which builds a
+// std::string for the key on insertion and on erasure like the
+// previous code did.
+struct MapBench {
+  std::unordered_map<std::string, void *, string_hash, std::equal_to<>> t;
+
+  void insert(const CID &cid, void *v) { t.emplace(as_key(cid), v); }
+  void *find(const CID &cid) {
+    auto it = t.find(as_key(cid));
+    return it == std::end(t) ? nullptr : (*it).second;
+  }
+  void erase(const CID &cid) { t.erase(std::string{as_key(cid)}); }
+};
+
+void report(const char *name, size_t n, size_t ops,
+            std::vector<uint64_t> &elapsed) {
+  std::sort(std::begin(elapsed), std::end(elapsed));
+
+  printf("{\"name\":\"%s\",\"n\":%zu,\"ops\":%zu,\"rounds\":%zu,"
+         "\"ns_per_op_min\":%.3f,\"ns_per_op_median\":%.3f}\n",
+         name, n, ops, elapsed.size(),
+         static_cast<double>(elapsed[0]) / static_cast<double>(ops),
+         static_cast<double>(elapsed[elapsed.size() / 2]) /
+             static_cast<double>(ops));
+  fflush(stdout);
+}
+
+template <typename B>
+void run(const char *prefix, const std::vector<CID> &cids,
+         const std::vector<CID> &missing, const std::vector<size_t> &order,
+         size_t rounds) {
+  auto n = cids.size();
+  B b;
+
+  for (size_t i = 0; i < n; ++i) {
+    b.insert(cids[i], const_cast<CID *>(&cids[i]));
+  }
+
+  std::vector<uint64_t> elapsed;
+  std::string name;
+
+  for (size_t r = 0; r < rounds; ++r) {
+    uint64_t acc = 0;
+    auto start = now();
+
+    for (auto i : order) {
+      acc += reinterpret_cast<uintptr_t>(b.find(cids[i]));
+    }
+
+    elapsed.push_back(now() - start);
+    sink = sink + acc;
+  }
+
+  name = std::string{prefix} + "_find";
+  report(name.c_str(), n, order.size(), elapsed);
+
+  elapsed.clear();
+
+  for (size_t r = 0; r < rounds; ++r) {
+    uint64_t acc = 0;
+    auto start = now();
+
+    for (auto &cid : missing) {
+      acc += reinterpret_cast<uintptr_t>(b.find(cid));
+    }
+
+    elapsed.push_back(now() - start);
+    sink = sink + acc;
+  }
+
+  name = std::string{prefix} + "_find_miss";
+  report(name.c_str(), n, missing.size(), elapsed);
+
+  elapsed.clear();
+
+  for (size_t r = 0; r < rounds; ++r) {
+    auto start = now();
+
+    for (auto &cid : missing) {
+      b.insert(cid, nullptr);
+      b.erase(cid);
+    }
+
+    elapsed.push_back(now() - start);
+  }
+
+  name = std::string{prefix} + "_insert_erase";
+  report(name.c_str(), n, missing.size(), elapsed);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t rounds = 5;
+  size_t max_entries = 4 * 1024 * 1024;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      rounds = strtoul(argv[++i], nullptr, 10);
+      if (rounds == 0 || rounds > MAX_ROUNDS) {
+        fprintf(stderr, "-r: ROUNDS must be in [1, %zu]\n", MAX_ROUNDS);
+        return EXIT_FAILURE;
+      }
+
+      continue;
+    }
+
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      max_entries = strtoul(argv[++i], nullptr, 10);
+
+      continue;
+    }
+
+    fprintf(stderr, "Usage: cidtablebench [-r ROUNDS] [-n MAX_ENTRIES]\n");
+    return EXIT_FAILURE;
+  }
+
+  // The number of operations per round is capped so that the small
+  // tables are measured for long enough, and the large ones are not
+  // measured for too long.
+  constexpr size_t nops = 1024 * 1024;
+
+  for (size_t n = 1024; n <= max_entries; n *= 4) {
+    auto cids = make_cids(n, 0x2545f4914f6cdd1dull);
+    auto missing = make_cids(std::min(n, nops), 0x5851f42d4c957f2dull);
+    std::vector<size_t> order(nops);
+    uint64_t state = 0x14057b7ef767814full;
+
+    for (auto &i : order) {
+      i = static_cast<size_t>(next_rand(state) % n);
+    }
+
+    run<CIDTableBench>("cid_table", cids, missing, order, rounds);
+    run<MapBench>("unordered_map", cids, missing, order, rounds);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -31,6 +31,7 @@
 #include <memory>
 #include <fstream>
 #include <iomanip>
+#include <thread>
 
 #include <unistd.h>
 #include <getopt.h>
@@ -54,7 +55,9 @@ using namespace ngtcp2;
 using namespace std::literals;
 
 namespace {
-auto randgen = util::make_mt19937();
+// randgen is per thread because load generation mode runs
+// connections in multiple threads.
+thread_local auto randgen = util::make_mt19937();
 } // namespace
 
 namespace {
@@ -64,7 +67,11 @@ constexpr size_t max_preferred_versionslen = 4;
 Config config{};
 
 Stream::Stream(const Request &req, int64_t stream_id)
-    : req(req), stream_id(stream_id), fd(-1) {}
+    : req(req),
+      stream_id(stream_id),
+      fd(-1),
+      start_ts(0),
+      response_started(false) {}
 
 Stream::~Stream() {
   if (fd != -1) {
@@ -186,6 +193,17 @@ Client::Client(struct ev_loop *loop, uint32_t client_chosen_version,
       original_version_(original_version),
       early_data_(false),
       handshake_confirmed_(false),
+      worker_(nullptr),
+      session_file_(config.session_file),
+      tp_file_(config.tp_file),
+      start_ts_(0),
+      no_gso_{
+#ifdef UDP_SEGMENT
+          false
+#else  // !UDP_SEGMENT
+          true
+#endif // !UDP_SEGMENT
+      },
       tx_{} {
   ev_io_init(&wev_, writecb, 0, EV_WRITE);
   wev_.data = this;
@@ -215,10 +233,14 @@ Client::~Client() {
 
 void Client::disconnect() {
   tx_.send_blocked = false;
+  tx_.num_blocked = 0;
+  tx_.num_blocked_sent = 0;
 
   handle_error();
 
-  config.tx_loss_prob = 0;
+  if (!worker_) {
+    config.tx_loss_prob = 0;
+  }
 
   ev_timer_stop(loop_, &delay_stream_timer_);
   ev_timer_stop(loop_, &key_update_timer_);
@@ -235,6 +257,15 @@ void Client::disconnect() {
   endpoints_.clear();
 
   ev_signal_stop(loop_, &sigintev_);
+
+  if (worker_) {
+    auto worker = worker_;
+    worker_ = nullptr;
+
+    // The requests which are still in flight never finish.
+    worker->get_stats().nreqs += streams_.size();
+    worker->on_client_done(this);
+  }
 }
 
 namespace {
@@ -317,6 +348,17 @@ int Client::handshake_completed() {
     }
   }
 
+  if (worker_) {
+    auto &stats = worker_->get_stats();
+
+    stats.handshake.record(util::timestamp() - start_ts_);
+    ++stats.nhandshakes;
+
+    if (early_data_ && tls_session_.get_early_data_accepted()) {
+      ++stats.nearly_data;
+    }
+  }
+
   if (!config.quiet) {
     std::cerr << "Negotiated cipher suite is " << tls_session_.get_cipher_name()
               << std::endl;
@@ -644,6 +686,8 @@ void Client::early_data_rejected() {
 int Client::init(int fd, const Address &local_addr, const Address &remote_addr,
                  const char *addr, const char *port,
                  TLSClientContext &tls_ctx) {
+  start_ts_ = util::timestamp();
+
   endpoints_.reserve(4);
 
   endpoints_.emplace_back();
@@ -732,15 +776,18 @@ int Client::init(int fd, const Address &local_addr, const Address &remote_addr,
       path = std::string{config.qlog_dir};
       path += '/';
       path += util::format_hex({scid.data, scid.datalen});
-      path += ".sqlog";
+      path += config.qlog_binary ? ".bqlog" : ".sqlog";
     }
-    qlog_ = fopen(path.c_str(), "w");
+    qlog_ = fopen(path.c_str(), "wb");
     if (qlog_ == nullptr) {
       std::cerr << "Could not open qlog file " << std::quoted(path) << ": "
                 << strerror(errno) << std::endl;
       return -1;
     }
     settings.qlog_write = qlog_write_cb;
+    if (config.qlog_binary) {
+      settings.qlog_format = NGTCP2_QLOG_FORMAT_BINARY;
+    }
   }
 
   settings.cc_algo = config.cc_algo;
@@ -831,14 +878,15 @@ int Client::init(int fd, const Address &local_addr, const Address &remote_addr,
   }
 
   if (tls_session_.init(early_data_, tls_ctx, addr_, this,
-                        client_chosen_version_, AppProtocol::H3) != 0) {
+                        client_chosen_version_, AppProtocol::H3,
+                        session_file_) != 0) {
     return -1;
   }
 
   ngtcp2_conn_set_tls_native_handle(conn_, tls_session_.get_native_handle());
 
-  if (early_data_ && config.tp_file) {
-    auto params = util::read_transport_params(config.tp_file);
+  if (early_data_ && tp_file_) {
+    auto params = util::read_transport_params(tp_file_);
     if (!params) {
       early_data_ = false;
     } else {
@@ -857,13 +905,17 @@ int Client::init(int fd, const Address &local_addr, const Address &remote_addr,
 
   ev_io_start(loop_, &ep.rev);
 
-  ev_signal_start(loop_, &sigintev_);
+  // SIGINT can be watched by only one event loop.  A load generation
+  // worker has its own event loop, and does not watch it.
+  if (!worker_) {
+    ev_signal_start(loop_, &sigintev_);
+  }
 
   return 0;
 }
 
 int Client::feed_data(const Endpoint &ep, const sockaddr *sa, socklen_t salen,
-                      const ngtcp2_pkt_info *pi,
+                      const ngtcp2_pkt_info *pi, ngtcp2_tstamp pkt_ts,
                       std::span<const uint8_t> data) {
   auto path = ngtcp2_path{
       {
@@ -876,10 +928,12 @@ int Client::feed_data(const Endpoint &ep, const sockaddr *sa, socklen_t salen,
       },
       const_cast<Endpoint *>(&ep),
   };
-  if (auto rv = ngtcp2_conn_read_pkt(conn_, &path, pi, data.data(), data.size(),
-                                     util::timestamp());
+  if (auto rv = ngtcp2_conn_read_timestamped_pkt(
+          conn_, &path, pi, data.data(), data.size(), pkt_ts,
+          util::timestamp());
       rv != 0) {
-    std::cerr << "ngtcp2_conn_read_pkt: " << ngtcp2_strerror(rv) << std::endl;
+    std::cerr << "ngtcp2_conn_read_timestamped_pkt: " << ngtcp2_strerror(rv)
+              << std::endl;
     if (!last_error_.error_code) {
       if (rv == NGTCP2_ERR_CRYPTO) {
         ngtcp2_ccerr_set_tls_alert(
@@ -909,7 +963,8 @@ int Client::on_read(const Endpoint &ep) {
   msg.msg_iov = &msg_iov;
   msg.msg_iovlen = 1;
 
-  uint8_t msg_ctrl[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(uint16_t))];
+  uint8_t msg_ctrl[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(uint16_t)) +
+                   CMSG_SPACE(sizeof(timespec))];
   msg.msg_control = msg_ctrl;
 
   for (;;) {
@@ -938,6 +993,7 @@ int Client::on_read(const Endpoint &ep) {
       gso_size = static_cast<size_t>(nread);
     }
 
+    auto pkt_ts = msghdr_get_recv_timestamp(&msg, util::timestamp());
     auto data = std::span{buf.data(), static_cast<size_t>(nread)};
 
     for (;;) {
@@ -962,7 +1018,7 @@ int Client::on_read(const Endpoint &ep) {
         if (!config.quiet) {
           std::cerr << "** Simulated incoming packet loss **" << std::endl;
         }
-      } else if (feed_data(ep, &su.sa, msg.msg_namelen, &pi,
+      } else if (feed_data(ep, &su.sa, msg.msg_namelen, &pi, pkt_ts,
                            {data.data(), datalen}) != 0) {
         return -1;
       }
@@ -1017,6 +1073,14 @@ int Client::on_write() {
     ev_io_stop(loop_, &wev_);
   }
 
+  // Open the streams which are held back by max_concurrent_streams
+  // after the previous ones have been closed.
+  if (config.max_concurrent_streams && httpconn_ &&
+      nstreams_done_ < config.nstreams &&
+      streams_.size() < config.max_concurrent_streams) {
+    on_extend_max_streams();
+  }
+
   if (auto rv = write_streams(); rv != 0) {
     return rv;
   }
@@ -1034,15 +1098,28 @@ int Client::on_write() {
 
 int Client::write_streams() {
   std::array<nghttp3_vec, 16> vec;
-  ngtcp2_path_storage ps;
-  size_t pktcnt = 0;
+  ngtcp2_path_storage ps, prev_ps;
+  uint32_t prev_ecn = 0;
   auto max_udp_payload_size = ngtcp2_conn_get_max_tx_udp_payload_size(conn_);
-  auto max_pktcnt =
-      std::max(ngtcp2_conn_get_send_quantum(conn_) / max_udp_payload_size,
-               static_cast<size_t>(1));
+  auto path_max_udp_payload_size =
+      ngtcp2_conn_get_path_max_tx_udp_payload_size(conn_);
+  ngtcp2_pkt_info pi;
+  size_t gso_size = 0;
   auto ts = util::timestamp();
+  // Limit the burst to the full sized packets that fit in a single
+  // GSO send.
+  auto max_txbuflen = std::max(
+      std::min(NGTCP2_MAX_GSO_DATALEN,
+               path_max_udp_payload_size * NGTCP2_MAX_GSO_SEGMENTS) /
+          path_max_udp_payload_size * path_max_udp_payload_size,
+      path_max_udp_payload_size);
+  auto txbuf = std::span{
+      tx_.data.data(), std::clamp(ngtcp2_conn_get_send_quantum(conn_),
+                                  path_max_udp_payload_size, max_txbuflen)};
+  auto buf = txbuf;
 
   ngtcp2_path_storage_zero(&ps);
+  ngtcp2_path_storage_zero(&prev_ps);
 
   for (;;) {
     int64_t stream_id = -1;
@@ -1072,11 +1149,13 @@ int Client::write_streams() {
       flags |= NGTCP2_WRITE_STREAM_FLAG_FIN;
     }
 
-    ngtcp2_pkt_info pi;
+    auto buflen = buf.size() >= max_udp_payload_size
+                      ? max_udp_payload_size
+                      : path_max_udp_payload_size;
 
     auto nwrite = ngtcp2_conn_writev_stream(
-        conn_, &ps.path, &pi, tx_.data.data(), max_udp_payload_size, &ndatalen,
-        flags, stream_id, reinterpret_cast<const ngtcp2_vec *>(v), vcnt, ts);
+        conn_, &ps.path, &pi, buf.data(), buflen, &ndatalen, flags, stream_id,
+        reinterpret_cast<const ngtcp2_vec *>(v), vcnt, ts);
     if (nwrite < 0) {
       switch (nwrite) {
       case NGTCP2_ERR_STREAM_DATA_BLOCKED:
@@ -1125,36 +1204,110 @@ int Client::write_streams() {
     }
 
     if (nwrite == 0) {
+      auto data = std::span{std::begin(txbuf), std::begin(buf)};
+      if (!data.empty()) {
+        auto &ep = *static_cast<Endpoint *>(prev_ps.path.user_data);
+
+        if (auto [rest, rv] =
+                send_packet(ep, prev_ps.path.remote, prev_ecn, data, gso_size);
+            rv != NETWORK_ERR_OK) {
+          if (rv != NETWORK_ERR_SEND_BLOCKED) {
+            return handle_send_error(rv);
+          }
+
+          on_send_blocked(ep, prev_ps.path.remote, prev_ecn, rest, gso_size);
+
+          start_wev_endpoint(ep);
+        }
+      }
+
       // We are congestion limited.
       ngtcp2_conn_update_pkt_tx_time(conn_, ts);
       return 0;
     }
 
-    auto &ep = *static_cast<Endpoint *>(ps.path.user_data);
+    auto last_pkt = std::begin(buf);
+
+    buf = buf.subspan(nwrite);
+
+    if (last_pkt == std::begin(txbuf)) {
+      ngtcp2_path_copy(&prev_ps.path, &ps.path);
+      prev_ecn = pi.ecn;
+      gso_size = nwrite;
+    } else if (!ngtcp2_path_eq(&prev_ps.path, &ps.path) || prev_ecn != pi.ecn ||
+               static_cast<size_t>(nwrite) > gso_size ||
+               (gso_size > path_max_udp_payload_size &&
+                static_cast<size_t>(nwrite) != gso_size)) {
+      auto &ep = *static_cast<Endpoint *>(prev_ps.path.user_data);
+      auto data = std::span{std::begin(txbuf), last_pkt};
+
+      if (auto [rest, rv] =
+              send_packet(ep, prev_ps.path.remote, prev_ecn, data, gso_size);
+          rv != NETWORK_ERR_OK) {
+        if (rv != NETWORK_ERR_SEND_BLOCKED) {
+          return handle_send_error(rv);
+        }
 
-    if (auto rv = send_packet(ep, ps.path.remote, pi.ecn,
-                              {tx_.data.data(), static_cast<size_t>(nwrite)});
-        rv != NETWORK_ERR_OK) {
-      if (rv != NETWORK_ERR_SEND_BLOCKED) {
-        ngtcp2_ccerr_set_liberr(&last_error_, NGTCP2_ERR_INTERNAL, nullptr, 0);
-        disconnect();
+        on_send_blocked(ep, prev_ps.path.remote, prev_ecn, rest, gso_size);
+
+        data = std::span{last_pkt, std::begin(buf)};
+        on_send_blocked(*static_cast<Endpoint *>(ps.path.user_data),
+                        ps.path.remote, pi.ecn, data, data.size());
+
+        start_wev_endpoint(ep);
+      } else {
+        auto &ep = *static_cast<Endpoint *>(ps.path.user_data);
+        auto data = std::span{last_pkt, std::begin(buf)};
+
+        if (auto [rest, rv] =
+                send_packet(ep, ps.path.remote, pi.ecn, data, data.size());
+            rv != NETWORK_ERR_OK) {
+          if (rv != NETWORK_ERR_SEND_BLOCKED) {
+            return handle_send_error(rv);
+          }
 
-        return rv;
+          assert(rest.size() == data.size());
+
+          on_send_blocked(ep, ps.path.remote, pi.ecn, rest, rest.size());
+
+          start_wev_endpoint(ep);
+        }
       }
 
       ngtcp2_conn_update_pkt_tx_time(conn_, ts);
-      on_send_blocked(ep, ps.path.remote, pi.ecn, nwrite);
-
       return 0;
     }
 
-    if (++pktcnt == max_pktcnt) {
+    if (buf.size() < path_max_udp_payload_size ||
+        static_cast<size_t>(nwrite) < gso_size) {
+      auto &ep = *static_cast<Endpoint *>(ps.path.user_data);
+      auto data = std::span{std::begin(txbuf), std::begin(buf)};
+
+      if (auto [rest, rv] =
+              send_packet(ep, ps.path.remote, pi.ecn, data, gso_size);
+          rv != NETWORK_ERR_OK) {
+        if (rv != NETWORK_ERR_SEND_BLOCKED) {
+          return handle_send_error(rv);
+        }
+
+        on_send_blocked(ep, ps.path.remote, pi.ecn, rest, gso_size);
+
+        start_wev_endpoint(ep);
+      }
+
       ngtcp2_conn_update_pkt_tx_time(conn_, ts);
       return 0;
     }
   }
 }
 
+int Client::handle_send_error(int rv) {
+  ngtcp2_ccerr_set_liberr(&last_error_, NGTCP2_ERR_INTERNAL, nullptr, 0);
+  disconnect();
+
+  return rv;
+}
+
 void Client::update_timer() {
   auto expiry = ngtcp2_conn_get_expiry(conn_);
   auto now = util::timestamp();
@@ -1268,6 +1421,7 @@ int udp_sock(int family) {
   fd_set_ip_mtu_discover(fd, family);
   fd_set_ip_dontfrag(fd, family);
   fd_set_udp_gro(fd);
+  fd_set_recv_timestamp(fd);
 
   return fd;
 }
@@ -1498,13 +1652,33 @@ void Client::start_delay_stream_timer() {
   ev_timer_start(loop_, &delay_stream_timer_);
 }
 
-int Client::send_packet(const Endpoint &ep, const ngtcp2_addr &remote_addr,
-                        unsigned int ecn, std::span<const uint8_t> data) {
+std::pair<std::span<const uint8_t>, int>
+Client::send_packet(const Endpoint &ep, const ngtcp2_addr &remote_addr,
+                    unsigned int ecn, std::span<const uint8_t> data,
+                    size_t gso_size) {
+  assert(gso_size);
+
   if (debug::packet_lost(config.tx_loss_prob)) {
     if (!config.quiet) {
       std::cerr << "** Simulated outgoing packet loss **" << std::endl;
     }
-    return NETWORK_ERR_OK;
+    return {{}, NETWORK_ERR_OK};
+  }
+
+  if (no_gso_ && data.size() > gso_size) {
+    for (; !data.empty();) {
+      auto len = std::min(gso_size, data.size());
+
+      auto [_, rv] =
+          send_packet(ep, remote_addr, ecn, {std::begin(data), len}, len);
+      if (rv != 0) {
+        return {data, rv};
+      }
+
+      data = data.subspan(len);
+    }
+
+    return {{}, 0};
   }
 
   iovec msg_iov;
@@ -1519,14 +1693,17 @@ int Client::send_packet(const Endpoint &ep, const ngtcp2_addr &remote_addr,
   msg.msg_iov = &msg_iov;
   msg.msg_iovlen = 1;
 
-  uint8_t msg_ctrl[CMSG_SPACE(sizeof(int))];
+  uint8_t msg_ctrl[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(uint16_t))];
 
   memset(msg_ctrl, 0, sizeof(msg_ctrl));
 
   msg.msg_control = msg_ctrl;
   msg.msg_controllen = sizeof(msg_ctrl);
 
+  size_t controllen = 0;
+
   auto cm = CMSG_FIRSTHDR(&msg);
+  controllen += CMSG_SPACE(sizeof(int));
   cm->cmsg_len = CMSG_LEN(sizeof(int));
   memcpy(CMSG_DATA(cm), &ecn, sizeof(ecn));
 
@@ -1545,6 +1722,20 @@ int Client::send_packet(const Endpoint &ep, const ngtcp2_addr &remote_addr,
     assert(0);
   }
 
+#ifdef UDP_SEGMENT
+  if (data.size() > gso_size) {
+    controllen += CMSG_SPACE(sizeof(uint16_t));
+    cm = CMSG_NXTHDR(&msg, cm);
+    cm->cmsg_level = SOL_UDP;
+    cm->cmsg_type = UDP_SEGMENT;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    uint16_t n = gso_size;
+    memcpy(CMSG_DATA(cm), &n, sizeof(n));
+  }
+#endif // UDP_SEGMENT
+
+  msg.msg_controllen = controllen;
+
   ssize_t nwrite = 0;
 
   do {
@@ -1552,14 +1743,32 @@ int Client::send_packet(const Endpoint &ep, const ngtcp2_addr &remote_addr,
   } while (nwrite == -1 && errno == EINTR);
 
   if (nwrite == -1) {
-    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-      return NETWORK_ERR_SEND_BLOCKED;
+    switch (errno) {
+    case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+    case EWOULDBLOCK:
+#endif // EAGAIN != EWOULDBLOCK
+      return {data, NETWORK_ERR_SEND_BLOCKED};
+#ifdef UDP_SEGMENT
+    case EIO:
+      if (data.size() > gso_size) {
+        // GSO failure; send each packet in a separate sendmsg call.
+        std::cerr << "sendmsg: disabling GSO due to " << strerror(errno)
+                  << std::endl;
+
+        no_gso_ = true;
+
+        return send_packet(ep, remote_addr, ecn, data, gso_size);
+      }
+      break;
+#endif // UDP_SEGMENT
     }
+
     std::cerr << "sendmsg: " << strerror(errno) << std::endl;
     if (errno == EMSGSIZE) {
-      return 0;
+      return {{}, 0};
     }
-    return NETWORK_ERR_FATAL;
+    return {data, NETWORK_ERR_FATAL};
   }
 
   assert(static_cast<size_t>(nwrite) == data.size());
@@ -1572,22 +1781,27 @@ int Client::send_packet(const Endpoint &ep, const ngtcp2_addr &remote_addr,
               << " bytes" << std::endl;
   }
 
-  return NETWORK_ERR_OK;
+  return {{}, NETWORK_ERR_OK};
 }
 
 void Client::on_send_blocked(const Endpoint &ep, const ngtcp2_addr &remote_addr,
-                             unsigned int ecn, size_t datalen) {
-  assert(!tx_.send_blocked);
+                             unsigned int ecn, std::span<const uint8_t> data,
+                             size_t gso_size) {
+  assert(tx_.num_blocked || !tx_.send_blocked);
+  assert(tx_.num_blocked < 2);
+  assert(gso_size);
 
   tx_.send_blocked = true;
 
-  memcpy(&tx_.blocked.remote_addr.su, remote_addr.addr, remote_addr.addrlen);
-  tx_.blocked.remote_addr.len = remote_addr.addrlen;
-  tx_.blocked.ecn = ecn;
-  tx_.blocked.datalen = datalen;
-  tx_.blocked.endpoint = &ep;
+  auto &p = tx_.blocked[tx_.num_blocked++];
+
+  memcpy(&p.remote_addr.su, remote_addr.addr, remote_addr.addrlen);
 
-  start_wev_endpoint(ep);
+  p.remote_addr.len = remote_addr.addrlen;
+  p.endpoint = &ep;
+  p.ecn = ecn;
+  p.data = data;
+  p.gso_size = gso_size;
 }
 
 void Client::start_wev_endpoint(const Endpoint &ep) {
@@ -1607,27 +1821,32 @@ void Client::start_wev_endpoint(const Endpoint &ep) {
 int Client::send_blocked_packet() {
   assert(tx_.send_blocked);
 
-  ngtcp2_addr remote_addr{
-      .addr = &tx_.blocked.remote_addr.su.sa,
-      .addrlen = tx_.blocked.remote_addr.len,
-  };
+  for (; tx_.num_blocked_sent < tx_.num_blocked; ++tx_.num_blocked_sent) {
+    auto &p = tx_.blocked[tx_.num_blocked_sent];
 
-  auto rv = send_packet(*tx_.blocked.endpoint, remote_addr, tx_.blocked.ecn,
-                        {tx_.data.data(), tx_.blocked.datalen});
-  if (rv != 0) {
-    if (rv == NETWORK_ERR_SEND_BLOCKED) {
-      assert(wev_.fd == tx_.blocked.endpoint->fd);
+    ngtcp2_addr remote_addr{
+        .addr = &p.remote_addr.su.sa,
+        .addrlen = p.remote_addr.len,
+    };
 
-      return 0;
-    }
+    auto [rest, rv] =
+        send_packet(*p.endpoint, remote_addr, p.ecn, p.data, p.gso_size);
+    if (rv != 0) {
+      if (rv != NETWORK_ERR_SEND_BLOCKED) {
+        return handle_send_error(rv);
+      }
 
-    ngtcp2_ccerr_set_liberr(&last_error_, NGTCP2_ERR_INTERNAL, nullptr, 0);
-    disconnect();
+      p.data = rest;
 
-    return rv;
+      start_wev_endpoint(*p.endpoint);
+
+      return 0;
+    }
   }
 
   tx_.send_blocked = false;
+  tx_.num_blocked = 0;
+  tx_.num_blocked_sent = 0;
 
   return 0;
 }
@@ -1659,9 +1878,12 @@ int Client::handle_error() {
     return 0;
   }
 
-  return send_packet(*static_cast<Endpoint *>(ps.path.user_data),
-                     ps.path.remote, pi.ecn,
-                     {buf.data(), static_cast<size_t>(nwrite)});
+  auto [_, rv] = send_packet(*static_cast<Endpoint *>(ps.path.user_data),
+                             ps.path.remote, pi.ecn,
+                             {buf.data(), static_cast<size_t>(nwrite)},
+                             static_cast<size_t>(nwrite));
+
+  return rv;
 }
 
 int Client::on_stream_close(int64_t stream_id, uint64_t app_error_code) {
@@ -1738,6 +1960,11 @@ int Client::on_extend_max_streams() {
   }
 
   for (; nstreams_done_ < config.nstreams; ++nstreams_done_) {
+    if (config.max_concurrent_streams &&
+        streams_.size() >= config.max_concurrent_streams) {
+      break;
+    }
+
     if (auto rv = ngtcp2_conn_open_bidi_stream(conn_, &stream_id, nullptr);
         rv != 0) {
       assert(NGTCP2_ERR_STREAM_ID_BLOCKED == rv);
@@ -1746,6 +1973,7 @@ int Client::on_extend_max_streams() {
 
     auto stream = std::make_unique<Stream>(
         config.requests[nstreams_done_ % config.requests.size()], stream_id);
+    stream->start_ts = util::timestamp();
 
     if (submit_http_request(stream.get()) != 0) {
       break;
@@ -1931,10 +2159,37 @@ int http_begin_headers(nghttp3_conn *conn, int64_t stream_id, void *user_data,
   if (!config.quiet) {
     debug::print_http_begin_response_headers(stream_id);
   }
+
+  auto c = static_cast<Client *>(user_data);
+  if (c->http_begin_headers(stream_id) != 0) {
+    return NGHTTP3_ERR_CALLBACK_FAILURE;
+  }
+
   return 0;
 }
 } // namespace
 
+int Client::http_begin_headers(int64_t stream_id) {
+  if (!worker_) {
+    return 0;
+  }
+
+  auto it = streams_.find(stream_id);
+  if (it == std::end(streams_)) {
+    return 0;
+  }
+
+  auto &stream = (*it).second;
+
+  // 1xx responses also begin a header.  Only the first one counts.
+  if (!stream->response_started) {
+    stream->response_started = true;
+    worker_->get_stats().ttfb.record(util::timestamp() - stream->start_ts);
+  }
+
+  return 0;
+}
+
 namespace {
 int http_recv_header(nghttp3_conn *conn, int64_t stream_id, int32_t token,
                      nghttp3_rcbuf *name, nghttp3_rcbuf *value, uint8_t flags,
@@ -2060,6 +2315,19 @@ int Client::http_stream_close(int64_t stream_id, uint64_t app_error_code) {
       std::cerr << "HTTP stream " << stream_id << " closed with error code "
                 << app_error_code << std::endl;
     }
+
+    if (worker_) {
+      auto &stats = worker_->get_stats();
+      auto &stream = (*it).second;
+
+      ++stats.nreqs;
+
+      if (app_error_code == NGHTTP3_H3_NO_ERROR && stream->response_started) {
+        ++stats.nreqs_success;
+        stats.request.record(util::timestamp() - stream->start_ts);
+      }
+    }
+
     streams_.erase(it);
   }
 
@@ -2181,9 +2449,18 @@ const std::vector<uint32_t> &Client::get_offered_versions() const {
 
 bool Client::get_early_data() const { return early_data_; };
 
+void Client::set_load_worker(LoadWorker *worker, const char *session_file,
+                             const char *tp_file) {
+  worker_ = worker;
+  session_file_ = session_file;
+  tp_file_ = tp_file;
+}
+
 namespace {
-int run(Client &c, const char *addr, const char *port,
-        TLSClientContext &tls_ctx) {
+// start connects |c| to |addr| and |port|, and sends the first
+// packets.
+int start(Client &c, const char *addr, const char *port,
+          TLSClientContext &tls_ctx) {
   Address remote_addr, local_addr;
 
   auto fd = create_sock(remote_addr, addr, port);
@@ -2220,12 +2497,284 @@ int run(Client &c, const char *addr, const char *port,
     return rv;
   }
 
+  return 0;
+}
+} // namespace
+
+namespace {
+int run(Client &c, const char *addr, const char *port,
+        TLSClientContext &tls_ctx) {
+  if (auto rv = start(c, addr, port, tls_ctx); rv != 0) {
+    return rv;
+  }
+
   ev_run(EV_DEFAULT, 0);
 
   return 0;
 }
 } // namespace
 
+LoadStats::LoadStats()
+    : nconns(0),
+      nhandshakes(0),
+      nresumed(0),
+      nearly_data(0),
+      nreqs(0),
+      nreqs_success(0) {}
+
+void LoadStats::merge(const LoadStats &other) {
+  handshake.merge(other.handshake);
+  ttfb.merge(other.ttfb);
+  request.merge(other.request);
+  nconns += other.nconns;
+  nhandshakes += other.nhandshakes;
+  nresumed += other.nresumed;
+  nearly_data += other.nearly_data;
+  nreqs += other.nreqs;
+  nreqs_success += other.nreqs_success;
+}
+
+namespace {
+void load_preparecb(struct ev_loop *loop, ev_prepare *w, int revents) {
+  auto worker = static_cast<LoadWorker *>(w->data);
+
+  worker->on_prepare();
+}
+} // namespace
+
+namespace {
+void load_ratecb(struct ev_loop *loop, ev_timer *w, int revents) {
+  auto worker = static_cast<LoadWorker *>(w->data);
+
+  worker->on_rate_timer();
+}
+} // namespace
+
+LoadWorker::LoadWorker(const char *addr, const char *port,
+                       TLSClientContext &tls_ctx, size_t nclients,
+                       size_t nconns, double rate, const char *session_file,
+                       const char *tp_file)
+    : loop_(ev_loop_new(EVFLAG_AUTO)),
+      addr_(addr),
+      port_(port),
+      tls_ctx_(tls_ctx),
+      nclients_(nclients),
+      nconns_(nconns),
+      nstarted_(0),
+      session_file_(session_file),
+      tp_file_(tp_file) {
+  ev_prepare_init(&prep_, load_preparecb);
+  prep_.data = this;
+  ev_timer_init(&rate_timer_, load_ratecb, 0., rate > 0 ? 1. / rate : 0.);
+  rate_timer_.data = this;
+}
+
+LoadWorker::~LoadWorker() {
+  // Client stops its watchers in its destructor, so it must be
+  // deleted before the event loop.
+  clients_.clear();
+
+  ev_loop_destroy(loop_);
+}
+
+void LoadWorker::run() {
+  ev_prepare_start(loop_, &prep_);
+
+  if (rate_timer_.repeat > 0.) {
+    ev_timer_again(loop_, &rate_timer_);
+  }
+
+  ev_run(loop_, 0);
+}
+
+void LoadWorker::start_client() {
+  ++nstarted_;
+
+  auto c = std::make_unique<Client>(loop_, config.version, config.version);
+  auto cp = c.get();
+
+  clients_.emplace(cp, std::move(c));
+
+  auto resume =
+      session_file_ &&
+      std::bernoulli_distribution(config.resume_ratio)(randgen);
+  if (resume) {
+    ++stats_.nresumed;
+    cp->set_load_worker(this, session_file_, tp_file_);
+  } else {
+    cp->set_load_worker(this, nullptr, nullptr);
+  }
+
+  if (start(*cp, addr_, port_, tls_ctx_) != 0) {
+    // disconnect reports the failure unless it has been done.
+    cp->disconnect();
+  }
+}
+
+void LoadWorker::on_client_done(Client *c) {
+  ++stats_.nconns;
+
+  done_.push_back(c);
+}
+
+void LoadWorker::on_prepare() {
+  for (;;) {
+    for (auto c : done_) {
+      clients_.erase(c);
+    }
+
+    done_.clear();
+
+    // A connection which fails to start finishes immediately.  It is
+    // replaced here rather than in the next iteration, because
+    // nothing might wake the event loop up.
+    if (rate_timer_.repeat > 0. || nstarted_ == nconns_ ||
+        clients_.size() == nclients_) {
+      break;
+    }
+
+    start_client();
+  }
+
+  finish_if_done();
+}
+
+void LoadWorker::on_rate_timer() {
+  if (nstarted_ < nconns_ && clients_.size() < nclients_) {
+    start_client();
+  }
+
+  finish_if_done();
+}
+
+void LoadWorker::finish_if_done() {
+  if (nstarted_ < nconns_ || !clients_.empty()) {
+    return;
+  }
+
+  ev_prepare_stop(loop_, &prep_);
+  ev_timer_stop(loop_, &rate_timer_);
+  ev_break(loop_, EVBREAK_ALL);
+}
+
+LoadStats &LoadWorker::get_stats() { return stats_; }
+
+namespace {
+void print_load_histogram(const char *name, const Histogram &h) {
+  std::cout << std::left << std::setw(10) << name << std::right;
+
+  if (h.count() == 0) {
+    std::cout << std::endl;
+    return;
+  }
+
+  std::cout << std::setw(10) << util::format_durationf(h.min());
+
+  for (auto q : {0.5, 0.9, 0.99, 0.999}) {
+    std::cout << std::setw(10) << util::format_durationf(h.quantile(q));
+  }
+
+  std::cout << std::setw(10) << util::format_durationf(h.max())
+            << std::setw(10) << util::format_durationf(h.mean()) << std::endl;
+}
+} // namespace
+
+namespace {
+void print_load_stats(const LoadStats &stats, ngtcp2_duration elapsed) {
+  auto secs = static_cast<double>(elapsed) / NGTCP2_SECONDS;
+
+  std::cout << std::fixed << std::setprecision(2) << "finished in "
+            << util::format_durationf(elapsed) << ", "
+            << static_cast<double>(stats.nconns) / secs << " conns/s, "
+            << static_cast<double>(stats.nreqs_success) / secs << " reqs/s"
+            << std::endl
+            << "connections: " << stats.nconns << " total, "
+            << stats.nhandshakes << " succeeded, "
+            << stats.nconns - stats.nhandshakes << " failed, "
+            << stats.nresumed << " resumed, " << stats.nearly_data
+            << " early data accepted" << std::endl
+            << "requests: " << stats.nreqs << " total, " << stats.nreqs_success
+            << " succeeded, " << stats.nreqs - stats.nreqs_success
+            << " failed" << std::endl
+            << "                 min       p50       p90       p99     p99.9"
+               "       max      mean"
+            << std::endl;
+
+  print_load_histogram("handshake", stats.handshake);
+  print_load_histogram("ttfb", stats.ttfb);
+  print_load_histogram("request", stats.request);
+}
+} // namespace
+
+namespace {
+int run_load(const char *addr, const char *port, TLSClientContext &tls_ctx,
+             const char *private_key_file, const char *cert_file) {
+  const char *session_file = nullptr;
+  const char *tp_file = nullptr;
+
+  if (config.resume_ratio > 0) {
+    // Make a connection first to get the TLS session and 0-RTT
+    // transport parameters which the other connections resume.
+    config.wait_for_ticket = true;
+
+    Client c(EV_DEFAULT, config.version, config.version);
+
+    if (run(c, addr, port, tls_ctx) != 0) {
+      return -1;
+    }
+
+    session_file = config.session_file;
+    tp_file = config.tp_file;
+  }
+
+  // The connections must not write the session and the transport
+  // parameters from multiple threads.
+  config.session_file = nullptr;
+  config.tp_file = nullptr;
+  config.wait_for_ticket = false;
+
+  TLSClientContext load_tls_ctx;
+  if (load_tls_ctx.init(private_key_file, cert_file) != 0) {
+    return -1;
+  }
+
+  auto rate =
+      static_cast<double>(config.rate) / static_cast<double>(config.threads);
+
+  std::vector<std::unique_ptr<LoadWorker>> workers;
+
+  for (size_t i = 0; i < config.threads; ++i) {
+    auto nclients = config.clients / config.threads +
+                    (i < config.clients % config.threads);
+    auto nconns = config.connections / config.threads +
+                  (i < config.connections % config.threads);
+
+    workers.emplace_back(std::make_unique<LoadWorker>(
+        addr, port, load_tls_ctx, nclients, nconns, rate, session_file,
+        tp_file));
+  }
+
+  auto start_ts = util::timestamp();
+
+  std::vector<std::thread> threads;
+
+  for (auto &w : workers) {
+    threads.emplace_back([worker = w.get()]() { worker->run(); });
+  }
+
+  LoadStats stats;
+
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+    stats.merge(workers[i]->get_stats());
+  }
+
+  print_load_stats(stats, util::timestamp() - start_ts);
+
+  return 0;
+}
+} // namespace
+
 namespace {
 std::string_view get_string(const char *uri, const http_parser_url &u,
                             http_parser_url_fields f) {
@@ -2331,6 +2880,7 @@ void config_set_default(Config &config) {
   config.handshake_timeout = UINT64_MAX;
   config.ack_thresh = 2;
   config.initial_pkt_num = UINT32_MAX;
+  config.threads = 1;
 }
 } // namespace
 
@@ -2456,6 +3006,11 @@ Options:
               file name  of each qlog  is the Source Connection  ID of
               client.   This  option   and  --qlog-file  are  mutually
               exclusive.
+  --qlog-binary
+              Write  qlog  in  compact  binary  format  instead  of
+              JSON-SEQ.  If --qlog-dir is given, the file extension
+              becomes ".bqlog".  Use qlogconv to convert it to
+              JSON-SEQ.
   --max-data=<SIZE>
               The initial connection-level flow control window.
               Default: )"
@@ -2545,6 +3100,41 @@ Options:
   --pmtud-probes=<SIZE>[[,<SIZE>]...]
               Specify UDP datagram payload sizes  to probe in Path MTU
               Discovery.  <SIZE> must be strictly larger than 1200.
+              On  a network  which supports  jumbo frames,  specify,
+              for example, 1452,8952.
+  --max-concurrent-streams=<N>
+              The maximum number of requests that are in flight on a
+              connection at the same time.  The remaining requests are
+              sent as the previous ones complete.  0 means no limit.
+  --handshake-only
+              Close  the connection  right after  handshake without
+              sending any request.
+  --clients=<N>
+              Enable load  generation mode, and keep  <N> connections
+              open at the same  time.  Each connection sends --nstreams
+              requests, and  is replaced  with a new  one when  all of
+              them finish.   The latency of handshake, the
+              time to the first byte of responses, and the completion
+              of requests are reported when all connections finish.
+  --threads=<N>
+              The number of threads in load generation mode.  It must
+              not exceed --clients.
+              Default: 1
+  --connections=<N>
+              The  total number  of connections  to make  in  load
+              generation mode.  It defaults to --clients.
+  --rate=<N>
+              Start <N> connections per second in load generation mode
+              instead of replacing  a connection as soon  as it ends.
+              The  request  rate  is  <N>  times  --nstreams.   The
+              number of open connections is still capped by --clients.
+  --resume-ratio=<P>
+              The probability that a connection resumes the TLS session
+              in load  generation mode.   <P> must be  [0.0, 1.0],
+              inclusive.   A connection is made first  to save the TLS
+              session  in --session-file,  and  0-RTT transport
+              parameters  in  --tp-file if  given.   The  resuming
+              connections send requests in 0-RTT if possible.
   -h, --help  Display this help and exit.
 
 ---
@@ -2629,6 +3219,14 @@ int main(int argc, char **argv) {
         {"wait-for-ticket", no_argument, &flag, 41},
         {"initial-pkt-num", required_argument, &flag, 42},
         {"pmtud-probes", required_argument, &flag, 43},
+        {"qlog-binary", no_argument, &flag, 44},
+        {"max-concurrent-streams", required_argument, &flag, 45},
+        {"clients", required_argument, &flag, 46},
+        {"threads", required_argument, &flag, 47},
+        {"connections", required_argument, &flag, 48},
+        {"rate", required_argument, &flag, 49},
+        {"handshake-only", no_argument, &flag, 50},
+        {"resume-ratio", required_argument, &flag, 51},
         {nullptr, 0, nullptr, 0},
     };
 
@@ -3050,7 +3648,7 @@ int main(int argc, char **argv) {
           config.initial_pkt_num = static_cast<uint32_t>(*n);
         }
         break;
-      case 43:
+      case 43: {
         // --pmtud-probes
         auto l = util::split_str(optarg);
         for (auto &s : l) {
@@ -3068,6 +3666,75 @@ int main(int argc, char **argv) {
         }
         break;
       }
+      case 44:
+        // --qlog-binary
+        config.qlog_binary = true;
+        break;
+      case 45:
+        // --max-concurrent-streams
+        if (auto n = util::parse_uint(optarg); !n) {
+          std::cerr << "max-concurrent-streams: invalid argument"
+                    << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.max_concurrent_streams = *n;
+        }
+        break;
+      case 46:
+        // --clients
+        if (auto n = util::parse_uint(optarg); !n) {
+          std::cerr << "clients: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.clients = *n;
+        }
+        break;
+      case 47:
+        // --threads
+        if (auto n = util::parse_uint(optarg); !n) {
+          std::cerr << "threads: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else if (*n == 0) {
+          std::cerr << "threads: must not be 0" << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.threads = *n;
+        }
+        break;
+      case 48:
+        // --connections
+        if (auto n = util::parse_uint(optarg); !n) {
+          std::cerr << "connections: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.connections = *n;
+        }
+        break;
+      case 49:
+        // --rate
+        if (auto n = util::parse_uint(optarg); !n) {
+          std::cerr << "rate: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.rate = *n;
+        }
+        break;
+      case 50:
+        // --handshake-only
+        config.handshake_only = true;
+        break;
+      case 51: {
+        // --resume-ratio
+        auto p = strtod(optarg, nullptr);
+        if (p < 0 || p > 1) {
+          std::cerr << "resume-ratio: must be in range [0.0, 1.0], inclusive."
+                    << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        config.resume_ratio = p;
+        break;
+      }
+      }
       break;
     default:
       break;
@@ -3097,6 +3764,40 @@ int main(int argc, char **argv) {
     exit(EXIT_FAILURE);
   }
 
+  if (config.clients) {
+    if (config.threads > config.clients) {
+      std::cerr << "threads: must not exceed clients" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    if (config.connections == 0) {
+      config.connections = config.clients;
+    } else if (config.connections < config.clients) {
+      std::cerr << "connections: must not be less than clients" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    if (config.resume_ratio > 0 && !config.session_file) {
+      std::cerr << "resume-ratio: session-file must be specified"
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    if (config.tx_loss_prob > 0 || config.rx_loss_prob > 0 ||
+        !config.download.empty() || !config.qlog_file.empty() ||
+        !config.token_file.empty()) {
+      std::cerr << "clients: tx-loss, rx-loss, download, qlog-file, and "
+                   "token-file cannot be used in load generation mode"
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    config.quiet = true;
+    if (!config.exit_on_first_stream_close) {
+      config.exit_on_all_streams_close = true;
+    }
+  }
+
   if (data_path) {
     auto fd = open(data_path, O_RDONLY);
     if (fd == -1) {
@@ -3154,6 +3855,13 @@ int main(int argc, char **argv) {
     config.nstreams = config.requests.size();
   }
 
+  if (config.handshake_only) {
+    config.nstreams = 0;
+    if (!config.exit_on_first_stream_close) {
+      config.exit_on_all_streams_close = true;
+    }
+  }
+
   TLSClientContext tls_ctx;
   if (tls_ctx.init(private_key_file, cert_file) != 0) {
     exit(EXIT_FAILURE);
@@ -3174,6 +3882,14 @@ int main(int argc, char **argv) {
     exit(EXIT_FAILURE);
   }
 
+  if (config.clients) {
+    if (run_load(addr, port, tls_ctx, private_key_file, cert_file) != 0) {
+      exit(EXIT_FAILURE);
+    }
+
+    return EXIT_SUCCESS;
+  }
+
   auto client_chosen_version = config.version;
 
   for (;;) {
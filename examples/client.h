@@ -35,6 +35,7 @@
 #include <string_view>
 #include <memory>
 #include <span>
+#include <unordered_map>
 
 #include <ngtcp2/ngtcp2.h>
 #include <ngtcp2/ngtcp2_crypto.h>
@@ -47,6 +48,7 @@
 #include "tls_client_session.h"
 #include "network.h"
 #include "shared.h"
+#include "histogram.h"
 #include "template.h"
 
 using namespace ngtcp2;
@@ -60,9 +62,14 @@ struct Stream {
   Request req;
   int64_t stream_id;
   int fd;
+  // start_ts is the time when the request is submitted.
+  ngtcp2_tstamp start_ts;
+  // response_started is true if the response header has started.
+  bool response_started;
 };
 
 class Client;
+class LoadWorker;
 
 struct Endpoint {
   Address addr;
@@ -85,15 +92,24 @@ public:
   int on_write();
   int write_streams();
   int feed_data(const Endpoint &ep, const sockaddr *sa, socklen_t salen,
-                const ngtcp2_pkt_info *pi, std::span<const uint8_t> data);
+                const ngtcp2_pkt_info *pi, ngtcp2_tstamp pkt_ts,
+                std::span<const uint8_t> data);
   int handle_expiry();
   void update_timer();
   int handshake_completed();
   int handshake_confirmed();
   void recv_version_negotiation(const uint32_t *sv, size_t nsv);
 
-  int send_packet(const Endpoint &ep, const ngtcp2_addr &remote_addr,
-                  unsigned int ecn, std::span<const uint8_t> data);
+  // send_packet sends |data| which consists of |gso_size| bytes
+  // packets, except for the last one, as a single UDP GSO datagram.
+  // It returns the unsent data and an error code.
+  std::pair<std::span<const uint8_t>, int>
+  send_packet(const Endpoint &ep, const ngtcp2_addr &remote_addr,
+              unsigned int ecn, std::span<const uint8_t> data,
+              size_t gso_size);
+  // handle_send_error closes the connection after send_packet fails
+  // with |rv| other than NETWORK_ERR_SEND_BLOCKED, and returns |rv|.
+  int handle_send_error(int rv);
   int on_stream_close(int64_t stream_id, uint64_t app_error_code);
   int on_extend_max_streams();
   int handle_error();
@@ -131,7 +147,8 @@ public:
   int http_stream_close(int64_t stream_id, uint64_t app_error_code);
 
   void on_send_blocked(const Endpoint &ep, const ngtcp2_addr &remote_addr,
-                       unsigned int ecn, size_t datalen);
+                       unsigned int ecn, std::span<const uint8_t> data,
+                       size_t gso_size);
   void start_wev_endpoint(const Endpoint &ep);
   int send_blocked_packet();
 
@@ -142,6 +159,14 @@ public:
 
   bool should_exit() const;
 
+  // set_load_worker makes this object report its measurement to
+  // |worker|.  The TLS session is resumed from |session_file|, and
+  // 0-RTT transport parameters are read from |tp_file| if they are
+  // not nullptr.  It must be called before init.
+  void set_load_worker(LoadWorker *worker, const char *session_file,
+                       const char *tp_file);
+  int http_begin_headers(int64_t stream_id);
+
 private:
   std::vector<Endpoint> endpoints_;
   Address remote_addr_;
@@ -172,18 +197,117 @@ private:
   // handshake_confirmed_ gets true after handshake has been
   // confirmed.
   bool handshake_confirmed_;
+  // worker_ is the load generation worker which this object belongs
+  // to, or nullptr.
+  LoadWorker *worker_;
+  // session_file_ is the file to read the TLS session from.
+  const char *session_file_;
+  // tp_file_ is the file to read 0-RTT transport parameters from.
+  const char *tp_file_;
+  // start_ts_ is the time when the connection is initialized.
+  ngtcp2_tstamp start_ts_;
+
+  // no_gso_ is true if UDP GSO is not available.
+  bool no_gso_;
 
   struct {
     bool send_blocked;
+    size_t num_blocked;
+    size_t num_blocked_sent;
     // blocked field is effective only when send_blocked is true.
     struct {
       const Endpoint *endpoint;
       Address remote_addr;
       unsigned int ecn;
-      size_t datalen;
-    } blocked;
+      std::span<const uint8_t> data;
+      size_t gso_size;
+    } blocked[2];
     std::array<uint8_t, 64_k> data;
   } tx_;
 };
 
+// LoadStats is the measurement that a load generation worker
+// collects.  The durations are recorded in histograms so that the
+// measurement of all workers can be merged.
+struct LoadStats {
+  LoadStats();
+
+  void merge(const LoadStats &other);
+
+  // handshake is the histogram of the time from the start of a
+  // connection to the completion of its handshake.
+  Histogram handshake;
+  // ttfb is the histogram of the time from the submission of a
+  // request to the beginning of its response.
+  Histogram ttfb;
+  // request is the histogram of the time from the submission of a
+  // request to the close of its stream.
+  Histogram request;
+  // nconns is the number of connections which have finished.
+  size_t nconns;
+  // nhandshakes is the number of connections which have completed
+  // handshake.
+  size_t nhandshakes;
+  // nresumed is the number of connections which have tried to resume
+  // a TLS session.
+  size_t nresumed;
+  // nearly_data is the number of connections whose early data has
+  // been accepted.
+  size_t nearly_data;
+  // nreqs is the number of requests which have finished.
+  size_t nreqs;
+  // nreqs_success is the number of requests which have finished
+  // without error.
+  size_t nreqs_success;
+};
+
+// LoadWorker drives the connections of a load generation thread.
+// Each worker has its own event loop.  It keeps up to |nclients|
+// connections open until it has started |nconns| connections, and
+// starts them at |rate| connections per second if |rate| is
+// nonzero.
+class LoadWorker {
+public:
+  LoadWorker(const char *addr, const char *port, TLSClientContext &tls_ctx,
+             size_t nclients, size_t nconns, double rate,
+             const char *session_file, const char *tp_file);
+  ~LoadWorker();
+
+  // run runs the event loop until all connections finish.
+  void run();
+  // on_client_done is called when the connection of |c| has
+  // finished.  |c| is deleted before the event loop waits for the
+  // next event.
+  void on_client_done(Client *c);
+  // on_prepare deletes the finished connections, and starts new ones.
+  void on_prepare();
+  // on_rate_timer starts a new connection if the number of open
+  // connections is less than |nclients|.
+  void on_rate_timer();
+
+  LoadStats &get_stats();
+
+private:
+  void start_client();
+  void finish_if_done();
+
+  struct ev_loop *loop_;
+  const char *addr_;
+  const char *port_;
+  TLSClientContext &tls_ctx_;
+  size_t nclients_;
+  size_t nconns_;
+  // nstarted_ is the number of connections started.
+  size_t nstarted_;
+  const char *session_file_;
+  const char *tp_file_;
+  std::unordered_map<Client *, std::unique_ptr<Client>> clients_;
+  // done_ contains the connections which have finished, and are
+  // waiting to be deleted.
+  std::vector<Client *> done_;
+  ev_prepare prep_;
+  ev_timer rate_timer_;
+  LoadStats stats_;
+};
+
 #endif // CLIENT_H
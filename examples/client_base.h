@@ -115,6 +115,8 @@ struct Config {
   // qlog_dir is the path to directory where qlog is stored.  qlog_dir
   // and qlog_file are mutually exclusive.
   std::string_view qlog_dir;
+  // qlog_binary is true if qlog is written in compact binary format.
+  bool qlog_binary;
   // max_data is the initial connection-level flow control window.
   uint64_t max_data;
   // max_stream_data_bidi_local is the initial stream-level flow
@@ -191,6 +193,30 @@ struct Config {
   uint32_t initial_pkt_num;
   // pmtud_probes is the array of UDP datagram payload size to probes.
   std::vector<uint16_t> pmtud_probes;
+  // max_concurrent_streams is the maximum number of requests that
+  // are in flight on a connection at the same time.  0 means no
+  // limit other than the one imposed by the server.
+  size_t max_concurrent_streams;
+  // clients is the number of connections which are kept open at the
+  // same time in load generation mode.  Load generation mode is
+  // enabled if it is nonzero.
+  size_t clients;
+  // threads is the number of threads which generate load.
+  size_t threads;
+  // connections is the total number of connections that are made in
+  // load generation mode.
+  size_t connections;
+  // rate is the number of connections started per second in load
+  // generation mode.  0 means that a new connection is started as
+  // soon as another one finishes.
+  size_t rate;
+  // handshake_only, if true, closes connections right after
+  // handshake without sending any request.
+  bool handshake_only;
+  // resume_ratio is the fraction of connections which resume the TLS
+  // session, and send early data if possible, in load generation
+  // mode.
+  double resume_ratio;
 };
 
 class ClientBase {
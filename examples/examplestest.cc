@@ -31,10 +31,16 @@
 
 // include test cases' include files here
 #include "util_test.h"
+#include "cid_table_test.h"
+#include "file_cache_test.h"
+#include "histogram_test.h"
 
 int main(int argc, char *argv[]) {
   const MunitSuite suites[] = {
       ngtcp2::util_suite,
+      ngtcp2::cid_table_suite,
+      ngtcp2::file_cache_suite,
+      ngtcp2::histogram_suite,
       {NULL, NULL, NULL, 0, MUNIT_SUITE_OPTION_NONE},
   };
   const MunitSuite suite = {
@@ -0,0 +1,210 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "file_cache.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include "util.h"
+#include "template.h"
+
+using namespace std::literals;
+
+namespace ngtcp2 {
+
+FileEntry::FileEntry()
+    : data(nullptr),
+      len(0),
+      content_type("text/plain"sv),
+      map(nullptr),
+      dev(0),
+      ino(0),
+      mtime{},
+      size(0),
+      flags(0) {}
+
+FileEntry::~FileEntry() {
+  if (map) {
+    munmap(map, len);
+  }
+}
+
+namespace {
+// same_file returns true if |st| describes the same version of the
+// file that |fe| holds.
+bool same_file(const FileEntry &fe, const struct stat &st) {
+  return fe.dev == st.st_dev && fe.ino == st.st_ino &&
+         fe.mtime.tv_sec == st.st_mtim.tv_sec &&
+         fe.mtime.tv_nsec == st.st_mtim.tv_nsec && fe.size == st.st_size;
+}
+} // namespace
+
+FileCache::FileCache(
+    size_t max_size, ngtcp2_duration validity,
+    const std::unordered_map<std::string, std::string> &mime_types)
+    : max_size_(max_size),
+      validity_(validity),
+      mime_types_(mime_types),
+      size_(0) {}
+
+std::shared_ptr<const FileEntry> FileCache::get(const std::string &path,
+                                                ngtcp2_tstamp ts) {
+  if (auto it = index_.find(path); it != std::end(index_)) {
+    auto node = (*it).second;
+
+    if (ts - (*node).validated_ts < validity_) {
+      lru_.splice(std::begin(lru_), lru_, node);
+      return (*node).entry;
+    }
+
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && same_file(*(*node).entry, st)) {
+      (*node).validated_ts = ts;
+      lru_.splice(std::begin(lru_), lru_, node);
+      return (*node).entry;
+    }
+
+    evict(node);
+  }
+
+  auto fe = read_file(path);
+  if (!fe || fe->map || max_size_ == 0) {
+    return fe;
+  }
+
+  size_ += fe->len;
+
+  while (size_ > max_size_) {
+    evict(std::prev(std::end(lru_)));
+  }
+
+  lru_.emplace_front(path, fe, ts);
+
+  auto &node = lru_.front();
+  index_.emplace(node.path, std::begin(lru_));
+
+  return fe;
+}
+
+std::shared_ptr<FileEntry>
+FileCache::read_file(const std::string &path) const {
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  auto fd_d = defer(close, fd);
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return nullptr;
+  }
+
+  auto fe = std::make_shared<FileEntry>();
+  fe->dev = st.st_dev;
+  fe->ino = st.st_ino;
+  fe->mtime = st.st_mtim;
+  fe->size = st.st_size;
+
+  if (S_ISDIR(st.st_mode)) {
+    fe->flags |= FILE_ENTRY_TYPE_DIR;
+    return fe;
+  }
+
+  fe->len = static_cast<uint64_t>(st.st_size);
+  fe->content_length = util::format_uint(fe->len);
+
+  auto ext = path.find_last_of("./"sv);
+  if (ext != std::string::npos && path[ext] == '.') {
+    if (auto it = mime_types_.find(path.substr(ext + 1));
+        it != std::end(mime_types_)) {
+      fe->content_type = (*it).second;
+    }
+  }
+
+  if (fe->len == 0) {
+    return fe;
+  }
+
+  if (fe->len > max_size_ / 8) {
+    fe->map = mmap(nullptr, fe->len, PROT_READ, MAP_SHARED, fd, 0);
+    if (fe->map == MAP_FAILED) {
+      std::cerr << "mmap: " << strerror(errno) << std::endl;
+      fe->map = nullptr;
+      return nullptr;
+    }
+
+    fe->data = static_cast<const uint8_t *>(fe->map);
+
+    return fe;
+  }
+
+  // The buffer is not zero initialized because it is overwritten
+  // right away.
+  fe->buf = std::unique_ptr<uint8_t[]>(new uint8_t[fe->len]);
+
+  for (uint64_t nread = 0; nread < fe->len;) {
+    auto n = pread(fd, fe->buf.get() + nread, fe->len - nread,
+                   static_cast<off_t>(nread));
+    if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      std::cerr << "pread: " << strerror(errno) << std::endl;
+
+      return nullptr;
+    }
+
+    // The file has been truncated after fstat.
+    if (n == 0) {
+      return nullptr;
+    }
+
+    nread += static_cast<uint64_t>(n);
+  }
+
+  fe->data = fe->buf.get();
+
+  return fe;
+}
+
+void FileCache::evict(std::list<Node>::iterator it) {
+  size_ -= (*it).entry->len;
+  index_.erase((*it).path);
+  lru_.erase(it);
+}
+
+size_t FileCache::size() const { return size_; }
+
+size_t FileCache::num_entries() const { return lru_.size(); }
+
+} // namespace ngtcp2
@@ -0,0 +1,131 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <sys/types.h>
+#include <time.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <ngtcp2/ngtcp2.h>
+
+namespace ngtcp2 {
+
+enum FileEntryFlag {
+  FILE_ENTRY_TYPE_DIR = 0x1,
+};
+
+// FileEntry is the content of a file.  It is immutable once it is
+// created, so that it can be shared by any number of streams.  An
+// entry which is evicted from FileCache stays alive until the last
+// stream which refers to it releases it.
+struct FileEntry {
+  FileEntry();
+  ~FileEntry();
+
+  FileEntry(const FileEntry &) = delete;
+  FileEntry &operator=(const FileEntry &) = delete;
+
+  // data points to the content of the file.  It is either buf, or
+  // the memory which maps the file if the file is not cached.
+  const uint8_t *data;
+  uint64_t len;
+  // content_length is len formatted as a decimal string.
+  std::string content_length;
+  // content_type is the MIME media type of the file.
+  std::string_view content_type;
+  std::unique_ptr<uint8_t[]> buf;
+  // map is the memory which maps the file, or nullptr.
+  void *map;
+  // dev, ino, mtime, and size identify the version of the file that
+  // this entry holds.
+  dev_t dev;
+  ino_t ino;
+  timespec mtime;
+  off_t size;
+  uint8_t flags;
+};
+
+// FileCache keeps the content of recently served files in memory so
+// that a request for a hot file makes no system call.  The total
+// length of the cached files is bounded by |max_size|, and the least
+// recently used files are evicted first.  A file which is larger than
+// 1/8 of |max_size| is mapped for each request instead of being
+// cached.
+//
+// A cached file is revalidated with stat(2) when it is requested
+// |validity| after it was last validated.  If its inode, mtime, or
+// size has changed, it is read again.  The content type of a file is
+// looked up in |mime_types| by its extension when it is read.
+class FileCache {
+public:
+  FileCache(size_t max_size, ngtcp2_duration validity,
+            const std::unordered_map<std::string, std::string> &mime_types);
+
+  // get returns the content of the file at |path|.  |ts| is the
+  // current time.  It returns nullptr if the file cannot be read.
+  std::shared_ptr<const FileEntry> get(const std::string &path,
+                                       ngtcp2_tstamp ts);
+
+  // size returns the total length of the cached files.
+  size_t size() const;
+  // num_entries returns the number of cached files.
+  size_t num_entries() const;
+
+private:
+  struct Node {
+    std::string path;
+    std::shared_ptr<const FileEntry> entry;
+    // validated_ts is the last time when entry is known to be up to
+    // date.
+    ngtcp2_tstamp validated_ts;
+  };
+
+  std::shared_ptr<FileEntry> read_file(const std::string &path) const;
+  void evict(std::list<Node>::iterator it);
+
+  size_t max_size_;
+  ngtcp2_duration validity_;
+  const std::unordered_map<std::string, std::string> &mime_types_;
+  // size_ is the total length of the cached files.
+  size_t size_;
+  // lru_ is ordered from the most recently used to the least.
+  std::list<Node> lru_;
+  std::unordered_map<std::string_view, std::list<Node>::iterator> index_;
+};
+
+} // namespace ngtcp2
+
+#endif // FILE_CACHE_H
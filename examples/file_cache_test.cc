@@ -0,0 +1,243 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "file_cache_test.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "file_cache.h"
+
+using namespace std::literals;
+
+namespace ngtcp2 {
+
+namespace {
+const MunitTest tests[]{
+    munit_void_test(test_file_cache_get),
+    munit_void_test(test_file_cache_evict),
+    munit_void_test(test_file_cache_revalidate),
+    munit_void_test(test_file_cache_large_file),
+    munit_test_end(),
+};
+} // namespace
+
+const MunitSuite file_cache_suite{
+    "/file_cache", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE,
+};
+
+namespace {
+// TempDir is a temporary directory which is removed with the files
+// created by write_file.
+struct TempDir {
+  TempDir() {
+    char tmpl[] = "/tmp/file_cache_test.XXXXXX";
+
+    assert_not_null(mkdtemp(tmpl));
+
+    path = tmpl;
+  }
+
+  ~TempDir() {
+    for (auto &name : names) {
+      unlink((path + '/' + name).c_str());
+    }
+
+    rmdir(path.c_str());
+  }
+
+  // write_file creates or replaces the file |name| with |data|, and
+  // returns its path.
+  std::string write_file(const std::string &name, const std::string &data) {
+    auto p = path + '/' + name;
+    auto fd = open(p.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    assert_int(-1, !=, fd);
+    assert_ptrdiff(static_cast<ptrdiff_t>(data.size()), ==,
+                   write(fd, data.data(), data.size()));
+
+    close(fd);
+
+    names.push_back(name);
+
+    return p;
+  }
+
+  std::string path;
+  std::vector<std::string> names;
+};
+} // namespace
+
+namespace {
+const std::unordered_map<std::string, std::string> mime_types{
+    {"html", "text/html"},
+};
+} // namespace
+
+void test_file_cache_get() {
+  TempDir dir;
+  FileCache cache(1024, NGTCP2_SECONDS, mime_types);
+
+  auto path = dir.write_file("index.html", "hello");
+
+  auto fe = cache.get(path, 0);
+
+  assert_not_null(fe.get());
+  assert_uint64(5, ==, fe->len);
+  assert_memory_equal(5, "hello", fe->data);
+  assert_stdstring_equal("5", fe->content_length);
+  assert_stdsv_equal("text/html"sv, fe->content_type);
+  assert_size(5, ==, cache.size());
+  assert_size(1, ==, cache.num_entries());
+
+  // The second request is served from the cache even if the file has
+  // been removed.
+  unlink(path.c_str());
+
+  assert_ptr_equal(fe.get(), cache.get(path, 1).get());
+
+  // Unknown extension falls back to text/plain.
+  fe = cache.get(dir.write_file("data.bin", ""), 0);
+
+  assert_not_null(fe.get());
+  assert_uint64(0, ==, fe->len);
+  assert_stdsv_equal("text/plain"sv, fe->content_type);
+
+  // Directory is cached, but takes no space.
+  fe = cache.get(dir.path, 0);
+
+  assert_not_null(fe.get());
+  assert_true(fe->flags & FILE_ENTRY_TYPE_DIR);
+  assert_size(5, ==, cache.size());
+  assert_size(3, ==, cache.num_entries());
+
+  // Missing file is not cached.
+  assert_null(cache.get(dir.path + "/nonexistent", 0).get());
+  assert_size(3, ==, cache.num_entries());
+}
+
+void test_file_cache_evict() {
+  TempDir dir;
+  FileCache cache(800, NGTCP2_SECONDS, mime_types);
+
+  auto a = dir.write_file("a", std::string(100, 'a'));
+  auto b = dir.write_file("b", std::string(100, 'b'));
+  auto c = dir.write_file("c", std::string(100, 'c'));
+
+  auto fea = cache.get(a, 0);
+  auto feb = cache.get(b, 0);
+
+  assert_size(200, ==, cache.size());
+
+  // Touch a so that b becomes the least recently used.
+  assert_ptr_equal(fea.get(), cache.get(a, 0).get());
+
+  for (size_t i = 0; i < 6; ++i) {
+    cache.get(dir.write_file("f" + std::to_string(i), std::string(100, 'f')),
+              0);
+  }
+
+  // Adding c exceeds 800 bytes, and evicts b.
+  cache.get(c, 0);
+
+  assert_size(800, ==, cache.size());
+  assert_size(8, ==, cache.num_entries());
+  assert_ptr_equal(fea.get(), cache.get(a, 0).get());
+
+  // The evicted entry is still usable by the holder.
+  assert_memory_equal(100, std::string(100, 'b').data(), feb->data);
+
+  auto feb2 = cache.get(b, 0);
+
+  assert_ptr_not_equal(feb.get(), feb2.get());
+  assert_size(800, ==, cache.size());
+}
+
+void test_file_cache_revalidate() {
+  TempDir dir;
+  FileCache cache(1024, NGTCP2_SECONDS, mime_types);
+
+  auto path = dir.write_file("a", "old");
+  auto fe = cache.get(path, 0);
+
+  assert_memory_equal(3, "old", fe->data);
+
+  dir.write_file("a", "newer");
+
+  // Within the validity period, the file is not checked.
+  assert_ptr_equal(fe.get(), cache.get(path, NGTCP2_SECONDS - 1).get());
+
+  // After that, the change is noticed.
+  auto fe2 = cache.get(path, NGTCP2_SECONDS);
+
+  assert_ptr_not_equal(fe.get(), fe2.get());
+  assert_uint64(5, ==, fe2->len);
+  assert_memory_equal(5, "newer", fe2->data);
+  assert_size(5, ==, cache.size());
+  assert_size(1, ==, cache.num_entries());
+
+  // Unchanged file is validated, and stays in the cache.
+  assert_ptr_equal(fe2.get(), cache.get(path, 3 * NGTCP2_SECONDS).get());
+
+  // Removed file is dropped from the cache.
+  unlink(path.c_str());
+
+  assert_null(cache.get(path, 5 * NGTCP2_SECONDS).get());
+  assert_size(0, ==, cache.size());
+  assert_size(0, ==, cache.num_entries());
+}
+
+void test_file_cache_large_file() {
+  TempDir dir;
+  FileCache cache(800, NGTCP2_SECONDS, mime_types);
+
+  auto path = dir.write_file("a", std::string(101, 'a'));
+
+  // A file larger than 1/8 of the cache is mapped, and not cached.
+  auto fe = cache.get(path, 0);
+
+  assert_not_null(fe.get());
+  assert_not_null(fe->map);
+  assert_memory_equal(101, std::string(101, 'a').data(), fe->data);
+  assert_size(0, ==, cache.size());
+  assert_size(0, ==, cache.num_entries());
+  assert_ptr_not_equal(fe.get(), cache.get(path, 0).get());
+
+  // Nothing is cached if the cache is disabled.
+  FileCache nocache(0, NGTCP2_SECONDS, mime_types);
+
+  fe = nocache.get(dir.write_file("b", "b"), 0);
+
+  assert_not_null(fe.get());
+  assert_memory_equal(1, "b", fe->data);
+  assert_size(0, ==, nocache.num_entries());
+}
+
+} // namespace ngtcp2
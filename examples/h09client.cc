@@ -769,7 +769,8 @@ int Client::init(int fd, const Address &local_addr, const Address &remote_addr,
   }
 
   if (tls_session_.init(early_data_, tls_ctx, addr_, this,
-                        client_chosen_version_, AppProtocol::HQ) != 0) {
+                        client_chosen_version_, AppProtocol::HQ,
+                        config.session_file) != 0) {
     return -1;
   }
 
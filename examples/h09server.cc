@@ -1477,7 +1477,8 @@ void siginthandler(struct ev_loop *loop, ev_signal *watcher, int revents) {
 } // namespace
 
 Server::Server(struct ev_loop *loop, TLSServerContext &tls_ctx)
-    : loop_(loop),
+    : handlers_(std::uniform_int_distribution<uint64_t>()(randgen)),
+      loop_(loop),
       tls_ctx_(tls_ctx),
       stateless_reset_bucket_(NGTCP2_STATELESS_RESET_BURST) {
   ev_signal_init(&sigintev_, siginthandler, SIGINT);
@@ -1508,14 +1509,11 @@ void Server::disconnect() {
   ev_timer_stop(loop_, &stateless_reset_regen_timer_);
   ev_signal_stop(loop_, &sigintev_);
 
-  while (!handlers_.empty()) {
-    auto it = std::begin(handlers_);
-    auto &h = (*it).second;
-
+  handlers_.for_each([this](Handler *h) {
     h->handle_error();
 
     remove(h);
-  }
+  });
 }
 
 void Server::close() {
@@ -1844,10 +1842,10 @@ void Server::read_pkt(Endpoint &ep, const Address &local_addr,
     return;
   }
 
-  auto dcid_key = util::make_cid_key({vc.dcid, vc.dcidlen});
+  auto dcid = std::span{vc.dcid, vc.dcidlen};
 
-  auto handler_it = handlers_.find(dcid_key);
-  if (handler_it == std::end(handlers_)) {
+  auto ph = handlers_.find(dcid);
+  if (!ph) {
     ngtcp2_pkt_hd hd;
 
     if (auto rv = ngtcp2_accept(&hd, data.data(), data.size()); rv != 0) {
@@ -1956,12 +1954,12 @@ void Server::read_pkt(Endpoint &ep, const Address &local_addr,
       associate_cid(&scids[i], h.get());
     }
 
-    handlers_.emplace(dcid_key, h.release());
+    handlers_.insert(dcid, h.release());
 
     return;
   }
 
-  auto h = (*handler_it).second;
+  auto h = *ph;
   auto conn = h->conn();
   if (ngtcp2_conn_in_closing_period(conn)) {
     // TODO do exponential backoff.
@@ -2486,11 +2484,11 @@ Server::send_packet(Endpoint &ep, bool &no_gso, const ngtcp2_addr &local_addr,
 }
 
 void Server::associate_cid(const ngtcp2_cid *cid, Handler *h) {
-  handlers_.emplace(util::make_cid_key(cid), h);
+  handlers_.insert({cid->data, cid->datalen}, h);
 }
 
 void Server::dissociate_cid(const ngtcp2_cid *cid) {
-  handlers_.erase(std::string{util::make_cid_key(cid)});
+  handlers_.erase({cid->data, cid->datalen});
 }
 
 void Server::remove(const Handler *h) {
@@ -0,0 +1,116 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace ngtcp2 {
+
+size_t histogram_bucket_index(uint64_t v) {
+  if (v < 2 * HISTOGRAM_SUB_BUCKETLEN) {
+    return static_cast<size_t>(v);
+  }
+
+  // |shift| is at least 1 here, and v >> shift is in
+  // [HISTOGRAM_SUB_BUCKETLEN, 2 * HISTOGRAM_SUB_BUCKETLEN).
+  auto shift = static_cast<size_t>(std::bit_width(v)) -
+               (HISTOGRAM_SUB_BUCKET_BITS + 1);
+
+  return shift * HISTOGRAM_SUB_BUCKETLEN + static_cast<size_t>(v >> shift);
+}
+
+uint64_t histogram_bucket_upper_bound(size_t idx) {
+  assert(idx < HISTOGRAM_BUCKETLEN);
+
+  if (idx < 2 * HISTOGRAM_SUB_BUCKETLEN) {
+    return idx;
+  }
+
+  auto shift = idx / HISTOGRAM_SUB_BUCKETLEN - 1;
+  auto sub = static_cast<uint64_t>(idx - shift * HISTOGRAM_SUB_BUCKETLEN);
+
+  return (sub << shift) + ((uint64_t{1} << shift) - 1);
+}
+
+Histogram::Histogram()
+    : counts_(HISTOGRAM_BUCKETLEN),
+      count_(0),
+      sum_(0),
+      min_(std::numeric_limits<uint64_t>::max()),
+      max_(0) {}
+
+void Histogram::record(uint64_t v) {
+  ++counts_[histogram_bucket_index(v)];
+  ++count_;
+  sum_ += v;
+  min_ = std::min(min_, v);
+  max_ = std::max(max_, v);
+}
+
+void Histogram::merge(const Histogram &other) {
+  for (size_t i = 0; i < HISTOGRAM_BUCKETLEN; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+
+  count_ += other.count_;
+  sum_ += other.sum_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+uint64_t Histogram::quantile(double q) const {
+  if (count_ == 0) {
+    return 0;
+  }
+
+  // rank is the 1-based rank of the value at |q| quantile.
+  auto rank = std::max(
+      static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_))),
+      uint64_t{1});
+  uint64_t n = 0;
+
+  for (size_t i = 0; i < HISTOGRAM_BUCKETLEN; ++i) {
+    n += counts_[i];
+    if (n >= rank) {
+      return std::clamp(histogram_bucket_upper_bound(i), min_, max_);
+    }
+  }
+
+  return max_;
+}
+
+uint64_t Histogram::count() const { return count_; }
+
+uint64_t Histogram::min() const { return count_ ? min_ : 0; }
+
+uint64_t Histogram::max() const { return max_; }
+
+uint64_t Histogram::mean() const { return count_ ? sum_ / count_ : 0; }
+
+} // namespace ngtcp2
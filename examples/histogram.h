@@ -0,0 +1,99 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ngtcp2 {
+
+// Histogram is a log-linear histogram in the style of HdrHistogram.
+// Values smaller than 2 * HISTOGRAM_SUB_BUCKETLEN are counted
+// exactly.  After that, each power of 2 range is split into
+// HISTOGRAM_SUB_BUCKETLEN buckets of equal width, so that the
+// relative error of a recorded value is less than 1 /
+// HISTOGRAM_SUB_BUCKETLEN.  It covers the whole range of uint64_t,
+// and it is intended to record durations in nanoseconds resolution.
+// Because the layout is fixed, histograms can be merged.
+class Histogram {
+public:
+  Histogram();
+
+  // record records |v|.
+  void record(uint64_t v);
+  // merge adds all values recorded in |other| to this histogram.
+  void merge(const Histogram &other);
+  // quantile returns the value at |q| quantile, where 0 <= |q| <= 1.
+  // The returned value is the largest value which is equivalent to
+  // the bucket that contains the quantile, capped by max().  It
+  // returns 0 if no value has been recorded.
+  uint64_t quantile(double q) const;
+
+  // count returns the number of recorded values.
+  uint64_t count() const;
+  // min returns the smallest recorded value.  It returns 0 if no
+  // value has been recorded.
+  uint64_t min() const;
+  // max returns the largest recorded value.
+  uint64_t max() const;
+  // mean returns the mean of recorded values.  It returns 0 if no
+  // value has been recorded.
+  uint64_t mean() const;
+
+private:
+  std::vector<uint64_t> counts_;
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t min_;
+  uint64_t max_;
+};
+
+// HISTOGRAM_SUB_BUCKET_BITS is the number of bits which determine the
+// bucket in a power of 2 range.
+constexpr size_t HISTOGRAM_SUB_BUCKET_BITS = 7;
+// HISTOGRAM_SUB_BUCKETLEN is the number of buckets in a power of 2
+// range.
+constexpr size_t HISTOGRAM_SUB_BUCKETLEN = 1 << HISTOGRAM_SUB_BUCKET_BITS;
+// HISTOGRAM_BUCKETLEN is the number of buckets in Histogram.
+constexpr size_t HISTOGRAM_BUCKETLEN =
+    (64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETLEN;
+
+// histogram_bucket_index returns the index of the bucket which |v|
+// falls into.
+size_t histogram_bucket_index(uint64_t v);
+
+// histogram_bucket_upper_bound returns the largest value which falls
+// into the bucket at |idx|.
+uint64_t histogram_bucket_upper_bound(size_t idx);
+
+} // namespace ngtcp2
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,126 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "histogram_test.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "histogram.h"
+
+namespace ngtcp2 {
+
+namespace {
+const MunitTest tests[]{
+    munit_void_test(test_histogram_bucket_index),
+    munit_void_test(test_histogram_quantile),
+    munit_void_test(test_histogram_merge),
+    munit_test_end(),
+};
+} // namespace
+
+const MunitSuite histogram_suite{
+    "/histogram", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE,
+};
+
+void test_histogram_bucket_index() {
+  constexpr auto umax = std::numeric_limits<uint64_t>::max();
+
+  // Small values are counted exactly.
+  assert_size(0, ==, histogram_bucket_index(0));
+  assert_size(255, ==, histogram_bucket_index(255));
+  assert_uint64(255, ==, histogram_bucket_upper_bound(255));
+
+  // From 256, each bucket covers 2 values, then 4, and so on.
+  assert_size(256, ==, histogram_bucket_index(256));
+  assert_size(256, ==, histogram_bucket_index(257));
+  assert_size(257, ==, histogram_bucket_index(258));
+  assert_uint64(257, ==, histogram_bucket_upper_bound(256));
+  assert_size(383, ==, histogram_bucket_index(511));
+  assert_size(384, ==, histogram_bucket_index(512));
+  assert_uint64(515, ==, histogram_bucket_upper_bound(384));
+
+  assert_size(HISTOGRAM_BUCKETLEN - 1, ==, histogram_bucket_index(umax));
+  assert_uint64(umax, ==,
+                histogram_bucket_upper_bound(HISTOGRAM_BUCKETLEN - 1));
+
+  // Buckets are contiguous, and the relative error is less than 1 /
+  // HISTOGRAM_SUB_BUCKETLEN.
+  for (size_t i = 1; i < HISTOGRAM_BUCKETLEN; ++i) {
+    auto lo = histogram_bucket_upper_bound(i - 1) + 1;
+    auto hi = histogram_bucket_upper_bound(i);
+
+    assert_size(i, ==, histogram_bucket_index(lo));
+    assert_size(i, ==, histogram_bucket_index(hi));
+    assert_uint64(hi - lo + 1, <=,
+                  std::max(lo / HISTOGRAM_SUB_BUCKETLEN, uint64_t{1}));
+  }
+}
+
+void test_histogram_quantile() {
+  Histogram h;
+
+  assert_uint64(0, ==, h.count());
+  assert_uint64(0, ==, h.min());
+  assert_uint64(0, ==, h.max());
+  assert_uint64(0, ==, h.mean());
+  assert_uint64(0, ==, h.quantile(0.5));
+
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    h.record(i * 1000);
+  }
+
+  assert_uint64(1000, ==, h.count());
+  assert_uint64(1000, ==, h.min());
+  assert_uint64(1000000, ==, h.max());
+  assert_uint64(500500, ==, h.mean());
+  // 1000 falls into a bucket of width 4.
+  assert_uint64(1003, ==, h.quantile(0));
+  assert_uint64(1000000, ==, h.quantile(1));
+
+  // 500000 falls into a bucket of width 2048, and 990000 falls into
+  // a bucket of width 4096.
+  assert_uint64(500000, <=, h.quantile(0.5));
+  assert_uint64(500000 + 2048, >, h.quantile(0.5));
+  assert_uint64(990000, <=, h.quantile(0.99));
+  assert_uint64(990000 + 4096, >, h.quantile(0.99));
+}
+
+void test_histogram_merge() {
+  Histogram a, b;
+
+  a.record(3);
+  b.record(100000);
+  b.record(100000);
+
+  a.merge(b);
+
+  assert_uint64(3, ==, a.count());
+  assert_uint64(3, ==, a.min());
+  assert_uint64(100000, ==, a.max());
+  assert_uint64(3, ==, a.quantile(0.3));
+  assert_uint64(100000, ==, a.quantile(0.5));
+}
+
+} // namespace ngtcp2
@@ -0,0 +1,143 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+/*
+ * qlogconv converts qlog written in NGTCP2_QLOG_FORMAT_BINARY format
+ * into JSON-SEQ format which qlog tools such as qvis can consume.
+ *
+ *   qlogconv [INPUT [OUTPUT]]
+ *
+ * If INPUT or OUTPUT is omitted or "-", stdin or stdout is used
+ * respectively.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <ngtcp2/ngtcp2.h>
+
+static void qlog_write(void *user_data, uint32_t flags, const void *data,
+                       size_t datalen) {
+  FILE *out = user_data;
+  (void)flags;
+
+  fwrite(data, 1, datalen, out);
+}
+
+int main(int argc, char **argv) {
+  FILE *in = stdin, *out = stdout;
+  uint8_t *buf = NULL, *p;
+  size_t bufcap = 0, buflen = 0, offset = 0, nread;
+  ngtcp2_ssize nconsumed;
+  int rv = EXIT_SUCCESS;
+
+  if (argc > 3) {
+    fprintf(stderr, "Usage: %s [INPUT [OUTPUT]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (argc > 1 && strcmp(argv[1], "-") != 0) {
+    in = fopen(argv[1], "rb");
+    if (in == NULL) {
+      fprintf(stderr, "Could not open %s: %s\n", argv[1], strerror(errno));
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (argc > 2 && strcmp(argv[2], "-") != 0) {
+    out = fopen(argv[2], "wb");
+    if (out == NULL) {
+      fprintf(stderr, "Could not open %s: %s\n", argv[2], strerror(errno));
+      rv = EXIT_FAILURE;
+      goto fin;
+    }
+  }
+
+  for (;;) {
+    if (buflen == bufcap) {
+      bufcap = bufcap ? bufcap * 2 : 64 * 1024;
+      p = realloc(buf, bufcap);
+      if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        rv = EXIT_FAILURE;
+        goto fin;
+      }
+
+      buf = p;
+    }
+
+    nread = fread(buf + buflen, 1, bufcap - buflen, in);
+    if (nread == 0) {
+      break;
+    }
+
+    buflen += nread;
+
+    for (p = buf; p != buf + buflen; p += nconsumed) {
+      nconsumed = ngtcp2_qlog_decode_binary(qlog_write, out, p,
+                                            (size_t)(buf + buflen - p));
+      if (nconsumed < 0) {
+        fprintf(stderr, "Malformed record at offset %zu\n",
+                offset + (size_t)(p - buf));
+        rv = EXIT_FAILURE;
+        goto fin;
+      }
+
+      if (nconsumed == 0) {
+        break;
+      }
+    }
+
+    offset += (size_t)(p - buf);
+    buflen = (size_t)(buf + buflen - p);
+    memmove(buf, p, buflen);
+  }
+
+  if (ferror(in)) {
+    fprintf(stderr, "Could not read input: %s\n", strerror(errno));
+    rv = EXIT_FAILURE;
+  } else if (buflen) {
+    fprintf(stderr, "Truncated record at offset %zu\n", offset);
+    rv = EXIT_FAILURE;
+  }
+
+fin:
+  free(buf);
+
+  if (out && out != stdout) {
+    fclose(out);
+  }
+
+  if (in != stdin) {
+    fclose(in);
+  }
+
+  return rv;
+}
@@ -43,6 +43,9 @@
 #include <netinet/udp.h>
 #include <net/if.h>
 #include <libgen.h>
+#ifdef HAVE_SCHED_SETAFFINITY
+#  include <sched.h>
+#endif // HAVE_SCHED_SETAFFINITY
 
 #include <http-parser/http_parser.h>
 
@@ -199,66 +202,6 @@ Request request_path(const std::string_view &uri, bool is_connect) {
 }
 } // namespace
 
-enum FileEntryFlag {
-  FILE_ENTRY_TYPE_DIR = 0x1,
-};
-
-struct FileEntry {
-  uint64_t len;
-  void *map;
-  int fd;
-  uint8_t flags;
-};
-
-namespace {
-std::unordered_map<std::string, FileEntry> file_cache;
-} // namespace
-
-std::pair<FileEntry, int> Stream::open_file(const std::string &path) {
-  auto it = file_cache.find(path);
-  if (it != std::end(file_cache)) {
-    return {(*it).second, 0};
-  }
-
-  auto fd = open(path.c_str(), O_RDONLY);
-  if (fd == -1) {
-    return {{}, -1};
-  }
-
-  struct stat st {};
-  if (fstat(fd, &st) != 0) {
-    close(fd);
-    return {{}, -1};
-  }
-
-  FileEntry fe{};
-  if (st.st_mode & S_IFDIR) {
-    fe.flags |= FILE_ENTRY_TYPE_DIR;
-    fe.fd = -1;
-    close(fd);
-  } else {
-    fe.fd = fd;
-    fe.len = st.st_size;
-    if (fe.len) {
-      fe.map = mmap(nullptr, fe.len, PROT_READ, MAP_SHARED, fd, 0);
-      if (fe.map == MAP_FAILED) {
-        std::cerr << "mmap: " << strerror(errno) << std::endl;
-        close(fd);
-        return {{}, -1};
-      }
-    }
-  }
-
-  file_cache.emplace(path, fe);
-
-  return {std::move(fe), 0};
-}
-
-void Stream::map_file(const FileEntry &fe) {
-  data = static_cast<uint8_t *>(fe.map);
-  datalen = fe.len;
-}
-
 int64_t Stream::find_dyn_length(const std::string_view &path) {
   assert(path[0] == '/');
 
@@ -432,44 +375,36 @@ int Stream::start_response(nghttp3_conn *httpconn) {
 
   auto dyn_len = find_dyn_length(req.path);
 
-  int64_t content_length = -1;
+  std::string content_length_str;
+  std::string_view content_length;
   nghttp3_data_reader dr{};
   auto content_type = "text/plain"sv;
 
   if (dyn_len == -1) {
     auto path = config.htdocs + req.path;
-    auto [fe, rv] = open_file(path);
-    if (rv != 0) {
+    file = handler->server()->file_cache().get(path, util::timestamp());
+    if (!file) {
       send_status_response(httpconn, 404);
       return 0;
     }
 
-    if (fe.flags & FILE_ENTRY_TYPE_DIR) {
+    if (file->flags & FILE_ENTRY_TYPE_DIR) {
       send_redirect_response(httpconn, 308,
                              path.substr(config.htdocs.size() - 1) + '/');
       return 0;
     }
 
-    content_length = fe.len;
-
     if (method != "HEAD") {
-      map_file(fe);
+      data = const_cast<uint8_t *>(file->data);
+      datalen = file->len;
     }
 
     dr.read_data = read_data;
-
-    auto ext = std::end(req.path) - 1;
-    for (; ext != std::begin(req.path) && *ext != '.' && *ext != '/'; --ext)
-      ;
-    if (*ext == '.') {
-      ++ext;
-      auto it = config.mime_types.find(std::string{ext, std::end(req.path)});
-      if (it != std::end(config.mime_types)) {
-        content_type = (*it).second;
-      }
-    }
+    content_length = file->content_length;
+    content_type = file->content_type;
   } else {
-    content_length = dyn_len;
+    content_length_str = util::format_uint(dyn_len);
+    content_length = content_length_str;
     dynresp = true;
     dr.read_data = dyn_read_data;
 
@@ -481,13 +416,11 @@ int Stream::start_response(nghttp3_conn *httpconn) {
     content_type = "application/octet-stream"sv;
   }
 
-  auto content_length_str = util::format_uint(content_length);
-
   std::array<nghttp3_nv, 5> nva{
       util::make_nv_nn(":status"sv, "200"sv),
       util::make_nv_nn("server"sv, NGTCP2_SERVER),
       util::make_nv_nn("content-type"sv, content_type),
-      util::make_nv_nc("content-length"sv, content_length_str),
+      util::make_nv_nc("content-length"sv, content_length),
   };
 
   size_t nvlen = 4;
@@ -566,7 +499,9 @@ void writecb(struct ev_loop *loop, ev_io *w, int revents) {
 
   switch (h->on_write()) {
   case 0:
+    return;
   case NETWORK_ERR_CLOSE_WAIT:
+    s->start_close_wait(h);
     return;
   default:
     s->remove(h);
@@ -574,33 +509,6 @@ void writecb(struct ev_loop *loop, ev_io *w, int revents) {
 }
 } // namespace
 
-namespace {
-void close_waitcb(struct ev_loop *loop, ev_timer *w, int revents) {
-  auto h = static_cast<Handler *>(w->data);
-  auto s = h->server();
-  auto conn = h->conn();
-
-  if (ngtcp2_conn_in_closing_period(conn)) {
-    if (!config.quiet) {
-      std::cerr << "Closing Period is over" << std::endl;
-    }
-
-    s->remove(h);
-    return;
-  }
-  if (ngtcp2_conn_in_draining_period(conn)) {
-    if (!config.quiet) {
-      std::cerr << "Draining Period is over" << std::endl;
-    }
-
-    s->remove(h);
-    return;
-  }
-
-  assert(0);
-}
-} // namespace
-
 namespace {
 void timeoutcb(struct ev_loop *loop, ev_timer *w, int revents) {
   int rv;
@@ -627,7 +535,7 @@ void timeoutcb(struct ev_loop *loop, ev_timer *w, int revents) {
 fail:
   switch (rv) {
   case NETWORK_ERR_CLOSE_WAIT:
-    ev_timer_stop(loop, w);
+    s->start_close_wait(h);
     return;
   default:
     s->remove(h);
@@ -1480,14 +1388,24 @@ int Handler::init(const Endpoint &ep, const Address &local_addr,
     auto path = std::string{config.qlog_dir};
     path += '/';
     path += util::format_hex({scid_.data, scid_.datalen});
-    path += ".sqlog";
-    qlog_ = fopen(path.c_str(), "w");
+    path += config.qlog_binary ? ".bqlog" : ".sqlog";
+    qlog_ = fopen(path.c_str(), "wb");
     if (qlog_ == nullptr) {
       std::cerr << "Could not open qlog file " << std::quoted(path) << ": "
                 << strerror(errno) << std::endl;
       return -1;
     }
     settings.qlog_write = ::write_qlog;
+    if (config.qlog_binary) {
+      settings.qlog_format = NGTCP2_QLOG_FORMAT_BINARY;
+    }
+    if (config.qlog_flight_recorder_size) {
+      settings.qlog_flight_recorder_size = config.qlog_flight_recorder_size;
+      settings.qlog_flight_recorder_pto_count = 3;
+    }
+    settings.qlog_filter = config.qlog_filter;
+    settings.qlog_metrics_interval = config.qlog_metrics_interval;
+    settings.qlog_pkt_sample_rate = config.qlog_pkt_sample_rate;
   }
   if (!config.preferred_versions.empty()) {
     settings.preferred_versions = config.preferred_versions.data();
@@ -1593,6 +1511,30 @@ int Handler::init(const Endpoint &ep, const Address &local_addr,
     return -1;
   }
 
+  if (config.careful_resume) {
+    if (auto ent = server_->find_path_capacity(sa, settings.initial_ts); ent) {
+      if (auto rv = ngtcp2_conn_set_path_capacity(conn_, &ent->cap); rv != 0) {
+        std::cerr << "ngtcp2_conn_set_path_capacity: " << ngtcp2_strerror(rv)
+                  << std::endl;
+        return -1;
+      }
+
+      if (ent->max_udp_payload_size > NGTCP2_MAX_UDP_PAYLOAD_SIZE) {
+        if (auto rv =
+                ngtcp2_conn_set_pmtud_hint(conn_, ent->max_udp_payload_size);
+            rv != 0) {
+          std::cerr << "ngtcp2_conn_set_pmtud_hint: " << ngtcp2_strerror(rv)
+                    << std::endl;
+          return -1;
+        }
+      }
+    }
+  }
+
+  if (auto tw = server_->timer_wheel(); tw) {
+    ngtcp2_conn_set_timer_wheel(conn_, tw);
+  }
+
   if (tls_session_.init(tls_ctx, this) != 0) {
     return -1;
   }
@@ -1608,7 +1550,7 @@ int Handler::init(const Endpoint &ep, const Address &local_addr,
 
 int Handler::feed_data(const Endpoint &ep, const Address &local_addr,
                        const sockaddr *sa, socklen_t salen,
-                       const ngtcp2_pkt_info *pi,
+                       const ngtcp2_pkt_info *pi, ngtcp2_tstamp pkt_ts,
                        std::span<const uint8_t> data) {
   auto path = ngtcp2_path{
       {
@@ -1622,13 +1564,14 @@ int Handler::feed_data(const Endpoint &ep, const Address &local_addr,
       const_cast<Endpoint *>(&ep),
   };
 
-  if (auto rv = ngtcp2_conn_read_pkt(conn_, &path, pi, data.data(), data.size(),
-                                     util::timestamp());
+  if (auto rv = ngtcp2_conn_read_timestamped_pkt(
+          conn_, &path, pi, data.data(), data.size(), pkt_ts,
+          util::timestamp());
       rv != 0) {
-    std::cerr << "ngtcp2_conn_read_pkt: " << ngtcp2_strerror(rv) << std::endl;
+    std::cerr << "ngtcp2_conn_read_timestamped_pkt: " << ngtcp2_strerror(rv)
+              << std::endl;
     switch (rv) {
     case NGTCP2_ERR_DRAINING:
-      start_draining_period();
       return NETWORK_ERR_CLOSE_WAIT;
     case NGTCP2_ERR_RETRY:
       return NETWORK_ERR_RETRY;
@@ -1653,8 +1596,10 @@ int Handler::feed_data(const Endpoint &ep, const Address &local_addr,
 
 int Handler::on_read(const Endpoint &ep, const Address &local_addr,
                      const sockaddr *sa, socklen_t salen,
-                     const ngtcp2_pkt_info *pi, std::span<const uint8_t> data) {
-  if (auto rv = feed_data(ep, local_addr, sa, salen, pi, data); rv != 0) {
+                     const ngtcp2_pkt_info *pi, ngtcp2_tstamp pkt_ts,
+                     std::span<const uint8_t> data) {
+  if (auto rv = feed_data(ep, local_addr, sa, salen, pi, pkt_ts, data);
+      rv != 0) {
     return rv;
   }
 
@@ -1712,9 +1657,16 @@ int Handler::write_streams() {
   ngtcp2_pkt_info pi;
   size_t gso_size = 0;
   auto ts = util::timestamp();
-  auto txbuf =
-      std::span{tx_.data.get(), std::max(ngtcp2_conn_get_send_quantum(conn_),
-                                         path_max_udp_payload_size)};
+  // Limit the burst to the full sized packets that fit in a single
+  // GSO send.  With jumbo frames, only a few packets fit.
+  auto max_txbuflen = std::max(
+      std::min(NGTCP2_MAX_GSO_DATALEN,
+               path_max_udp_payload_size * NGTCP2_MAX_GSO_SEGMENTS) /
+          path_max_udp_payload_size * path_max_udp_payload_size,
+      path_max_udp_payload_size);
+  auto txbuf = std::span{
+      tx_.data.get(), std::clamp(ngtcp2_conn_get_send_quantum(conn_),
+                                 path_max_udp_payload_size, max_txbuflen)};
   auto buf = txbuf;
 
   ngtcp2_path_storage_zero(&ps);
@@ -1970,20 +1922,6 @@ int Handler::send_blocked_packet() {
 
 void Handler::signal_write() { ev_io_start(loop_, &wev_); }
 
-void Handler::start_draining_period() {
-  ev_io_stop(loop_, &wev_);
-
-  ev_set_cb(&timer_, close_waitcb);
-  timer_.repeat =
-      static_cast<ev_tstamp>(ngtcp2_conn_get_pto(conn_)) / NGTCP2_SECONDS * 3;
-  ev_timer_again(loop_, &timer_);
-
-  if (!config.quiet) {
-    std::cerr << "Draining period has started (" << timer_.repeat << " seconds)"
-              << std::endl;
-  }
-}
-
 int Handler::start_closing_period() {
   if (!conn_ || ngtcp2_conn_in_closing_period(conn_) ||
       ngtcp2_conn_in_draining_period(conn_)) {
@@ -1992,16 +1930,6 @@ int Handler::start_closing_period() {
 
   ev_io_stop(loop_, &wev_);
 
-  ev_set_cb(&timer_, close_waitcb);
-  timer_.repeat =
-      static_cast<ev_tstamp>(ngtcp2_conn_get_pto(conn_)) / NGTCP2_SECONDS * 3;
-  ev_timer_again(loop_, &timer_);
-
-  if (!config.quiet) {
-    std::cerr << "Closing period has started (" << timer_.repeat << " seconds)"
-              << std::endl;
-  }
-
   conn_closebuf_ = std::make_unique<Buffer>(NGTCP2_MAX_UDP_PAYLOAD_SIZE);
 
   ngtcp2_path_storage ps;
@@ -2027,6 +1955,14 @@ int Handler::start_closing_period() {
   return 0;
 }
 
+std::span<const uint8_t> Handler::conn_close_pkt() const {
+  if (!conn_closebuf_) {
+    return {};
+  }
+
+  return conn_closebuf_->data();
+}
+
 int Handler::handle_error() {
   if (last_error_.type == NGTCP2_CCERR_TYPE_IDLE_CLOSE) {
     return -1;
@@ -2064,6 +2000,11 @@ int Handler::send_conn_close() {
 }
 
 void Handler::update_timer() {
+  if (server_->timer_wheel()) {
+    server_->update_timer();
+    return;
+  }
+
   auto expiry = ngtcp2_conn_get_expiry(conn_);
   auto now = util::timestamp();
 
@@ -2194,6 +2135,14 @@ void sreadcb(struct ev_loop *loop, ev_io *w, int revents) {
 }
 } // namespace
 
+namespace {
+void swritecb(struct ev_loop *loop, ev_io *w, int revents) {
+  auto ep = static_cast<Endpoint *>(w->data);
+
+  ep->server->on_endpoint_writable(*ep);
+}
+} // namespace
+
 namespace {
 void siginthandler(struct ev_loop *loop, ev_signal *watcher, int revents) {
   ev_break(loop, EVBREAK_ALL);
@@ -2201,9 +2150,17 @@ void siginthandler(struct ev_loop *loop, ev_signal *watcher, int revents) {
 } // namespace
 
 Server::Server(struct ev_loop *loop, TLSServerContext &tls_ctx)
-    : loop_(loop),
+    : handlers_(std::uniform_int_distribution<uint64_t>()(randgen)),
+      closed_(std::uniform_int_distribution<uint64_t>()(randgen)),
+      loop_(loop),
       tls_ctx_(tls_ctx),
-      stateless_reset_bucket_(NGTCP2_STATELESS_RESET_BURST) {
+      stateless_reset_bucket_(NGTCP2_STATELESS_RESET_BURST),
+      tw_(nullptr),
+      timer_expiry_(UINT64_MAX),
+      txq_{},
+      io_stats_{},
+      file_cache_(config.file_cache_size, config.file_cache_validity,
+                  config.mime_types) {
   ev_signal_init(&sigintev_, siginthandler, SIGINT);
 
   ev_timer_init(
@@ -2215,11 +2172,41 @@ Server::Server(struct ev_loop *loop, TLSServerContext &tls_ctx)
       },
       0., 1.);
   stateless_reset_regen_timer_.data = this;
+
+  ev_prepare_init(&txq_prep_, [](struct ev_loop *loop, ev_prepare *w,
+                                 int revents) {
+    auto server = static_cast<Server *>(w->data);
+
+    server->flush_tx_queue();
+  });
+  txq_prep_.data = this;
+
+  ev_timer_init(
+      &timer_,
+      [](struct ev_loop *loop, ev_timer *w, int revents) {
+        auto server = static_cast<Server *>(w->data);
+
+        server->on_timer();
+      },
+      0., 0.);
+  timer_.data = this;
+
+  ev_timer_init(
+      &close_wait_timer_,
+      [](struct ev_loop *loop, ev_timer *w, int revents) {
+        auto server = static_cast<Server *>(w->data);
+
+        server->on_close_wait_timer();
+      },
+      0., 0.);
+  close_wait_timer_.data = this;
 }
 
 Server::~Server() {
   disconnect();
   close();
+
+  ngtcp2_timer_wheel_del(tw_);
 }
 
 void Server::disconnect() {
@@ -2227,19 +2214,42 @@ void Server::disconnect() {
 
   for (auto &ep : endpoints_) {
     ev_io_stop(loop_, &ep.rev);
+    ev_io_stop(loop_, &ep.wev);
+  }
+
+  ev_prepare_stop(loop_, &txq_prep_);
+
+#ifdef HAVE_LIBURING
+  if (uring_) {
+    uring_->stop();
   }
+#endif // HAVE_LIBURING
+
+#ifdef HAVE_AF_XDP
+  if (xdp_) {
+    xdp_->stop();
+  }
+#endif // HAVE_AF_XDP
 
   ev_timer_stop(loop_, &stateless_reset_regen_timer_);
+  ev_timer_stop(loop_, &timer_);
   ev_signal_stop(loop_, &sigintev_);
 
-  while (!handlers_.empty()) {
-    auto it = std::begin(handlers_);
-    auto &h = (*it).second;
-
+  handlers_.for_each([this](Handler *h) {
     h->handle_error();
 
     remove(h);
+  });
+
+  ev_timer_stop(loop_, &close_wait_timer_);
+
+  for (auto &cc : close_wait_) {
+    for (auto &cid : cc->scids) {
+      closed_.erase({cid.data, cid.datalen});
+    }
   }
+
+  close_wait_.clear();
 }
 
 void Server::close() {
@@ -2250,6 +2260,32 @@ void Server::close() {
   endpoints_.clear();
 }
 
+namespace {
+// fd_set_cpu_options sets the socket options for --cpu to |fd|.  It
+// returns -1 if SO_REUSEPORT cannot be set.
+int fd_set_cpu_options(int fd) {
+  if (config.cpu == -1) {
+    return 0;
+  }
+
+  int val = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &val,
+                 static_cast<socklen_t>(sizeof(val))) == -1) {
+    std::cerr << "setsockopt: SO_REUSEPORT: " << strerror(errno)
+              << std::endl;
+    return -1;
+  }
+
+  fd_set_incoming_cpu(fd, config.cpu);
+
+  if (config.steer_by_cpu) {
+    fd_attach_reuseport_cpu_prog(fd);
+  }
+
+  return 0;
+}
+} // namespace
+
 namespace {
 int create_sock(Address &local_addr, const char *addr, const char *port,
                 int family) {
@@ -2305,7 +2341,13 @@ int create_sock(Address &local_addr, const char *addr, const char *port,
       continue;
     }
 
+    if (fd_set_cpu_options(fd) != 0) {
+      close(fd);
+      continue;
+    }
+
     fd_set_recv_ecn(fd, rp->ai_family);
+    fd_set_recv_timestamp(fd);
     fd_set_ip_mtu_discover(fd, rp->ai_family);
     fd_set_ip_dontfrag(fd, family);
 
@@ -2349,6 +2391,7 @@ int add_endpoint(std::vector<Endpoint> &endpoints, const char *addr,
   ep.addr = dest;
   ep.fd = fd;
   ev_io_init(&ep.rev, sreadcb, 0, EV_READ);
+  ev_io_init(&ep.wev, swritecb, 0, EV_WRITE);
 
   return 0;
 }
@@ -2390,7 +2433,13 @@ int add_endpoint(std::vector<Endpoint> &endpoints, const Address &addr) {
     return -1;
   }
 
+  if (fd_set_cpu_options(fd) != 0) {
+    close(fd);
+    return -1;
+  }
+
   fd_set_recv_ecn(fd, addr.su.sa.sa_family);
+  fd_set_recv_timestamp(fd);
   fd_set_ip_mtu_discover(fd, addr.su.sa.sa_family);
   fd_set_ip_dontfrag(fd, addr.su.sa.sa_family);
 
@@ -2405,6 +2454,7 @@ int add_endpoint(std::vector<Endpoint> &endpoints, const Address &addr) {
   ep.addr = addr;
   ep.fd = fd;
   ev_io_init(&ep.rev, sreadcb, 0, EV_READ);
+  ev_io_init(&ep.wev, swritecb, 0, EV_WRITE);
 
   return 0;
 }
@@ -2435,17 +2485,59 @@ int Server::init(const char *addr, const char *port) {
     return -1;
   }
 
+#ifdef HAVE_LIBURING
+  if (config.io_uring) {
+    uring_ = std::make_unique<Uring>(loop_, this);
+    if (uring_->init() != 0) {
+      return -1;
+    }
+  }
+#endif // HAVE_LIBURING
+
   for (auto &ep : endpoints_) {
     ep.server = this;
     ep.rev.data = &ep;
+    ep.wev.data = &ep;
+
+    ev_io_set(&ep.wev, ep.fd, EV_WRITE);
+
+#ifdef HAVE_LIBURING
+    if (uring_) {
+      uring_->start_recv(ep);
+      continue;
+    }
+#endif // HAVE_LIBURING
 
     ev_io_set(&ep.rev, ep.fd, EV_READ);
 
     ev_io_start(loop_, &ep.rev);
   }
 
+#ifdef HAVE_AF_XDP
+  if (!config.af_xdp.empty()) {
+    xdp_ = std::make_unique<Xdp>(loop_, this);
+    if (xdp_->init(config.af_xdp, endpoints_) != 0) {
+      return -1;
+    }
+  }
+#endif // HAVE_AF_XDP
+
   ev_signal_start(loop_, &sigintev_);
 
+  if (config.sendmmsg) {
+    ev_prepare_start(loop_, &txq_prep_);
+  }
+
+  if (config.timer_wheel) {
+    if (auto rv = ngtcp2_timer_wheel_new(&tw_, NGTCP2_MILLISECONDS,
+                                         util::timestamp(), nullptr);
+        rv != 0) {
+      std::cerr << "ngtcp2_timer_wheel_new: " << ngtcp2_strerror(rv)
+                << std::endl;
+      return -1;
+    }
+  }
+
   return 0;
 }
 
@@ -2453,7 +2545,6 @@ int Server::on_read(Endpoint &ep) {
   sockaddr_union su;
   std::array<uint8_t, 64_k - 1> buf;
   size_t pktcnt = 0;
-  ngtcp2_pkt_info pi;
 
   iovec msg_iov;
   msg_iov.iov_base = buf.data();
@@ -2465,7 +2556,8 @@ int Server::on_read(Endpoint &ep) {
   msg.msg_iovlen = 1;
 
   uint8_t msg_ctrl[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(in6_pktinfo)) +
-                   CMSG_SPACE(sizeof(uint16_t))];
+                   CMSG_SPACE(sizeof(uint16_t)) +
+                   CMSG_SPACE(sizeof(timespec))];
   msg.msg_control = msg_ctrl;
 
   for (; pktcnt < 10;) {
@@ -2473,6 +2565,9 @@ int Server::on_read(Endpoint &ep) {
     msg.msg_controllen = sizeof(msg_ctrl);
 
     auto nread = recvmsg(ep.fd, &msg, 0);
+
+    ++io_stats_.syscalls;
+
     if (nread == -1) {
       if (!(errno == EAGAIN || errno == ENOTCONN)) {
         std::cerr << "recvmsg: " << strerror(errno) << std::endl;
@@ -2480,76 +2575,84 @@ int Server::on_read(Endpoint &ep) {
       return 0;
     }
 
-    // Packets less than 22 bytes never be a valid QUIC packet.
-    if (nread < 22) {
-      ++pktcnt;
+    pktcnt += on_read_msg(ep, msg, {buf.data(), static_cast<size_t>(nread)});
+  }
 
-      continue;
-    }
+  return 0;
+}
 
-    if (util::prohibited_port(util::port(&su))) {
-      ++pktcnt;
+size_t Server::on_read_msg(Endpoint &ep, msghdr &msg,
+                           std::span<const uint8_t> data) {
+  auto su = static_cast<sockaddr_union *>(msg.msg_name);
+  size_t pktcnt = 0;
+  ngtcp2_pkt_info pi;
 
-      continue;
-    }
+  // Packets less than 22 bytes never be a valid QUIC packet.
+  if (data.size() < 22) {
+    return 1;
+  }
 
-    pi.ecn = msghdr_get_ecn(&msg, su.storage.ss_family);
-    auto local_addr = msghdr_get_local_addr(&msg, su.storage.ss_family);
-    if (!local_addr) {
-      ++pktcnt;
-      std::cerr << "Unable to obtain local address" << std::endl;
-      continue;
-    }
+  if (util::prohibited_port(util::port(su))) {
+    return 1;
+  }
 
-    auto gso_size = msghdr_get_udp_gro(&msg);
-    if (gso_size == 0) {
-      gso_size = static_cast<size_t>(nread);
-    }
+  pi.ecn = msghdr_get_ecn(&msg, su->storage.ss_family);
+  auto local_addr = msghdr_get_local_addr(&msg, su->storage.ss_family);
+  if (!local_addr) {
+    std::cerr << "Unable to obtain local address" << std::endl;
+    return 1;
+  }
 
-    set_port(*local_addr, ep.addr);
+  auto gso_size = msghdr_get_udp_gro(&msg);
+  if (gso_size == 0) {
+    gso_size = data.size();
+  }
 
-    auto data = std::span{buf.data(), static_cast<size_t>(nread)};
+  set_port(*local_addr, ep.addr);
 
-    for (; !data.empty();) {
-      auto datalen = std::min(data.size(), gso_size);
+  // All packets coalesced by UDP GRO share the same timestamp.
+  auto pkt_ts = msghdr_get_recv_timestamp(&msg, util::timestamp());
 
-      ++pktcnt;
+  for (; !data.empty();) {
+    auto datalen = std::min(data.size(), gso_size);
 
-      if (!config.quiet) {
-        std::array<char, IF_NAMESIZE> ifname;
-        std::cerr << "Received packet: local="
-                  << util::straddr(&local_addr->su.sa, local_addr->len)
-                  << " remote=" << util::straddr(&su.sa, msg.msg_namelen)
-                  << " if="
-                  << if_indextoname(local_addr->ifindex, ifname.data())
-                  << " ecn=0x" << std::hex << static_cast<uint32_t>(pi.ecn)
-                  << std::dec << " " << datalen << " bytes" << std::endl;
-      }
+    ++pktcnt;
 
-      // Packets less than 22 bytes never be a valid QUIC packet.
-      if (datalen < 22) {
-        break;
-      }
+    if (!config.quiet) {
+      std::array<char, IF_NAMESIZE> ifname;
+      std::cerr << "Received packet: local="
+                << util::straddr(&local_addr->su.sa, local_addr->len)
+                << " remote=" << util::straddr(&su->sa, msg.msg_namelen)
+                << " if=" << if_indextoname(local_addr->ifindex, ifname.data())
+                << " ecn=0x" << std::hex << static_cast<uint32_t>(pi.ecn)
+                << std::dec << " " << datalen << " bytes" << std::endl;
+    }
 
-      if (debug::packet_lost(config.rx_loss_prob)) {
-        if (!config.quiet) {
-          std::cerr << "** Simulated incoming packet loss **" << std::endl;
-        }
-      } else {
-        read_pkt(ep, *local_addr, &su.sa, msg.msg_namelen, &pi,
-                 {data.data(), datalen});
-      }
+    // Packets less than 22 bytes never be a valid QUIC packet.
+    if (datalen < 22) {
+      break;
+    }
 
-      data = data.subspan(datalen);
+    if (debug::packet_lost(config.rx_loss_prob)) {
+      if (!config.quiet) {
+        std::cerr << "** Simulated incoming packet loss **" << std::endl;
+      }
+    } else {
+      read_pkt(ep, *local_addr, &su->sa, msg.msg_namelen, &pi, pkt_ts,
+               {data.data(), datalen});
     }
+
+    data = data.subspan(datalen);
   }
 
-  return 0;
+  io_stats_.pkts += pktcnt;
+
+  return pktcnt;
 }
 
 void Server::read_pkt(Endpoint &ep, const Address &local_addr,
                       const sockaddr *sa, socklen_t salen,
-                      const ngtcp2_pkt_info *pi,
+                      const ngtcp2_pkt_info *pi, ngtcp2_tstamp pkt_ts,
                       std::span<const uint8_t> data) {
   ngtcp2_version_cid vc;
 
@@ -2568,10 +2671,15 @@ void Server::read_pkt(Endpoint &ep, const Address &local_addr,
     return;
   }
 
-  auto dcid_key = util::make_cid_key({vc.dcid, vc.dcidlen});
+  auto dcid = std::span{vc.dcid, vc.dcidlen};
+
+  auto ph = handlers_.find(dcid);
+  if (!ph) {
+    if (auto pcc = closed_.find(dcid); pcc) {
+      on_closed_conn_pkt(**pcc);
+      return;
+    }
 
-  auto handler_it = handlers_.find(dcid_key);
-  if (handler_it == std::end(handlers_)) {
     ngtcp2_pkt_hd hd;
 
     if (auto rv = ngtcp2_accept(&hd, data.data(), data.size()); rv != 0) {
@@ -2653,7 +2761,7 @@ void Server::read_pkt(Endpoint &ep, const Address &local_addr,
       return;
     }
 
-    switch (h->on_read(ep, local_addr, sa, salen, pi, data)) {
+    switch (h->on_read(ep, local_addr, sa, salen, pi, pkt_ts, data)) {
     case 0:
       break;
     case NETWORK_ERR_RETRY:
@@ -2680,26 +2788,18 @@ void Server::read_pkt(Endpoint &ep, const Address &local_addr,
       associate_cid(&scids[i], h.get());
     }
 
-    handlers_.emplace(dcid_key, h.release());
+    handlers_.insert(dcid, h.release());
 
     return;
   }
 
-  auto h = (*handler_it).second;
-  auto conn = h->conn();
-  if (ngtcp2_conn_in_closing_period(conn)) {
-    // TODO do exponential backoff.
-    if (h->send_conn_close() != 0) {
-      remove(h);
-    }
-    return;
-  }
-  if (ngtcp2_conn_in_draining_period(conn)) {
-    return;
-  }
+  auto h = *ph;
 
-  if (auto rv = h->on_read(ep, local_addr, sa, salen, pi, data); rv != 0) {
-    if (rv != NETWORK_ERR_CLOSE_WAIT) {
+  if (auto rv = h->on_read(ep, local_addr, sa, salen, pi, pkt_ts, data);
+      rv != 0) {
+    if (rv == NETWORK_ERR_CLOSE_WAIT) {
+      start_close_wait(h);
+    } else {
       remove(h);
     }
     return;
@@ -3062,6 +3162,16 @@ Server::send_packet(Endpoint &ep, bool &no_gso, const ngtcp2_addr &local_addr,
     return {{}, NETWORK_ERR_OK};
   }
 
+#ifdef HAVE_LIBURING
+  if (uring_ && uring_->no_gso()) {
+    no_gso = true;
+  }
+#endif // HAVE_LIBURING
+
+  if (txq_.no_gso) {
+    no_gso = true;
+  }
+
   if (no_gso && data.size() > gso_size) {
     for (; !data.empty();) {
       auto len = std::min(gso_size, data.size());
@@ -3078,6 +3188,31 @@ Server::send_packet(Endpoint &ep, bool &no_gso, const ngtcp2_addr &local_addr,
     return {{}, 0};
   }
 
+#ifdef HAVE_AF_XDP
+  if (xdp_) {
+    switch (xdp_->send(local_addr, remote_addr, ecn, data, gso_size)) {
+    case 0:
+      io_stats_.pkts += (data.size() + gso_size - 1) / gso_size;
+
+      if (!config.quiet) {
+        std::cerr << "Sent packet via AF_XDP: local="
+                  << util::straddr(local_addr.addr, local_addr.addrlen)
+                  << " remote="
+                  << util::straddr(remote_addr.addr, remote_addr.addrlen)
+                  << " ecn=0x" << std::hex << ecn << std::dec << " "
+                  << data.size() << " bytes" << std::endl;
+      }
+
+      return {{}, NETWORK_ERR_OK};
+    case NETWORK_ERR_SEND_BLOCKED:
+      return {data, NETWORK_ERR_SEND_BLOCKED};
+    }
+
+    // The remote endpoint has not been seen on the interface.  Send
+    // data through the socket.
+  }
+#endif // HAVE_AF_XDP
+
   iovec msg_iov;
   msg_iov.iov_base = const_cast<uint8_t *>(data.data());
   msg_iov.iov_len = data.size();
@@ -3165,9 +3300,28 @@ Server::send_packet(Endpoint &ep, bool &no_gso, const ngtcp2_addr &local_addr,
 
   ssize_t nwrite = 0;
 
-  do {
-    nwrite = sendmsg(ep.fd, &msg, 0);
-  } while (nwrite == -1 && errno == EINTR);
+#ifdef HAVE_LIBURING
+  if (uring_) {
+    // The result of the send is reported asynchronously.
+    uring_->sendmsg(ep.fd, msg);
+    nwrite = static_cast<ssize_t>(data.size());
+  } else
+#endif // HAVE_LIBURING
+  if (config.sendmmsg) {
+    // The datagram is sent by flush_tx_queue at the end of this event
+    // loop iteration.
+    if (!queue_msg(ep, msg, data.size() > gso_size)) {
+      return {data, NETWORK_ERR_SEND_BLOCKED};
+    }
+
+    nwrite = static_cast<ssize_t>(data.size());
+  } else {
+    do {
+      nwrite = sendmsg(ep.fd, &msg, 0);
+
+      ++io_stats_.syscalls;
+    } while (nwrite == -1 && errno == EINTR);
+  }
 
   if (nwrite == -1) {
     switch (errno) {
@@ -3198,6 +3352,8 @@ Server::send_packet(Endpoint &ep, bool &no_gso, const ngtcp2_addr &local_addr,
     return {{}, NETWORK_ERR_OK};
   }
 
+  io_stats_.pkts += (data.size() + gso_size - 1) / gso_size;
+
   if (!config.quiet) {
     std::cerr << "Sent packet: local="
               << util::straddr(local_addr.addr, local_addr.addrlen)
@@ -3210,21 +3366,176 @@ Server::send_packet(Endpoint &ep, bool &no_gso, const ngtcp2_addr &local_addr,
   return {{}, NETWORK_ERR_OK};
 }
 
-void Server::associate_cid(const ngtcp2_cid *cid, Handler *h) {
-  handlers_.emplace(util::make_cid_key(cid), h);
-}
+namespace {
+// TXQ_MAX_BUFLEN is the maximum number of bytes queued by --sendmmsg.
+// A handler which sends beyond this limit is blocked.
+constexpr size_t TXQ_MAX_BUFLEN = 4_m;
+// TXQ_MAX_BATCH is the maximum number of datagrams passed to a single
+// sendmmsg call.
+constexpr size_t TXQ_MAX_BATCH = 64;
+} // namespace
 
-void Server::dissociate_cid(const ngtcp2_cid *cid) {
-  handlers_.erase(std::string{util::make_cid_key(cid)});
-}
+bool Server::queue_msg(Endpoint &ep, const msghdr &msg, bool gso) {
+  assert(msg.msg_iovlen == 1);
 
-void Server::remove(const Handler *h) {
-  auto conn = h->conn();
+  auto &iov = msg.msg_iov[0];
 
-  dissociate_cid(ngtcp2_conn_get_client_initial_dcid(conn));
+  // Block the handler while ep is not writable, so that the queue
+  // does not grow without bound.
+  if (ev_is_active(&ep.wev) ||
+      txq_.buf.size() + iov.iov_len > TXQ_MAX_BUFLEN) {
+    return false;
+  }
 
-  std::vector<ngtcp2_cid> cids(ngtcp2_conn_get_scid(conn, nullptr));
-  ngtcp2_conn_get_scid(conn, cids.data());
+  auto &m = txq_.msgs.emplace_back();
+
+  m.endpoint = &ep;
+  memcpy(&m.name, msg.msg_name, msg.msg_namelen);
+  m.namelen = msg.msg_namelen;
+  assert(msg.msg_controllen <= m.ctrl.size());
+  memcpy(m.ctrl.data(), msg.msg_control, msg.msg_controllen);
+  m.controllen = msg.msg_controllen;
+  m.offset = txq_.buf.size();
+  m.len = iov.iov_len;
+  m.gso = gso;
+
+  auto p = static_cast<const uint8_t *>(iov.iov_base);
+
+  txq_.buf.insert(std::end(txq_.buf), p, p + iov.iov_len);
+
+  return true;
+}
+
+void Server::flush_tx_queue() {
+  std::array<mmsghdr, TXQ_MAX_BATCH> mmsgs;
+  std::array<iovec, TXQ_MAX_BATCH> iovs;
+  auto &msgs = txq_.msgs;
+  // nkept is the number of datagrams which stay in the queue.
+  size_t nkept = 0;
+  size_t keptlen = 0;
+
+  for (size_t i = 0; i < msgs.size();) {
+    auto ep = msgs[i].endpoint;
+
+    if (ev_is_active(&ep->wev)) {
+      // ep is blocked.  Keep the datagram in order.
+      auto &m = msgs[i++];
+
+      memmove(txq_.buf.data() + keptlen, txq_.buf.data() + m.offset, m.len);
+      m.offset = keptlen;
+      keptlen += m.len;
+      msgs[nkept++] = m;
+
+      continue;
+    }
+
+    // Send the consecutive datagrams to ep in a batch.
+    size_t n = 0;
+
+    for (; i + n < msgs.size() && n < TXQ_MAX_BATCH &&
+           msgs[i + n].endpoint == ep;
+         ++n) {
+      auto &m = msgs[i + n];
+      auto &iov = iovs[n];
+
+      iov.iov_base = txq_.buf.data() + m.offset;
+      iov.iov_len = m.len;
+
+      auto &hdr = mmsgs[n].msg_hdr;
+
+      hdr = {};
+      hdr.msg_name = &m.name;
+      hdr.msg_namelen = m.namelen;
+      hdr.msg_iov = &iov;
+      hdr.msg_iovlen = 1;
+      hdr.msg_control = m.ctrl.data();
+      hdr.msg_controllen = m.controllen;
+    }
+
+    int nsent;
+
+    do {
+      nsent = sendmmsg(ep->fd, mmsgs.data(), static_cast<unsigned int>(n), 0);
+
+      ++io_stats_.syscalls;
+    } while (nsent == -1 && errno == EINTR);
+
+    if (nsent > 0) {
+      i += static_cast<size_t>(nsent);
+
+      continue;
+    }
+
+    // The first datagram in the batch failed.
+    switch (errno) {
+    case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+    case EWOULDBLOCK:
+#endif // EAGAIN != EWOULDBLOCK
+      // Keep this and the following datagrams to ep until it becomes
+      // writable.
+      ev_io_start(loop_, &ep->wev);
+
+      continue;
+#ifdef UDP_SEGMENT
+    case EIO:
+      if (msgs[i].gso) {
+        // GSO failure; the handlers send each packet separately from
+        // now on.  This batch is lost.
+        std::cerr << "sendmmsg: disabling GSO due to " << strerror(errno)
+                  << std::endl;
+
+        txq_.no_gso = true;
+
+        ++i;
+
+        continue;
+      }
+
+      break;
+#endif // UDP_SEGMENT
+    }
+
+    std::cerr << "sendmmsg: " << strerror(errno) << std::endl;
+
+    ++i;
+  }
+
+  msgs.resize(nkept);
+  txq_.buf.resize(keptlen);
+}
+
+void Server::on_endpoint_writable(Endpoint &ep) {
+  ev_io_stop(loop_, &ep.wev);
+
+  flush_tx_queue();
+}
+
+void Server::associate_cid(const ngtcp2_cid *cid, Handler *h) {
+  handlers_.insert({cid->data, cid->datalen}, h);
+}
+
+void Server::dissociate_cid(const ngtcp2_cid *cid) {
+  handlers_.erase({cid->data, cid->datalen});
+}
+
+void Server::remove(const Handler *h) {
+  auto conn = h->conn();
+
+  if (config.careful_resume) {
+    ngtcp2_path_capacity cap;
+
+    if (ngtcp2_conn_get_path_capacity(conn, &cap) == 0) {
+      store_path_capacity(ngtcp2_conn_get_path(conn)->remote.addr, cap,
+                          ngtcp2_conn_get_path_max_tx_udp_payload_size(conn),
+                          util::timestamp());
+    }
+  }
+
+  dissociate_cid(ngtcp2_conn_get_client_initial_dcid(conn));
+
+  std::vector<ngtcp2_cid> cids(ngtcp2_conn_get_scid(conn, nullptr));
+  ngtcp2_conn_get_scid(conn, cids.data());
 
   for (auto &cid : cids) {
     dissociate_cid(&cid);
@@ -3233,6 +3544,303 @@ void Server::remove(const Handler *h) {
   delete h;
 }
 
+namespace {
+bool closed_conn_later(const std::unique_ptr<ClosedConn> &lhs,
+                       const std::unique_ptr<ClosedConn> &rhs) {
+  return lhs->expiry > rhs->expiry;
+}
+} // namespace
+
+void Server::start_close_wait(const Handler *h) {
+  auto conn = h->conn();
+  auto pto = ngtcp2_conn_get_pto(conn);
+  auto pkt = h->conn_close_pkt();
+
+  auto cc = std::make_unique<ClosedConn>(ClosedConn{
+      .pkt = {std::begin(pkt), std::end(pkt)},
+      .expiry = util::timestamp() + 3 * pto,
+      .next_send = 1,
+  });
+
+  if (!cc->pkt.empty()) {
+    auto path = ngtcp2_conn_get_path(conn);
+
+    cc->endpoint = static_cast<Endpoint *>(path->user_data);
+    memcpy(&cc->local_addr.su, path->local.addr, path->local.addrlen);
+    cc->local_addr.len = path->local.addrlen;
+    memcpy(&cc->remote_addr.su, path->remote.addr, path->remote.addrlen);
+    cc->remote_addr.len = path->remote.addrlen;
+  }
+
+  cc->scids.resize(ngtcp2_conn_get_scid(conn, nullptr));
+  ngtcp2_conn_get_scid(conn, cc->scids.data());
+  cc->scids.push_back(*ngtcp2_conn_get_client_initial_dcid(conn));
+
+  if (!config.quiet) {
+    std::cerr << (cc->pkt.empty() ? "Draining" : "Closing")
+              << " period has started ("
+              << static_cast<ev_tstamp>(pto) / NGTCP2_SECONDS * 3
+              << " seconds)" << std::endl;
+  }
+
+  remove(h);
+
+  for (auto &cid : cc->scids) {
+    closed_.insert({cid.data, cid.datalen}, cc.get());
+  }
+
+  auto p = cc.get();
+
+  close_wait_.push_back(std::move(cc));
+  std::push_heap(std::begin(close_wait_), std::end(close_wait_),
+                 closed_conn_later);
+
+  // Rearm the timer if this record expires first.
+  if (close_wait_.front().get() == p) {
+    on_close_wait_timer();
+  }
+}
+
+void Server::on_closed_conn_pkt(ClosedConn &cc) {
+  // Packets are not answered in the draining period.
+  if (cc.pkt.empty()) {
+    return;
+  }
+
+  // Reply to the 1st, 2nd, 4th, 8th, ... packets so that a peer which
+  // keeps sending cannot make us send as many packets.
+  if (++cc.nrecv < cc.next_send) {
+    return;
+  }
+
+  cc.next_send *= 2;
+
+  if (!config.quiet) {
+    std::cerr << "Closing Period: TX CONNECTION_CLOSE" << std::endl;
+  }
+
+  send_packet(*cc.endpoint,
+              {&cc.local_addr.su.sa, cc.local_addr.len},
+              {&cc.remote_addr.su.sa, cc.remote_addr.len},
+              /* ecn = */ 0, cc.pkt);
+}
+
+void Server::on_close_wait_timer() {
+  auto now = util::timestamp();
+
+  ev_timer_stop(loop_, &close_wait_timer_);
+
+  while (!close_wait_.empty() && close_wait_.front()->expiry <= now) {
+    std::pop_heap(std::begin(close_wait_), std::end(close_wait_),
+                  closed_conn_later);
+
+    auto cc = std::move(close_wait_.back());
+    close_wait_.pop_back();
+
+    if (!config.quiet) {
+      std::cerr << (cc->pkt.empty() ? "Draining" : "Closing")
+                << " Period is over" << std::endl;
+    }
+
+    for (auto &cid : cc->scids) {
+      closed_.erase({cid.data, cid.datalen});
+    }
+  }
+
+  if (close_wait_.empty()) {
+    return;
+  }
+
+  ev_timer_set(&close_wait_timer_,
+               static_cast<ev_tstamp>(close_wait_.front()->expiry - now) /
+                   NGTCP2_SECONDS,
+               0.);
+  ev_timer_start(loop_, &close_wait_timer_);
+}
+
+namespace {
+// PATH_CAPACITY_LIFETIME is the period of time that the remembered
+// path capacity is considered valid.
+constexpr ngtcp2_duration PATH_CAPACITY_LIFETIME = 3600 * NGTCP2_SECONDS;
+} // namespace
+
+void Server::store_path_capacity(const sockaddr *sa,
+                                 const ngtcp2_path_capacity &cap,
+                                 size_t max_udp_payload_size,
+                                 ngtcp2_tstamp ts) {
+  if (config.path_capacity_cache_size == 0) {
+    return;
+  }
+
+  auto key = util::make_subnet_key(sa);
+  if (key.empty()) {
+    return;
+  }
+
+  if (auto it = path_capacity_index_.find(key);
+      it != std::end(path_capacity_index_)) {
+    auto &ent = *(*it).second;
+
+    ent.cap = cap;
+    ent.max_udp_payload_size = max_udp_payload_size;
+    ent.ts = ts;
+
+    path_capacities_.splice(std::begin(path_capacities_), path_capacities_,
+                            (*it).second);
+
+    return;
+  }
+
+  if (path_capacities_.size() >= config.path_capacity_cache_size) {
+    path_capacity_index_.erase(path_capacities_.back().key);
+    path_capacities_.pop_back();
+  }
+
+  path_capacities_.push_front(
+      PathCapacityEntry{key, cap, max_udp_payload_size, ts});
+  path_capacity_index_.emplace(std::move(key), std::begin(path_capacities_));
+}
+
+const Server::PathCapacityEntry *
+Server::find_path_capacity(const sockaddr *sa, ngtcp2_tstamp ts) {
+  auto it = path_capacity_index_.find(util::make_subnet_key(sa));
+  if (it == std::end(path_capacity_index_)) {
+    return nullptr;
+  }
+
+  auto ent_it = (*it).second;
+
+  if (ent_it->ts + PATH_CAPACITY_LIFETIME <= ts) {
+    path_capacities_.erase(ent_it);
+    path_capacity_index_.erase(it);
+
+    return nullptr;
+  }
+
+  path_capacities_.splice(std::begin(path_capacities_), path_capacities_,
+                          ent_it);
+
+  return &*ent_it;
+}
+
+ngtcp2_timer_wheel *Server::timer_wheel() const { return tw_; }
+
+void Server::update_timer() {
+  auto expiry = ngtcp2_timer_wheel_get_expiry(tw_);
+
+#ifdef HAVE_LIBURING
+  if (uring_) {
+    uring_->set_timeout(expiry);
+    return;
+  }
+#endif // HAVE_LIBURING
+
+  // Rearm the timer only if the earliest expiry moves earlier.  The
+  // timer which fires early just rearms itself.
+  if (ev_is_active(&timer_) && timer_expiry_ <= expiry) {
+    return;
+  }
+
+  ev_timer_stop(loop_, &timer_);
+
+  timer_expiry_ = expiry;
+
+  if (expiry == UINT64_MAX) {
+    return;
+  }
+
+  auto now = util::timestamp();
+  auto t = expiry > now ? static_cast<ev_tstamp>(expiry - now) / NGTCP2_SECONDS
+                        : 0.;
+
+  ev_timer_set(&timer_, t, 0.);
+  ev_timer_start(loop_, &timer_);
+}
+
+void Server::on_timer() {
+  auto now = util::timestamp();
+
+  // Collect the expired connections before handling any of them.  A
+  // handled connection might expire at or before now again, and it
+  // would be returned forever.  Such a connection is handled in the
+  // next call.
+  expired_handlers_.clear();
+
+  for (;;) {
+    auto conn = ngtcp2_timer_wheel_expire(tw_, now);
+    if (!conn) {
+      break;
+    }
+
+    expired_handlers_.push_back(
+        static_cast<Handler *>(ngtcp2_conn_get_user_data(conn)));
+  }
+
+  for (auto h : expired_handlers_) {
+    if (!config.quiet) {
+      std::cerr << "Timer expired" << std::endl;
+    }
+
+    auto rv = h->handle_expiry();
+    if (rv == 0) {
+      rv = h->on_write();
+    }
+
+    switch (rv) {
+    case 0:
+      break;
+    case NETWORK_ERR_CLOSE_WAIT:
+      start_close_wait(h);
+      break;
+    default:
+      remove(h);
+      break;
+    }
+  }
+
+  update_timer();
+}
+
+FileCache &Server::file_cache() { return file_cache_; }
+
+void Server::print_io_stats() const {
+  auto syscalls = io_stats_.syscalls;
+  auto backend = config.sendmmsg ? "recvmsg/sendmmsg" : "recvmsg/sendmsg";
+
+#ifdef HAVE_LIBURING
+  if (uring_) {
+    syscalls += uring_->nsyscalls();
+    backend = "io_uring";
+  }
+#endif // HAVE_LIBURING
+
+#ifdef HAVE_AF_XDP
+  if (xdp_) {
+    syscalls += xdp_->nsyscalls();
+    backend = "af_xdp";
+  }
+#endif // HAVE_AF_XDP
+
+  // Every iteration of libev waits for events once, whichever backend
+  // sends and receives packets.
+  auto loop_waits = static_cast<uint64_t>(ev_iteration(loop_));
+  auto io_syscalls = syscalls;
+
+  syscalls += loop_waits;
+
+  std::cerr << "I/O backend=" << backend << " packets=" << io_stats_.pkts
+            << " syscalls=" << syscalls << " io_syscalls=" << io_syscalls
+            << " loop_waits=" << loop_waits;
+
+  if (io_stats_.pkts) {
+    std::cerr << " syscalls_per_packet="
+              << static_cast<double>(syscalls) /
+                     static_cast<double>(io_stats_.pkts);
+  }
+
+  std::cerr << std::endl;
+}
+
 void Server::on_stateless_reset_regen() {
   assert(stateless_reset_bucket_ < NGTCP2_STATELESS_RESET_BURST);
 
@@ -3337,6 +3945,10 @@ void config_set_default(Config &config) {
   config.handshake_timeout = UINT64_MAX;
   config.ack_thresh = 2;
   config.initial_pkt_num = UINT32_MAX;
+  config.path_capacity_cache_size = 1024;
+  config.file_cache_size = 64_m;
+  config.file_cache_validity = NGTCP2_SECONDS;
+  config.cpu = -1;
 }
 } // namespace
 
@@ -3405,6 +4017,25 @@ Options:
               Path to  the directory where  qlog file is  stored.  The
               file name  of each qlog  is the Source Connection  ID of
               server.
+  --qlog-binary
+              Write  qlog  in  compact  binary  format  instead  of
+              JSON-SEQ.  The  file extension becomes ".bqlog".  Use
+              qlogconv to convert it to JSON-SEQ.
+  --qlog-flight-recorder=<SIZE>
+              Keep the most recent qlog events  in a buffer of <SIZE>
+              bytes  per  connection,  and  write  them  out  only  on
+              connection error, persistent congestion, or 3 consecutive
+              PTOs.  Requires --qlog-dir.
+  --qlog-filter=<CLASS>[[,<CLASS>]...]
+              Do not write the given classes of qlog events.  <CLASS>
+              is either "pkt" (packet_sent and packet_received events)
+              or "frame" (frames in packet events).
+  --qlog-metrics-interval=<DURATION>
+              Write metrics_updated qlog event at most once in
+              <DURATION>.
+  --qlog-sample=<N>
+              Write only 1 in <N> packet_sent and packet_received qlog
+              events.
   --no-quic-dump
               Disables printing QUIC STREAM and CRYPTO frame data out.
   --no-http-dump
@@ -3502,6 +4133,78 @@ Options:
   --pmtud-probes=<SIZE>[[,<SIZE>]...]
               Specify UDP datagram payload sizes  to probe in Path MTU
               Discovery.  <SIZE> must be strictly larger than 1200.
+              On  a network  which supports  jumbo frames,  specify,
+              for example, 1452,8952.
+  --careful-resume
+              Enable Careful Resume.  The path capacity of the closed
+              connection is  remembered per client subnet, and  it is
+              used to  skip slow start  of the next  connection from
+              the same subnet.   The discovered path MTU is  also used
+              as a hint for Path MTU Discovery.
+  --path-capacity-cache-size=<N>
+              The maximum  number of path  capacity entries  to remember
+              for Careful Resume.
+              Default: )"
+            << config.path_capacity_cache_size << R"(
+  --timer-wheel
+              Track the expiry of all connections in a single timer
+              wheel, and  use one timer for  all of them  instead of a
+              timer per connection.
+  --sendmmsg  Queue the  outgoing datagrams of  all connections, and
+              send them with sendmmsg(2) at the end of each event loop
+              iteration.   Datagrams  to  an  endpoint  which  would
+              block stay queued until the endpoint becomes writable.
+  --io-uring  Send and  receive UDP datagrams through  io_uring instead
+              of  recvmsg(2) and  sendmsg(2).  Each  socket  receives
+              with  a  multishot  IORING_OP_RECVMSG,  and  outgoing
+              datagrams  are submitted  in a  batch once  per event
+              loop  iteration.  This option  implies --timer-wheel,
+              and its  timer is driven by io_uring.  The number of
+              packets and system calls is printed on exit.
+  --af-xdp=<IFNAME>
+              Receive  and send  UDP  datagrams  through an  AF_XDP
+              socket  bound to  the queue  0 of  <IFNAME>.  An  XDP
+              program  which steers  the  datagrams to  the  server
+              ports to  the socket  is attached  to <IFNAME>.  This
+              requires CAP_NET_ADMIN  and CAP_BPF,  and the  server
+              must be the  only user of the queue.   Datagrams to a
+              remote  endpoint  which  has not  been  seen  on  the
+              interface are sent through the UDP socket.
+  --file-cache-size=<SIZE>
+              The maximum  total size  of the files  under --htdocs
+              which are kept in memory.  The least recently requested
+              files are  evicted first.  A file  larger than  1/8 of
+              <SIZE>  is mapped  for each  request  instead.  0
+              disables the cache.
+              Default: )"
+            << util::format_uint_iec(config.file_cache_size) << R"(
+  --file-cache-validity=<DURATION>
+              The period of time during which a cached file is served
+              without  checking  whether  it has  changed  on  disk.
+              After that,  the file is  read again if its  inode,
+              modification time, or size has changed.
+              Default: )"
+            << util::format_duration(config.file_cache_validity) << R"(
+  --cpu=<CPU>
+              Pin the server to <CPU>, and bind  the UDP sockets with
+              SO_REUSEPORT  and  SO_INCOMING_CPU, so that  several
+              servers, each pinned  to a different CPU, can listen
+              on the same address and port.  The server is pinned
+              right after the options are parsed, so that the memory
+              allocated after that  is placed locally by first-touch.
+              No NUMA memory policy is set.
+  --steer-by-cpu
+              Deliver an  incoming datagram to  the server  which is
+              pinned to the CPU that processed the datagram in the
+              kernel, so that  the datagram is handled on  the same
+              CPU.  This requires --cpu.  The servers must be started
+              with --cpu=0, --cpu=1, and so on in this order, because
+              the n-th socket that joins  the SO_REUSEPORT group is
+              selected for CPU n.  Datagrams processed on a CPU without
+              a server are distributed by hash.  If a server exits,
+              the kernel moves the last socket  of the group into its
+              slot, and the datagrams are no longer steered to  the
+              right CPU.  Restart all servers in order to restore it.
   -h, --help  Display this help and exit.
 
 ---
@@ -3521,6 +4224,25 @@ Options:
 }
 } // namespace
 
+#ifdef HAVE_SCHED_SETAFFINITY
+namespace {
+// set_cpu_affinity pins the calling thread to |cpu|.
+int set_cpu_affinity(int cpu) {
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  CPU_SET(static_cast<size_t>(cpu), &set);
+
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    std::cerr << "sched_setaffinity: " << strerror(errno) << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
+} // namespace
+#endif // HAVE_SCHED_SETAFFINITY
+
 std::ofstream keylog_file;
 
 int main(int argc, char **argv) {
@@ -3571,6 +4293,21 @@ int main(int argc, char **argv) {
         {"ack-thresh", required_argument, &flag, 30},
         {"initial-pkt-num", required_argument, &flag, 31},
         {"pmtud-probes", required_argument, &flag, 32},
+        {"careful-resume", no_argument, &flag, 33},
+        {"path-capacity-cache-size", required_argument, &flag, 34},
+        {"timer-wheel", no_argument, &flag, 35},
+        {"qlog-binary", no_argument, &flag, 36},
+        {"qlog-flight-recorder", required_argument, &flag, 37},
+        {"qlog-filter", required_argument, &flag, 38},
+        {"qlog-metrics-interval", required_argument, &flag, 39},
+        {"qlog-sample", required_argument, &flag, 40},
+        {"io-uring", no_argument, &flag, 41},
+        {"sendmmsg", no_argument, &flag, 42},
+        {"af-xdp", required_argument, &flag, 43},
+        {"file-cache-size", required_argument, &flag, 44},
+        {"file-cache-validity", required_argument, &flag, 45},
+        {"cpu", required_argument, &flag, 46},
+        {"steer-by-cpu", no_argument, &flag, 47},
         {nullptr, 0, nullptr, 0}};
 
     auto optidx = 0;
@@ -3898,7 +4635,7 @@ int main(int argc, char **argv) {
           config.initial_pkt_num = static_cast<uint32_t>(*n);
         }
         break;
-      case 32:
+      case 32: {
         // --pmtud-probes
         auto l = util::split_str(optarg);
         for (auto &s : l) {
@@ -3916,6 +4653,138 @@ int main(int argc, char **argv) {
         }
         break;
       }
+      case 33:
+        // --careful-resume
+        config.careful_resume = true;
+        break;
+      case 34:
+        // --path-capacity-cache-size
+        if (auto n = util::parse_uint(optarg); !n) {
+          std::cerr << "path-capacity-cache-size: invalid argument"
+                    << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.path_capacity_cache_size = *n;
+        }
+        break;
+      case 35:
+        // --timer-wheel
+        config.timer_wheel = true;
+        break;
+      case 36:
+        // --qlog-binary
+        config.qlog_binary = true;
+        break;
+      case 37:
+        // --qlog-flight-recorder
+        if (auto n = util::parse_uint_iec(optarg); !n) {
+          std::cerr << "qlog-flight-recorder: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.qlog_flight_recorder_size = *n;
+        }
+        break;
+      case 38: {
+        // --qlog-filter
+        auto l = util::split_str(optarg);
+        for (auto &s : l) {
+          if (s == "pkt"sv) {
+            config.qlog_filter |= NGTCP2_QLOG_FILTER_PKT;
+          } else if (s == "frame"sv) {
+            config.qlog_filter |= NGTCP2_QLOG_FILTER_FRAME;
+          } else {
+            std::cerr << "qlog-filter: invalid argument" << std::endl;
+            exit(EXIT_FAILURE);
+          }
+        }
+        break;
+      }
+      case 39:
+        // --qlog-metrics-interval
+        if (auto t = util::parse_duration(optarg); !t) {
+          std::cerr << "qlog-metrics-interval: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.qlog_metrics_interval = *t;
+        }
+        break;
+      case 40:
+        // --qlog-sample
+        if (auto n = util::parse_uint(optarg); !n) {
+          std::cerr << "qlog-sample: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.qlog_pkt_sample_rate = *n;
+        }
+        break;
+      case 41:
+        // --io-uring
+#ifdef HAVE_LIBURING
+        config.io_uring = true;
+        // io_uring drives the expiry of all connections with a single
+        // timeout.
+        config.timer_wheel = true;
+#else  // !HAVE_LIBURING
+        std::cerr << "io-uring: ngtcp2 was built without liburing"
+                  << std::endl;
+        exit(EXIT_FAILURE);
+#endif // !HAVE_LIBURING
+        break;
+      case 42:
+        // --sendmmsg
+        config.sendmmsg = true;
+        break;
+      case 43:
+        // --af-xdp
+#ifdef HAVE_AF_XDP
+        config.af_xdp = optarg;
+#else  // !HAVE_AF_XDP
+        std::cerr << "af-xdp: ngtcp2 was built without AF_XDP support"
+                  << std::endl;
+        exit(EXIT_FAILURE);
+#endif // !HAVE_AF_XDP
+        break;
+      case 44:
+        // --file-cache-size
+        if (auto n = util::parse_uint_iec(optarg); !n) {
+          std::cerr << "file-cache-size: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.file_cache_size = *n;
+        }
+        break;
+      case 45:
+        // --file-cache-validity
+        if (auto t = util::parse_duration(optarg); !t) {
+          std::cerr << "file-cache-validity: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.file_cache_validity = *t;
+        }
+        break;
+      case 46:
+        // --cpu
+#ifdef HAVE_SCHED_SETAFFINITY
+        if (auto n = util::parse_uint(optarg); !n) {
+          std::cerr << "cpu: invalid argument" << std::endl;
+          exit(EXIT_FAILURE);
+        } else if (*n >= CPU_SETSIZE) {
+          std::cerr << "cpu: must be less than " << CPU_SETSIZE << std::endl;
+          exit(EXIT_FAILURE);
+        } else {
+          config.cpu = static_cast<int>(*n);
+        }
+#else  // !HAVE_SCHED_SETAFFINITY
+        std::cerr << "cpu: CPU affinity is not supported on this platform"
+                  << std::endl;
+        exit(EXIT_FAILURE);
+#endif // !HAVE_SCHED_SETAFFINITY
+        break;
+      case 47:
+        // --steer-by-cpu
+        config.steer_by_cpu = true;
+        break;
+      }
       break;
     default:
       break;
@@ -3943,6 +4812,21 @@ int main(int argc, char **argv) {
     config.port = *n;
   }
 
+  if (config.steer_by_cpu && config.cpu == -1) {
+    std::cerr << "steer-by-cpu: requires --cpu" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+#ifdef HAVE_SCHED_SETAFFINITY
+  // Pin the process as early as possible, so that first-touch places
+  // the memory allocated after this point locally to the CPU.  The
+  // memory which static initialization and option parsing have
+  // allocated is not affected.  No NUMA memory policy is set.
+  if (config.cpu != -1 && set_cpu_affinity(config.cpu) != 0) {
+    exit(EXIT_FAILURE);
+  }
+#endif // HAVE_SCHED_SETAFFINITY
+
   if (auto mt = util::read_mime_types(config.mime_types_file); !mt) {
     std::cerr << "mime-types-file: Could not read MIME media types file "
               << std::quoted(config.mime_types_file) << std::endl;
@@ -3984,6 +4868,8 @@ int main(int argc, char **argv) {
 
   ev_run(EV_DEFAULT, 0);
 
+  s.print_io_stats();
+
   s.disconnect();
   s.close();
 
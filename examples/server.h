@@ -33,6 +33,7 @@
 #include <unordered_map>
 #include <string>
 #include <deque>
+#include <list>
 #include <string_view>
 #include <memory>
 #include <span>
@@ -47,6 +48,10 @@
 #include "tls_server_context.h"
 #include "network.h"
 #include "shared.h"
+#include "cid_table.h"
+#include "file_cache.h"
+#include "uring.h"
+#include "xdp.h"
 
 using namespace ngtcp2;
 
@@ -59,14 +64,11 @@ struct HTTPHeader {
 };
 
 class Handler;
-struct FileEntry;
 
 struct Stream {
   Stream(int64_t stream_id, Handler *handler);
 
   int start_response(nghttp3_conn *conn);
-  std::pair<FileEntry, int> open_file(const std::string &path);
-  void map_file(const FileEntry &fe);
   int send_status_response(nghttp3_conn *conn, unsigned int status_code,
                            const std::vector<HTTPHeader> &extra_headers = {});
   int send_redirect_response(nghttp3_conn *conn, unsigned int status_code,
@@ -81,9 +83,12 @@ struct Stream {
   std::string method;
   std::string authority;
   std::string status_resp_body;
-  // data is a pointer to the memory which maps file denoted by fd.
+  // file is the file which is sent as the response body.  It keeps
+  // the content alive even if it is evicted from FileCache.
+  std::shared_ptr<const FileEntry> file;
+  // data is a pointer to the response body.
   uint8_t *data;
-  // datalen is the length of mapped file by data.
+  // datalen is the length of the response body.
   uint64_t datalen;
   // dynresp is true if dynamic data response is enabled.
   bool dynresp;
@@ -99,10 +104,35 @@ class Server;
 struct Endpoint {
   Address addr;
   ev_io rev;
+  // wev waits for fd to become writable while the datagrams queued
+  // for fd by --sendmmsg are blocked.
+  ev_io wev;
   Server *server;
   int fd;
 };
 
+// ClosedConn is what is left of a connection after it enters the
+// closing or draining period.  It only holds what is needed to answer
+// the packets which arrive until the period ends, so that Handler
+// and everything it owns can be freed immediately.
+struct ClosedConn {
+  // scids is the Connection IDs which are routed to this record.
+  std::vector<ngtcp2_cid> scids;
+  // pkt is the packet which contains CONNECTION_CLOSE.  It is empty
+  // in the draining period.
+  std::vector<uint8_t> pkt;
+  Endpoint *endpoint;
+  Address local_addr;
+  Address remote_addr;
+  // expiry is the time when the period ends.
+  ngtcp2_tstamp expiry;
+  // nrecv is the number of packets received during the period.
+  uint64_t nrecv;
+  // next_send is the value of nrecv at which pkt is sent next.  It
+  // doubles every time pkt is sent.
+  uint64_t next_send;
+};
+
 class Handler : public HandlerBase {
 public:
   Handler(struct ev_loop *loop, Server *server);
@@ -115,13 +145,13 @@ public:
            TLSServerContext &tls_ctx);
 
   int on_read(const Endpoint &ep, const Address &local_addr, const sockaddr *sa,
-              socklen_t salen, const ngtcp2_pkt_info *pi,
+              socklen_t salen, const ngtcp2_pkt_info *pi, ngtcp2_tstamp pkt_ts,
               std::span<const uint8_t> data);
   int on_write();
   int write_streams();
   int feed_data(const Endpoint &ep, const Address &local_addr,
                 const sockaddr *sa, socklen_t salen, const ngtcp2_pkt_info *pi,
-                std::span<const uint8_t> data);
+                ngtcp2_tstamp pkt_ts, std::span<const uint8_t> data);
   void update_timer();
   int handle_expiry();
   void signal_write();
@@ -134,8 +164,10 @@ public:
   uint32_t version() const;
   void on_stream_open(int64_t stream_id);
   int on_stream_close(int64_t stream_id, uint64_t app_error_code);
-  void start_draining_period();
   int start_closing_period();
+  // conn_close_pkt returns the packet written by
+  // start_closing_period.  It is empty if no packet has been written.
+  std::span<const uint8_t> conn_close_pkt() const;
   int handle_error();
   int send_conn_close();
 
@@ -228,9 +260,16 @@ public:
   void close();
 
   int on_read(Endpoint &ep);
+  // on_read_msg processes a datagram |data| received from |ep|.
+  // |msg| carries the remote address and the control data.  It
+  // returns the number of packets in |data|.
+  size_t on_read_msg(Endpoint &ep, msghdr &msg,
+                     std::span<const uint8_t> data);
+  // read_pkt processes a QUIC packet |data|.  |pkt_ts| is the time
+  // when |data| was received.
   void read_pkt(Endpoint &ep, const Address &local_addr, const sockaddr *sa,
                 socklen_t salen, const ngtcp2_pkt_info *pi,
-                std::span<const uint8_t> data);
+                ngtcp2_tstamp pkt_ts, std::span<const uint8_t> data);
   int send_version_negotiation(uint32_t version, std::span<const uint8_t> dcid,
                                std::span<const uint8_t> scid, Endpoint &ep,
                                const Address &local_addr, const sockaddr *sa,
@@ -256,21 +295,141 @@ public:
               const ngtcp2_addr &remote_addr, unsigned int ecn,
               std::span<const uint8_t> data, size_t gso_size);
   void remove(const Handler *h);
+  // start_close_wait replaces |h| in the closing or draining period
+  // with ClosedConn, and removes |h|.
+  void start_close_wait(const Handler *h);
+  // on_closed_conn_pkt handles a packet which is routed to |cc|.
+  void on_closed_conn_pkt(ClosedConn &cc);
+  // on_close_wait_timer frees ClosedConn whose period has ended.
+  void on_close_wait_timer();
+  // flush_tx_queue sends the datagrams queued by --sendmmsg.
+  // Datagrams to an endpoint which would block stay in the queue
+  // until the endpoint becomes writable.
+  void flush_tx_queue();
+  // on_endpoint_writable is called when |ep| becomes writable after
+  // sendmmsg was blocked.
+  void on_endpoint_writable(Endpoint &ep);
 
   void associate_cid(const ngtcp2_cid *cid, Handler *h);
   void dissociate_cid(const ngtcp2_cid *cid);
 
   void on_stateless_reset_regen();
 
+  struct PathCapacityEntry {
+    std::string key;
+    ngtcp2_path_capacity cap;
+    // max_udp_payload_size is the maximum UDP payload size discovered
+    // by PMTUD.
+    size_t max_udp_payload_size;
+    // ts is the timestamp when this entry is stored.
+    ngtcp2_tstamp ts;
+  };
+
+  // store_path_capacity remembers |cap| and |max_udp_payload_size| of
+  // the path to the remote address |sa| for Careful Resume.
+  void store_path_capacity(const sockaddr *sa, const ngtcp2_path_capacity &cap,
+                           size_t max_udp_payload_size, ngtcp2_tstamp ts);
+  // find_path_capacity returns the entry remembered for the remote
+  // address |sa| if any.
+  const PathCapacityEntry *find_path_capacity(const sockaddr *sa,
+                                              ngtcp2_tstamp ts);
+
+  // timer_wheel returns the timer wheel which tracks the expiry of all
+  // connections.  It returns nullptr if --timer-wheel is not given.
+  ngtcp2_timer_wheel *timer_wheel() const;
+  // update_timer arms the timer for the earliest expiry in the timer
+  // wheel.
+  void update_timer();
+  // on_timer handles the connections whose expiry has been reached.
+  void on_timer();
+
+  // print_io_stats prints the number of packets and the system calls
+  // which are made to send and receive them, including the calls
+  // made by the event loop to wait for events.
+  void print_io_stats() const;
+
+  FileCache &file_cache();
+
 private:
-  std::unordered_map<std::string, Handler *, string_hash, std::equal_to<>>
-      handlers_;
+  // handlers_ maps Connection ID to Handler which owns it.
+  CIDTable<Handler *> handlers_;
+  // closed_ maps Connection ID to ClosedConn which owns it.
+  CIDTable<ClosedConn *> closed_;
+  // close_wait_ is a min-heap of ClosedConn ordered by expiry.
+  std::vector<std::unique_ptr<ClosedConn>> close_wait_;
+  ev_timer close_wait_timer_;
+  // path_capacities_ is the list of the path capacities ordered by
+  // recency.  The most recently used entry is at the front.
+  std::list<PathCapacityEntry> path_capacities_;
+  std::unordered_map<std::string, std::list<PathCapacityEntry>::iterator,
+                     string_hash, std::equal_to<>>
+      path_capacity_index_;
   struct ev_loop *loop_;
   std::vector<Endpoint> endpoints_;
   TLSServerContext &tls_ctx_;
   ev_signal sigintev_;
   ev_timer stateless_reset_regen_timer_;
   size_t stateless_reset_bucket_;
+  ngtcp2_timer_wheel *tw_;
+  // timer_ is the timer for tw_.
+  ev_timer timer_;
+  // timer_expiry_ is the timestamp when timer_ expires.
+  ngtcp2_tstamp timer_expiry_;
+  // expired_handlers_ is the list of Handlers whose expiry has been
+  // reached in on_timer.
+  std::vector<Handler *> expired_handlers_;
+#ifdef HAVE_LIBURING
+  // uring_ performs UDP I/O if --io-uring is given.
+  std::unique_ptr<Uring> uring_;
+#endif // HAVE_LIBURING
+#ifdef HAVE_AF_XDP
+  // xdp_ performs UDP I/O on the interface given by --af-xdp.
+  std::unique_ptr<Xdp> xdp_;
+#endif // HAVE_AF_XDP
+  // TxMsg is an outgoing datagram, or a GSO batch of datagrams,
+  // which is queued by --sendmmsg.
+  struct TxMsg {
+    Endpoint *endpoint;
+    sockaddr_union name;
+    socklen_t namelen;
+    std::array<uint8_t, CMSG_SPACE(sizeof(int)) +
+                            CMSG_SPACE(sizeof(uint16_t)) +
+                            CMSG_SPACE(sizeof(in6_pktinfo))>
+        ctrl;
+    size_t controllen;
+    // offset and len locate the payload in txq_.buf.
+    size_t offset;
+    size_t len;
+    // gso is true if the payload is sent with UDP_SEGMENT.
+    bool gso;
+  };
+
+  // queue_msg queues |msg| which is sent to |ep|.  It returns false if
+  // the queue is full.
+  bool queue_msg(Endpoint &ep, const msghdr &msg, bool gso);
+
+  // txq_ is the transmit queue which collects outgoing datagrams from
+  // all handlers during an event loop iteration.
+  struct {
+    std::vector<TxMsg> msgs;
+    std::vector<uint8_t> buf;
+    // no_gso is true if the kernel has rejected a GSO send.
+    bool no_gso;
+  } txq_;
+  // txq_prep_ runs flush_tx_queue before libev waits for events.
+  ev_prepare txq_prep_;
+  struct {
+    // pkts is the number of UDP datagrams sent and received.  A GSO
+    // or GRO buffer counts each datagram in it.
+    uint64_t pkts;
+    // syscalls is the number of system calls made to send and
+    // receive pkts.  The calls made by the event loop to wait for
+    // events are counted by ev_iteration instead.
+    uint64_t syscalls;
+  } io_stats_;
+  // file_cache_ keeps the hot files under htdocs in memory.  It is
+  // shared by all connections.
+  FileCache file_cache_;
 };
 
 #endif // SERVER_H
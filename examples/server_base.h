@@ -86,6 +86,20 @@ struct Config {
   bool verify_client;
   // qlog_dir is the path to directory where qlog is stored.
   std::string_view qlog_dir;
+  // qlog_binary is true if qlog is written in compact binary format.
+  bool qlog_binary;
+  // qlog_flight_recorder_size is the size of buffer per connection
+  // which keeps the recent qlog events until something goes wrong.
+  // 0 disables flight recorder.
+  size_t qlog_flight_recorder_size;
+  // qlog_filter is bitwise OR of NGTCP2_QLOG_FILTER_*.
+  uint32_t qlog_filter;
+  // qlog_metrics_interval is the minimum interval between
+  // metrics_updated qlog events.
+  ngtcp2_duration qlog_metrics_interval;
+  // qlog_pkt_sample_rate makes only 1 in qlog_pkt_sample_rate packet
+  // qlog events written.
+  size_t qlog_pkt_sample_rate;
   // no_quic_dump is true if hexdump of QUIC STREAM and CRYPTO data
   // should be disabled.
   bool no_quic_dump;
@@ -154,6 +168,40 @@ struct Config {
   uint32_t initial_pkt_num;
   // pmtud_probes is the array of UDP datagram payload size to probes.
   std::vector<uint16_t> pmtud_probes;
+  // careful_resume, if true, enables Careful Resume.  The path
+  // capacity of a closed connection is remembered per client subnet,
+  // and it is imported to a new connection from the same subnet.
+  bool careful_resume;
+  // path_capacity_cache_size is the maximum number of the path
+  // capacity entries to remember for Careful Resume.
+  size_t path_capacity_cache_size;
+  // timer_wheel, if true, tracks the expiry of all connections in a
+  // single timer wheel instead of a timer per connection.
+  bool timer_wheel;
+  // io_uring, if true, performs UDP I/O through io_uring instead of
+  // recvmsg and sendmsg.
+  bool io_uring;
+  // sendmmsg, if true, queues outgoing datagrams from all connections
+  // and sends them with sendmmsg at the end of an event loop
+  // iteration.
+  bool sendmmsg;
+  // af_xdp is the name of the network interface on which UDP
+  // datagrams are received and sent through an AF_XDP socket.
+  std::string_view af_xdp;
+  // file_cache_size is the maximum total length of the files which
+  // are kept in memory.  0 disables the cache.
+  size_t file_cache_size;
+  // file_cache_validity is the period of time during which a cached
+  // file is served without checking whether it has changed.
+  ngtcp2_duration file_cache_validity;
+  // cpu is the CPU to which the server is pinned, or -1.  If it is
+  // not -1, the UDP sockets are bound with SO_REUSEPORT so that the
+  // servers pinned to the different CPUs share the same address and
+  // port.
+  int cpu;
+  // steer_by_cpu, if true, delivers a datagram to the server which is
+  // pinned to the CPU that processes the datagram in the kernel.
+  bool steer_by_cpu;
 };
 
 struct Buffer {
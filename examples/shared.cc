@@ -28,7 +28,9 @@
 
 #include <cstring>
 #include <cassert>
+#include <ctime>
 #include <iostream>
+#include <algorithm>
 
 #include <unistd.h>
 #ifdef HAVE_NETINET_IN_H
@@ -49,6 +51,9 @@
 #ifdef HAVE_LINUX_RTNETLINK_H
 #  include <linux/rtnetlink.h>
 #endif // HAVE_LINUX_RTNETLINK_H
+#ifdef HAVE_LINUX_FILTER_H
+#  include <linux/filter.h>
+#endif // HAVE_LINUX_FILTER_H
 
 #include "template.h"
 
@@ -214,6 +219,80 @@ size_t msghdr_get_udp_gro(msghdr *msg) {
   return gso_size;
 }
 
+void fd_set_recv_timestamp(int fd) {
+#ifdef SO_TIMESTAMPNS
+  int val = 1;
+
+  if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &val,
+                 static_cast<socklen_t>(sizeof(val))) == -1) {
+    std::cerr << "setsockopt: SO_TIMESTAMPNS: " << strerror(errno)
+              << std::endl;
+  }
+#endif // SO_TIMESTAMPNS
+}
+
+void fd_set_incoming_cpu(int fd, int cpu) {
+#ifdef SO_INCOMING_CPU
+  if (setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu,
+                 static_cast<socklen_t>(sizeof(cpu))) == -1) {
+    std::cerr << "setsockopt: SO_INCOMING_CPU: " << strerror(errno)
+              << std::endl;
+  }
+#endif // SO_INCOMING_CPU
+}
+
+void fd_attach_reuseport_cpu_prog(int fd) {
+#if defined(HAVE_LINUX_FILTER_H) && defined(SO_ATTACH_REUSEPORT_CBPF)
+  // If the returned index is not less than the number of sockets in
+  // the group, the kernel falls back to the hash of 4-tuple.
+  sock_filter code[]{
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+       static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  sock_fprog prog{
+      .len = static_cast<unsigned short>(std::size(code)),
+      .filter = code,
+  };
+
+  if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog,
+                 static_cast<socklen_t>(sizeof(prog))) == -1) {
+    std::cerr << "setsockopt: SO_ATTACH_REUSEPORT_CBPF: " << strerror(errno)
+              << std::endl;
+  }
+#endif // HAVE_LINUX_FILTER_H && SO_ATTACH_REUSEPORT_CBPF
+}
+
+ngtcp2_tstamp msghdr_get_recv_timestamp(msghdr *msg, ngtcp2_tstamp now) {
+#ifdef SO_TIMESTAMPNS
+  for (auto cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      timespec rts, rnow;
+      memcpy(&rts, CMSG_DATA(cmsg), sizeof(rts));
+
+      if (clock_gettime(CLOCK_REALTIME, &rnow) != 0) {
+        return now;
+      }
+
+      auto recvd = static_cast<uint64_t>(rts.tv_sec) * NGTCP2_SECONDS +
+                   static_cast<uint64_t>(rts.tv_nsec);
+      auto realtime = static_cast<uint64_t>(rnow.tv_sec) * NGTCP2_SECONDS +
+                      static_cast<uint64_t>(rnow.tv_nsec);
+
+      // CLOCK_REALTIME might be stepped backwards after the datagram
+      // was received.
+      if (recvd >= realtime) {
+        return now;
+      }
+
+      return now - std::min(realtime - recvd, now);
+    }
+  }
+#endif // SO_TIMESTAMPNS
+
+  return now;
+}
+
 void set_port(Address &dst, Address &src) {
   switch (dst.su.storage.ss_family) {
   case AF_INET:
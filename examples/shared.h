@@ -48,6 +48,14 @@ constexpr uint8_t HQ_ALPN_V1[] = "\xahq-interop";
 constexpr uint8_t H3_ALPN[] = "\x2h3";
 constexpr uint8_t H3_ALPN_V1[] = "\x2h3";
 
+// NGTCP2_MAX_GSO_DATALEN is the maximum number of bytes that a single
+// UDP GSO send can carry.  It is the largest UDP payload of an IPv4
+// datagram.
+constexpr size_t NGTCP2_MAX_GSO_DATALEN = 65507;
+// NGTCP2_MAX_GSO_SEGMENTS is the maximum number of segments that a
+// single UDP GSO send can carry (UDP_MAX_SEGMENTS in Linux kernel).
+constexpr size_t NGTCP2_MAX_GSO_SEGMENTS = 64;
+
 // msghdr_get_ecn gets ECN bits from |msg|.  |family| is the address
 // family from which packet is received.
 unsigned int msghdr_get_ecn(msghdr *msg, int family);
@@ -66,12 +74,37 @@ void fd_set_ip_dontfrag(int fd, int family);
 // fd_set_udp_gro sets UDP_GRO socket option to |fd|.
 void fd_set_udp_gro(int fd);
 
+// fd_set_recv_timestamp sets SO_TIMESTAMPNS socket option to |fd| so
+// that the kernel reports the time when each datagram is received.
+void fd_set_recv_timestamp(int fd);
+
+// fd_set_incoming_cpu sets SO_INCOMING_CPU socket option to |fd| so
+// that the kernel prefers |fd| for the datagrams which are processed
+// on |cpu|.
+void fd_set_incoming_cpu(int fd, int cpu);
+
+// fd_attach_reuseport_cpu_prog attaches a classic BPF program to the
+// SO_REUSEPORT group of |fd| which selects the socket whose index in
+// the group is the CPU that processes an incoming datagram.  When a
+// socket is closed, the kernel moves the last socket of the group
+// into the vacated index, so the mapping from CPU to socket is broken
+// until all sockets are recreated in order.
+void fd_attach_reuseport_cpu_prog(int fd);
+
 std::optional<Address> msghdr_get_local_addr(msghdr *msg, int family);
 
 // msghdr_get_udp_gro returns UDP_GRO value from |msg|.  If UDP_GRO is
 // not found, or UDP_GRO is not supported, this function returns 0.
 size_t msghdr_get_udp_gro(msghdr *msg);
 
+// msghdr_get_recv_timestamp returns the time when the datagram in
+// |msg| was received by the kernel, in the same clock as |now| which
+// must be the current time obtained by util::timestamp().  The kernel
+// reports it in CLOCK_REALTIME, and it is converted by subtracting its
+// age from |now|.  If the timestamp is not found, or it is not
+// supported, this function returns |now|.
+ngtcp2_tstamp msghdr_get_recv_timestamp(msghdr *msg, ngtcp2_tstamp now);
+
 void set_port(Address &dst, Address &src);
 
 // get_local_addr stores preferred local address (interface address)
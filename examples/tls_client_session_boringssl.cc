@@ -41,7 +41,8 @@ extern Config config;
 int TLSClientSession::init(bool &early_data_enabled,
                            const TLSClientContext &tls_ctx,
                            const char *remote_addr, ClientBase *client,
-                           uint32_t quic_version, AppProtocol app_proto) {
+                           uint32_t quic_version, AppProtocol app_proto,
+                           const char *session_file) {
   early_data_enabled = false;
 
   auto ssl_ctx = tls_ctx.get_native_handle();
@@ -75,16 +76,16 @@ int TLSClientSession::init(bool &early_data_enabled,
     SSL_set_tlsext_host_name(ssl_, remote_addr);
   }
 
-  if (config.session_file) {
-    auto f = BIO_new_file(config.session_file, "r");
+  if (session_file) {
+    auto f = BIO_new_file(session_file, "r");
     if (f == nullptr) {
-      std::cerr << "Could not read TLS session file " << config.session_file
+      std::cerr << "Could not read TLS session file " << session_file
                 << std::endl;
     } else {
       auto session = PEM_read_bio_SSL_SESSION(f, nullptr, 0, nullptr);
       BIO_free(f);
       if (session == nullptr) {
-        std::cerr << "Could not read TLS session file " << config.session_file
+        std::cerr << "Could not read TLS session file " << session_file
                   << std::endl;
       } else {
         if (!SSL_set_session(ssl_, session)) {
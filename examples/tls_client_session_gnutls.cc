@@ -91,7 +91,8 @@ int hook_func(gnutls_session_t session, unsigned int htype, unsigned when,
 int TLSClientSession::init(bool &early_data_enabled,
                            const TLSClientContext &tls_ctx,
                            const char *remote_addr, ClientBase *client,
-                           uint32_t quic_version, AppProtocol app_proto) {
+                           uint32_t quic_version, AppProtocol app_proto,
+                           const char *session_file) {
   early_data_enabled = false;
 
   if (auto rv =
@@ -123,8 +124,8 @@ int TLSClientSession::init(bool &early_data_enabled,
     return -1;
   }
 
-  if (config.session_file) {
-    auto f = std::ifstream(config.session_file);
+  if (session_file) {
+    auto f = std::ifstream(session_file);
     if (f) {
       f.seekg(0, std::ios::end);
       auto pos = f.tellg();
@@ -141,7 +142,7 @@ int TLSClientSession::init(bool &early_data_enabled,
       if (auto rv =
               gnutls_pem_base64_decode2("GNUTLS SESSION PARAMETERS", &s, &d);
           rv < 0) {
-        std::cerr << "Could not read session in " << config.session_file
+        std::cerr << "Could not read session in " << session_file
                   << std::endl;
         return -1;
       }
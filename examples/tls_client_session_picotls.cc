@@ -72,7 +72,8 @@ auto negotiated_protocols_hq = std::to_array<ptls_iovec_t>({
 
 int TLSClientSession::init(bool &early_data_enabled, TLSClientContext &tls_ctx,
                            const char *remote_addr, ClientBase *client,
-                           uint32_t quic_version, AppProtocol app_proto) {
+                           uint32_t quic_version, AppProtocol app_proto,
+                           const char *session_file) {
   cptls_.ptls = ptls_client_new(tls_ctx.get_native_handle());
   if (!cptls_.ptls) {
     std::cerr << "ptls_client_new failed" << std::endl;
@@ -120,10 +121,10 @@ int TLSClientSession::init(bool &early_data_enabled, TLSClientContext &tls_ctx,
     ptls_set_server_name(cptls_.ptls, remote_addr, strlen(remote_addr));
   }
 
-  if (config.session_file) {
-    auto f = BIO_new_file(config.session_file, "r");
+  if (session_file) {
+    auto f = BIO_new_file(session_file, "r");
     if (f == nullptr) {
-      std::cerr << "Could not read TLS session file " << config.session_file
+      std::cerr << "Could not read TLS session file " << session_file
                 << std::endl;
     } else {
       auto f_d = defer(BIO_free, f);
@@ -133,7 +134,7 @@ int TLSClientSession::init(bool &early_data_enabled, TLSClientContext &tls_ctx,
       long datalen;
 
       if (PEM_read_bio(f, &name, &header, &data, &datalen) != 1) {
-        std::cerr << "Could not read TLS session file " << config.session_file
+        std::cerr << "Could not read TLS session file " << session_file
                   << std::endl;
       } else {
         if ("PICOTLS SESSION PARAMETERS"sv != name) {
@@ -42,9 +42,11 @@ public:
   TLSClientSession();
   ~TLSClientSession();
 
+  // init creates a TLS session.  If |session_file| is not nullptr,
+  // it tries to resume the TLS session stored in the file.
   int init(bool &early_data_enabled, TLSClientContext &tls_ctx,
            const char *remote_addr, ClientBase *client, uint32_t quic_version,
-           AppProtocol app_proto);
+           AppProtocol app_proto, const char *session_file);
 
   bool get_early_data_accepted() const;
 };
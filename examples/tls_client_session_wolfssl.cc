@@ -52,7 +52,8 @@ int wolfssl_session_ticket_cb(WOLFSSL *ssl, const unsigned char *ticket,
 int TLSClientSession::init(bool &early_data_enabled,
                            const TLSClientContext &tls_ctx,
                            const char *remote_addr, ClientBase *client,
-                           uint32_t quic_version, AppProtocol app_proto) {
+                           uint32_t quic_version, AppProtocol app_proto,
+                           const char *session_file) {
   early_data_enabled = false;
 
   auto ssl_ctx = tls_ctx.get_native_handle();
@@ -92,11 +93,11 @@ int TLSClientSession::init(bool &early_data_enabled,
   // Just use QUIC v1
   wolfSSL_set_quic_transport_version(ssl_, 0x39);
 
-  if (config.session_file) {
+  if (session_file) {
 #ifdef HAVE_SESSION_TICKET
-    auto f = wolfSSL_BIO_new_file(config.session_file, "r");
+    auto f = wolfSSL_BIO_new_file(session_file, "r");
     if (f == nullptr) {
-      std::cerr << "Could not open TLS session file " << config.session_file
+      std::cerr << "Could not open TLS session file " << session_file
                 << std::endl;
     } else {
       char *name, *header;
@@ -107,7 +108,7 @@ int TLSClientSession::init(bool &early_data_enabled,
       WOLFSSL_SESSION *session;
 
       if (wolfSSL_PEM_read_bio(f, &name, &header, &data, &datalen) != 1) {
-        std::cerr << "Could not read TLS session file " << config.session_file
+        std::cerr << "Could not read TLS session file " << session_file
                   << std::endl;
       } else {
         if ("WOLFSSL SESSION PARAMETERS"sv != name) {
@@ -118,12 +119,12 @@ int TLSClientSession::init(bool &early_data_enabled,
           session = wolfSSL_d2i_SSL_SESSION(nullptr, &pdata, datalen);
           if (session == nullptr) {
             std::cerr << "Could not parse TLS session from file "
-                      << config.session_file << std::endl;
+                      << session_file << std::endl;
           } else {
             ret = wolfSSL_set_session(ssl_, session);
             if (ret != WOLFSSL_SUCCESS) {
               std::cerr << "Could not install TLS session from file "
-                        << config.session_file << std::endl;
+                        << session_file << std::endl;
             } else {
               if (!config.disable_early_data &&
                   wolfSSL_SESSION_get_max_early_data(session)) {
@@ -0,0 +1,500 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "uring.h"
+
+#ifdef HAVE_LIBURING
+
+#  include <cassert>
+#  include <cstring>
+#  include <array>
+#  include <algorithm>
+#  include <iostream>
+
+#  include <netinet/udp.h>
+
+#  include "server.h"
+#  include "template.h"
+
+extern Config config;
+
+namespace {
+// URING_ENTRIES is the number of the submission queue entries.
+constexpr unsigned int URING_ENTRIES = 1024;
+// URING_BGID is the buffer group ID of the provided buffer ring.
+constexpr uint16_t URING_BGID = 0;
+// URING_NUM_RECV_BUFS is the number of the provided buffers.  It must
+// be a power of 2.
+constexpr uint16_t URING_NUM_RECV_BUFS = 64;
+// URING_RECV_BUFLEN is the size of a provided buffer.  It holds
+// io_uring_recvmsg_out, the name, the control data, and a datagram
+// which might be coalesced by UDP GRO.
+constexpr size_t URING_RECV_BUFLEN = 64_k + 512;
+// URING_NUM_SEND_SLOTS is the number of the datagrams which can be in
+// flight.
+constexpr size_t URING_NUM_SEND_SLOTS = 64;
+// URING_CTRLLEN is the size of the control data of a datagram.
+constexpr size_t URING_CTRLLEN = CMSG_SPACE(sizeof(int)) +
+                                 CMSG_SPACE(sizeof(in6_pktinfo)) +
+                                 CMSG_SPACE(sizeof(uint16_t)) +
+                                 CMSG_SPACE(sizeof(timespec));
+} // namespace
+
+namespace {
+// The lower 2 bits of user_data tell the kind of an operation.  The
+// rest of the bits is the pointer to Endpoint or SendSlot, or the
+// generation of the timeout.
+enum {
+  URING_OP_RECV,
+  URING_OP_SEND,
+  URING_OP_TIMEOUT,
+  URING_OP_NONE,
+};
+
+constexpr uint64_t URING_OP_MASK = 0x3;
+} // namespace
+
+struct Uring::SendSlot {
+  msghdr msg;
+  iovec iov;
+  sockaddr_union name;
+  std::array<uint8_t, URING_CTRLLEN> ctrl;
+  std::array<uint8_t, 64_k> data;
+  // gso is true if the datagram is sent with UDP_SEGMENT.
+  bool gso;
+};
+
+Uring::Uring(struct ev_loop *loop, Server *server)
+    : loop_(loop),
+      server_(server),
+      ring_{},
+      ring_inited_(false),
+      buf_ring_(nullptr),
+      recv_msg_{},
+      timeout_ts_{},
+      timeout_expiry_(UINT64_MAX),
+      timeout_gen_(0),
+      timeout_active_(false),
+      timeout_dirty_(false),
+      no_gso_(false),
+      nsyscalls_(0) {
+  ev_io_init(
+      &rev_,
+      [](struct ev_loop *loop, ev_io *w, int revents) {
+        auto uring = static_cast<Uring *>(w->data);
+
+        uring->on_read();
+      },
+      0, EV_READ);
+  rev_.data = this;
+
+  ev_prepare_init(&prep_, [](struct ev_loop *loop, ev_prepare *w,
+                             int revents) {
+    auto uring = static_cast<Uring *>(w->data);
+
+    uring->flush();
+  });
+  prep_.data = this;
+
+  recv_msg_.msg_namelen = sizeof(sockaddr_union);
+  recv_msg_.msg_controllen = URING_CTRLLEN;
+}
+
+Uring::~Uring() {
+  stop();
+
+  if (!ring_inited_) {
+    return;
+  }
+
+  if (buf_ring_) {
+    io_uring_free_buf_ring(&ring_, buf_ring_, URING_NUM_RECV_BUFS, URING_BGID);
+  }
+
+  io_uring_queue_exit(&ring_);
+}
+
+int Uring::init() {
+  if (auto rv = io_uring_queue_init(URING_ENTRIES, &ring_, 0); rv != 0) {
+    std::cerr << "io_uring_queue_init: " << strerror(-rv) << std::endl;
+    return -1;
+  }
+
+  ring_inited_ = true;
+
+  int err;
+
+  buf_ring_ = io_uring_setup_buf_ring(&ring_, URING_NUM_RECV_BUFS, URING_BGID,
+                                      0, &err);
+  if (!buf_ring_) {
+    std::cerr << "io_uring_setup_buf_ring: " << strerror(-err) << std::endl;
+    return -1;
+  }
+
+  bufs_ = std::make_unique<uint8_t[]>(URING_NUM_RECV_BUFS * URING_RECV_BUFLEN);
+
+  for (uint16_t i = 0; i < URING_NUM_RECV_BUFS; ++i) {
+    io_uring_buf_ring_add(buf_ring_, bufs_.get() + i * URING_RECV_BUFLEN,
+                          URING_RECV_BUFLEN, i,
+                          io_uring_buf_ring_mask(URING_NUM_RECV_BUFS), i);
+  }
+
+  io_uring_buf_ring_advance(buf_ring_, URING_NUM_RECV_BUFS);
+
+  send_slots_.resize(URING_NUM_SEND_SLOTS);
+  free_send_slots_.reserve(URING_NUM_SEND_SLOTS);
+
+  for (auto &slot : send_slots_) {
+    free_send_slots_.push_back(&slot);
+  }
+
+  ev_io_set(&rev_, ring_.ring_fd, EV_READ);
+  ev_io_start(loop_, &rev_);
+  ev_prepare_start(loop_, &prep_);
+
+  return 0;
+}
+
+void Uring::stop() {
+  ev_io_stop(loop_, &rev_);
+  ev_prepare_stop(loop_, &prep_);
+}
+
+io_uring_sqe *Uring::get_sqe() {
+  auto sqe = io_uring_get_sqe(&ring_);
+  if (sqe) {
+    return sqe;
+  }
+
+  // The submission queue is full.
+  io_uring_submit(&ring_);
+  ++nsyscalls_;
+
+  sqe = io_uring_get_sqe(&ring_);
+
+  assert(sqe);
+
+  return sqe;
+}
+
+void Uring::start_recv(Endpoint &ep) {
+  auto sqe = get_sqe();
+
+  io_uring_prep_recvmsg_multishot(sqe, ep.fd, &recv_msg_, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = URING_BGID;
+  io_uring_sqe_set_data64(sqe,
+                          reinterpret_cast<uint64_t>(&ep) | URING_OP_RECV);
+}
+
+void Uring::sendmsg(int fd, const msghdr &msg) {
+  assert(msg.msg_iovlen == 1);
+  assert(msg.msg_namelen <= sizeof(sockaddr_union));
+  assert(msg.msg_controllen <= URING_CTRLLEN);
+
+  if (free_send_slots_.empty()) {
+    wait_send_slot();
+  }
+
+  auto slot = free_send_slots_.back();
+  free_send_slots_.pop_back();
+
+  auto &iov = msg.msg_iov[0];
+
+  assert(iov.iov_len <= slot->data.size());
+
+  memcpy(slot->data.data(), iov.iov_base, iov.iov_len);
+  memcpy(&slot->name, msg.msg_name, msg.msg_namelen);
+  memcpy(slot->ctrl.data(), msg.msg_control, msg.msg_controllen);
+
+  slot->iov.iov_base = slot->data.data();
+  slot->iov.iov_len = iov.iov_len;
+
+  slot->msg = {};
+  slot->msg.msg_name = &slot->name;
+  slot->msg.msg_namelen = msg.msg_namelen;
+  slot->msg.msg_iov = &slot->iov;
+  slot->msg.msg_iovlen = 1;
+  slot->msg.msg_control = slot->ctrl.data();
+  slot->msg.msg_controllen = msg.msg_controllen;
+
+  slot->gso = false;
+
+#  ifdef UDP_SEGMENT
+  for (auto cm = CMSG_FIRSTHDR(&slot->msg); cm;
+       cm = CMSG_NXTHDR(&slot->msg, cm)) {
+    if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_SEGMENT) {
+      slot->gso = true;
+      break;
+    }
+  }
+#  endif // UDP_SEGMENT
+
+  auto sqe = get_sqe();
+
+  io_uring_prep_sendmsg(sqe, fd, &slot->msg, 0);
+  io_uring_sqe_set_data64(sqe,
+                          reinterpret_cast<uint64_t>(slot) | URING_OP_SEND);
+}
+
+void Uring::set_timeout(ngtcp2_tstamp expiry) {
+  if (timeout_expiry_ <= expiry) {
+    return;
+  }
+
+  timeout_expiry_ = expiry;
+  timeout_dirty_ = true;
+}
+
+void Uring::flush() {
+  if (timeout_dirty_) {
+    timeout_dirty_ = false;
+
+    if (timeout_active_) {
+      auto sqe = get_sqe();
+
+      io_uring_prep_timeout_remove(sqe, (timeout_gen_ << 2) | URING_OP_TIMEOUT,
+                                   0);
+      io_uring_sqe_set_data64(sqe, URING_OP_NONE);
+    }
+
+    ++timeout_gen_;
+
+    // util::timestamp() is based on CLOCK_MONOTONIC which is the
+    // default clock of an absolute timeout.
+    timeout_ts_.tv_sec =
+        static_cast<long long>(timeout_expiry_ / NGTCP2_SECONDS);
+    timeout_ts_.tv_nsec =
+        static_cast<long long>(timeout_expiry_ % NGTCP2_SECONDS);
+
+    auto sqe = get_sqe();
+
+    io_uring_prep_timeout(sqe, &timeout_ts_, 0, IORING_TIMEOUT_ABS);
+    io_uring_sqe_set_data64(sqe, (timeout_gen_ << 2) | URING_OP_TIMEOUT);
+
+    timeout_active_ = true;
+  }
+
+  if (io_uring_sq_ready(&ring_) == 0) {
+    return;
+  }
+
+  io_uring_submit(&ring_);
+  ++nsyscalls_;
+}
+
+void Uring::on_read() {
+  std::array<io_uring_cqe *, 64> cqes;
+  std::array<Completion, 64> comps;
+
+  for (auto &c : deferred_) {
+    handle_completion(c);
+  }
+
+  deferred_.clear();
+
+  for (;;) {
+    auto n = io_uring_peek_batch_cqe(&ring_, cqes.data(), cqes.size());
+    if (n == 0) {
+      break;
+    }
+
+    // Copy completions first because handling them might reap more
+    // completions while sending packets.
+    for (size_t i = 0; i < n; ++i) {
+      comps[i] = {
+          .user_data = cqes[i]->user_data,
+          .res = cqes[i]->res,
+          .flags = cqes[i]->flags,
+      };
+    }
+
+    io_uring_cq_advance(&ring_, n);
+
+    for (size_t i = 0; i < n; ++i) {
+      handle_completion(comps[i]);
+    }
+  }
+
+  flush();
+}
+
+void Uring::handle_completion(const Completion &c) {
+  switch (c.user_data & URING_OP_MASK) {
+  case URING_OP_RECV:
+    on_recv(*reinterpret_cast<Endpoint *>(c.user_data & ~URING_OP_MASK), c);
+    break;
+  case URING_OP_SEND:
+    on_send(reinterpret_cast<SendSlot *>(c.user_data & ~URING_OP_MASK), c);
+    break;
+  case URING_OP_TIMEOUT:
+    on_timeout(c.user_data >> 2, c);
+    break;
+  }
+}
+
+void Uring::wait_send_slot() {
+  io_uring_cqe *cqe;
+
+  while (free_send_slots_.empty()) {
+    if (auto rv = io_uring_submit_and_wait(&ring_, 1);
+        rv < 0 && rv != -EINTR) {
+      std::cerr << "io_uring_submit_and_wait: " << strerror(-rv)
+                << std::endl;
+      assert(0);
+    }
+
+    ++nsyscalls_;
+
+    while (io_uring_peek_cqe(&ring_, &cqe) == 0) {
+      Completion c{
+          .user_data = cqe->user_data,
+          .res = cqe->res,
+          .flags = cqe->flags,
+      };
+
+      io_uring_cqe_seen(&ring_, cqe);
+
+      if ((c.user_data & URING_OP_MASK) == URING_OP_SEND) {
+        on_send(reinterpret_cast<SendSlot *>(c.user_data & ~URING_OP_MASK),
+                c);
+        continue;
+      }
+
+      // Receiving a packet here might end up sending packets from
+      // the Handler which is currently sending.  Defer it to the next
+      // event loop iteration.
+      if (deferred_.empty()) {
+        ev_feed_event(loop_, &rev_, EV_READ);
+      }
+
+      deferred_.push_back(c);
+    }
+  }
+}
+
+void Uring::on_recv(Endpoint &ep, const Completion &c) {
+  if (c.res < 0) {
+    if (c.res != -ENOBUFS) {
+      std::cerr << "recvmsg: " << strerror(-c.res) << std::endl;
+    }
+  } else {
+    assert(c.flags & IORING_CQE_F_BUFFER);
+
+    auto bid = static_cast<uint16_t>(c.flags >> IORING_CQE_BUFFER_SHIFT);
+    auto buf = bufs_.get() + bid * URING_RECV_BUFLEN;
+
+    auto o = io_uring_recvmsg_validate(buf, c.res, &recv_msg_);
+    if (o && !(o->flags & MSG_TRUNC)) {
+      auto name = static_cast<uint8_t *>(io_uring_recvmsg_name(o));
+
+      msghdr msg{};
+      msg.msg_name = name;
+      msg.msg_namelen = std::min(o->namelen, recv_msg_.msg_namelen);
+      msg.msg_control = name + recv_msg_.msg_namelen;
+      msg.msg_controllen = o->controllen;
+
+      auto payload =
+          static_cast<uint8_t *>(io_uring_recvmsg_payload(o, &recv_msg_));
+      auto payloadlen = io_uring_recvmsg_payload_length(
+          o, static_cast<int>(c.res), &recv_msg_);
+
+      server_->on_read_msg(ep, msg, {payload, payloadlen});
+    }
+
+    recycle_buf(bid);
+  }
+
+  if (c.flags & IORING_CQE_F_MORE) {
+    return;
+  }
+
+  // The multishot receive has terminated.  It is terminated with
+  // ENOBUFS if the provided buffers run out.
+  if (c.res >= 0 || c.res == -ENOBUFS) {
+    start_recv(ep);
+  }
+}
+
+void Uring::recycle_buf(uint16_t bid) {
+  io_uring_buf_ring_add(buf_ring_, bufs_.get() + bid * URING_RECV_BUFLEN,
+                        URING_RECV_BUFLEN, bid,
+                        io_uring_buf_ring_mask(URING_NUM_RECV_BUFS), 0);
+  io_uring_buf_ring_advance(buf_ring_, 1);
+}
+
+void Uring::on_send(SendSlot *slot, const Completion &c) {
+  free_send_slots_.push_back(slot);
+
+  if (c.res >= 0) {
+    return;
+  }
+
+  switch (-c.res) {
+  case EAGAIN:
+#  if EAGAIN != EWOULDBLOCK
+  case EWOULDBLOCK:
+#  endif // EAGAIN != EWOULDBLOCK
+    // Unlike sendmsg(2) on a non-blocking socket, the datagram is not
+    // retried.  Treat it as lost.
+    if (!config.quiet) {
+      std::cerr << "sendmsg: " << strerror(-c.res) << std::endl;
+    }
+
+    return;
+  case EIO:
+    if (slot->gso) {
+      // GSO failure; send each packet separately from now on.  This
+      // datagram is lost.
+      std::cerr << "sendmsg: disabling GSO due to " << strerror(-c.res)
+                << std::endl;
+
+      no_gso_ = true;
+
+      return;
+    }
+
+    break;
+  }
+
+  std::cerr << "sendmsg: " << strerror(-c.res) << std::endl;
+}
+
+void Uring::on_timeout(uint64_t gen, const Completion &c) {
+  // A timeout which is removed completes with ECANCELED.
+  if (gen != timeout_gen_ || c.res != -ETIME) {
+    return;
+  }
+
+  timeout_active_ = false;
+  timeout_expiry_ = UINT64_MAX;
+
+  server_->on_timer();
+}
+
+bool Uring::no_gso() const { return no_gso_; }
+
+uint64_t Uring::nsyscalls() const { return nsyscalls_; }
+
+#endif // HAVE_LIBURING
@@ -0,0 +1,137 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef URING_H
+#define URING_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_LIBURING
+
+#  include <vector>
+#  include <memory>
+
+#  include <liburing.h>
+
+#  include <ngtcp2/ngtcp2.h>
+
+#  include <ev.h>
+
+#  include "network.h"
+
+using namespace ngtcp2;
+
+class Server;
+struct Endpoint;
+
+// Uring performs the UDP I/O of Server through io_uring.  Each
+// endpoint has a multishot IORING_OP_RECVMSG which picks its buffers
+// from a provided buffer ring, so that a single submission keeps
+// receiving datagrams.  Outgoing datagrams are queued as
+// IORING_OP_SENDMSG, and all queued submissions are handed to the
+// kernel in one io_uring_enter call per event loop iteration.  The
+// expiry of connections is driven by IORING_OP_TIMEOUT.
+//
+// libev still runs the event loop.  It watches the ring file
+// descriptor which becomes readable when completions are posted.
+class Uring {
+public:
+  Uring(struct ev_loop *loop, Server *server);
+  ~Uring();
+
+  int init();
+  // start_recv starts receiving datagrams from |ep|.
+  void start_recv(Endpoint &ep);
+  // sendmsg queues |msg| to |fd|.  The name, control data, and the
+  // payload in |msg| are copied, so they need not outlive this call.
+  void sendmsg(int fd, const msghdr &msg);
+  // set_timeout arranges Server::on_timer to be called at |expiry|.
+  // Like the libev timer, it is rearmed only if |expiry| is earlier
+  // than the current one.
+  void set_timeout(ngtcp2_tstamp expiry);
+  // flush submits all queued submissions.
+  void flush();
+  // on_read processes the posted completions.
+  void on_read();
+  void stop();
+  // no_gso returns true if the kernel has rejected a GSO send.
+  bool no_gso() const;
+  // nsyscalls returns the number of io_uring_enter calls.
+  uint64_t nsyscalls() const;
+
+private:
+  struct SendSlot;
+
+  // Completion is a copy of io_uring_cqe.
+  struct Completion {
+    uint64_t user_data;
+    int32_t res;
+    uint32_t flags;
+  };
+
+  io_uring_sqe *get_sqe();
+  void handle_completion(const Completion &c);
+  void on_recv(Endpoint &ep, const Completion &c);
+  void on_send(SendSlot *slot, const Completion &c);
+  void on_timeout(uint64_t gen, const Completion &c);
+  void recycle_buf(uint16_t bid);
+  // wait_send_slot blocks until a send completes.
+  void wait_send_slot();
+
+  struct ev_loop *loop_;
+  Server *server_;
+  io_uring ring_;
+  bool ring_inited_;
+  ev_io rev_;
+  // prep_ runs flush before libev waits for events.
+  ev_prepare prep_;
+  io_uring_buf_ring *buf_ring_;
+  std::unique_ptr<uint8_t[]> bufs_;
+  // recv_msg_ tells the kernel how much space to reserve for the
+  // name and the control data in each provided buffer.
+  msghdr recv_msg_;
+  std::vector<SendSlot> send_slots_;
+  std::vector<SendSlot *> free_send_slots_;
+  // deferred_ contains the completions which are reaped while
+  // waiting for a send slot, and have not been handled yet.
+  std::vector<Completion> deferred_;
+  // timeout_ts_ is the absolute time of the timeout to submit.
+  __kernel_timespec timeout_ts_;
+  // timeout_expiry_ is the expiry of the timeout which is armed or
+  // about to be armed.
+  ngtcp2_tstamp timeout_expiry_;
+  // timeout_gen_ identifies the latest timeout so that the completion
+  // of the cancelled ones are ignored.
+  uint64_t timeout_gen_;
+  bool timeout_active_;
+  bool timeout_dirty_;
+  bool no_gso_;
+  uint64_t nsyscalls_;
+};
+
+#endif // HAVE_LIBURING
+
+#endif // URING_H
@@ -349,15 +349,6 @@ int hexdump(FILE *out, const void *data, size_t datalen) {
   return 0;
 }
 
-std::string_view make_cid_key(const ngtcp2_cid *cid) {
-  return make_cid_key({cid->data, cid->datalen});
-}
-
-std::string_view make_cid_key(std::span<const uint8_t> cid) {
-  return std::string_view{reinterpret_cast<const char *>(cid.data()),
-                          cid.size()};
-}
-
 std::string straddr(const sockaddr *sa, socklen_t salen) {
   std::array<char, NI_MAXHOST> host;
   std::array<char, NI_MAXSERV> port;
@@ -386,6 +377,33 @@ uint16_t port(const sockaddr_union *su) {
   }
 }
 
+std::string make_subnet_key(const sockaddr *sa) {
+  std::string res;
+
+  switch (sa->sa_family) {
+  case AF_INET: {
+    auto in = reinterpret_cast<const sockaddr_in *>(sa);
+    auto p = reinterpret_cast<const char *>(&in->sin_addr);
+
+    res += static_cast<char>(AF_INET);
+    res.append(p, 3);
+
+    return res;
+  }
+  case AF_INET6: {
+    auto in6 = reinterpret_cast<const sockaddr_in6 *>(sa);
+    auto p = reinterpret_cast<const char *>(&in6->sin6_addr);
+
+    res += static_cast<char>(AF_INET6);
+    res.append(p, 6);
+
+    return res;
+  }
+  default:
+    return res;
+  }
+}
+
 bool prohibited_port(uint16_t port) {
   switch (port) {
   case 1900:
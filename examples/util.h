@@ -146,16 +146,17 @@ template <typename S, typename T> bool istarts_with(const S &a, const T &b) {
   return istarts_with(a.begin(), a.end(), b.begin(), b.end());
 }
 
-// make_cid_key returns the key for |cid|.
-std::string_view make_cid_key(const ngtcp2_cid *cid);
-std::string_view make_cid_key(std::span<const uint8_t> cid);
-
 // straddr stringifies |sa| of length |salen| in a format "[IP]:PORT".
 std::string straddr(const sockaddr *sa, socklen_t salen);
 
 // port returns port from |su|.
 uint16_t port(const sockaddr_union *su);
 
+// make_subnet_key returns the key for the subnet which |sa| belongs
+// to.  The subnet is /24 for IPv4, and /48 for IPv6.  It returns an
+// empty string if the address family of |sa| is not supported.
+std::string make_subnet_key(const sockaddr *sa);
+
 // prohibited_port returns true if |port| is prohibited as a client
 // port.
 bool prohibited_port(uint16_t port);
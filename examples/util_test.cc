@@ -24,6 +24,10 @@
  */
 #include "util_test.h"
 
+#ifdef HAVE_ARPA_INET_H
+#  include <arpa/inet.h>
+#endif // HAVE_ARPA_INET_H
+
 #include <limits>
 #include <array>
 
@@ -45,6 +49,7 @@ const MunitTest tests[]{
     munit_void_test(test_util_normalize_path),
     munit_void_test(test_util_hexdump),
     munit_void_test(test_util_format_hex),
+    munit_void_test(test_util_make_subnet_key),
     munit_test_end(),
 };
 } // namespace
@@ -404,4 +409,44 @@ void test_util_format_hex() {
   assert_stdstring_equal("deadbeef", util::format_hex(a));
 }
 
+void test_util_make_subnet_key() {
+  sockaddr_in a{}, b{};
+  auto sa = reinterpret_cast<const sockaddr *>(&a);
+  auto sb = reinterpret_cast<const sockaddr *>(&b);
+
+  a.sin_family = AF_INET;
+  a.sin_port = htons(443);
+  inet_pton(AF_INET, "192.0.2.1", &a.sin_addr);
+
+  b.sin_family = AF_INET;
+  b.sin_port = htons(4433);
+  inet_pton(AF_INET, "192.0.2.254", &b.sin_addr);
+
+  assert_size(4, ==, util::make_subnet_key(sa).size());
+  assert_stdstring_equal(util::make_subnet_key(sa),
+                         util::make_subnet_key(sb));
+
+  inet_pton(AF_INET, "192.0.3.1", &b.sin_addr);
+
+  assert_true(util::make_subnet_key(sa) != util::make_subnet_key(sb));
+
+  sockaddr_in6 c{}, d{};
+  auto sc = reinterpret_cast<const sockaddr *>(&c);
+  auto sd = reinterpret_cast<const sockaddr *>(&d);
+
+  c.sin6_family = AF_INET6;
+  inet_pton(AF_INET6, "2001:db8:1::1", &c.sin6_addr);
+
+  d.sin6_family = AF_INET6;
+  inet_pton(AF_INET6, "2001:db8:1:ffff::2", &d.sin6_addr);
+
+  assert_size(7, ==, util::make_subnet_key(sc).size());
+  assert_stdstring_equal(util::make_subnet_key(sc),
+                         util::make_subnet_key(sd));
+
+  inet_pton(AF_INET6, "2001:db8:2::1", &d.sin6_addr);
+
+  assert_true(util::make_subnet_key(sc) != util::make_subnet_key(sd));
+}
+
 } // namespace ngtcp2
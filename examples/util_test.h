@@ -47,6 +47,7 @@ munit_void_test_decl(test_util_parse_duration);
 munit_void_test_decl(test_util_normalize_path);
 munit_void_test_decl(test_util_hexdump);
 munit_void_test_decl(test_util_format_hex);
+munit_void_test_decl(test_util_make_subnet_key);
 
 } // namespace ngtcp2
 
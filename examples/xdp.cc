@@ -0,0 +1,1001 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "xdp.h"
+
+#ifdef HAVE_AF_XDP
+
+#  include <cassert>
+#  include <cstring>
+#  include <atomic>
+#  include <algorithm>
+#  include <iostream>
+
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/socket.h>
+#  include <sys/syscall.h>
+#  include <net/if.h>
+#  include <net/ethernet.h>
+#  include <netinet/ip.h>
+#  include <netinet/ip6.h>
+#  include <netinet/udp.h>
+#  include <linux/bpf.h>
+
+#  include "server.h"
+#  include "template.h"
+#  include "util.h"
+
+namespace {
+// XDP_FRAME_SIZE is the size of a UMEM frame.
+constexpr size_t XDP_FRAME_SIZE = 2048;
+// XDP_NUM_RX_FRAMES is the number of the frames which are given to
+// the kernel for reception.  It is also the size of the fill ring
+// and the receive ring.  It must be a power of 2.
+constexpr uint32_t XDP_NUM_RX_FRAMES = 2048;
+// XDP_NUM_TX_FRAMES is the number of the frames for transmission.  It
+// is also the size of the transmit ring and the completion ring.  It
+// must be a power of 2.
+constexpr uint32_t XDP_NUM_TX_FRAMES = 2048;
+// XDP_RX_BATCH is the maximum number of the frames processed at once.
+constexpr uint32_t XDP_RX_BATCH = 64;
+// XDP_QUEUE_ID is the queue of the interface the socket is bound to.
+constexpr uint32_t XDP_QUEUE_ID = 0;
+// XDP_MAX_MAC_ADDRS is the maximum number of the remote link-layer
+// addresses to remember.
+constexpr size_t XDP_MAX_MAC_ADDRS = 4096;
+} // namespace
+
+namespace {
+uint32_t load_acquire(uint32_t *p) {
+  return std::atomic_ref<uint32_t>(*p).load(std::memory_order_acquire);
+}
+} // namespace
+
+namespace {
+void store_release(uint32_t *p, uint32_t v) {
+  std::atomic_ref<uint32_t>(*p).store(v, std::memory_order_release);
+}
+} // namespace
+
+namespace {
+int sys_bpf(int cmd, bpf_attr &attr) {
+  return static_cast<int>(syscall(__NR_bpf, cmd, &attr, sizeof(attr)));
+}
+} // namespace
+
+namespace {
+// BPFProg assembles an eBPF program.  A jump to a label which is
+// bound later is fixed up by finish.
+class BPFProg {
+public:
+  void emit(uint8_t code, uint8_t dst, uint8_t src, int16_t off,
+            int32_t imm) {
+    bpf_insn insn{};
+
+    insn.code = code;
+    insn.dst_reg = dst & 0xf;
+    insn.src_reg = src & 0xf;
+    insn.off = off;
+    insn.imm = imm;
+
+    insns_.push_back(insn);
+  }
+
+  // jmp emits a conditional jump to |label| which compares |dst| with
+  // |imm|.  If |op| is BPF_JA, it is an unconditional jump.
+  void jmp(uint8_t op, uint8_t dst, int32_t imm, size_t label) {
+    fixups_.emplace_back(insns_.size(), label);
+    emit(BPF_JMP | op | BPF_K, dst, 0, 0, imm);
+  }
+
+  // jmp_reg emits a conditional jump to |label| which compares |dst|
+  // with |src|.
+  void jmp_reg(uint8_t op, uint8_t dst, uint8_t src, size_t label) {
+    fixups_.emplace_back(insns_.size(), label);
+    emit(BPF_JMP | op | BPF_X, dst, src, 0, 0);
+  }
+
+  void bind(size_t label) {
+    if (labels_.size() <= label) {
+      labels_.resize(label + 1);
+    }
+
+    labels_[label] = insns_.size();
+  }
+
+  std::span<const bpf_insn> finish() {
+    for (auto [pos, label] : fixups_) {
+      insns_[pos].off = static_cast<int16_t>(labels_[label] - pos - 1);
+    }
+
+    return insns_;
+  }
+
+private:
+  std::vector<bpf_insn> insns_;
+  std::vector<std::pair<size_t, size_t>> fixups_;
+  std::vector<size_t> labels_;
+};
+} // namespace
+
+namespace {
+// mac_addr_key returns the key of Xdp::mac_addrs_ for |sa|.  IPv4
+// address is mapped to IPv6.
+std::array<uint8_t, 16> mac_addr_key(const sockaddr *sa) {
+  std::array<uint8_t, 16> key{};
+
+  switch (sa->sa_family) {
+  case AF_INET: {
+    auto &addr = reinterpret_cast<const sockaddr_in *>(sa)->sin_addr;
+
+    key[10] = 0xff;
+    key[11] = 0xff;
+    memcpy(key.data() + 12, &addr, sizeof(addr));
+
+    break;
+  }
+  case AF_INET6: {
+    auto &addr = reinterpret_cast<const sockaddr_in6 *>(sa)->sin6_addr;
+
+    memcpy(key.data(), &addr, sizeof(addr));
+
+    break;
+  }
+  }
+
+  return key;
+}
+} // namespace
+
+namespace {
+uint64_t cksum_add(uint64_t sum, const uint8_t *p, size_t len) {
+  for (; len > 1; p += 2, len -= 2) {
+    sum += static_cast<uint64_t>((p[0] << 8) | p[1]);
+  }
+
+  if (len) {
+    sum += static_cast<uint64_t>(p[0] << 8);
+  }
+
+  return sum;
+}
+} // namespace
+
+namespace {
+uint16_t cksum_fold(uint64_t sum) {
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+
+  return static_cast<uint16_t>(~sum);
+}
+} // namespace
+
+namespace {
+// write_frame writes a UDP datagram |data| from |local_addr| to
+// |remote_addr| with Ethernet, IP, and UDP headers to |frame|.  It
+// returns the length of the frame.
+size_t write_frame(uint8_t *frame, const std::array<uint8_t, 6> &dst_mac,
+                   const std::array<uint8_t, 6> &src_mac,
+                   const sockaddr *local_addr, const sockaddr *remote_addr,
+                   unsigned int ecn, std::span<const uint8_t> data) {
+  ether_header eh;
+
+  memcpy(eh.ether_dhost, dst_mac.data(), dst_mac.size());
+  memcpy(eh.ether_shost, src_mac.data(), src_mac.size());
+
+  auto p = frame + sizeof(eh);
+  udphdr uh{};
+  uint64_t sum;
+
+  uh.uh_ulen = htons(static_cast<uint16_t>(sizeof(uh) + data.size()));
+
+  if (local_addr->sa_family == AF_INET) {
+    auto local = reinterpret_cast<const sockaddr_in *>(local_addr);
+    auto remote = reinterpret_cast<const sockaddr_in *>(remote_addr);
+    iphdr ih{};
+
+    eh.ether_type = htons(ETHERTYPE_IP);
+
+    ih.version = 4;
+    ih.ihl = sizeof(ih) / 4;
+    ih.tos = static_cast<uint8_t>(ecn);
+    ih.tot_len =
+        htons(static_cast<uint16_t>(sizeof(ih) + sizeof(uh) + data.size()));
+    ih.frag_off = htons(IP_DF);
+    ih.ttl = 64;
+    ih.protocol = IPPROTO_UDP;
+    ih.saddr = local->sin_addr.s_addr;
+    ih.daddr = remote->sin_addr.s_addr;
+    ih.check = htons(cksum_fold(
+        cksum_add(0, reinterpret_cast<uint8_t *>(&ih), sizeof(ih))));
+
+    memcpy(p, &ih, sizeof(ih));
+    p += sizeof(ih);
+
+    uh.uh_sport = local->sin_port;
+    uh.uh_dport = remote->sin_port;
+
+    sum = cksum_add(0, reinterpret_cast<uint8_t *>(&ih.saddr),
+                    sizeof(ih.saddr) + sizeof(ih.daddr));
+  } else {
+    auto local = reinterpret_cast<const sockaddr_in6 *>(local_addr);
+    auto remote = reinterpret_cast<const sockaddr_in6 *>(remote_addr);
+    ip6_hdr ih{};
+
+    eh.ether_type = htons(ETHERTYPE_IPV6);
+
+    ih.ip6_flow = htonl((6u << 28) | (ecn << 20));
+    ih.ip6_plen = uh.uh_ulen;
+    ih.ip6_nxt = IPPROTO_UDP;
+    ih.ip6_hlim = 64;
+    ih.ip6_src = local->sin6_addr;
+    ih.ip6_dst = remote->sin6_addr;
+
+    memcpy(p, &ih, sizeof(ih));
+    p += sizeof(ih);
+
+    uh.uh_sport = local->sin6_port;
+    uh.uh_dport = remote->sin6_port;
+
+    sum = cksum_add(0, reinterpret_cast<uint8_t *>(&ih.ip6_src),
+                    sizeof(ih.ip6_src) + sizeof(ih.ip6_dst));
+  }
+
+  memcpy(frame, &eh, sizeof(eh));
+
+  // The pseudo header, the UDP header, and the payload.
+  sum += IPPROTO_UDP + ntohs(uh.uh_ulen);
+  sum = cksum_add(sum, reinterpret_cast<uint8_t *>(&uh), sizeof(uh));
+  sum = cksum_add(sum, data.data(), data.size());
+
+  auto cksum = cksum_fold(sum);
+  uh.uh_sum = htons(cksum == 0 ? 0xffff : cksum);
+
+  memcpy(p, &uh, sizeof(uh));
+  p += sizeof(uh);
+
+  p = std::copy_n(data.data(), data.size(), p);
+
+  return static_cast<size_t>(p - frame);
+}
+} // namespace
+
+Xdp::Xdp(struct ev_loop *loop, Server *server)
+    : loop_(loop),
+      server_(server),
+      fd_(-1),
+      map_fd_(-1),
+      prog_fd_(-1),
+      link_fd_(-1),
+      ifindex_(0),
+      umem_(nullptr),
+      umemlen_(0),
+      rx_{},
+      tx_{},
+      fill_{},
+      comp_{},
+      tx_pending_(false),
+      nsyscalls_(0) {
+  ev_io_init(
+      &rev_,
+      [](struct ev_loop *loop, ev_io *w, int revents) {
+        auto xdp = static_cast<Xdp *>(w->data);
+
+        xdp->on_read();
+      },
+      0, EV_READ);
+  rev_.data = this;
+
+  ev_prepare_init(&prep_, [](struct ev_loop *loop, ev_prepare *w,
+                             int revents) {
+    auto xdp = static_cast<Xdp *>(w->data);
+
+    xdp->flush();
+  });
+  prep_.data = this;
+}
+
+Xdp::~Xdp() {
+  stop();
+
+  // Closing link_fd_ detaches the XDP program.
+  for (auto fd : {link_fd_, prog_fd_, map_fd_}) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+
+  for (auto ring : {&rx_, &tx_, &fill_, &comp_}) {
+    if (ring->map) {
+      munmap(ring->map, ring->maplen);
+    }
+  }
+
+  if (fd_ != -1) {
+    close(fd_);
+  }
+
+  if (umem_) {
+    munmap(umem_, umemlen_);
+  }
+}
+
+int Xdp::init(std::string_view ifname, std::span<Endpoint> endpoints) {
+  endpoints_ = endpoints;
+
+  ifindex_ = if_nametoindex(std::string{ifname}.c_str());
+  if (ifindex_ == 0) {
+    std::cerr << "if_nametoindex: " << ifname << ": " << strerror(errno)
+              << std::endl;
+    return -1;
+  }
+
+  fd_ = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+  if (fd_ == -1) {
+    std::cerr << "socket: AF_XDP: " << strerror(errno) << std::endl;
+    return -1;
+  }
+
+  umemlen_ = (XDP_NUM_RX_FRAMES + XDP_NUM_TX_FRAMES) * XDP_FRAME_SIZE;
+
+  auto p = mmap(nullptr, umemlen_, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    std::cerr << "mmap: " << strerror(errno) << std::endl;
+    return -1;
+  }
+
+  umem_ = static_cast<uint8_t *>(p);
+
+  xdp_umem_reg mr{};
+  mr.addr = reinterpret_cast<uintptr_t>(umem_);
+  mr.len = umemlen_;
+  mr.chunk_size = XDP_FRAME_SIZE;
+
+  if (setsockopt(fd_, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr)) != 0) {
+    std::cerr << "setsockopt: XDP_UMEM_REG: " << strerror(errno)
+              << std::endl;
+    return -1;
+  }
+
+  for (auto [opt, size] : {
+           std::pair{XDP_UMEM_FILL_RING, XDP_NUM_RX_FRAMES},
+           std::pair{XDP_RX_RING, XDP_NUM_RX_FRAMES},
+           std::pair{XDP_UMEM_COMPLETION_RING, XDP_NUM_TX_FRAMES},
+           std::pair{XDP_TX_RING, XDP_NUM_TX_FRAMES},
+       }) {
+    if (setsockopt(fd_, SOL_XDP, opt, &size, sizeof(size)) != 0) {
+      std::cerr << "setsockopt: XDP ring size: " << strerror(errno)
+                << std::endl;
+      return -1;
+    }
+  }
+
+  xdp_mmap_offsets off;
+  socklen_t offlen = sizeof(off);
+
+  if (getsockopt(fd_, SOL_XDP, XDP_MMAP_OFFSETS, &off, &offlen) != 0) {
+    std::cerr << "getsockopt: XDP_MMAP_OFFSETS: " << strerror(errno)
+              << std::endl;
+    return -1;
+  }
+
+  if (map_ring(rx_, off.rx, XDP_NUM_RX_FRAMES, sizeof(xdp_desc),
+               XDP_PGOFF_RX_RING) != 0 ||
+      map_ring(tx_, off.tx, XDP_NUM_TX_FRAMES, sizeof(xdp_desc),
+               XDP_PGOFF_TX_RING) != 0 ||
+      map_ring(fill_, off.fr, XDP_NUM_RX_FRAMES, sizeof(uint64_t),
+               XDP_UMEM_PGOFF_FILL_RING) != 0 ||
+      map_ring(comp_, off.cr, XDP_NUM_TX_FRAMES, sizeof(uint64_t),
+               XDP_UMEM_PGOFF_COMPLETION_RING) != 0) {
+    return -1;
+  }
+
+  // The first XDP_NUM_RX_FRAMES frames are for reception, and the
+  // rest is for transmission.
+  auto fill_descs = static_cast<uint64_t *>(fill_.descs);
+
+  for (uint32_t i = 0; i < XDP_NUM_RX_FRAMES; ++i) {
+    fill_descs[i] = i * XDP_FRAME_SIZE;
+  }
+
+  store_release(fill_.producer, XDP_NUM_RX_FRAMES);
+
+  free_frames_.reserve(XDP_NUM_TX_FRAMES);
+
+  for (uint32_t i = 0; i < XDP_NUM_TX_FRAMES; ++i) {
+    free_frames_.push_back((XDP_NUM_RX_FRAMES + i) * XDP_FRAME_SIZE);
+  }
+
+  sockaddr_xdp sxdp{};
+  sxdp.sxdp_family = AF_XDP;
+  sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP;
+  sxdp.sxdp_ifindex = ifindex_;
+  sxdp.sxdp_queue_id = XDP_QUEUE_ID;
+
+  if (bind(fd_, reinterpret_cast<sockaddr *>(&sxdp), sizeof(sxdp)) != 0) {
+    std::cerr << "bind: AF_XDP: " << ifname << ": " << strerror(errno)
+              << std::endl;
+    return -1;
+  }
+
+  if (load_prog(endpoints) != 0) {
+    return -1;
+  }
+
+  ev_io_set(&rev_, fd_, EV_READ);
+  ev_io_start(loop_, &rev_);
+  ev_prepare_start(loop_, &prep_);
+
+  kick_rx();
+
+  return 0;
+}
+
+int Xdp::map_ring(Ring &ring, const xdp_ring_offset &off, uint32_t size,
+                  size_t desclen, off_t pgoff) {
+  ring.maplen = off.desc + size * desclen;
+
+  auto p = mmap(nullptr, ring.maplen, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd_, pgoff);
+  if (p == MAP_FAILED) {
+    std::cerr << "mmap: AF_XDP ring: " << strerror(errno) << std::endl;
+    return -1;
+  }
+
+  auto base = static_cast<uint8_t *>(p);
+
+  ring.map = p;
+  ring.producer = reinterpret_cast<uint32_t *>(base + off.producer);
+  ring.consumer = reinterpret_cast<uint32_t *>(base + off.consumer);
+  ring.flags = reinterpret_cast<uint32_t *>(base + off.flags);
+  ring.descs = base + off.desc;
+  ring.mask = size - 1;
+
+  return 0;
+}
+
+int Xdp::load_prog(std::span<Endpoint> endpoints) {
+  bpf_attr attr{};
+
+  attr.map_type = BPF_MAP_TYPE_XSKMAP;
+  attr.key_size = sizeof(uint32_t);
+  attr.value_size = sizeof(uint32_t);
+  attr.max_entries = XDP_QUEUE_ID + 1;
+
+  map_fd_ = sys_bpf(BPF_MAP_CREATE, attr);
+  if (map_fd_ == -1) {
+    std::cerr << "bpf: BPF_MAP_CREATE: " << strerror(errno) << std::endl;
+    return -1;
+  }
+
+  uint32_t key = XDP_QUEUE_ID;
+  uint32_t value = static_cast<uint32_t>(fd_);
+
+  attr = {};
+  attr.map_fd = static_cast<uint32_t>(map_fd_);
+  attr.key = reinterpret_cast<uintptr_t>(&key);
+  attr.value = reinterpret_cast<uintptr_t>(&value);
+
+  if (sys_bpf(BPF_MAP_UPDATE_ELEM, attr) != 0) {
+    std::cerr << "bpf: BPF_MAP_UPDATE_ELEM: " << strerror(errno) << std::endl;
+    return -1;
+  }
+
+  // The program below redirects IPv4 and IPv6 UDP datagrams to one of
+  // the ports of |endpoints| to the socket.  IPv4 packets with options
+  // or fragments, and IPv6 packets with extension headers are passed
+  // to the kernel.  The 16 bits fields are compared in network byte
+  // order.
+  enum {
+    LABEL_IPV4,
+    LABEL_PORT,
+    LABEL_REDIRECT,
+    LABEL_PASS,
+  };
+
+  BPFProg prog;
+
+  // r6 = ctx
+  prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0);
+  // r2 = ctx->data, r3 = ctx->data_end
+  prog.emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6,
+            offsetof(xdp_md, data), 0);
+  prog.emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_3, BPF_REG_6,
+            offsetof(xdp_md, data_end), 0);
+  // Ethernet + IPv4 + UDP
+  prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+  prog.emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0,
+            sizeof(ether_header) + sizeof(iphdr) + sizeof(udphdr));
+  prog.jmp_reg(BPF_JGT, BPF_REG_4, BPF_REG_3, LABEL_PASS);
+  // r5 = ether_type
+  prog.emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2,
+            offsetof(ether_header, ether_type), 0);
+  prog.jmp(BPF_JEQ, BPF_REG_5, htons(ETHERTYPE_IP), LABEL_IPV4);
+  prog.jmp(BPF_JNE, BPF_REG_5, htons(ETHERTYPE_IPV6), LABEL_PASS);
+  // Ethernet + IPv6 + UDP
+  prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+  prog.emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0,
+            sizeof(ether_header) + sizeof(ip6_hdr) + sizeof(udphdr));
+  prog.jmp_reg(BPF_JGT, BPF_REG_4, BPF_REG_3, LABEL_PASS);
+  prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2,
+            sizeof(ether_header) + offsetof(ip6_hdr, ip6_nxt), 0);
+  prog.jmp(BPF_JNE, BPF_REG_5, IPPROTO_UDP, LABEL_PASS);
+  prog.emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2,
+            sizeof(ether_header) + sizeof(ip6_hdr) + offsetof(udphdr, uh_dport),
+            0);
+  prog.jmp(BPF_JA, 0, 0, LABEL_PORT);
+
+  prog.bind(LABEL_IPV4);
+  // version and ihl
+  prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2,
+            sizeof(ether_header), 0);
+  prog.jmp(BPF_JNE, BPF_REG_5, 0x45, LABEL_PASS);
+  // MF and fragment offset
+  prog.emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2,
+            sizeof(ether_header) + offsetof(iphdr, frag_off), 0);
+  prog.emit(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0,
+            htons(IP_MF | IP_OFFMASK));
+  prog.jmp(BPF_JNE, BPF_REG_5, 0, LABEL_PASS);
+  prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2,
+            sizeof(ether_header) + offsetof(iphdr, protocol), 0);
+  prog.jmp(BPF_JNE, BPF_REG_5, IPPROTO_UDP, LABEL_PASS);
+  prog.emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2,
+            sizeof(ether_header) + sizeof(iphdr) + offsetof(udphdr, uh_dport),
+            0);
+
+  prog.bind(LABEL_PORT);
+
+  std::vector<uint16_t> ports;
+
+  for (auto &ep : endpoints) {
+    auto port = htons(util::port(&ep.addr.su));
+
+    if (std::find(std::begin(ports), std::end(ports), port) !=
+        std::end(ports)) {
+      continue;
+    }
+
+    ports.push_back(port);
+    prog.jmp(BPF_JEQ, BPF_REG_5, port, LABEL_REDIRECT);
+  }
+
+  prog.jmp(BPF_JA, 0, 0, LABEL_PASS);
+
+  prog.bind(LABEL_REDIRECT);
+  // bpf_redirect_map(map, ctx->rx_queue_index, XDP_PASS)
+  prog.emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6,
+            offsetof(xdp_md, rx_queue_index), 0);
+  prog.emit(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0,
+            map_fd_);
+  prog.emit(0, 0, 0, 0, 0);
+  prog.emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS);
+  prog.emit(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map);
+  prog.emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+  prog.bind(LABEL_PASS);
+  prog.emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS);
+  prog.emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+  auto insns = prog.finish();
+  std::array<char, 4096> log{};
+  static constexpr char license[] = "Dual MIT/GPL";
+
+  attr = {};
+  attr.prog_type = BPF_PROG_TYPE_XDP;
+  attr.insns = reinterpret_cast<uintptr_t>(insns.data());
+  attr.insn_cnt = static_cast<uint32_t>(insns.size());
+  attr.license = reinterpret_cast<uintptr_t>(license);
+  attr.log_buf = reinterpret_cast<uintptr_t>(log.data());
+  attr.log_size = log.size();
+  attr.log_level = 1;
+
+  prog_fd_ = sys_bpf(BPF_PROG_LOAD, attr);
+  if (prog_fd_ == -1) {
+    std::cerr << "bpf: BPF_PROG_LOAD: " << strerror(errno) << std::endl
+              << log.data() << std::endl;
+    return -1;
+  }
+
+  attr = {};
+  attr.link_create.prog_fd = static_cast<uint32_t>(prog_fd_);
+  attr.link_create.target_ifindex = ifindex_;
+  attr.link_create.attach_type = BPF_XDP;
+
+  link_fd_ = sys_bpf(BPF_LINK_CREATE, attr);
+  if (link_fd_ == -1) {
+    std::cerr << "bpf: BPF_LINK_CREATE: " << strerror(errno) << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
+
+void Xdp::on_read() {
+  std::array<uint64_t, XDP_RX_BATCH> addrs;
+  auto descs = static_cast<xdp_desc *>(rx_.descs);
+  auto fill_descs = static_cast<uint64_t *>(fill_.descs);
+
+  for (;;) {
+    auto cons = *rx_.consumer;
+    auto n = std::min(load_acquire(rx_.producer) - cons, XDP_RX_BATCH);
+    if (n == 0) {
+      kick_rx();
+
+      return;
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+      auto &desc = descs[(cons + i) & rx_.mask];
+
+      handle_frame(umem_ + desc.addr, desc.len);
+
+      addrs[i] = desc.addr & ~static_cast<uint64_t>(XDP_FRAME_SIZE - 1);
+    }
+
+    store_release(rx_.consumer, cons + n);
+
+    // The fill ring has room for all frames for reception.
+    auto prod = *fill_.producer;
+
+    for (uint32_t i = 0; i < n; ++i) {
+      fill_descs[(prod + i) & fill_.mask] = addrs[i];
+    }
+
+    store_release(fill_.producer, prod + n);
+  }
+}
+
+void Xdp::handle_frame(uint8_t *frame, size_t len) {
+  // The XDP program has checked the headers except for the lengths
+  // in them.  Checksums are not verified because QUIC packets are
+  // authenticated.
+  ether_header eh;
+
+  if (len < sizeof(eh)) {
+    return;
+  }
+
+  memcpy(&eh, frame, sizeof(eh));
+
+  auto p = frame + sizeof(eh);
+  auto end = frame + len;
+  sockaddr_union remote{}, local{};
+  socklen_t namelen;
+  unsigned int ecn;
+
+  switch (ntohs(eh.ether_type)) {
+  case ETHERTYPE_IP: {
+    iphdr ih;
+
+    if (static_cast<size_t>(end - p) < sizeof(ih)) {
+      return;
+    }
+
+    memcpy(&ih, p, sizeof(ih));
+
+    if (ntohs(ih.tot_len) > end - p) {
+      return;
+    }
+
+    end = p + ntohs(ih.tot_len);
+    p += sizeof(ih);
+    ecn = ih.tos & IPTOS_ECN_MASK;
+
+    remote.in.sin_family = AF_INET;
+    remote.in.sin_addr.s_addr = ih.saddr;
+    local.in.sin_family = AF_INET;
+    local.in.sin_addr.s_addr = ih.daddr;
+    namelen = sizeof(remote.in);
+
+    break;
+  }
+  case ETHERTYPE_IPV6: {
+    ip6_hdr ih;
+
+    if (static_cast<size_t>(end - p) < sizeof(ih)) {
+      return;
+    }
+
+    memcpy(&ih, p, sizeof(ih));
+
+    if (ntohs(ih.ip6_plen) > end - p - sizeof(ih)) {
+      return;
+    }
+
+    p += sizeof(ih);
+    end = p + ntohs(ih.ip6_plen);
+    ecn = (ntohl(ih.ip6_flow) >> 20) & IPTOS_ECN_MASK;
+
+    remote.in6.sin6_family = AF_INET6;
+    remote.in6.sin6_addr = ih.ip6_src;
+    local.in6.sin6_family = AF_INET6;
+    local.in6.sin6_addr = ih.ip6_dst;
+    namelen = sizeof(remote.in6);
+
+    break;
+  }
+  default:
+    return;
+  }
+
+  udphdr uh;
+
+  if (static_cast<size_t>(end - p) < sizeof(uh)) {
+    return;
+  }
+
+  memcpy(&uh, p, sizeof(uh));
+
+  if (ntohs(uh.uh_ulen) < sizeof(uh) || ntohs(uh.uh_ulen) > end - p) {
+    return;
+  }
+
+  end = p + ntohs(uh.uh_ulen);
+  p += sizeof(uh);
+
+  // sin_port and sin6_port are at the same offset.
+  remote.in.sin_port = uh.uh_sport;
+  local.in.sin_port = uh.uh_dport;
+
+  auto ep = find_endpoint(&local.sa);
+  if (!ep) {
+    return;
+  }
+
+  auto key = mac_addr_key(&remote.sa);
+  if (mac_addrs_.size() >= XDP_MAX_MAC_ADDRS && !mac_addrs_.contains(key)) {
+    mac_addrs_.erase(std::begin(mac_addrs_));
+  }
+
+  auto &mac = mac_addrs_[key];
+  memcpy(mac.remote.data(), eh.ether_shost, mac.remote.size());
+  memcpy(mac.local.data(), eh.ether_dhost, mac.local.size());
+
+  // Make up the control data which recvmsg would return.
+  alignas(cmsghdr) std::array<uint8_t, CMSG_SPACE(sizeof(in6_pktinfo)) +
+                                           CMSG_SPACE(sizeof(int))>
+      ctrl{};
+  msghdr msg{};
+
+  msg.msg_name = &remote;
+  msg.msg_namelen = namelen;
+  msg.msg_control = ctrl.data();
+  msg.msg_controllen = ctrl.size();
+
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+
+  if (local.sa.sa_family == AF_INET) {
+    in_pktinfo pktinfo{};
+    pktinfo.ipi_ifindex = static_cast<int>(ifindex_);
+    pktinfo.ipi_addr = local.in.sin_addr;
+
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type = IP_PKTINFO;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(pktinfo));
+    memcpy(CMSG_DATA(cmsg), &pktinfo, sizeof(pktinfo));
+
+    cmsg = CMSG_NXTHDR(&msg, cmsg);
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type = IP_TOS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+    *CMSG_DATA(cmsg) = static_cast<uint8_t>(ecn);
+
+    msg.msg_controllen =
+        CMSG_SPACE(sizeof(pktinfo)) + CMSG_SPACE(sizeof(uint8_t));
+  } else {
+    in6_pktinfo pktinfo{};
+    pktinfo.ipi6_ifindex = ifindex_;
+    pktinfo.ipi6_addr = local.in6.sin6_addr;
+
+    cmsg->cmsg_level = IPPROTO_IPV6;
+    cmsg->cmsg_type = IPV6_PKTINFO;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(pktinfo));
+    memcpy(CMSG_DATA(cmsg), &pktinfo, sizeof(pktinfo));
+
+    auto tclass = static_cast<int>(ecn);
+
+    cmsg = CMSG_NXTHDR(&msg, cmsg);
+    cmsg->cmsg_level = IPPROTO_IPV6;
+    cmsg->cmsg_type = IPV6_TCLASS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(tclass));
+    memcpy(CMSG_DATA(cmsg), &tclass, sizeof(tclass));
+
+    msg.msg_controllen =
+        CMSG_SPACE(sizeof(pktinfo)) + CMSG_SPACE(sizeof(tclass));
+  }
+
+  server_->on_read_msg(*ep, msg, {p, static_cast<size_t>(end - p)});
+}
+
+Endpoint *Xdp::find_endpoint(const sockaddr *sa) {
+  for (auto &ep : endpoints_) {
+    if (ep.addr.su.sa.sa_family != sa->sa_family) {
+      continue;
+    }
+
+    if (sa->sa_family == AF_INET) {
+      auto &addr = ep.addr.su.in;
+      auto in = reinterpret_cast<const sockaddr_in *>(sa);
+
+      if (addr.sin_port == in->sin_port &&
+          (addr.sin_addr.s_addr == INADDR_ANY ||
+           addr.sin_addr.s_addr == in->sin_addr.s_addr)) {
+        return &ep;
+      }
+
+      continue;
+    }
+
+    auto &addr = ep.addr.su.in6;
+    auto in6 = reinterpret_cast<const sockaddr_in6 *>(sa);
+
+    if (addr.sin6_port == in6->sin6_port &&
+        (IN6_IS_ADDR_UNSPECIFIED(&addr.sin6_addr) ||
+         IN6_ARE_ADDR_EQUAL(&addr.sin6_addr, &in6->sin6_addr))) {
+      return &ep;
+    }
+  }
+
+  return nullptr;
+}
+
+int Xdp::send(const ngtcp2_addr &local_addr, const ngtcp2_addr &remote_addr,
+              unsigned int ecn, std::span<const uint8_t> data,
+              size_t gso_size) {
+  auto hdrlen = sizeof(ether_header) + sizeof(udphdr) +
+                (remote_addr.addr->sa_family == AF_INET ? sizeof(iphdr)
+                                                        : sizeof(ip6_hdr));
+  if (hdrlen + std::min(gso_size, data.size()) > XDP_FRAME_SIZE) {
+    return -1;
+  }
+
+  auto it = mac_addrs_.find(mac_addr_key(remote_addr.addr));
+  if (it == std::end(mac_addrs_)) {
+    return -1;
+  }
+
+  auto &mac = (*it).second;
+  auto nframes = (data.size() + gso_size - 1) / gso_size;
+
+  if (free_frames_.size() < nframes) {
+    reclaim();
+
+    if (free_frames_.size() < nframes) {
+      return NETWORK_ERR_SEND_BLOCKED;
+    }
+  }
+
+  auto descs = static_cast<xdp_desc *>(tx_.descs);
+  auto prod = *tx_.producer;
+
+  // A frame not in free_frames_ occupies the transmit ring or the
+  // completion ring, so that the transmit ring has room for all free
+  // frames.
+  assert(XDP_NUM_TX_FRAMES - (prod - load_acquire(tx_.consumer)) >=
+         nframes);
+
+  for (; !data.empty(); ++prod) {
+    auto len = std::min(gso_size, data.size());
+    auto addr = free_frames_.back();
+
+    free_frames_.pop_back();
+
+    auto &desc = descs[prod & tx_.mask];
+
+    desc.addr = addr;
+    desc.len = static_cast<uint32_t>(
+        write_frame(umem_ + addr, mac.remote, mac.local, local_addr.addr,
+                    remote_addr.addr, ecn, {data.data(), len}));
+    desc.options = 0;
+
+    data = data.subspan(len);
+  }
+
+  store_release(tx_.producer, prod);
+
+  tx_pending_ = true;
+
+  return 0;
+}
+
+void Xdp::reclaim() {
+  auto descs = static_cast<uint64_t *>(comp_.descs);
+  auto cons = *comp_.consumer;
+  auto prod = load_acquire(comp_.producer);
+
+  for (; cons != prod; ++cons) {
+    free_frames_.push_back(descs[cons & comp_.mask]);
+  }
+
+  store_release(comp_.consumer, cons);
+}
+
+void Xdp::kick_tx() {
+  if (!tx_pending_) {
+    return;
+  }
+
+  tx_pending_ = false;
+
+  if (!(load_acquire(tx_.flags) & XDP_RING_NEED_WAKEUP)) {
+    return;
+  }
+
+  ++nsyscalls_;
+
+  if (sendto(fd_, nullptr, 0, MSG_DONTWAIT, nullptr, 0) == -1) {
+    switch (errno) {
+    case EAGAIN:
+    case EBUSY:
+    case ENOBUFS:
+    case ENETDOWN:
+      // The frames are transmitted by the next kick.
+      tx_pending_ = true;
+
+      return;
+    }
+
+    std::cerr << "sendto: AF_XDP: " << strerror(errno) << std::endl;
+  }
+}
+
+void Xdp::kick_rx() {
+  // A driver which has run out of the frames in the fill ring stops
+  // receiving until it is woken up.  No event is reported to the
+  // socket until then.
+  if (!(load_acquire(fill_.flags) & XDP_RING_NEED_WAKEUP)) {
+    return;
+  }
+
+  ++nsyscalls_;
+
+  if (recvfrom(fd_, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr) == -1) {
+    switch (errno) {
+    case EAGAIN:
+    case EBUSY:
+    case ENOBUFS:
+    case ENETDOWN:
+      return;
+    }
+
+    std::cerr << "recvfrom: AF_XDP: " << strerror(errno) << std::endl;
+  }
+}
+
+void Xdp::flush() {
+  kick_tx();
+  reclaim();
+}
+
+void Xdp::stop() {
+  ev_prepare_stop(loop_, &prep_);
+  ev_io_stop(loop_, &rev_);
+}
+
+uint64_t Xdp::nsyscalls() const { return nsyscalls_; }
+
+#endif // HAVE_AF_XDP
@@ -0,0 +1,160 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef XDP_H
+#define XDP_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif // HAVE_CONFIG_H
+
+#if defined(HAVE_LINUX_IF_XDP_H) && defined(HAVE_LINUX_BPF_H)
+#  define HAVE_AF_XDP 1
+#endif // HAVE_LINUX_IF_XDP_H && HAVE_LINUX_BPF_H
+
+#ifdef HAVE_AF_XDP
+
+#  include <vector>
+#  include <map>
+#  include <array>
+#  include <span>
+#  include <string_view>
+
+#  include <linux/if_xdp.h>
+
+#  include <ngtcp2/ngtcp2.h>
+
+#  include <ev.h>
+
+#  include "network.h"
+
+using namespace ngtcp2;
+
+class Server;
+struct Endpoint;
+
+// Xdp receives and sends the UDP datagrams of Server through an
+// AF_XDP socket bound to the queue 0 of a network interface.  An XDP
+// program attached to the interface redirects the UDP datagrams
+// destined to the ports of the endpoints to the socket, and passes
+// everything else to the kernel.  Received frames are processed in
+// place in UMEM, and the outgoing datagrams are written to UMEM
+// frames with Ethernet, IP, and UDP headers built here.
+//
+// The link-layer address of a remote endpoint is learned from the
+// frames received from it.  A datagram to a remote endpoint which
+// has not been seen yet, or a datagram which does not fit in a frame
+// is sent by the kernel through the UDP socket of Endpoint, which
+// remains open.
+//
+// See README.rst for how to try it with a veth pair.
+class Xdp {
+public:
+  Xdp(struct ev_loop *loop, Server *server);
+  ~Xdp();
+
+  // init creates an AF_XDP socket on |ifname|, and attaches the XDP
+  // program which steers the datagrams to |endpoints|.
+  int init(std::string_view ifname, std::span<Endpoint> endpoints);
+  // send writes |data| which is a GSO batch of |gso_size| bytes
+  // datagrams to the transmit ring.  It returns 0 if it succeeds,
+  // NETWORK_ERR_SEND_BLOCKED if there are not enough free frames, or
+  // -1 if |data| cannot be sent through the AF_XDP socket, in which
+  // case the caller should send it through the UDP socket.
+  int send(const ngtcp2_addr &local_addr, const ngtcp2_addr &remote_addr,
+           unsigned int ecn, std::span<const uint8_t> data, size_t gso_size);
+  // flush kicks the kernel to transmit the frames written by send,
+  // and reclaims the frames which have been transmitted.
+  void flush();
+  // on_read processes the frames in the receive ring, and returns
+  // them to the fill ring.
+  void on_read();
+  void stop();
+  // nsyscalls returns the number of the system calls made to kick
+  // the kernel.
+  uint64_t nsyscalls() const;
+
+private:
+  // Ring is a view of a ring mapped from the kernel.
+  struct Ring {
+    uint32_t *producer;
+    uint32_t *consumer;
+    uint32_t *flags;
+    void *descs;
+    uint32_t mask;
+    void *map;
+    size_t maplen;
+  };
+
+  // MacAddr is the pair of the link-layer address of the remote
+  // endpoint and ours.
+  struct MacAddr {
+    std::array<uint8_t, 6> remote;
+    std::array<uint8_t, 6> local;
+  };
+
+  int map_ring(Ring &ring, const xdp_ring_offset &off, uint32_t size,
+               size_t desclen, off_t pgoff);
+  int load_prog(std::span<Endpoint> endpoints);
+  void handle_frame(uint8_t *frame, size_t len);
+  Endpoint *find_endpoint(const sockaddr *sa);
+  // reclaim moves the transmitted frames to free_frames_.
+  void reclaim();
+  void kick_tx();
+  // kick_rx wakes up the driver if it needs the frames in the fill
+  // ring to receive.
+  void kick_rx();
+
+  struct ev_loop *loop_;
+  Server *server_;
+  std::span<Endpoint> endpoints_;
+  int fd_;
+  int map_fd_;
+  int prog_fd_;
+  int link_fd_;
+  uint32_t ifindex_;
+  uint8_t *umem_;
+  size_t umemlen_;
+  Ring rx_;
+  Ring tx_;
+  Ring fill_;
+  Ring comp_;
+  // free_frames_ contains the addresses of the frames which are
+  // available for transmission.
+  std::vector<uint64_t> free_frames_;
+  // mac_addrs_ is the link-layer address of the remote endpoint keyed
+  // by its IP address.
+  std::map<std::array<uint8_t, 16>, MacAddr> mac_addrs_;
+  ev_io rev_;
+  // prep_ runs flush before libev waits for events.
+  ev_prepare prep_;
+  // tx_pending_ is true if frames are written to the transmit ring
+  // since the last kick.
+  bool tx_pending_;
+  uint64_t nsyscalls_;
+};
+
+#endif // HAVE_AF_XDP
+
+#endif // XDP_H
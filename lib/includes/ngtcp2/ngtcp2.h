@@ -1588,6 +1588,194 @@ typedef struct ngtcp2_conn_info {
   uint64_t bytes_in_flight;
 } ngtcp2_conn_info;
 
+#define NGTCP2_PATH_CAPACITY_V1 1
+#define NGTCP2_PATH_CAPACITY_VERSION NGTCP2_PATH_CAPACITY_V1
+
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_path_capacity` is a snapshot of the capacity of a
+ * network path observed by a connection.  Application can obtain it
+ * by `ngtcp2_conn_get_path_capacity`, store it, and give it to a
+ * later connection over the same path by
+ * `ngtcp2_conn_set_path_capacity` in order to enable Careful Resume
+ * (see
+ * https://datatracker.ietf.org/doc/html/draft-ietf-tsvwg-careful-resume).
+ * This struct has been available since v1.7.0.
+ */
+typedef struct ngtcp2_path_capacity {
+  /**
+   * :member:`cwnd` is the size of congestion window.
+   */
+  uint64_t cwnd;
+  /**
+   * :member:`min_rtt` is the minimum RTT observed on the path.
+   */
+  ngtcp2_duration min_rtt;
+  /**
+   * :member:`delivery_rate_sec` is the delivery rate measured in
+   * byte per second.  It is 0 if the delivery rate is not known.
+   * The library does not use this field when the capacity is
+   * imported.  It is provided so that application can decide
+   * whether the capacity is worth remembering.
+   */
+  uint64_t delivery_rate_sec;
+} ngtcp2_path_capacity;
+
+#define NGTCP2_CONN_STATS_V1 1
+#define NGTCP2_CONN_STATS_VERSION NGTCP2_CONN_STATS_V1
+
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_conn_stats` holds cumulative counters of a
+ * connection.  Unlike :type:`ngtcp2_conn_info`, the counters only
+ * increase during the lifetime of a connection.  This struct has been
+ * available since v1.7.0.
+ */
+typedef struct ngtcp2_conn_stats {
+  /**
+   * :member:`pkt_sent` is the number of QUIC packets sent.
+   */
+  uint64_t pkt_sent;
+  /**
+   * :member:`bytes_sent` is the number of bytes of QUIC packets sent.
+   */
+  uint64_t bytes_sent;
+  /**
+   * :member:`pkt_recv` is the number of QUIC packets received and
+   * successfully decrypted.
+   */
+  uint64_t pkt_recv;
+  /**
+   * :member:`bytes_recv` is the number of bytes of QUIC packets
+   * received and successfully decrypted.
+   */
+  uint64_t bytes_recv;
+  /**
+   * :member:`pkt_lost` is the number of QUIC packets declared lost.
+   * Path MTU probes are not counted.
+   */
+  uint64_t pkt_lost;
+  /**
+   * :member:`bytes_lost` is the number of bytes of QUIC packets
+   * declared lost.  Path MTU probes are not counted.
+   */
+  uint64_t bytes_lost;
+  /**
+   * :member:`pkt_spurious_lost` is the number of QUIC packets which
+   * are acknowledged after they are declared lost.
+   */
+  uint64_t pkt_spurious_lost;
+  /**
+   * :member:`stream_bytes_retransmitted` is the number of bytes of
+   * stream data retransmitted in STREAM frames.
+   */
+  uint64_t stream_bytes_retransmitted;
+  /**
+   * :member:`pto_count` is the number of PTO timer expirations.
+   */
+  uint64_t pto_count;
+  /**
+   * :member:`ecn_ce_acked` is the number of QUIC packets sent which
+   * are reported as CE marked by a remote endpoint.
+   */
+  uint64_t ecn_ce_acked;
+  /**
+   * :member:`cwnd_limited_duration` is the time spent while sending
+   * is limited by congestion window.
+   */
+  ngtcp2_duration cwnd_limited_duration;
+  /**
+   * :member:`app_limited_duration` is the time spent while
+   * application has nothing to send.
+   */
+  ngtcp2_duration app_limited_duration;
+  /**
+   * :member:`flow_control_limited_duration` is the time spent while
+   * sending is blocked by flow control of a remote endpoint.
+   */
+  ngtcp2_duration flow_control_limited_duration;
+  /**
+   * :member:`handshake_duration` is the time taken to complete
+   * handshake, measured from :member:`ngtcp2_settings.initial_ts`.
+   * It is 0 if handshake has not completed yet.
+   */
+  ngtcp2_duration handshake_duration;
+} ngtcp2_conn_stats;
+
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_HISTOGRAM_BUCKETLEN` is the number of buckets in
+ * :type:`ngtcp2_histogram`.
+ */
+#define NGTCP2_HISTOGRAM_BUCKETLEN 240
+
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_histogram` is a fixed-bucket log-linear histogram of
+ * durations.  Durations are recorded in microseconds resolution.
+ * Each of the first 8 buckets covers 1 microsecond.  After that,
+ * each power of 2 range is split into 8 buckets of equal width, so
+ * that the relative error of a bucket is at most 12.5%.  The last
+ * bucket also contains all durations which are larger than or equal
+ * to 2^32 microseconds.  `ngtcp2_histogram_bucket_lower_bound`
+ * returns the lower bound of each bucket.  Because the layout is
+ * fixed, histograms can be merged by `ngtcp2_histogram_merge`.  This
+ * struct has been available since v1.7.0.
+ */
+typedef struct ngtcp2_histogram {
+  /**
+   * :member:`buckets` contains the number of samples which fall into
+   * each bucket.
+   */
+  uint64_t buckets[NGTCP2_HISTOGRAM_BUCKETLEN];
+  /**
+   * :member:`count` is the number of samples.
+   */
+  uint64_t count;
+  /**
+   * :member:`sum` is the sum of samples.
+   */
+  ngtcp2_duration sum;
+  /**
+   * :member:`min` is the smallest sample.  It is UINT64_MAX if
+   * :member:`count` is 0.
+   */
+  ngtcp2_duration min;
+  /**
+   * :member:`max` is the largest sample.
+   */
+  ngtcp2_duration max;
+} ngtcp2_histogram;
+
+/**
+ * @enum
+ *
+ * :type:`ngtcp2_histogram_type` defines the kind of histogram that a
+ * connection collects.
+ */
+typedef enum ngtcp2_histogram_type {
+  /**
+   * :enum:`NGTCP2_HISTOGRAM_TYPE_RTT` is the histogram of RTT
+   * samples, which are not adjusted by ACK Delay.
+   */
+  NGTCP2_HISTOGRAM_TYPE_RTT,
+  /**
+   * :enum:`NGTCP2_HISTOGRAM_TYPE_ACK_DELAY` is the histogram of ACK
+   * Delay reported by a remote endpoint in the ACK frames which
+   * produce RTT samples.
+   */
+  NGTCP2_HISTOGRAM_TYPE_ACK_DELAY,
+  /**
+   * :enum:`NGTCP2_HISTOGRAM_TYPE_RX_GAP` is the histogram of
+   * intervals between 2 consecutive received UDP datagrams.
+   */
+  NGTCP2_HISTOGRAM_TYPE_RX_GAP
+} ngtcp2_histogram_type;
+
 /**
  * @enum
  *
@@ -1637,6 +1825,31 @@ typedef void (*ngtcp2_printf)(void *user_data, const char *format, ...);
  */
 #define NGTCP2_QLOG_WRITE_FLAG_FIN 0x01u
 
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_QLOG_FILTER_NONE` indicates that no qlog event is
+ * filtered out.
+ */
+#define NGTCP2_QLOG_FILTER_NONE 0x00u
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_QLOG_FILTER_PKT` filters out packet_sent and
+ * packet_received events.  The remaining events, such as
+ * metrics_updated and packet_lost, describe loss recovery and
+ * congestion control.
+ */
+#define NGTCP2_QLOG_FILTER_PKT 0x01u
+/**
+ * @macro
+ *
+ * :macro:`NGTCP2_QLOG_FILTER_FRAME` filters out frames from
+ * packet_sent and packet_received events.  Only packet headers and
+ * lengths are written.
+ */
+#define NGTCP2_QLOG_FILTER_FRAME 0x02u
+
 /**
  * @struct
  *
@@ -1665,6 +1878,31 @@ typedef struct ngtcp2_rand_ctx {
 typedef void (*ngtcp2_qlog_write)(void *user_data, uint32_t flags,
                                   const void *data, size_t datalen);
 
+/**
+ * @enum
+ *
+ * :type:`ngtcp2_qlog_format` defines the encoding of qlog which is
+ * passed to :type:`ngtcp2_qlog_write`.
+ */
+typedef enum ngtcp2_qlog_format {
+  /**
+   * :enum:`NGTCP2_QLOG_FORMAT_JSON_SEQ` is qlog JSON-SEQ format.  It
+   * can be directly consumed by qlog tools such as qvis.
+   */
+  NGTCP2_QLOG_FORMAT_JSON_SEQ,
+  /**
+   * :enum:`NGTCP2_QLOG_FORMAT_BINARY` is a compact binary encoding
+   * which is much cheaper to produce than JSON-SEQ.  It consists of
+   * length prefixed records, and each call of
+   * :type:`ngtcp2_qlog_write` delivers one record.  Use
+   * `ngtcp2_qlog_decode_binary` to convert it to JSON-SEQ.  The
+   * encoding is not stable across ngtcp2 versions; it should be
+   * converted with the same version of the library which produced
+   * it.
+   */
+  NGTCP2_QLOG_FORMAT_BINARY
+} ngtcp2_qlog_format;
+
 /**
  * @enum
  *
@@ -1690,7 +1928,8 @@ typedef enum ngtcp2_token_type {
 
 #define NGTCP2_SETTINGS_V1 1
 #define NGTCP2_SETTINGS_V2 2
-#define NGTCP2_SETTINGS_VERSION NGTCP2_SETTINGS_V2
+#define NGTCP2_SETTINGS_V3 3
+#define NGTCP2_SETTINGS_VERSION NGTCP2_SETTINGS_V3
 
 /**
  * @struct
@@ -1724,7 +1963,9 @@ typedef struct ngtcp2_settings {
   ngtcp2_printf log_printf;
   /**
    * :member:`max_tx_udp_payload_size` is the maximum size of UDP
-   * datagram payload that the local endpoint transmits.
+   * datagram payload that the local endpoint transmits.  On a path
+   * that supports jumbo frames, set this field to 8952 (9000 - 48) to
+   * let the predefined PMTUD probes discover it.
    */
   size_t max_tx_udp_payload_size;
   /**
@@ -1880,13 +2121,15 @@ typedef struct ngtcp2_settings {
   /* The following fields have been added since NGTCP2_SETTINGS_V2. */
   /**
    * :member:`pmtud_probes` is the array of UDP datagram payload size
-   * to probe during Path MTU Discovery.  The discovery is done in the
-   * order appeared in this array.  The size must be strictly larger
-   * than 1200, otherwise the behavior is undefined.  The maximum
-   * value in this array should be set to
-   * :member:`max_tx_udp_payload_size`.  If this field is not set, the
-   * predefined PMTUD probes are made.  This field has been available
-   * since v1.4.0.
+   * to probe during Path MTU Discovery.  The sizes are searched by
+   * binary search; if a size is acknowledged, only the larger sizes
+   * are probed next, and if a size is lost, only the smaller sizes
+   * are probed next.  The order in this array does not matter since
+   * v1.7.0.  The size must be strictly larger than 1200, otherwise the
+   * behavior is undefined.  The maximum value in this array should be
+   * set to :member:`max_tx_udp_payload_size`.  If this field is not
+   * set, the predefined PMTUD probes are made.  This field has been
+   * available since v1.4.0.
    */
   const uint16_t *pmtud_probes;
   /**
@@ -1895,6 +2138,71 @@ typedef struct ngtcp2_settings {
    * field has been available since v1.4.0.
    */
   size_t pmtud_probeslen;
+  /* The following fields have been added since NGTCP2_SETTINGS_V3. */
+  /**
+   * :member:`qlog_format` is the encoding of qlog passed to
+   * :member:`qlog_write`.  The default value is
+   * :enum:`ngtcp2_qlog_format.NGTCP2_QLOG_FORMAT_JSON_SEQ`.  This
+   * field has been available since v1.7.0.
+   */
+  ngtcp2_qlog_format qlog_format;
+  /**
+   * :member:`qlog_flight_recorder_size` is the size of in-memory
+   * buffer which keeps the most recent qlog events.  If it is
+   * nonzero, and :member:`qlog_write` is set, qlog events are not
+   * passed to :member:`qlog_write` as they happen.  Instead, they are
+   * kept in the buffer, discarding the oldest ones when it is full,
+   * and written to :member:`qlog_write` only when one of the
+   * following events occurs: a connection error is detected or
+   * signaled by a remote endpoint, handshake times out, persistent
+   * congestion is established, the number of consecutive PTOs
+   * reaches :member:`qlog_flight_recorder_pto_count`, or
+   * `ngtcp2_conn_flush_qlog` is called.  After that, qlog events are
+   * passed to :member:`qlog_write` as usual.  If none of them
+   * occurs, :member:`qlog_write` is only called with
+   * :macro:`NGTCP2_QLOG_WRITE_FLAG_FIN` when the connection is
+   * deleted.  The qlog preamble is always kept.  This field has
+   * been available since v1.7.0.
+   */
+  size_t qlog_flight_recorder_size;
+  /**
+   * :member:`qlog_flight_recorder_pto_count` is the number of
+   * consecutive PTOs that triggers the flush of the events kept by
+   * flight recorder.  0 disables this trigger.  This field is
+   * ignored if :member:`qlog_flight_recorder_size` is 0.  This field
+   * has been available since v1.7.0.
+   */
+  size_t qlog_flight_recorder_pto_count;
+  /**
+   * :member:`qlog_filter` is bitwise OR of zero or more of
+   * :macro:`NGTCP2_QLOG_FILTER_* <NGTCP2_QLOG_FILTER_NONE>`, which
+   * specifies the classes of qlog events that are not written.  This
+   * field has been available since v1.7.0.
+   */
+  uint32_t qlog_filter;
+  /**
+   * :member:`qlog_metrics_interval` is the minimum interval between
+   * metrics_updated events.  metrics_updated events which occur
+   * within this interval since the last one written are discarded.
+   * 0 writes all of them.  This field has been available since
+   * v1.7.0.
+   */
+  ngtcp2_duration qlog_metrics_interval;
+  /**
+   * :member:`qlog_pkt_sample_rate`, if it is larger than 1, makes
+   * only 1 in :member:`qlog_pkt_sample_rate` packet_sent and
+   * packet_received events written.  Other events are not affected.
+   * This field has been available since v1.7.0.
+   */
+  size_t qlog_pkt_sample_rate;
+  /**
+   * :member:`histograms`, if set to nonzero, makes a connection
+   * collect histograms of RTT samples, ACK Delay, and intervals
+   * between received UDP datagrams.  They are obtained by
+   * `ngtcp2_conn_get_histogram`.  This field has been available since
+   * v1.7.0.
+   */
+  uint8_t histograms;
 } ngtcp2_settings;
 
 /**
@@ -3708,6 +4016,33 @@ ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
                                const uint8_t *pkt, size_t pktlen,
                                ngtcp2_tstamp ts);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_read_timestamped_pkt` is similar to
+ * `ngtcp2_conn_read_pkt`, but it takes the time when the packet was
+ * received in |pkt_ts| in addition to the current time |ts|.
+ * |pkt_ts| is typically the receive timestamp reported by the kernel
+ * (e.g., SO_TIMESTAMPNS), and must be in the same clock as |ts|.  If
+ * an application reads several datagrams in a batch, passing the
+ * receive timestamp of each datagram lets the library take RTT
+ * samples and compute ACK Delay as if each datagram were processed
+ * immediately when it arrived.  |pkt_ts| is used for RTT samples,
+ * ACK Delay, and packets that are buffered for later processing;
+ * |ts| is used for everything else including timers.  If |pkt_ts| is
+ * greater than |ts|, |ts| is used instead.
+ *
+ * Calling this function with |pkt_ts| equal to |ts| is the same as
+ * calling `ngtcp2_conn_read_pkt`.  This function returns the same
+ * error codes as `ngtcp2_conn_read_pkt`.
+ *
+ * This function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN int ngtcp2_conn_read_timestamped_pkt_versioned(
+    ngtcp2_conn *conn, const ngtcp2_path *path, int pkt_info_version,
+    const ngtcp2_pkt_info *pi, const uint8_t *pkt, size_t pktlen,
+    ngtcp2_tstamp pkt_ts, ngtcp2_tstamp ts);
+
 /**
  * @function
  *
@@ -4059,6 +4394,127 @@ NGTCP2_EXTERN int ngtcp2_conn_handle_expiry(ngtcp2_conn *conn,
  */
 NGTCP2_EXTERN ngtcp2_duration ngtcp2_conn_get_pto(ngtcp2_conn *conn);
 
+/**
+ * @struct
+ *
+ * :type:`ngtcp2_timer_wheel` is a hierarchical timer wheel which
+ * tracks the expiry of many :type:`ngtcp2_conn` objects.  A
+ * connection attached to the wheel by `ngtcp2_conn_set_timer_wheel`
+ * updates its entry whenever a function changes its expiry.  They
+ * are `ngtcp2_conn_read_pkt`, `ngtcp2_conn_writev_stream` (and the
+ * other functions that write packets),
+ * `ngtcp2_conn_update_pkt_tx_time`, `ngtcp2_conn_handle_expiry`,
+ * `ngtcp2_conn_set_keep_alive_timeout`,
+ * `ngtcp2_conn_initiate_key_update`,
+ * `ngtcp2_conn_initiate_migration`,
+ * `ngtcp2_conn_initiate_immediate_migration`,
+ * `ngtcp2_conn_tls_handshake_completed`, and
+ * `ngtcp2_conn_write_connection_close`.  An application can then use
+ * a single timer for all connections.
+ *
+ * This type has been available since v1.7.0.
+ */
+typedef struct ngtcp2_timer_wheel ngtcp2_timer_wheel;
+
+/**
+ * @function
+ *
+ * `ngtcp2_timer_wheel_new` creates new :type:`ngtcp2_timer_wheel`,
+ * and assigns its pointer to |*ptw|.  |tick| is the granularity of
+ * the wheel.  The expiry is rounded up to |tick|, so that a
+ * connection never expires early.  |ts| is the current timestamp.
+ * |mem| is a memory allocator.  If |mem| is ``NULL``, the memory
+ * allocator returned by `ngtcp2_mem_default()` is used.
+ *
+ * This function has been available since v1.7.0.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_INVALID_ARGUMENT`
+ *     |tick| is 0.
+ * :macro:`NGTCP2_ERR_NOMEM`
+ *     Out of memory
+ */
+NGTCP2_EXTERN int ngtcp2_timer_wheel_new(ngtcp2_timer_wheel **ptw,
+                                         ngtcp2_duration tick,
+                                         ngtcp2_tstamp ts,
+                                         const ngtcp2_mem *mem);
+
+/**
+ * @function
+ *
+ * `ngtcp2_timer_wheel_del` frees resources allocated for |tw|.  The
+ * connections that are still attached to |tw| are detached.  If |tw|
+ * is ``NULL``, this function does nothing.
+ *
+ * This function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN void ngtcp2_timer_wheel_del(ngtcp2_timer_wheel *tw);
+
+/**
+ * @function
+ *
+ * `ngtcp2_timer_wheel_get_expiry` returns the timestamp at which an
+ * application should call `ngtcp2_timer_wheel_expire` next.  It
+ * never returns a timestamp later than the earliest expiry of the
+ * attached connections, but it may return an earlier one for the
+ * connections which expire far in the future.  It returns
+ * ``UINT64_MAX`` if no connection has an expiry.
+ *
+ * This function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN ngtcp2_tstamp
+ngtcp2_timer_wheel_get_expiry(const ngtcp2_timer_wheel *tw);
+
+/**
+ * @function
+ *
+ * `ngtcp2_timer_wheel_expire` advances |tw| to the current timestamp
+ * |ts|, and returns a connection whose expiry has been reached.  It
+ * returns ``NULL`` if there is no such connection.  The returned
+ * connection is no longer tracked by |tw| until its expiry is updated
+ * by `ngtcp2_conn_handle_expiry` or the functions that write packets.
+ *
+ * An application should collect the connections by calling this
+ * function repeatedly until it returns ``NULL``, and then call
+ * `ngtcp2_conn_handle_expiry` and write packets for each of them.
+ * It should not handle a connection before this function returns
+ * ``NULL``, because the handled connection is returned again if its
+ * new expiry is not later than |ts|, for example, when it cannot send
+ * a packet.
+ *
+ * This function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN ngtcp2_conn *ngtcp2_timer_wheel_expire(ngtcp2_timer_wheel *tw,
+                                                     ngtcp2_tstamp ts);
+
+/**
+ * @function
+ *
+ * `ngtcp2_conn_set_timer_wheel` attaches |conn| to |tw|, and
+ * schedules its current expiry.  If |conn| is attached to another
+ * wheel, it is detached from it first.  If |tw| is ``NULL``, |conn|
+ * is just detached.  |conn| is detached automatically when it is
+ * deleted.
+ *
+ * This function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN void ngtcp2_conn_set_timer_wheel(ngtcp2_conn *conn,
+                                               ngtcp2_timer_wheel *tw);
+
+/**
+ * @function
+ *
+ * `ngtcp2_conn_get_user_data` returns the user data which is passed
+ * to `ngtcp2_conn_client_new` or `ngtcp2_conn_server_new`.  It is
+ * useful to find the application object for the connection returned
+ * by `ngtcp2_timer_wheel_expire`.
+ *
+ * This function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN void *ngtcp2_conn_get_user_data(ngtcp2_conn *conn);
+
 /**
  * @function
  *
@@ -4906,6 +5362,128 @@ NGTCP2_EXTERN void ngtcp2_conn_get_conn_info_versioned(ngtcp2_conn *conn,
                                                        int conn_info_version,
                                                        ngtcp2_conn_info *cinfo);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_get_stats` assigns cumulative counters of |conn| to
+ * |*stats|.  The reason which limits sending is determined each time
+ * application tries to write a packet, and the durations are
+ * accounted up to the latest timestamp passed to the functions which
+ * write or read packets.  This function has been available since
+ * v1.7.0.
+ */
+NGTCP2_EXTERN void ngtcp2_conn_get_stats_versioned(ngtcp2_conn *conn,
+                                                   int conn_stats_version,
+                                                   ngtcp2_conn_stats *stats);
+
+/**
+ * @function
+ *
+ * `ngtcp2_conn_get_histogram` returns the histogram of |type|
+ * collected by |conn|.  It returns NULL if
+ * :member:`ngtcp2_settings.histograms` is 0.  The returned pointer is
+ * valid until |conn| is deleted.  This function has been available
+ * since v1.7.0.
+ */
+NGTCP2_EXTERN const ngtcp2_histogram *
+ngtcp2_conn_get_histogram(ngtcp2_conn *conn, ngtcp2_histogram_type type);
+
+/**
+ * @function
+ *
+ * `ngtcp2_histogram_init` initializes |h| so that it contains no
+ * samples.  This function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN void ngtcp2_histogram_init(ngtcp2_histogram *h);
+
+/**
+ * @function
+ *
+ * `ngtcp2_histogram_merge` adds the samples in |src| to |dest|.  This
+ * function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN void ngtcp2_histogram_merge(ngtcp2_histogram *dest,
+                                          const ngtcp2_histogram *src);
+
+/**
+ * @function
+ *
+ * `ngtcp2_histogram_quantile` returns the estimated value of |h| at
+ * |permille| / 1000 quantile.  For example, pass 990 to get 99th
+ * percentile.  |permille| larger than 1000 is treated as 1000.  The
+ * estimate is the upper bound of the bucket that contains the
+ * quantile, but it never exceeds :member:`ngtcp2_histogram.max`.  It
+ * returns 0 if |h| contains no samples.  This function has been
+ * available since v1.7.0.
+ */
+NGTCP2_EXTERN ngtcp2_duration
+ngtcp2_histogram_quantile(const ngtcp2_histogram *h, uint32_t permille);
+
+/**
+ * @function
+ *
+ * `ngtcp2_histogram_bucket_lower_bound` returns the smallest duration
+ * that falls into the bucket at the index |idx|.  |idx| must be
+ * strictly less than :macro:`NGTCP2_HISTOGRAM_BUCKETLEN`.  This
+ * function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN ngtcp2_duration ngtcp2_histogram_bucket_lower_bound(size_t idx);
+
+/**
+ * @function
+ *
+ * `ngtcp2_conn_get_path_capacity` assigns the capacity of the current
+ * path to |*cap|.  Application should call this function when a
+ * connection is about to be closed, and remember the result keyed by
+ * the remote address of the current path.  This function has been
+ * available since v1.7.0.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_INVALID_STATE`
+ *     No RTT sample has been obtained yet.
+ */
+NGTCP2_EXTERN int
+ngtcp2_conn_get_path_capacity_versioned(ngtcp2_conn *conn,
+                                        int path_capacity_version,
+                                        ngtcp2_path_capacity *cap);
+
+/**
+ * @function
+ *
+ * `ngtcp2_conn_set_path_capacity` imports the path capacity |cap|
+ * which was previously obtained by `ngtcp2_conn_get_path_capacity`
+ * from a connection over the same path, and enables Careful Resume.
+ * The connection starts with the initial congestion window as usual.
+ * Once it has obtained an RTT sample which is consistent with
+ * :member:`cap->min_rtt <ngtcp2_path_capacity.min_rtt>`, and it is
+ * limited by the congestion window, the congestion window jumps to
+ * the half of :member:`cap->cwnd <ngtcp2_path_capacity.cwnd>`.  The
+ * jump is then validated by the acknowledgements, and the congestion
+ * window is reduced if a congestion is detected during validation.
+ * If the path changes, the imported capacity is discarded.
+ *
+ * This function must be called before the handshake completes.  The
+ * application is responsible for discarding stale capacity.  This
+ * function has been available since v1.7.0.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_INVALID_ARGUMENT`
+ *     :member:`cap->cwnd <ngtcp2_path_capacity.cwnd>` is 0, or
+ *     :member:`cap->min_rtt <ngtcp2_path_capacity.min_rtt>` is 0 or
+ *     ``UINT64_MAX``.
+ * :macro:`NGTCP2_ERR_INVALID_STATE`
+ *     The handshake has completed, or the path capacity has already
+ *     been set.
+ */
+NGTCP2_EXTERN int
+ngtcp2_conn_set_path_capacity_versioned(ngtcp2_conn *conn,
+                                        int path_capacity_version,
+                                        const ngtcp2_path_capacity *cap);
+
 /**
  * @function
  *
@@ -4990,6 +5568,35 @@ NGTCP2_EXTERN size_t ngtcp2_conn_get_max_tx_udp_payload_size(ngtcp2_conn *conn);
 NGTCP2_EXTERN size_t
 ngtcp2_conn_get_path_max_tx_udp_payload_size(ngtcp2_conn *conn);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_set_pmtud_hint` tells |conn| that UDP payload of size
+ * |udp_payload_size| was known to work for the current path, for
+ * example, in the previous connection.  Application can obtain it by
+ * calling `ngtcp2_conn_get_path_max_tx_udp_payload_size` before
+ * closing the previous connection.  Path MTU Discovery probes
+ * |udp_payload_size| first, and the remaining candidates are searched
+ * relative to it.  |udp_payload_size| is still probed, and it is not
+ * used until it is acknowledged.  The hint is ignored if it exceeds
+ * the maximum UDP payload size that can be sent, or the path changes
+ * before Path MTU Discovery starts.
+ *
+ * This function must be called before the handshake completes.  This
+ * function has been available since v1.7.0.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :macro:`NGTCP2_ERR_INVALID_ARGUMENT`
+ *     |udp_payload_size| is less than or equal to 1200, or larger than
+ *     65535.
+ * :macro:`NGTCP2_ERR_INVALID_STATE`
+ *     The handshake has completed.
+ */
+NGTCP2_EXTERN int ngtcp2_conn_set_pmtud_hint(ngtcp2_conn *conn,
+                                             size_t udp_payload_size);
+
 /**
  * @function
  *
@@ -5513,6 +6120,46 @@ NGTCP2_EXTERN size_t ngtcp2_conn_get_send_quantum(ngtcp2_conn *conn);
 NGTCP2_EXTERN size_t ngtcp2_conn_get_stream_loss_count(ngtcp2_conn *conn,
                                                        int64_t stream_id);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_flush_qlog` writes the qlog events kept by flight
+ * recorder to :member:`ngtcp2_settings.qlog_write`, and makes the
+ * subsequent events written as they happen.  Application can call
+ * this function when it finds something unusual about |conn|.  This
+ * function does nothing if flight recorder is not enabled by
+ * :member:`ngtcp2_settings.qlog_flight_recorder_size`, or the events
+ * have already been flushed.
+ *
+ * This function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN void ngtcp2_conn_flush_qlog(ngtcp2_conn *conn);
+
+/**
+ * @function
+ *
+ * `ngtcp2_qlog_decode_binary` decodes a single qlog record at the
+ * beginning of |data| of length |datalen| bytes, which is written in
+ * :enum:`ngtcp2_qlog_format.NGTCP2_QLOG_FORMAT_BINARY` format, and
+ * calls |write| with |user_data| to emit the equivalent qlog in
+ * :enum:`ngtcp2_qlog_format.NGTCP2_QLOG_FORMAT_JSON_SEQ` format.
+ * The output is identical to what the library would have written if
+ * JSON-SEQ format had been chosen.  |write| might be called more
+ * than once, or not at all for a single record.
+ *
+ * This function returns the number of bytes consumed from |data| if
+ * it succeeds.  If |data| does not contain a complete record, this
+ * function returns 0.  The caller should call this function again
+ * when more data is available.  It returns
+ * :macro:`NGTCP2_ERR_INVALID_ARGUMENT` if the record is malformed.
+ *
+ * This function has been available since v1.7.0.
+ */
+NGTCP2_EXTERN ngtcp2_ssize ngtcp2_qlog_decode_binary(ngtcp2_qlog_write write,
+                                                     void *user_data,
+                                                     const uint8_t *data,
+                                                     size_t datalen);
+
 /**
  * @function
  *
@@ -5763,6 +6410,17 @@ NGTCP2_EXTERN uint32_t ngtcp2_select_version(const uint32_t *preferred_versions,
   ngtcp2_conn_read_pkt_versioned((CONN), (PATH), NGTCP2_PKT_INFO_VERSION,      \
                                  (PI), (PKT), (PKTLEN), (TS))
 
+/*
+ * `ngtcp2_conn_read_timestamped_pkt` is a wrapper around
+ * `ngtcp2_conn_read_timestamped_pkt_versioned` to set the correct
+ * struct version.
+ */
+#define ngtcp2_conn_read_timestamped_pkt(CONN, PATH, PI, PKT, PKTLEN, PKT_TS,  \
+                                         TS)                                   \
+  ngtcp2_conn_read_timestamped_pkt_versioned(                                  \
+      (CONN), (PATH), NGTCP2_PKT_INFO_VERSION, (PI), (PKT), (PKTLEN),          \
+      (PKT_TS), (TS))
+
 /*
  * `ngtcp2_conn_write_pkt` is a wrapper around
  * `ngtcp2_conn_write_pkt_versioned` to set the correct struct
@@ -5895,6 +6553,32 @@ NGTCP2_EXTERN uint32_t ngtcp2_select_version(const uint32_t *preferred_versions,
 #define ngtcp2_conn_get_conn_info(CONN, CINFO)                                 \
   ngtcp2_conn_get_conn_info_versioned((CONN), NGTCP2_CONN_INFO_VERSION, (CINFO))
 
+/*
+ * `ngtcp2_conn_get_stats` is a wrapper around
+ * `ngtcp2_conn_get_stats_versioned` to set the correct struct
+ * version.
+ */
+#define ngtcp2_conn_get_stats(CONN, STATS)                                     \
+  ngtcp2_conn_get_stats_versioned((CONN), NGTCP2_CONN_STATS_VERSION, (STATS))
+
+/*
+ * `ngtcp2_conn_get_path_capacity` is a wrapper around
+ * `ngtcp2_conn_get_path_capacity_versioned` to set the correct struct
+ * version.
+ */
+#define ngtcp2_conn_get_path_capacity(CONN, CAP)                               \
+  ngtcp2_conn_get_path_capacity_versioned(                                     \
+      (CONN), NGTCP2_PATH_CAPACITY_VERSION, (CAP))
+
+/*
+ * `ngtcp2_conn_set_path_capacity` is a wrapper around
+ * `ngtcp2_conn_set_path_capacity_versioned` to set the correct struct
+ * version.
+ */
+#define ngtcp2_conn_set_path_capacity(CONN, CAP)                               \
+  ngtcp2_conn_set_path_capacity_versioned(                                     \
+      (CONN), NGTCP2_PATH_CAPACITY_VERSION, (CAP))
+
 /*
  * `ngtcp2_settings_default` is a wrapper around
  * `ngtcp2_settings_default_versioned` to set the correct struct
@@ -297,7 +297,12 @@ static void bbr_on_init(ngtcp2_cc_bbr *bbr, ngtcp2_conn_stat *cstat,
   bbr_init_pacing_rate(bbr, cstat);
   bbr_enter_startup(bbr);
 
-  cstat->send_quantum = cstat->max_tx_udp_payload_size * 10;
+  /* Cap send_quantum as bbr_set_send_quantum does.  With jumbo
+     frames, 10 packets exceed 64KiB. */
+  cstat->send_quantum =
+      ngtcp2_max_size(ngtcp2_min_size(cstat->max_tx_udp_payload_size * 10,
+                                      64 * 1024),
+                      cstat->max_tx_udp_payload_size);
 
   /* Missing in documentation */
   bbr->loss_round_start = 0;
@@ -575,3 +575,289 @@ void ngtcp2_cc_cubic_cc_event(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
 
   cubic->epoch_start += ts - last_ts;
 }
+
+static void cc_cr_enter_normal(ngtcp2_cc_cr *cr, const char *reason) {
+  cr->phase = NGTCP2_CC_CR_PHASE_NORMAL;
+
+  ngtcp2_log_info(cr->cc.log, NGTCP2_LOG_EVENT_CCA,
+                  "careful resume: enter normal phase (%s)", reason);
+}
+
+static void cc_cr_on_pkt_acked(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
+                               const ngtcp2_cc_pkt *pkt, ngtcp2_tstamp ts) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+  uint64_t cwnd = cstat->cwnd;
+
+  if (cr->inner->on_pkt_acked) {
+    cr->inner->on_pkt_acked(cr->inner, cstat, pkt, ts);
+  }
+
+  if (pkt->pktns_id != NGTCP2_PKTNS_ID_APPLICATION) {
+    return;
+  }
+
+  switch (cr->phase) {
+  case NGTCP2_CC_CR_PHASE_UNVALIDATED:
+    cstat->cwnd = cwnd;
+    cr->pipesize += pkt->pktlen;
+
+    if (pkt->pkt_num < cr->first_unvalidated_pkt_num) {
+      return;
+    }
+
+    /* The first packet sent after the jump is acknowledged.  Shrink
+       the congestion window to what is actually used. */
+    cstat->cwnd = ngtcp2_min_uint64(
+        cwnd, ngtcp2_max_uint64(cstat->bytes_in_flight, cr->pipesize));
+    cr->phase = NGTCP2_CC_CR_PHASE_VALIDATING;
+
+    ngtcp2_log_info(cr->cc.log, NGTCP2_LOG_EVENT_CCA,
+                    "careful resume: enter validating phase cwnd=%" PRIu64
+                    " pipesize=%" PRIu64,
+                    cstat->cwnd, cr->pipesize);
+
+    break;
+  case NGTCP2_CC_CR_PHASE_VALIDATING:
+    cr->pipesize += pkt->pktlen;
+
+    break;
+  case NGTCP2_CC_CR_PHASE_SAFE_RETREAT:
+    cstat->cwnd = cwnd;
+    cr->pipesize += pkt->pktlen;
+
+    if (cr->last_unvalidated_pkt_num == -1 ||
+        pkt->pkt_num < cr->last_unvalidated_pkt_num) {
+      return;
+    }
+
+    cstat->ssthresh = cr->pipesize;
+    cc_cr_enter_normal(cr, "retreated");
+
+    return;
+  default:
+    return;
+  }
+
+  if (cr->last_unvalidated_pkt_num != -1 &&
+      pkt->pkt_num >= cr->last_unvalidated_pkt_num) {
+    cc_cr_enter_normal(cr, "validated");
+  }
+}
+
+static void cc_cr_on_pkt_lost(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
+                              const ngtcp2_cc_pkt *pkt, ngtcp2_tstamp ts) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+
+  if (cr->inner->on_pkt_lost) {
+    cr->inner->on_pkt_lost(cr->inner, cstat, pkt, ts);
+  }
+}
+
+static void cc_cr_congestion_event(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
+                                   ngtcp2_tstamp sent_ts, ngtcp2_tstamp ts) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+  uint64_t min_cwnd;
+
+  if (cr->inner->congestion_event) {
+    cr->inner->congestion_event(cr->inner, cstat, sent_ts, ts);
+  }
+
+  switch (cr->phase) {
+  case NGTCP2_CC_CR_PHASE_RECONNAISSANCE:
+    cc_cr_enter_normal(cr, "congestion before jump");
+
+    return;
+  case NGTCP2_CC_CR_PHASE_UNVALIDATED:
+  case NGTCP2_CC_CR_PHASE_VALIDATING:
+    if (cr->last_unvalidated_pkt_num == -1) {
+      cc_cr_enter_normal(cr, "congestion before validation");
+
+      return;
+    }
+
+    min_cwnd = 2 * cstat->max_tx_udp_payload_size;
+    cstat->cwnd = ngtcp2_max_uint64(cr->pipesize / 2, min_cwnd);
+    cstat->ssthresh = cstat->cwnd;
+    cr->phase = NGTCP2_CC_CR_PHASE_SAFE_RETREAT;
+
+    ngtcp2_log_info(cr->cc.log, NGTCP2_LOG_EVENT_CCA,
+                    "careful resume: enter safe retreat phase cwnd=%" PRIu64
+                    " pipesize=%" PRIu64,
+                    cstat->cwnd, cr->pipesize);
+
+    return;
+  default:
+    return;
+  }
+}
+
+static void cc_cr_on_spurious_congestion(ngtcp2_cc *cc,
+                                         ngtcp2_conn_stat *cstat,
+                                         ngtcp2_tstamp ts) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+
+  if (cr->inner->on_spurious_congestion) {
+    cr->inner->on_spurious_congestion(cr->inner, cstat, ts);
+  }
+}
+
+static void cc_cr_on_persistent_congestion(ngtcp2_cc *cc,
+                                           ngtcp2_conn_stat *cstat,
+                                           ngtcp2_tstamp ts) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+
+  if (cr->inner->on_persistent_congestion) {
+    cr->inner->on_persistent_congestion(cr->inner, cstat, ts);
+  }
+
+  if (cr->phase != NGTCP2_CC_CR_PHASE_NORMAL) {
+    cc_cr_enter_normal(cr, "persistent congestion");
+  }
+}
+
+static void cc_cr_on_ack_recv(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
+                              const ngtcp2_cc_ack *ack, ngtcp2_tstamp ts) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+  uint64_t cwnd = cstat->cwnd;
+
+  if (cr->inner->on_ack_recv) {
+    cr->inner->on_ack_recv(cr->inner, cstat, ack, ts);
+  }
+
+  switch (cr->phase) {
+  case NGTCP2_CC_CR_PHASE_UNVALIDATED:
+    /* Let the library pace packets by the congestion window even if
+       the underlying congestion controller sets pacing interval. */
+    cstat->pacing_interval = 0;
+    /* fall through */
+  case NGTCP2_CC_CR_PHASE_SAFE_RETREAT:
+    cstat->cwnd = cwnd;
+
+    return;
+  default:
+    return;
+  }
+}
+
+static void cc_cr_on_pkt_sent(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
+                              const ngtcp2_cc_pkt *pkt) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+  uint64_t jump_cwnd;
+
+  if (cr->inner->on_pkt_sent) {
+    cr->inner->on_pkt_sent(cr->inner, cstat, pkt);
+  }
+
+  if (pkt->pktns_id != NGTCP2_PKTNS_ID_APPLICATION) {
+    return;
+  }
+
+  switch (cr->phase) {
+  case NGTCP2_CC_CR_PHASE_RECONNAISSANCE:
+    /* Jump only if RTT sample is available, and the sender is limited
+       by the congestion window. */
+    if (cstat->min_rtt == UINT64_MAX || cstat->bytes_in_flight < cstat->cwnd) {
+      return;
+    }
+
+    if (cstat->min_rtt < cr->saved_rtt / 2 ||
+        cstat->min_rtt / 10 > cr->saved_rtt) {
+      cc_cr_enter_normal(cr, "RTT changed");
+
+      return;
+    }
+
+    jump_cwnd = cr->saved_cwnd / 2;
+    if (jump_cwnd <= cstat->cwnd) {
+      cc_cr_enter_normal(cr, "no gain");
+
+      return;
+    }
+
+    cr->pipesize = cstat->bytes_in_flight;
+    cr->first_unvalidated_pkt_num = pkt->pkt_num + 1;
+    cstat->cwnd = jump_cwnd;
+    cstat->pacing_interval = 0;
+    cr->phase = NGTCP2_CC_CR_PHASE_UNVALIDATED;
+
+    ngtcp2_log_info(cr->cc.log, NGTCP2_LOG_EVENT_CCA,
+                    "careful resume: enter unvalidated phase cwnd=%" PRIu64,
+                    cstat->cwnd);
+
+    return;
+  case NGTCP2_CC_CR_PHASE_UNVALIDATED:
+    cr->last_unvalidated_pkt_num = pkt->pkt_num;
+
+    if (cstat->bytes_in_flight < cstat->cwnd) {
+      return;
+    }
+
+    /* The whole jump has been sent. */
+    cr->phase = NGTCP2_CC_CR_PHASE_VALIDATING;
+
+    ngtcp2_log_info(cr->cc.log, NGTCP2_LOG_EVENT_CCA,
+                    "careful resume: enter validating phase cwnd=%" PRIu64
+                    " pipesize=%" PRIu64,
+                    cstat->cwnd, cr->pipesize);
+
+    return;
+  default:
+    return;
+  }
+}
+
+static void cc_cr_new_rtt_sample(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
+                                 ngtcp2_tstamp ts) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+
+  if (cr->inner->new_rtt_sample) {
+    cr->inner->new_rtt_sample(cr->inner, cstat, ts);
+  }
+}
+
+static void cc_cr_reset(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
+                        ngtcp2_tstamp ts) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+
+  if (cr->inner->reset) {
+    cr->inner->reset(cr->inner, cstat, ts);
+  }
+
+  /* The saved capacity is only valid for the original path. */
+  if (cr->phase != NGTCP2_CC_CR_PHASE_NORMAL) {
+    cc_cr_enter_normal(cr, "congestion state reset");
+  }
+}
+
+static void cc_cr_event(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
+                        ngtcp2_cc_event_type event, ngtcp2_tstamp ts) {
+  ngtcp2_cc_cr *cr = ngtcp2_struct_of(cc, ngtcp2_cc_cr, cc);
+
+  if (cr->inner->event) {
+    cr->inner->event(cr->inner, cstat, event, ts);
+  }
+}
+
+void ngtcp2_cc_cr_init(ngtcp2_cc_cr *cr, ngtcp2_cc *inner, ngtcp2_log *log,
+                       uint64_t saved_cwnd, ngtcp2_duration saved_rtt) {
+  memset(cr, 0, sizeof(*cr));
+
+  cr->cc.log = log;
+  cr->cc.on_pkt_acked = cc_cr_on_pkt_acked;
+  cr->cc.on_pkt_lost = cc_cr_on_pkt_lost;
+  cr->cc.congestion_event = cc_cr_congestion_event;
+  cr->cc.on_spurious_congestion = cc_cr_on_spurious_congestion;
+  cr->cc.on_persistent_congestion = cc_cr_on_persistent_congestion;
+  cr->cc.on_ack_recv = cc_cr_on_ack_recv;
+  cr->cc.on_pkt_sent = cc_cr_on_pkt_sent;
+  cr->cc.new_rtt_sample = cc_cr_new_rtt_sample;
+  cr->cc.reset = cc_cr_reset;
+  cr->cc.event = cc_cr_event;
+
+  cr->inner = inner;
+  cr->phase = NGTCP2_CC_CR_PHASE_RECONNAISSANCE;
+  cr->saved_cwnd = saved_cwnd;
+  cr->saved_rtt = saved_rtt;
+  cr->first_unvalidated_pkt_num = INT64_MAX;
+  cr->last_unvalidated_pkt_num = -1;
+}
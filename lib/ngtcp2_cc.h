@@ -397,4 +397,65 @@ void ngtcp2_cc_cubic_cc_event(ngtcp2_cc *cc, ngtcp2_conn_stat *cstat,
 
 uint64_t ngtcp2_cbrt(uint64_t n);
 
+/*
+ * ngtcp2_cc_cr_phase is the phase of Careful Resume.
+ */
+typedef enum ngtcp2_cc_cr_phase {
+  /* NGTCP2_CC_CR_PHASE_RECONNAISSANCE is the initial phase.  The
+     congestion window is not changed until the saved capacity is
+     confirmed to be consistent with the current path. */
+  NGTCP2_CC_CR_PHASE_RECONNAISSANCE,
+  /* NGTCP2_CC_CR_PHASE_UNVALIDATED is the phase after the jump.  The
+     congestion window is not increased until a packet sent in this
+     phase is acknowledged. */
+  NGTCP2_CC_CR_PHASE_UNVALIDATED,
+  /* NGTCP2_CC_CR_PHASE_VALIDATING is the phase where the packets sent
+     in NGTCP2_CC_CR_PHASE_UNVALIDATED are being acknowledged. */
+  NGTCP2_CC_CR_PHASE_VALIDATING,
+  /* NGTCP2_CC_CR_PHASE_SAFE_RETREAT is the phase after a congestion
+     is detected during validation. */
+  NGTCP2_CC_CR_PHASE_SAFE_RETREAT,
+  /* NGTCP2_CC_CR_PHASE_NORMAL indicates that Careful Resume has
+     finished, and the underlying congestion controller works as
+     usual. */
+  NGTCP2_CC_CR_PHASE_NORMAL,
+} ngtcp2_cc_cr_phase;
+
+/*
+ * ngtcp2_cc_cr implements Careful Resume
+ * (draft-ietf-tsvwg-careful-resume) on top of another congestion
+ * controller.  It forwards all events to the underlying congestion
+ * controller, and then adjusts the congestion window depending on its
+ * phase.
+ */
+typedef struct ngtcp2_cc_cr {
+  ngtcp2_cc cc;
+  /* inner is the underlying congestion controller. */
+  ngtcp2_cc *inner;
+  ngtcp2_cc_cr_phase phase;
+  /* saved_cwnd is the congestion window imported from the previous
+     connection. */
+  uint64_t saved_cwnd;
+  /* saved_rtt is the minimum RTT imported from the previous
+     connection. */
+  ngtcp2_duration saved_rtt;
+  /* pipesize is the number of bytes acknowledged since the jump. */
+  uint64_t pipesize;
+  /* first_unvalidated_pkt_num is the packet number of the first
+     packet sent in NGTCP2_CC_CR_PHASE_UNVALIDATED. */
+  int64_t first_unvalidated_pkt_num;
+  /* last_unvalidated_pkt_num is the packet number of the last packet
+     sent in NGTCP2_CC_CR_PHASE_UNVALIDATED.  It is -1 if no packet
+     has been sent in that phase. */
+  int64_t last_unvalidated_pkt_num;
+} ngtcp2_cc_cr;
+
+/*
+ * ngtcp2_cc_cr_init initializes |cr| which wraps |inner|.
+ * |saved_cwnd| and |saved_rtt| are the congestion window and the
+ * minimum RTT imported from the previous connection.
+ */
+void ngtcp2_cc_cr_init(ngtcp2_cc_cr *cr, ngtcp2_cc *inner, ngtcp2_log *log,
+                       uint64_t saved_cwnd, ngtcp2_duration saved_rtt);
+
 #endif /* NGTCP2_CC_H */
@@ -41,6 +41,7 @@
 #include "ngtcp2_settings.h"
 #include "ngtcp2_tstamp.h"
 #include "ngtcp2_frame_chain.h"
+#include "ngtcp2_probe.h"
 
 /* NGTCP2_FLOW_WINDOW_RTT_FACTOR is the factor of RTT when flow
    control window auto-tuning is triggered. */
@@ -68,6 +69,20 @@ static int conn_local_stream(ngtcp2_conn *conn, int64_t stream_id) {
  */
 static int bidi_stream(int64_t stream_id) { return (stream_id & 0x2) == 0; }
 
+/*
+ * conn_update_timer_wheel tells conn->tw the current expiry of
+ * |conn| if it is attached to the timer wheel.  It must be called
+ * when the public function which might change the timers returns.
+ */
+static void conn_update_timer_wheel(ngtcp2_conn *conn) {
+  if (conn->tw == NULL) {
+    return;
+  }
+
+  ngtcp2_timer_wheel_update(conn->tw, &conn->tw_ent,
+                            ngtcp2_conn_get_expiry(conn));
+}
+
 static void conn_update_timestamp(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   assert(conn->log.last_ts <= ts);
   assert(conn->qlog.last_ts <= ts);
@@ -775,6 +790,17 @@ static int retired_ts_less(const ngtcp2_pq_entry *lhs,
   return a->retired_ts < b->retired_ts;
 }
 
+/*
+ * conn_get_cc returns the congestion controller which drives |conn|.
+ */
+static ngtcp2_cc *conn_get_cc(ngtcp2_conn *conn) {
+  if (conn->flags & NGTCP2_CONN_FLAG_CAREFUL_RESUME) {
+    return &conn->cr.cc;
+  }
+
+  return &conn->cc;
+}
+
 /*
  * conn_reset_conn_stat_cc resets congestion state in |cstat|.
  */
@@ -1109,6 +1135,16 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   if (settings->qlog_write) {
     buflen = buflen_align(buflen);
     buflen += NGTCP2_QLOG_BUFLEN;
+
+    if (settings->qlog_flight_recorder_size) {
+      buflen = buflen_align(buflen);
+      buflen += settings->qlog_flight_recorder_size;
+    }
+  }
+
+  if (settings->histograms) {
+    buflen = buflen_align(buflen);
+    buflen += sizeof(ngtcp2_histogram) * NGTCP2_HISTOGRAM_NUM_TYPES;
   }
 
   if (settings->pmtud_probeslen) {
@@ -1175,14 +1211,36 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
 
   ngtcp2_log_init(&(*pconn)->log, scid, settings->log_printf,
                   settings->initial_ts, user_data);
-  ngtcp2_qlog_init(&(*pconn)->qlog, settings->qlog_write, settings->initial_ts,
-                   user_data);
+  ngtcp2_qlog_init(&(*pconn)->qlog, settings->qlog_write,
+                   settings->qlog_format, settings->initial_ts, user_data);
+  ngtcp2_qlog_set_filter(&(*pconn)->qlog, settings->qlog_filter,
+                         settings->qlog_metrics_interval,
+                         settings->qlog_pkt_sample_rate);
   if ((*pconn)->qlog.write) {
     buf = buf_align(buf);
     ngtcp2_buf_init(&(*pconn)->qlog.buf, buf, NGTCP2_QLOG_BUFLEN);
     buf = buf_advance(buf, NGTCP2_QLOG_BUFLEN);
+
+    if (settings->qlog_flight_recorder_size) {
+      buf = buf_align(buf);
+      ngtcp2_qlog_set_recorder(&(*pconn)->qlog, buf,
+                               settings->qlog_flight_recorder_size);
+      buf = buf_advance(buf, settings->qlog_flight_recorder_size);
+    }
   }
 
+  if (settings->histograms) {
+    (*pconn)->hist = buf_align(buf);
+    buf = buf_advance((*pconn)->hist,
+                      sizeof(ngtcp2_histogram) * NGTCP2_HISTOGRAM_NUM_TYPES);
+
+    for (i = 0; i < NGTCP2_HISTOGRAM_NUM_TYPES; ++i) {
+      ngtcp2_histogram_init(&(*pconn)->hist[i]);
+    }
+  }
+
+  (*pconn)->rx.last_ts = UINT64_MAX;
+
   (*pconn)->local.settings = *settings;
 
   if (settings->tokenlen) {
@@ -1212,6 +1270,11 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   ngtcp2_dcid_init(&(*pconn)->dcid.current, 0, dcid, NULL);
   ngtcp2_dcid_set_path(&(*pconn)->dcid.current, path);
 
+  (*pconn)->pmtud_bh.largest_acked_pkt_num = -1;
+  (*pconn)->pmtud_bh.max_udp_payload_size = SIZE_MAX;
+
+  ngtcp2_timer_wheel_entry_init(&(*pconn)->tw_ent);
+
   rv = ngtcp2_gaptr_push(&(*pconn)->dcid.seqgap, 0, 1);
   if (rv != 0) {
     goto fail_seqgap_push;
@@ -1377,6 +1440,7 @@ static int conn_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   (*pconn)->crypto.key_update.confirmed_ts = UINT64_MAX;
   (*pconn)->tx.last_max_data_ts = UINT64_MAX;
   (*pconn)->tx.pacing.next_ts = UINT64_MAX;
+  (*pconn)->cstat.tx_limit_ts = UINT64_MAX;
   (*pconn)->tx.last_blocked_offset = UINT64_MAX;
   (*pconn)->early.discard_started_ts = UINT64_MAX;
 
@@ -1516,6 +1580,10 @@ void ngtcp2_conn_del(ngtcp2_conn *conn) {
     return;
   }
 
+  if (conn->tw) {
+    ngtcp2_timer_wheel_detach(conn->tw, &conn->tw_ent);
+  }
+
   ngtcp2_qlog_end(&conn->qlog);
 
   if (conn->early.ckm) {
@@ -2135,6 +2203,8 @@ void ngtcp2_conn_set_keep_alive_timeout(ngtcp2_conn *conn,
   }
 
   conn->keep_alive.timeout = timeout;
+
+  conn_update_timer_wheel(conn);
 }
 
 /*
@@ -2452,6 +2522,12 @@ conn_write_handshake_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi, uint8_t *dest,
 
   ngtcp2_qlog_pkt_sent_end(&conn->qlog, &hd, (size_t)spktlen);
 
+  ++conn->cstat.pkt_sent;
+  conn->cstat.bytes_sent += (size_t)spktlen;
+
+  NGTCP2_PROBE5(pkt_sent, conn->log.scid, hd.type, hd.pkt_num, spktlen,
+                conn->cstat.cwnd);
+
   if ((rtb_entry_flags & NGTCP2_RTB_ENTRY_FLAG_ACK_ELICITING) || padded) {
     if (pi) {
       conn_handle_tx_ecn(conn, pi, &rtb_entry_flags, pktns, &hd, ts);
@@ -3217,6 +3293,7 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
   const ngtcp2_cid *scid = NULL;
   int keep_alive_expired = 0;
   uint32_t version = 0;
+  ngtcp2_cc *ccx = conn_get_cc(conn);
 
   /* Return 0 if destlen is less than minimum packet length which can
      trigger Stateless Reset */
@@ -3774,6 +3851,9 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
         *pfrc = nfrc;
         pfrc = &(*pfrc)->next;
 
+        conn->cstat.stream_bytes_retransmitted +=
+            ngtcp2_vec_len(nfrc->fr.stream.data, nfrc->fr.stream.datacnt);
+
         pkt_empty = 0;
         rtb_entry_flags |= NGTCP2_RTB_ENTRY_FLAG_ACK_ELICITING |
                            NGTCP2_RTB_ENTRY_FLAG_PTO_ELICITING |
@@ -4187,6 +4267,12 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
 
   ngtcp2_qlog_pkt_sent_end(&conn->qlog, hd, (size_t)nwrite);
 
+  ++conn->cstat.pkt_sent;
+  conn->cstat.bytes_sent += (size_t)nwrite;
+
+  NGTCP2_PROBE5(pkt_sent, conn->log.scid, hd->type, hd->pkt_num, nwrite,
+                conn->cstat.cwnd);
+
   /* TODO ack-eliciting vs needs-tracking */
   /* probe packet needs tracking but it does not need ACK, could be lost. */
   if ((rtb_entry_flags & NGTCP2_RTB_ENTRY_FLAG_ACK_ELICITING) || padded) {
@@ -4209,9 +4295,8 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
     }
 
     if ((rtb_entry_flags & NGTCP2_RTB_ENTRY_FLAG_ACK_ELICITING) &&
-        pktns->rtb.num_ack_eliciting == 0 && conn->cc.event) {
-      conn->cc.event(&conn->cc, &conn->cstat, NGTCP2_CC_EVENT_TYPE_TX_START,
-                     ts);
+        pktns->rtb.num_ack_eliciting == 0 && ccx->event) {
+      ccx->event(ccx, &conn->cstat, NGTCP2_CC_EVENT_TYPE_TX_START, ts);
     }
 
     rv = conn_on_pkt_sent(conn, &pktns->rtb, ent);
@@ -4223,9 +4308,9 @@ static ngtcp2_ssize conn_write_pkt(ngtcp2_conn *conn, ngtcp2_pkt_info *pi,
     }
 
     if (rtb_entry_flags & NGTCP2_RTB_ENTRY_FLAG_ACK_ELICITING) {
-      if (conn->cc.on_pkt_sent) {
-        conn->cc.on_pkt_sent(
-            &conn->cc, &conn->cstat,
+      if (ccx->on_pkt_sent) {
+        ccx->on_pkt_sent(
+            ccx, &conn->cstat,
             ngtcp2_cc_pkt_init(&cc_pkt, hd->pkt_num, (size_t)nwrite,
                                NGTCP2_PKTNS_ID_APPLICATION, ts, ent->rst.lost,
                                ent->rst.tx_in_flight, ent->rst.is_app_limited));
@@ -4388,6 +4473,12 @@ ngtcp2_ssize ngtcp2_conn_write_single_frame_pkt(
 
   ngtcp2_qlog_pkt_sent_end(&conn->qlog, &hd, (size_t)nwrite);
 
+  ++conn->cstat.pkt_sent;
+  conn->cstat.bytes_sent += (size_t)nwrite;
+
+  NGTCP2_PROBE5(pkt_sent, conn->log.scid, hd.type, hd.pkt_num, nwrite,
+                conn->cstat.cwnd);
+
   /* Do this when we are sure that there is no error. */
   switch (fr->type) {
   case NGTCP2_FRAME_ACK:
@@ -4661,9 +4752,11 @@ static int conn_start_pmtud(ngtcp2_conn *conn) {
   hard_max_udp_payload_size = (size_t)ngtcp2_min_uint64(
       conn->remote.transport_params->max_udp_payload_size,
       (uint64_t)conn->local.settings.max_tx_udp_payload_size);
+  hard_max_udp_payload_size = ngtcp2_min_size(
+      hard_max_udp_payload_size, conn->pmtud_bh.max_udp_payload_size);
 
   rv = ngtcp2_pmtud_new(&conn->pmtud, conn->dcid.current.max_udp_payload_size,
-                        hard_max_udp_payload_size,
+                        hard_max_udp_payload_size, conn->pmtud_hint,
                         conn->pktns.tx.last_pkt_num + 1,
                         conn->local.settings.pmtud_probes,
                         conn->local.settings.pmtud_probeslen, conn->mem);
@@ -4671,6 +4764,9 @@ static int conn_start_pmtud(ngtcp2_conn *conn) {
     return rv;
   }
 
+  /* The hint is only valid for the initial path. */
+  conn->pmtud_hint = 0;
+
   if (ngtcp2_pmtud_finished(conn->pmtud)) {
     ngtcp2_conn_stop_pmtud(conn);
   }
@@ -4692,6 +4788,61 @@ void ngtcp2_conn_stop_pmtud(ngtcp2_conn *conn) {
   conn->pmtud = NULL;
 }
 
+/*
+ * conn_reset_pmtud_bh resets the state of PMTU black hole detection.
+ */
+static void conn_reset_pmtud_bh(ngtcp2_conn *conn) {
+  conn->pmtud_bh.num_lost_pkts = 0;
+  conn->pmtud_bh.largest_acked_pkt_num = -1;
+  conn->pmtud_bh.max_udp_payload_size = SIZE_MAX;
+}
+
+void ngtcp2_conn_pmtud_on_pkt_acked(ngtcp2_conn *conn,
+                                    const ngtcp2_rtb_entry *ent) {
+  if (ent->pktlen <= NGTCP2_MAX_UDP_PAYLOAD_SIZE) {
+    return;
+  }
+
+  conn->pmtud_bh.num_lost_pkts = 0;
+  conn->pmtud_bh.largest_acked_pkt_num = ngtcp2_max_int64(
+      conn->pmtud_bh.largest_acked_pkt_num, ent->hd.pkt_num);
+}
+
+int ngtcp2_conn_pmtud_on_pkt_lost(ngtcp2_conn *conn,
+                                  const ngtcp2_rtb_entry *ent) {
+  size_t max_udp_payload_size = conn->dcid.current.max_udp_payload_size;
+
+  if (conn->local.settings.no_pmtud ||
+      conn->local.settings.no_tx_udp_payload_size_shaping ||
+      max_udp_payload_size <= NGTCP2_MAX_UDP_PAYLOAD_SIZE ||
+      ent->pktlen <= NGTCP2_MAX_UDP_PAYLOAD_SIZE ||
+      ent->hd.pkt_num <= conn->pmtud_bh.largest_acked_pkt_num) {
+    return 0;
+  }
+
+  if (++conn->pmtud_bh.num_lost_pkts < NGTCP2_PMTUD_BLACK_HOLE_THRESHOLD) {
+    return 0;
+  }
+
+  ngtcp2_log_info(&conn->log, NGTCP2_LOG_EVENT_CON,
+                  "PMTU black hole detected max_udp_payload_size=%zu",
+                  max_udp_payload_size);
+
+  /* Packets in flight are likely to be lost as well.  Do not count
+     them. */
+  conn->pmtud_bh.num_lost_pkts = 0;
+  conn->pmtud_bh.largest_acked_pkt_num = conn->pktns.tx.last_pkt_num;
+  conn->pmtud_bh.max_udp_payload_size = max_udp_payload_size - 1;
+
+  conn->dcid.current.max_udp_payload_size = NGTCP2_MAX_UDP_PAYLOAD_SIZE;
+  conn->cstat.max_tx_udp_payload_size =
+      ngtcp2_conn_get_path_max_tx_udp_payload_size(conn);
+
+  ngtcp2_conn_stop_pmtud(conn);
+
+  return conn_start_pmtud(conn);
+}
+
 static ngtcp2_ssize conn_write_pmtud_probe(ngtcp2_conn *conn,
                                            ngtcp2_pkt_info *pi, uint8_t *dest,
                                            size_t destlen, ngtcp2_tstamp ts) {
@@ -5724,6 +5875,11 @@ static int conn_recv_connection_close(ngtcp2_conn *conn,
   ccerr->error_code = fr->error_code;
   ccerr->frame_type = fr->frame_type;
 
+  if (ccerr->type == NGTCP2_CCERR_TYPE_TRANSPORT &&
+      ccerr->error_code != NGTCP2_NO_ERROR) {
+    ngtcp2_qlog_flush(&conn->qlog);
+  }
+
   if (!fr->reasonlen) {
     ccerr->reasonlen = 0;
 
@@ -5765,10 +5921,12 @@ static void conn_recv_path_challenge(ngtcp2_conn *conn, const ngtcp2_path *path,
  * conn_reset_congestion_state resets congestion state.
  */
 static void conn_reset_congestion_state(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+  ngtcp2_cc *cc = conn_get_cc(conn);
+
   conn_reset_conn_stat_cc(conn, &conn->cstat);
 
-  if (conn->cc.reset) {
-    conn->cc.reset(&conn->cc, &conn->cstat, ts);
+  if (cc->reset) {
+    cc->reset(cc, &conn->cstat, ts);
   }
 
   if (conn->hs_pktns) {
@@ -5819,6 +5977,7 @@ static int conn_recv_path_response(ngtcp2_conn *conn, ngtcp2_path_response *fr,
 
     if (!conn->local.settings.no_pmtud) {
       ngtcp2_conn_stop_pmtud(conn);
+      conn_reset_pmtud_bh(conn);
 
       if (!(ent_flags & NGTCP2_PV_ENTRY_FLAG_UNDERSIZED)) {
         rv = conn_start_pmtud(conn);
@@ -6119,7 +6278,7 @@ conn_recv_handshake_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
                     "buffering 1RTT packet len=%zu", pktlen);
 
     rv = conn_buffer_pkt(conn, &conn->pktns, path, pi, pkt, pktlen, dgramlen,
-                         ts);
+                         pkt_ts);
     if (rv != 0) {
       assert(ngtcp2_err_is_fatal(rv));
       return rv;
@@ -6267,7 +6426,7 @@ conn_recv_handshake_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
                     "buffering 0-RTT packet len=%zu", pktlen);
 
     rv = conn_buffer_pkt(conn, conn->in_pktns, path, pi, pkt, pktlen, dgramlen,
-                         ts);
+                         pkt_ts);
     if (rv != 0) {
       assert(ngtcp2_err_is_fatal(rv));
       return rv;
@@ -6374,7 +6533,7 @@ conn_recv_handshake_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
                       "buffering Handshake packet len=%zu", pktlen);
 
       rv = conn_buffer_pkt(conn, conn->hs_pktns, path, pi, pkt, pktlen,
-                           dgramlen, ts);
+                           dgramlen, pkt_ts);
       if (rv != 0) {
         assert(ngtcp2_err_is_fatal(rv));
         return rv;
@@ -6602,6 +6761,11 @@ conn_recv_handshake_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
 
   ngtcp2_qlog_pkt_received_end(&conn->qlog, &hd, pktlen);
 
+  ++conn->cstat.pkt_recv;
+  conn->cstat.bytes_recv += pktlen;
+
+  NGTCP2_PROBE4(pkt_recv, conn->log.scid, hd.type, hd.pkt_num, pktlen);
+
   rv = pktns_commit_recv_pkt_num(pktns, hd.pkt_num, require_ack, pkt_ts);
   if (rv != 0) {
     return rv;
@@ -6647,11 +6811,11 @@ static int is_unrecoverable_error(int liberr) {
  * This function returns the same error code returned by
  * conn_recv_handshake_pkt.
  */
-static ngtcp2_ssize conn_recv_handshake_cpkt(ngtcp2_conn *conn,
-                                             const ngtcp2_path *path,
-                                             const ngtcp2_pkt_info *pi,
-                                             const uint8_t *pkt, size_t pktlen,
-                                             ngtcp2_tstamp ts) {
+static ngtcp2_ssize
+conn_recv_handshake_cpkt(ngtcp2_conn *conn, const ngtcp2_path *path,
+                         const ngtcp2_pkt_info *pi, const uint8_t *pkt,
+                         size_t pktlen, ngtcp2_tstamp pkt_ts,
+                         ngtcp2_tstamp ts) {
   ngtcp2_ssize nread;
   size_t dgramlen = pktlen;
   const uint8_t *origpkt = pkt;
@@ -6662,8 +6826,8 @@ static ngtcp2_ssize conn_recv_handshake_cpkt(ngtcp2_conn *conn,
   }
 
   while (pktlen) {
-    nread =
-        conn_recv_handshake_pkt(conn, path, pi, pkt, pktlen, dgramlen, ts, ts);
+    nread = conn_recv_handshake_pkt(conn, path, pi, pkt, pktlen, dgramlen,
+                                    pkt_ts, ts);
     if (nread < 0) {
       if (ngtcp2_err_is_fatal((int)nread)) {
         return nread;
@@ -6768,6 +6932,8 @@ int ngtcp2_conn_init_stream(ngtcp2_conn *conn, ngtcp2_strm *strm,
     goto fail;
   }
 
+  NGTCP2_PROBE2(stream_open, conn->log.scid, stream_id);
+
   return 0;
 
 fail:
@@ -8387,6 +8553,8 @@ static void conn_rotate_keys(ngtcp2_conn *conn, int64_t pkt_num,
   conn->crypto.key_update.new_tx_ckm = NULL;
   pktns->crypto.tx.ckm->pkt_num = pktns->tx.last_pkt_num + 1;
 
+  NGTCP2_PROBE3(key_update, conn->log.scid, pkt_num, initiator);
+
   conn->flags |= NGTCP2_CONN_FLAG_KEY_UPDATE_NOT_CONFIRMED;
   if (initiator) {
     conn->flags |= NGTCP2_CONN_FLAG_KEY_UPDATE_INITIATOR;
@@ -8731,6 +8899,11 @@ conn_recv_delayed_handshake_pkt(ngtcp2_conn *conn, const ngtcp2_pkt_info *pi,
 
   ngtcp2_qlog_pkt_received_end(&conn->qlog, hd, pktlen);
 
+  ++conn->cstat.pkt_recv;
+  conn->cstat.bytes_recv += pktlen;
+
+  NGTCP2_PROBE4(pkt_recv, conn->log.scid, hd->type, hd->pkt_num, pktlen);
+
   rv = pktns_commit_recv_pkt_num(pktns, hd->pkt_num, require_ack, pkt_ts);
   if (rv != 0) {
     return rv;
@@ -9373,6 +9546,11 @@ static ngtcp2_ssize conn_recv_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
 
   ngtcp2_qlog_pkt_received_end(&conn->qlog, &hd, pktlen);
 
+  ++conn->cstat.pkt_recv;
+  conn->cstat.bytes_recv += pktlen;
+
+  NGTCP2_PROBE4(pkt_recv, conn->log.scid, hd.type, hd.pkt_num, pktlen);
+
   if (recv_ncid) {
     rv = conn_post_process_recv_new_connection_id(conn, ts);
     if (rv != 0) {
@@ -9594,11 +9772,13 @@ static int conn_sync_stream_data_limit(ngtcp2_conn *conn) {
  * NGTCP2_ERR_CALLBACK_FAILURE
  *     User callback failed.
  */
-static int conn_handshake_completed(ngtcp2_conn *conn) {
+static int conn_handshake_completed(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   int rv;
 
   conn->flags |= NGTCP2_CONN_FLAG_HANDSHAKE_COMPLETED;
 
+  conn->cstat.handshake_duration = ts - conn->local.settings.initial_ts;
+
   rv = conn_call_handshake_completed(conn);
   if (rv != 0) {
     return rv;
@@ -9633,7 +9813,8 @@ static int conn_handshake_completed(ngtcp2_conn *conn) {
  */
 static int conn_recv_cpkt(ngtcp2_conn *conn, const ngtcp2_path *path,
                           const ngtcp2_pkt_info *pi, const uint8_t *pkt,
-                          size_t pktlen, ngtcp2_tstamp ts) {
+                          size_t pktlen, ngtcp2_tstamp pkt_ts,
+                          ngtcp2_tstamp ts) {
   ngtcp2_ssize nread;
   int rv;
   const uint8_t *origpkt = pkt;
@@ -9644,7 +9825,7 @@ static int conn_recv_cpkt(ngtcp2_conn *conn, const ngtcp2_path *path,
   }
 
   while (pktlen) {
-    nread = conn_recv_pkt(conn, path, pi, pkt, pktlen, dgramlen, ts, ts);
+    nread = conn_recv_pkt(conn, path, pi, pkt, pktlen, dgramlen, pkt_ts, ts);
     if (nread < 0) {
       if (ngtcp2_err_is_fatal((int)nread)) {
         return (int)nread;
@@ -9738,6 +9919,7 @@ static ngtcp2_ssize conn_read_handshake(ngtcp2_conn *conn,
                                         const ngtcp2_path *path,
                                         const ngtcp2_pkt_info *pi,
                                         const uint8_t *pkt, size_t pktlen,
+                                        ngtcp2_tstamp pkt_ts,
                                         ngtcp2_tstamp ts) {
   int rv;
   ngtcp2_ssize nread;
@@ -9747,7 +9929,7 @@ static ngtcp2_ssize conn_read_handshake(ngtcp2_conn *conn,
     /* TODO Better to log something when we ignore input */
     return (ngtcp2_ssize)pktlen;
   case NGTCP2_CS_CLIENT_WAIT_HANDSHAKE:
-    nread = conn_recv_handshake_cpkt(conn, path, pi, pkt, pktlen, ts);
+    nread = conn_recv_handshake_cpkt(conn, path, pi, pkt, pktlen, pkt_ts, ts);
     if (nread < 0) {
       return nread;
     }
@@ -9768,7 +9950,7 @@ static ngtcp2_ssize conn_read_handshake(ngtcp2_conn *conn,
 
     if (conn_is_tls_handshake_completed(conn) &&
         !(conn->flags & NGTCP2_CONN_FLAG_HANDSHAKE_COMPLETED)) {
-      rv = conn_handshake_completed(conn);
+      rv = conn_handshake_completed(conn, ts);
       if (rv != 0) {
         return rv;
       }
@@ -9781,7 +9963,7 @@ static ngtcp2_ssize conn_read_handshake(ngtcp2_conn *conn,
 
     return nread;
   case NGTCP2_CS_SERVER_INITIAL:
-    nread = conn_recv_handshake_cpkt(conn, path, pi, pkt, pktlen, ts);
+    nread = conn_recv_handshake_cpkt(conn, path, pi, pkt, pktlen, pkt_ts, ts);
     if (nread < 0) {
       return nread;
     }
@@ -9819,7 +10001,7 @@ static ngtcp2_ssize conn_read_handshake(ngtcp2_conn *conn,
 
     return nread;
   case NGTCP2_CS_SERVER_WAIT_HANDSHAKE:
-    nread = conn_recv_handshake_cpkt(conn, path, pi, pkt, pktlen, ts);
+    nread = conn_recv_handshake_cpkt(conn, path, pi, pkt, pktlen, pkt_ts, ts);
     if (nread < 0) {
       return nread;
     }
@@ -9866,7 +10048,7 @@ static ngtcp2_ssize conn_read_handshake(ngtcp2_conn *conn,
                         pktlen - (size_t)nread);
 
         rv = conn_buffer_pkt(conn, &conn->pktns, path, pi, pkt + nread,
-                             pktlen - (size_t)nread, pktlen, ts);
+                             pktlen - (size_t)nread, pktlen, pkt_ts);
         if (rv != 0) {
           assert(ngtcp2_err_is_fatal(rv));
           return rv;
@@ -9882,7 +10064,7 @@ static ngtcp2_ssize conn_read_handshake(ngtcp2_conn *conn,
       return NGTCP2_ERR_REQUIRED_TRANSPORT_PARAM;
     }
 
-    rv = conn_handshake_completed(conn);
+    rv = conn_handshake_completed(conn, ts);
     if (rv != 0) {
       return rv;
     }
@@ -9928,11 +10110,10 @@ static ngtcp2_ssize conn_read_handshake(ngtcp2_conn *conn,
   }
 }
 
-int ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
-                                   int pkt_info_version,
-                                   const ngtcp2_pkt_info *pi,
-                                   const uint8_t *pkt, size_t pktlen,
-                                   ngtcp2_tstamp ts) {
+static int conn_read_pkt(ngtcp2_conn *conn, const ngtcp2_path *path,
+                         int pkt_info_version, const ngtcp2_pkt_info *pi,
+                         const uint8_t *pkt, size_t pktlen,
+                         ngtcp2_tstamp pkt_ts, ngtcp2_tstamp ts) {
   int rv = 0;
   ngtcp2_ssize nread = 0;
   const ngtcp2_pkt_info zero_pi = {0};
@@ -9965,7 +10146,7 @@ int ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
   switch (conn->state) {
   case NGTCP2_CS_CLIENT_INITIAL:
   case NGTCP2_CS_CLIENT_WAIT_HANDSHAKE:
-    nread = conn_read_handshake(conn, path, pi, pkt, pktlen, ts);
+    nread = conn_read_handshake(conn, path, pi, pkt, pktlen, pkt_ts, ts);
     if (nread < 0) {
       return (int)nread;
     }
@@ -9996,7 +10177,7 @@ int ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
       return 0;
     }
 
-    nread = conn_read_handshake(conn, path, pi, pkt, pktlen, ts);
+    nread = conn_read_handshake(conn, path, pi, pkt, pktlen, pkt_ts, ts);
     if (nread < 0) {
       return (int)nread;
     }
@@ -10025,7 +10206,44 @@ int ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
     ngtcp2_unreachable();
   }
 
-  return conn_recv_cpkt(conn, path, pi, pkt, pktlen, ts);
+  return conn_recv_cpkt(conn, path, pi, pkt, pktlen, pkt_ts, ts);
+}
+
+int ngtcp2_conn_read_pkt_versioned(ngtcp2_conn *conn, const ngtcp2_path *path,
+                                   int pkt_info_version,
+                                   const ngtcp2_pkt_info *pi,
+                                   const uint8_t *pkt, size_t pktlen,
+                                   ngtcp2_tstamp ts) {
+  return ngtcp2_conn_read_timestamped_pkt_versioned(
+      conn, path, pkt_info_version, pi, pkt, pktlen, ts, ts);
+}
+
+int ngtcp2_conn_read_timestamped_pkt_versioned(
+    ngtcp2_conn *conn, const ngtcp2_path *path, int pkt_info_version,
+    const ngtcp2_pkt_info *pi, const uint8_t *pkt, size_t pktlen,
+    ngtcp2_tstamp pkt_ts, ngtcp2_tstamp ts) {
+  int rv;
+
+  NGTCP2_PROBE3(read_pkt, conn->log.scid, pktlen, ts);
+
+  /* The packet cannot be received in the future. */
+  pkt_ts = ngtcp2_min_uint64(pkt_ts, ts);
+
+  if (conn->hist) {
+    if (conn->rx.last_ts != UINT64_MAX && pkt_ts >= conn->rx.last_ts) {
+      ngtcp2_histogram_add(&conn->hist[NGTCP2_HISTOGRAM_TYPE_RX_GAP],
+                           pkt_ts - conn->rx.last_ts);
+    }
+
+    conn->rx.last_ts = pkt_ts;
+  }
+
+  rv = conn_read_pkt(conn, path, pkt_info_version, pi, pkt, pktlen, pkt_ts,
+                     ts);
+
+  conn_update_timer_wheel(conn);
+
+  return rv;
 }
 
 /*
@@ -10466,6 +10684,8 @@ void ngtcp2_conn_tls_handshake_completed(ngtcp2_conn *conn) {
   if (conn->server) {
     conn->flags |= NGTCP2_CONN_FLAG_HANDSHAKE_CONFIRMED;
   }
+
+  conn_update_timer_wheel(conn);
 }
 
 int ngtcp2_conn_get_handshake_completed(ngtcp2_conn *conn) {
@@ -10853,9 +11073,15 @@ static int conn_initiate_key_update(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
 }
 
 int ngtcp2_conn_initiate_key_update(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+  int rv;
+
   conn_update_timestamp(conn, ts);
 
-  return conn_initiate_key_update(conn, ts);
+  rv = conn_initiate_key_update(conn, ts);
+
+  conn_update_timer_wheel(conn);
+
+  return rv;
 }
 
 /*
@@ -10994,7 +11220,7 @@ ngtcp2_tstamp ngtcp2_conn_get_expiry(ngtcp2_conn *conn) {
   return ngtcp2_min_uint64(res, conn->tx.pacing.next_ts);
 }
 
-int ngtcp2_conn_handle_expiry(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+static int conn_handle_expiry(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   int rv;
   ngtcp2_duration pto;
 
@@ -11054,12 +11280,38 @@ int ngtcp2_conn_handle_expiry(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   if (!conn_is_tls_handshake_completed(conn) &&
       ngtcp2_tstamp_elapsed(conn->local.settings.initial_ts,
                             conn->local.settings.handshake_timeout, ts)) {
+    ngtcp2_qlog_flush(&conn->qlog);
+
     return NGTCP2_ERR_HANDSHAKE_TIMEOUT;
   }
 
   return 0;
 }
 
+void ngtcp2_conn_set_timer_wheel(ngtcp2_conn *conn, ngtcp2_timer_wheel *tw) {
+  if (conn->tw) {
+    ngtcp2_timer_wheel_detach(conn->tw, &conn->tw_ent);
+  }
+
+  conn->tw = tw;
+
+  if (tw) {
+    ngtcp2_timer_wheel_attach(tw, &conn->tw_ent);
+  }
+
+  conn_update_timer_wheel(conn);
+}
+
+void *ngtcp2_conn_get_user_data(ngtcp2_conn *conn) { return conn->user_data; }
+
+int ngtcp2_conn_handle_expiry(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+  int rv = conn_handle_expiry(conn, ts);
+
+  conn_update_timer_wheel(conn);
+
+  return rv;
+}
+
 static void acktr_cancel_expired_ack_delay_timer(ngtcp2_acktr *acktr,
                                                  ngtcp2_duration max_ack_delay,
                                                  ngtcp2_tstamp ts) {
@@ -11676,6 +11928,36 @@ ngtcp2_ssize ngtcp2_conn_write_stream_versioned(
                                              stream_id, &datav, 1, ts);
 }
 
+/*
+ * conn_update_tx_limit accounts the time elapsed since the last
+ * update to the current reason which limits sending, and then sets
+ * |tx_limit| as the new reason.
+ */
+static void conn_update_tx_limit(ngtcp2_conn *conn, ngtcp2_tx_limit tx_limit,
+                                 ngtcp2_tstamp ts) {
+  ngtcp2_conn_stat *cstat = &conn->cstat;
+  ngtcp2_duration elapsed;
+
+  if (cstat->tx_limit_ts != UINT64_MAX) {
+    elapsed = ts - cstat->tx_limit_ts;
+
+    switch (cstat->tx_limit) {
+    case NGTCP2_TX_LIMIT_CWND:
+      cstat->cwnd_limited_duration += elapsed;
+      break;
+    case NGTCP2_TX_LIMIT_APP:
+      cstat->app_limited_duration += elapsed;
+      break;
+    case NGTCP2_TX_LIMIT_FLOW_CONTROL:
+      cstat->flow_control_limited_duration += elapsed;
+      break;
+    }
+  }
+
+  cstat->tx_limit = (uint8_t)tx_limit;
+  cstat->tx_limit_ts = ts;
+}
+
 static ngtcp2_ssize conn_write_vmsg_wrapper(ngtcp2_conn *conn,
                                             ngtcp2_path *path,
                                             int pkt_info_version,
@@ -11687,20 +11969,35 @@ static ngtcp2_ssize conn_write_vmsg_wrapper(ngtcp2_conn *conn,
 
   nwrite = ngtcp2_conn_write_vmsg(conn, path, pkt_info_version, pi, dest,
                                   destlen, vmsg, ts);
+
+  conn_update_timer_wheel(conn);
+
   if (nwrite < 0) {
+    if (nwrite == NGTCP2_ERR_STREAM_DATA_BLOCKED) {
+      conn_update_tx_limit(conn, NGTCP2_TX_LIMIT_FLOW_CONTROL, ts);
+    }
+
     return nwrite;
   }
 
   if (cstat->bytes_in_flight >= cstat->cwnd) {
     conn->rst.is_cwnd_limited = 1;
-  }
 
-  if (nwrite == 0 && cstat->bytes_in_flight < cstat->cwnd) {
+    conn_update_tx_limit(conn, NGTCP2_TX_LIMIT_CWND, ts);
+  } else if (nwrite == 0) {
     conn->rst.app_limited = conn->rst.delivered + cstat->bytes_in_flight;
 
     if (conn->rst.app_limited == 0) {
       conn->rst.app_limited = cstat->max_tx_udp_payload_size;
     }
+
+    conn_update_tx_limit(conn,
+                         ngtcp2_conn_get_max_data_left(conn)
+                             ? NGTCP2_TX_LIMIT_APP
+                             : NGTCP2_TX_LIMIT_FLOW_CONTROL,
+                         ts);
+  } else {
+    conn_update_tx_limit(conn, NGTCP2_TX_LIMIT_NONE, ts);
   }
 
   return nwrite;
@@ -12427,22 +12724,34 @@ ngtcp2_ssize ngtcp2_conn_write_connection_close_versioned(
     ngtcp2_conn *conn, ngtcp2_path *path, int pkt_info_version,
     ngtcp2_pkt_info *pi, uint8_t *dest, size_t destlen,
     const ngtcp2_ccerr *ccerr, ngtcp2_tstamp ts) {
+  ngtcp2_ssize nwrite;
   (void)pkt_info_version;
 
   conn_update_timestamp(conn, ts);
 
   switch (ccerr->type) {
   case NGTCP2_CCERR_TYPE_TRANSPORT:
-    return ngtcp2_conn_write_connection_close_pkt(
+    if (ccerr->error_code != NGTCP2_NO_ERROR) {
+      ngtcp2_qlog_flush(&conn->qlog);
+    }
+
+    nwrite = ngtcp2_conn_write_connection_close_pkt(
         conn, path, pi, dest, destlen, ccerr->error_code, ccerr->reason,
         ccerr->reasonlen, ts);
+    break;
   case NGTCP2_CCERR_TYPE_APPLICATION:
-    return ngtcp2_conn_write_application_close_pkt(
+    nwrite = ngtcp2_conn_write_application_close_pkt(
         conn, path, pi, dest, destlen, ccerr->error_code, ccerr->reason,
         ccerr->reasonlen, ts);
+    break;
   default:
-    return 0;
+    nwrite = 0;
+    break;
   }
+
+  conn_update_timer_wheel(conn);
+
+  return nwrite;
 }
 
 int ngtcp2_conn_in_closing_period(ngtcp2_conn *conn) {
@@ -12456,6 +12765,9 @@ int ngtcp2_conn_in_draining_period(ngtcp2_conn *conn) {
 int ngtcp2_conn_close_stream(ngtcp2_conn *conn, ngtcp2_strm *strm) {
   int rv;
 
+  NGTCP2_PROBE3(stream_close, conn->log.scid, strm->stream_id,
+                strm->app_error_code);
+
   rv = conn_call_stream_close(conn, strm);
   if (rv != 0) {
     return rv;
@@ -12787,6 +13099,12 @@ int ngtcp2_conn_update_rtt(ngtcp2_conn *conn, ngtcp2_duration rtt,
                            ngtcp2_duration ack_delay, ngtcp2_tstamp ts) {
   ngtcp2_conn_stat *cstat = &conn->cstat;
 
+  if (conn->hist) {
+    ngtcp2_histogram_add(&conn->hist[NGTCP2_HISTOGRAM_TYPE_RTT], rtt);
+    ngtcp2_histogram_add(&conn->hist[NGTCP2_HISTOGRAM_TYPE_ACK_DELAY],
+                         ack_delay);
+  }
+
   if (cstat->min_rtt == UINT64_MAX) {
     cstat->latest_rtt = rtt;
     cstat->min_rtt = rtt;
@@ -12853,6 +13171,123 @@ void ngtcp2_conn_get_conn_info_versioned(ngtcp2_conn *conn,
   cinfo->bytes_in_flight = cstat->bytes_in_flight;
 }
 
+void ngtcp2_conn_get_stats_versioned(ngtcp2_conn *conn, int conn_stats_version,
+                                     ngtcp2_conn_stats *stats) {
+  const ngtcp2_conn_stat *cstat = &conn->cstat;
+  ngtcp2_duration elapsed = 0;
+  (void)conn_stats_version;
+
+  if (cstat->tx_limit_ts != UINT64_MAX) {
+    elapsed = conn->log.last_ts - cstat->tx_limit_ts;
+  }
+
+  stats->pkt_sent = cstat->pkt_sent;
+  stats->bytes_sent = cstat->bytes_sent;
+  stats->pkt_recv = cstat->pkt_recv;
+  stats->bytes_recv = cstat->bytes_recv;
+  stats->pkt_lost = cstat->pkt_lost;
+  stats->bytes_lost = cstat->bytes_lost;
+  stats->pkt_spurious_lost = cstat->pkt_spurious_lost;
+  stats->stream_bytes_retransmitted = cstat->stream_bytes_retransmitted;
+  stats->pto_count = cstat->total_pto_count;
+  stats->ecn_ce_acked = cstat->ecn_ce_acked;
+  stats->cwnd_limited_duration = cstat->cwnd_limited_duration;
+  stats->app_limited_duration = cstat->app_limited_duration;
+  stats->flow_control_limited_duration = cstat->flow_control_limited_duration;
+  stats->handshake_duration = cstat->handshake_duration;
+
+  switch (cstat->tx_limit) {
+  case NGTCP2_TX_LIMIT_CWND:
+    stats->cwnd_limited_duration += elapsed;
+    break;
+  case NGTCP2_TX_LIMIT_APP:
+    stats->app_limited_duration += elapsed;
+    break;
+  case NGTCP2_TX_LIMIT_FLOW_CONTROL:
+    stats->flow_control_limited_duration += elapsed;
+    break;
+  }
+}
+
+const ngtcp2_histogram *ngtcp2_conn_get_histogram(ngtcp2_conn *conn,
+                                                  ngtcp2_histogram_type type) {
+  if (!conn->hist) {
+    return NULL;
+  }
+
+  switch (type) {
+  case NGTCP2_HISTOGRAM_TYPE_RTT:
+  case NGTCP2_HISTOGRAM_TYPE_ACK_DELAY:
+  case NGTCP2_HISTOGRAM_TYPE_RX_GAP:
+    return &conn->hist[type];
+  default:
+    return NULL;
+  }
+}
+
+int ngtcp2_conn_get_path_capacity_versioned(ngtcp2_conn *conn,
+                                            int path_capacity_version,
+                                            ngtcp2_path_capacity *cap) {
+  const ngtcp2_conn_stat *cstat = &conn->cstat;
+  (void)path_capacity_version;
+
+  if (cstat->min_rtt == UINT64_MAX) {
+    return NGTCP2_ERR_INVALID_STATE;
+  }
+
+  cap->cwnd = cstat->cwnd;
+  cap->min_rtt = cstat->min_rtt;
+  cap->delivery_rate_sec = cstat->delivery_rate_sec;
+
+  return 0;
+}
+
+int ngtcp2_conn_set_path_capacity_versioned(ngtcp2_conn *conn,
+                                            int path_capacity_version,
+                                            const ngtcp2_path_capacity *cap) {
+  (void)path_capacity_version;
+
+  if (cap->cwnd == 0 || cap->min_rtt == 0 || cap->min_rtt == UINT64_MAX) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  if (conn->flags &
+      (NGTCP2_CONN_FLAG_HANDSHAKE_COMPLETED | NGTCP2_CONN_FLAG_CAREFUL_RESUME)) {
+    return NGTCP2_ERR_INVALID_STATE;
+  }
+
+  ngtcp2_cc_cr_init(&conn->cr, &conn->cc, &conn->log, cap->cwnd, cap->min_rtt);
+
+  conn->flags |= NGTCP2_CONN_FLAG_CAREFUL_RESUME;
+
+  if (conn->in_pktns) {
+    conn->in_pktns->rtb.cc = &conn->cr.cc;
+  }
+
+  if (conn->hs_pktns) {
+    conn->hs_pktns->rtb.cc = &conn->cr.cc;
+  }
+
+  conn->pktns.rtb.cc = &conn->cr.cc;
+
+  return 0;
+}
+
+int ngtcp2_conn_set_pmtud_hint(ngtcp2_conn *conn, size_t udp_payload_size) {
+  if (udp_payload_size <= NGTCP2_MAX_UDP_PAYLOAD_SIZE ||
+      udp_payload_size > UINT16_MAX) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  if (conn_is_tls_handshake_completed(conn)) {
+    return NGTCP2_ERR_INVALID_STATE;
+  }
+
+  conn->pmtud_hint = udp_payload_size;
+
+  return 0;
+}
+
 static void conn_get_loss_time_and_pktns(ngtcp2_conn *conn,
                                          ngtcp2_tstamp *ploss_time,
                                          ngtcp2_pktns **ppktns) {
@@ -13031,10 +13466,20 @@ int ngtcp2_conn_on_loss_detection_timer(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   }
 
   ++cstat->pto_count;
+  ++cstat->total_pto_count;
 
   ngtcp2_log_info(&conn->log, NGTCP2_LOG_EVENT_LDC, "pto_count=%zu",
                   cstat->pto_count);
 
+  NGTCP2_PROBE4(pto, conn->log.scid, cstat->pto_count, cstat->cwnd,
+                cstat->bytes_in_flight);
+
+  if (conn->local.settings.qlog_flight_recorder_pto_count &&
+      cstat->pto_count ==
+          conn->local.settings.qlog_flight_recorder_pto_count) {
+    ngtcp2_qlog_flush(&conn->qlog);
+  }
+
   ngtcp2_conn_set_loss_detection_timer(conn, ts);
 
   return 0;
@@ -13316,7 +13761,7 @@ static int conn_initiate_migration_precheck(ngtcp2_conn *conn,
   return 0;
 }
 
-int ngtcp2_conn_initiate_immediate_migration(ngtcp2_conn *conn,
+static int conn_initiate_immediate_migration(ngtcp2_conn *conn,
                                              const ngtcp2_path *path,
                                              ngtcp2_tstamp ts) {
   int rv;
@@ -13370,7 +13815,17 @@ int ngtcp2_conn_initiate_immediate_migration(ngtcp2_conn *conn,
   return conn_call_activate_dcid(conn, &conn->dcid.current);
 }
 
-int ngtcp2_conn_initiate_migration(ngtcp2_conn *conn, const ngtcp2_path *path,
+int ngtcp2_conn_initiate_immediate_migration(ngtcp2_conn *conn,
+                                             const ngtcp2_path *path,
+                                             ngtcp2_tstamp ts) {
+  int rv = conn_initiate_immediate_migration(conn, path, ts);
+
+  conn_update_timer_wheel(conn);
+
+  return rv;
+}
+
+static int conn_initiate_migration(ngtcp2_conn *conn, const ngtcp2_path *path,
                                    ngtcp2_tstamp ts) {
   int rv;
   ngtcp2_dcid *dcid;
@@ -13407,6 +13862,15 @@ int ngtcp2_conn_initiate_migration(ngtcp2_conn *conn, const ngtcp2_path *path,
   return conn_call_activate_dcid(conn, &pv->dcid);
 }
 
+int ngtcp2_conn_initiate_migration(ngtcp2_conn *conn, const ngtcp2_path *path,
+                                   ngtcp2_tstamp ts) {
+  int rv = conn_initiate_migration(conn, path, ts);
+
+  conn_update_timer_wheel(conn);
+
+  return rv;
+}
+
 uint64_t ngtcp2_conn_get_max_data_left(ngtcp2_conn *conn) {
   return conn->tx.max_offset - conn->tx.offset;
 }
@@ -13580,7 +14044,7 @@ int ngtcp2_conn_set_stream_user_data(ngtcp2_conn *conn, int64_t stream_id,
   return 0;
 }
 
-void ngtcp2_conn_update_pkt_tx_time(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+static void conn_update_pkt_tx_time(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   ngtcp2_duration pacing_interval;
   ngtcp2_duration wait;
 
@@ -13607,6 +14071,12 @@ void ngtcp2_conn_update_pkt_tx_time(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   conn->tx.pacing.pktlen = 0;
 }
 
+void ngtcp2_conn_update_pkt_tx_time(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
+  conn_update_pkt_tx_time(conn, ts);
+
+  conn_update_timer_wheel(conn);
+}
+
 size_t ngtcp2_conn_get_send_quantum(ngtcp2_conn *conn) {
   return conn->cstat.send_quantum;
 }
@@ -13663,6 +14133,10 @@ size_t ngtcp2_conn_get_stream_loss_count(ngtcp2_conn *conn, int64_t stream_id) {
   return strm->tx.loss_count;
 }
 
+void ngtcp2_conn_flush_qlog(ngtcp2_conn *conn) {
+  ngtcp2_qlog_flush(&conn->qlog);
+}
+
 void ngtcp2_path_challenge_entry_init(ngtcp2_path_challenge_entry *pcent,
                                       const ngtcp2_path *path,
                                       const uint8_t *data) {
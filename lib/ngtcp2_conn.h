@@ -51,6 +51,8 @@
 #include "ngtcp2_qlog.h"
 #include "ngtcp2_rst.h"
 #include "ngtcp2_conn_stat.h"
+#include "ngtcp2_timer_wheel.h"
+#include "ngtcp2_histogram.h"
 
 typedef enum {
   /* Client specific handshake states */
@@ -217,6 +219,9 @@ void ngtcp2_path_challenge_entry_init(ngtcp2_path_challenge_entry *pcent,
 /* NGTCP2_CONN_FLAG_KEY_UPDATE_INITIATOR is set when the local
    endpoint has initiated key update. */
 #define NGTCP2_CONN_FLAG_KEY_UPDATE_INITIATOR 0x10000u
+/* NGTCP2_CONN_FLAG_CAREFUL_RESUME is set when application imports
+   path capacity, and cr wraps the congestion controller. */
+#define NGTCP2_CONN_FLAG_CAREFUL_RESUME 0x20000u
 
 typedef struct ngtcp2_pktns {
   struct {
@@ -486,6 +491,9 @@ struct ngtcp2_conn {
     ngtcp2_static_ringbuf_path_challenge path_challenge;
     /* ccerr is the received connection close error. */
     ngtcp2_ccerr ccerr;
+    /* last_ts is the timestamp when the last UDP datagram was
+       received.  It is only updated if hist is not NULL. */
+    ngtcp2_tstamp last_ts;
   } rx;
 
   struct {
@@ -666,8 +674,37 @@ struct ngtcp2_conn {
   ngtcp2_conn_stat cstat;
   ngtcp2_pv *pv;
   ngtcp2_pmtud *pmtud;
+  /* pmtud_hint is the UDP payload size which is probed first when
+     PMTUD starts for the first time.  0 means no hint. */
+  size_t pmtud_hint;
+  /* pmtud_bh is the state of PMTU black hole detection on the current
+     path. */
+  struct {
+    /* num_lost_pkts is the number of the consecutive lost packets
+       which are larger than NGTCP2_MAX_UDP_PAYLOAD_SIZE. */
+    size_t num_lost_pkts;
+    /* largest_acked_pkt_num is the largest packet number of the
+       acknowledged packet which is larger than
+       NGTCP2_MAX_UDP_PAYLOAD_SIZE.  Packets whose packet number is
+       lower than or equal to this value are not counted toward
+       num_lost_pkts. */
+    int64_t largest_acked_pkt_num;
+    /* max_udp_payload_size is the upper bound of UDP payload size
+       that PMTUD probes.  It is lowered when a black hole is
+       detected. */
+    size_t max_udp_payload_size;
+  } pmtud_bh;
+  /* tw is the timer wheel which tracks the expiry of this connection.
+     It is NULL if the expiry is not tracked. */
+  ngtcp2_timer_wheel *tw;
+  /* tw_ent is the entry of this connection in tw. */
+  ngtcp2_timer_wheel_entry tw_ent;
   ngtcp2_log log;
   ngtcp2_qlog qlog;
+  /* hist points to the array of histograms indexed by
+     ngtcp2_histogram_type.  It is NULL if histograms are not
+     collected. */
+  ngtcp2_histogram *hist;
   ngtcp2_rst rst;
   ngtcp2_cc_algo cc_algo;
   union {
@@ -676,6 +713,9 @@ struct ngtcp2_conn {
     ngtcp2_cc_cubic cubic;
     ngtcp2_cc_bbr bbr;
   };
+  /* cr is Careful Resume state which is effective only if
+     NGTCP2_CONN_FLAG_CAREFUL_RESUME is set. */
+  ngtcp2_cc_cr cr;
   const ngtcp2_mem *mem;
   /* idle_ts is the time instant when idle timer started. */
   ngtcp2_tstamp idle_ts;
@@ -1085,6 +1125,30 @@ int ngtcp2_conn_start_pmtud(ngtcp2_conn *conn);
 
 void ngtcp2_conn_stop_pmtud(ngtcp2_conn *conn);
 
+/*
+ * ngtcp2_conn_pmtud_on_pkt_acked is called when a packet |ent| in
+ * application packet number space is acknowledged.
+ */
+void ngtcp2_conn_pmtud_on_pkt_acked(ngtcp2_conn *conn,
+                                    const ngtcp2_rtb_entry *ent);
+
+/*
+ * ngtcp2_conn_pmtud_on_pkt_lost is called when a packet |ent| in
+ * application packet number space is declared lost.  If the
+ * consecutive packets larger than NGTCP2_MAX_UDP_PAYLOAD_SIZE are
+ * lost, it concludes that the path is a black hole for them, falls
+ * back to NGTCP2_MAX_UDP_PAYLOAD_SIZE, and restarts PMTUD below the
+ * size that failed.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * NGTCP2_ERR_NOMEM
+ *     Out of memory.
+ */
+int ngtcp2_conn_pmtud_on_pkt_lost(ngtcp2_conn *conn,
+                                  const ngtcp2_rtb_entry *ent);
+
 /**
  * @function
  *
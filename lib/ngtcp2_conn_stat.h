@@ -31,6 +31,34 @@
 
 #include <ngtcp2/ngtcp2.h>
 
+/**
+ * @enum
+ *
+ * :type:`ngtcp2_tx_limit` is the reason which limits sending.
+ */
+typedef enum ngtcp2_tx_limit {
+  /**
+   * :enum:`NGTCP2_TX_LIMIT_NONE` indicates that sending is not
+   * limited.
+   */
+  NGTCP2_TX_LIMIT_NONE,
+  /**
+   * :enum:`NGTCP2_TX_LIMIT_CWND` indicates that sending is limited by
+   * congestion window.
+   */
+  NGTCP2_TX_LIMIT_CWND,
+  /**
+   * :enum:`NGTCP2_TX_LIMIT_APP` indicates that application has
+   * nothing to send.
+   */
+  NGTCP2_TX_LIMIT_APP,
+  /**
+   * :enum:`NGTCP2_TX_LIMIT_FLOW_CONTROL` indicates that sending is
+   * blocked by flow control.
+   */
+  NGTCP2_TX_LIMIT_FLOW_CONTROL,
+} ngtcp2_tx_limit;
+
 /**
  * @struct
  *
@@ -128,6 +156,84 @@ typedef struct ngtcp2_conn_stat {
    * scheduled and transmitted together.
    */
   size_t send_quantum;
+  /**
+   * :member:`pkt_sent` is the number of QUIC packets sent.
+   */
+  uint64_t pkt_sent;
+  /**
+   * :member:`bytes_sent` is the number of bytes of QUIC packets sent.
+   */
+  uint64_t bytes_sent;
+  /**
+   * :member:`pkt_recv` is the number of QUIC packets received and
+   * successfully decrypted.
+   */
+  uint64_t pkt_recv;
+  /**
+   * :member:`bytes_recv` is the number of bytes of QUIC packets
+   * received and successfully decrypted.
+   */
+  uint64_t bytes_recv;
+  /**
+   * :member:`pkt_lost` is the number of QUIC packets declared lost.
+   * PMTUD probes are not counted.
+   */
+  uint64_t pkt_lost;
+  /**
+   * :member:`bytes_lost` is the number of bytes of QUIC packets
+   * declared lost.  PMTUD probes are not counted.
+   */
+  uint64_t bytes_lost;
+  /**
+   * :member:`pkt_spurious_lost` is the number of QUIC packets which
+   * are acknowledged after they are declared lost.
+   */
+  uint64_t pkt_spurious_lost;
+  /**
+   * :member:`stream_bytes_retransmitted` is the number of bytes of
+   * STREAM data retransmitted.
+   */
+  uint64_t stream_bytes_retransmitted;
+  /**
+   * :member:`total_pto_count` is the number of PTO timer expirations.
+   * Unlike :member:`pto_count`, it is never reset.
+   */
+  uint64_t total_pto_count;
+  /**
+   * :member:`ecn_ce_acked` is the number of QUIC packets sent which
+   * are reported as CE marked by a remote endpoint.
+   */
+  uint64_t ecn_ce_acked;
+  /**
+   * :member:`cwnd_limited_duration` is the time spent while sending
+   * is limited by congestion window.
+   */
+  ngtcp2_duration cwnd_limited_duration;
+  /**
+   * :member:`app_limited_duration` is the time spent while
+   * application has nothing to send.
+   */
+  ngtcp2_duration app_limited_duration;
+  /**
+   * :member:`flow_control_limited_duration` is the time spent while
+   * sending is blocked by flow control of a remote endpoint.
+   */
+  ngtcp2_duration flow_control_limited_duration;
+  /**
+   * :member:`handshake_duration` is the time taken to complete
+   * handshake.  It is 0 if handshake has not completed yet.
+   */
+  ngtcp2_duration handshake_duration;
+  /**
+   * :member:`tx_limit` is the current reason which limits sending.
+   * It is one of :type:`ngtcp2_tx_limit`.
+   */
+  uint8_t tx_limit;
+  /**
+   * :member:`tx_limit_ts` is the timestamp when :member:`tx_limit` is
+   * last updated.
+   */
+  ngtcp2_tstamp tx_limit_ts;
 } ngtcp2_conn_stat;
 
 #endif /* NGTCP2_CONN_STAT_H */
@@ -0,0 +1,148 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_histogram.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "ngtcp2_macro.h"
+
+/* NGTCP2_HISTOGRAM_SUB_BITS is the number of bits to address a
+   bucket within a power of 2 range. */
+#define NGTCP2_HISTOGRAM_SUB_BITS 3
+/* NGTCP2_HISTOGRAM_SUBLEN is the number of buckets within a power of
+   2 range. */
+#define NGTCP2_HISTOGRAM_SUBLEN (1 << NGTCP2_HISTOGRAM_SUB_BITS)
+/* NGTCP2_HISTOGRAM_MAX_US is the smallest duration in microseconds
+   that falls into the last bucket without being clamped. */
+#define NGTCP2_HISTOGRAM_MAX_US (1ULL << 32)
+
+/*
+ * histogram_log2 returns the position of the most significant bit set
+ * in |x|.  |x| must not be 0.
+ */
+static size_t histogram_log2(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63 - (size_t)__builtin_clzll(x);
+#else  /* !(defined(__GNUC__) || defined(__clang__)) */
+  size_t n = 0;
+
+  for (; x >>= 1; ++n)
+    ;
+
+  return n;
+#endif /* !(defined(__GNUC__) || defined(__clang__)) */
+}
+
+size_t ngtcp2_histogram_bucket_index(ngtcp2_duration v) {
+  uint64_t us = v / NGTCP2_MICROSECONDS;
+  size_t k;
+
+  if (us < NGTCP2_HISTOGRAM_SUBLEN) {
+    return (size_t)us;
+  }
+
+  if (us >= NGTCP2_HISTOGRAM_MAX_US) {
+    return NGTCP2_HISTOGRAM_BUCKETLEN - 1;
+  }
+
+  k = histogram_log2(us) - NGTCP2_HISTOGRAM_SUB_BITS;
+
+  return NGTCP2_HISTOGRAM_SUBLEN + k * NGTCP2_HISTOGRAM_SUBLEN +
+         (size_t)((us >> k) & (NGTCP2_HISTOGRAM_SUBLEN - 1));
+}
+
+ngtcp2_duration ngtcp2_histogram_bucket_lower_bound(size_t idx) {
+  size_t k;
+
+  assert(idx < NGTCP2_HISTOGRAM_BUCKETLEN);
+
+  if (idx < NGTCP2_HISTOGRAM_SUBLEN) {
+    return idx * NGTCP2_MICROSECONDS;
+  }
+
+  idx -= NGTCP2_HISTOGRAM_SUBLEN;
+  k = idx / NGTCP2_HISTOGRAM_SUBLEN;
+
+  return ((uint64_t)(NGTCP2_HISTOGRAM_SUBLEN + idx % NGTCP2_HISTOGRAM_SUBLEN)
+          << k) *
+         NGTCP2_MICROSECONDS;
+}
+
+void ngtcp2_histogram_init(ngtcp2_histogram *h) {
+  memset(h, 0, sizeof(*h));
+  h->min = UINT64_MAX;
+}
+
+void ngtcp2_histogram_add(ngtcp2_histogram *h, ngtcp2_duration v) {
+  ++h->buckets[ngtcp2_histogram_bucket_index(v)];
+  ++h->count;
+  h->sum += v;
+  h->min = ngtcp2_min_uint64(h->min, v);
+  h->max = ngtcp2_max_uint64(h->max, v);
+}
+
+void ngtcp2_histogram_merge(ngtcp2_histogram *dest,
+                            const ngtcp2_histogram *src) {
+  size_t i;
+
+  for (i = 0; i < NGTCP2_HISTOGRAM_BUCKETLEN; ++i) {
+    dest->buckets[i] += src->buckets[i];
+  }
+
+  dest->count += src->count;
+  dest->sum += src->sum;
+  dest->min = ngtcp2_min_uint64(dest->min, src->min);
+  dest->max = ngtcp2_max_uint64(dest->max, src->max);
+}
+
+ngtcp2_duration ngtcp2_histogram_quantile(const ngtcp2_histogram *h,
+                                          uint32_t permille) {
+  uint64_t rank, n = 0;
+  size_t i;
+
+  if (h->count == 0) {
+    return 0;
+  }
+
+  permille = ngtcp2_min_uint32(permille, 1000);
+
+  /* rank = ceil(count * permille / 1000) without overflow. */
+  rank = h->count / 1000 * permille +
+         (h->count % 1000 * permille + 999) / 1000;
+  if (rank == 0) {
+    rank = 1;
+  }
+
+  for (i = 0; i < NGTCP2_HISTOGRAM_BUCKETLEN - 1; ++i) {
+    n += h->buckets[i];
+    if (n >= rank) {
+      return ngtcp2_min_uint64(ngtcp2_histogram_bucket_lower_bound(i + 1) - 1,
+                               h->max);
+    }
+  }
+
+  return h->max;
+}
@@ -25,6 +25,7 @@
 #include "ngtcp2_pmtud.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include "ngtcp2_mem.h"
 #include "ngtcp2_macro.h"
@@ -39,42 +40,84 @@ static uint16_t pmtud_default_probes[] = {
     1390 - 48, /* Typical Tunneled MTU */
     1280 - 48, /* IPv6 minimum MTU */
     1492 - 48, /* PPPoE */
+    9000 - 48, /* Jumbo frame.  This is only probed if
+                  max_tx_udp_payload_size allows it. */
 };
 
+/*
+ * pmtud_add_probe adds |probe| to the sorted array |probes| of length
+ * |*pprobeslen| unless it is already included.  It returns the index
+ * of |probe| in |probes|.
+ */
+static size_t pmtud_add_probe(uint16_t *probes, size_t *pprobeslen,
+                              uint16_t probe) {
+  size_t i;
+
+  for (i = 0; i < *pprobeslen; ++i) {
+    if (probes[i] == probe) {
+      return i;
+    }
+
+    if (probes[i] > probe) {
+      break;
+    }
+  }
+
+  memmove(probes + i + 1, probes + i, sizeof(probes[0]) * (*pprobeslen - i));
+  probes[i] = probe;
+  ++*pprobeslen;
+
+  return i;
+}
+
 int ngtcp2_pmtud_new(ngtcp2_pmtud **ppmtud, size_t max_udp_payload_size,
-                     size_t hard_max_udp_payload_size, int64_t tx_pkt_num,
+                     size_t hard_max_udp_payload_size,
+                     size_t hint_udp_payload_size, int64_t tx_pkt_num,
                      const uint16_t *probes, size_t probeslen,
                      const ngtcp2_mem *mem) {
-  ngtcp2_pmtud *pmtud = ngtcp2_mem_malloc(mem, sizeof(ngtcp2_pmtud));
+  ngtcp2_pmtud *pmtud;
+  size_t i;
+
+  if (!probeslen) {
+    probes = pmtud_default_probes;
+    probeslen = ngtcp2_arraylen(pmtud_default_probes);
+  }
 
+  pmtud = ngtcp2_mem_malloc(mem, sizeof(ngtcp2_pmtud) +
+                                     sizeof(probes[0]) * (probeslen + 1));
   if (pmtud == NULL) {
     return NGTCP2_ERR_NOMEM;
   }
 
   pmtud->mem = mem;
-  pmtud->mtu_idx = 0;
   pmtud->num_pkts_sent = 0;
   pmtud->expiry = UINT64_MAX;
   pmtud->tx_pkt_num = tx_pkt_num;
   pmtud->max_udp_payload_size = max_udp_payload_size;
   pmtud->hard_max_udp_payload_size = hard_max_udp_payload_size;
   pmtud->min_fail_udp_payload_size = SIZE_MAX;
+  pmtud->probes = (uint16_t *)(void *)(pmtud + 1);
+  pmtud->probeslen = 0;
 
-  if (probeslen) {
-    pmtud->probes = probes;
-    pmtud->probeslen = probeslen;
-  } else {
-    pmtud->probes = pmtud_default_probes;
-    pmtud->probeslen = ngtcp2_arraylen(pmtud_default_probes);
-  }
-
-  for (; pmtud->mtu_idx < pmtud->probeslen; ++pmtud->mtu_idx) {
-    if (pmtud->probes[pmtud->mtu_idx] > pmtud->hard_max_udp_payload_size) {
+  for (i = 0; i < probeslen; ++i) {
+    if (probes[i] <= max_udp_payload_size ||
+        probes[i] > hard_max_udp_payload_size) {
       continue;
     }
-    if (pmtud->probes[pmtud->mtu_idx] > pmtud->max_udp_payload_size) {
-      break;
-    }
+
+    pmtud_add_probe(pmtud->probes, &pmtud->probeslen, probes[i]);
+  }
+
+  pmtud->lo = 0;
+  pmtud->hi = pmtud->probeslen;
+
+  if (hint_udp_payload_size > max_udp_payload_size &&
+      hint_udp_payload_size <= hard_max_udp_payload_size) {
+    pmtud->mtu_idx = pmtud_add_probe(pmtud->probes, &pmtud->probeslen,
+                                     (uint16_t)hint_udp_payload_size);
+    pmtud->hi = pmtud->probeslen;
+  } else {
+    pmtud->mtu_idx = pmtud->lo + (pmtud->hi - pmtud->lo) / 2;
   }
 
   *ppmtud = pmtud;
@@ -114,22 +157,9 @@ int ngtcp2_pmtud_require_probe(ngtcp2_pmtud *pmtud) {
 }
 
 static void pmtud_next_probe(ngtcp2_pmtud *pmtud) {
-  assert(pmtud->mtu_idx < pmtud->probeslen);
-
-  ++pmtud->mtu_idx;
   pmtud->num_pkts_sent = 0;
   pmtud->expiry = UINT64_MAX;
-
-  for (; pmtud->mtu_idx < pmtud->probeslen; ++pmtud->mtu_idx) {
-    if (pmtud->probes[pmtud->mtu_idx] <= pmtud->max_udp_payload_size ||
-        pmtud->probes[pmtud->mtu_idx] > pmtud->hard_max_udp_payload_size) {
-      continue;
-    }
-
-    if (pmtud->probes[pmtud->mtu_idx] < pmtud->min_fail_udp_payload_size) {
-      break;
-    }
-  }
+  pmtud->mtu_idx = pmtud->lo + (pmtud->hi - pmtud->lo) / 2;
 }
 
 void ngtcp2_pmtud_probe_success(ngtcp2_pmtud *pmtud, size_t payloadlen) {
@@ -138,7 +168,12 @@ void ngtcp2_pmtud_probe_success(ngtcp2_pmtud *pmtud, size_t payloadlen) {
 
   assert(pmtud->mtu_idx < pmtud->probeslen);
 
-  if (pmtud->probes[pmtud->mtu_idx] > pmtud->max_udp_payload_size) {
+  for (; pmtud->lo < pmtud->hi &&
+         pmtud->probes[pmtud->lo] <= pmtud->max_udp_payload_size;
+       ++pmtud->lo)
+    ;
+
+  if (pmtud->mtu_idx >= pmtud->lo) {
     return;
   }
 
@@ -158,10 +193,11 @@ void ngtcp2_pmtud_handle_expiry(ngtcp2_pmtud *pmtud, ngtcp2_tstamp ts) {
 
   pmtud->min_fail_udp_payload_size = ngtcp2_min_size(
       pmtud->min_fail_udp_payload_size, pmtud->probes[pmtud->mtu_idx]);
+  pmtud->hi = pmtud->mtu_idx;
 
   pmtud_next_probe(pmtud);
 }
 
 int ngtcp2_pmtud_finished(ngtcp2_pmtud *pmtud) {
-  return pmtud->mtu_idx >= pmtud->probeslen;
+  return pmtud->lo >= pmtud->hi;
 }
@@ -31,11 +31,22 @@
 
 #include <ngtcp2/ngtcp2.h>
 
+/* NGTCP2_PMTUD_BLACK_HOLE_THRESHOLD is the number of the consecutive
+   lost packets larger than NGTCP2_MAX_UDP_PAYLOAD_SIZE that makes us
+   conclude that the path is a black hole for those packets. */
+#define NGTCP2_PMTUD_BLACK_HOLE_THRESHOLD 3
+
 typedef struct ngtcp2_pmtud {
   const ngtcp2_mem *mem;
   /* mtu_idx is the index of UDP payload size candidates to try
      out. */
   size_t mtu_idx;
+  /* lo and hi define the range [lo, hi) of the indices of UDP payload
+     size candidates that are neither known to work nor known to
+     fail.  The next candidate is chosen by binary search in this
+     range. */
+  size_t lo;
+  size_t hi;
   /* num_pkts_sent is the number of mtu_idx sized UDP datagram payload
      sent */
   size_t num_pkts_sent;
@@ -58,8 +69,11 @@ typedef struct ngtcp2_pmtud {
   /* min_fail_udp_payload_size is the minimum UDP payload size that is
      known to fail. */
   size_t min_fail_udp_payload_size;
-  /* probes is the array of UDP datagram payload size to probe. */
-  const uint16_t *probes;
+  /* probes is the array of UDP datagram payload size to probe.  It
+     only contains the sizes in range (max_udp_payload_size,
+     hard_max_udp_payload_size] given at the creation, and they are
+     sorted in ascending order without duplicates. */
+  uint16_t *probes;
   /* probeslen is the number of probes pointed by probes. */
   size_t probeslen;
 } ngtcp2_pmtud;
@@ -76,7 +90,12 @@ typedef struct ngtcp2_pmtud {
  *
  * The array pointed by |pmtud_probes| of length |pmtud_probeslen|
  * specifies UDP datagram payload size to probe.  If |pmtud_probeslen|
- * is zero, the default probes are used.
+ * is zero, the default probes are used.  The probes are sorted, and
+ * searched by binary search.
+ *
+ * If |hint_udp_payload_size| is nonzero, it is added to the
+ * candidates, and probed first.  It is ignored if it is not in range
+ * (|max_udp_payload_size|, |hard_max_udp_payload_size|].
  *
  * This function returns 0 if it succeeds, or one of the following
  * negative error codes:
@@ -85,7 +104,8 @@ typedef struct ngtcp2_pmtud {
  *     Out of memory.
  */
 int ngtcp2_pmtud_new(ngtcp2_pmtud **ppmtud, size_t max_udp_payload_size,
-                     size_t hard_max_udp_payload_size, int64_t tx_pkt_num,
+                     size_t hard_max_udp_payload_size,
+                     size_t hint_udp_payload_size, int64_t tx_pkt_num,
                      const uint16_t *pmtud_probes, size_t pmtud_probeslen,
                      const ngtcp2_mem *mem);
 
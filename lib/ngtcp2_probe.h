@@ -0,0 +1,73 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef NGTCP2_PROBE_H
+#define NGTCP2_PROBE_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <ngtcp2/ngtcp2.h>
+
+/*
+ * NGTCP2_PROBE<N> defines a USDT probe named NAME in provider ngtcp2
+ * with N arguments.  Probes are compiled out unless the library is
+ * configured with USDT support, and the arguments are not evaluated
+ * in that case.  By convention, the first argument of a connection
+ * level probe is the SCID of the connection encoded as
+ * NULL-terminated hex string (ngtcp2_log.scid).
+ *
+ * The available probes are:
+ *
+ * read_pkt(scid, pktlen, ts)
+ * pkt_recv(scid, type, pkt_num, pktlen)
+ * pkt_sent(scid, type, pkt_num, pktlen, cwnd)
+ * pkt_lost(scid, pktns_id, pkt_num, pktlen, cwnd)
+ * congestion_event(scid, cwnd, ssthresh, bytes_in_flight)
+ * persistent_congestion(scid, cwnd)
+ * spurious_congestion(scid, cwnd)
+ * pto(scid, pto_count, cwnd, bytes_in_flight)
+ * stream_open(scid, stream_id)
+ * stream_close(scid, stream_id, app_error_code)
+ * key_update(scid, pkt_num, initiator)
+ */
+#ifdef HAVE_USDT
+#  include <sys/sdt.h>
+
+#  define NGTCP2_PROBE2(NAME, A1, A2) DTRACE_PROBE2(ngtcp2, NAME, A1, A2)
+#  define NGTCP2_PROBE3(NAME, A1, A2, A3)                                      \
+    DTRACE_PROBE3(ngtcp2, NAME, A1, A2, A3)
+#  define NGTCP2_PROBE4(NAME, A1, A2, A3, A4)                                  \
+    DTRACE_PROBE4(ngtcp2, NAME, A1, A2, A3, A4)
+#  define NGTCP2_PROBE5(NAME, A1, A2, A3, A4, A5)                              \
+    DTRACE_PROBE5(ngtcp2, NAME, A1, A2, A3, A4, A5)
+#else /* !HAVE_USDT */
+#  define NGTCP2_PROBE2(NAME, A1, A2) ((void)0)
+#  define NGTCP2_PROBE3(NAME, A1, A2, A3) ((void)0)
+#  define NGTCP2_PROBE4(NAME, A1, A2, A3, A4) ((void)0)
+#  define NGTCP2_PROBE5(NAME, A1, A2, A3, A4, A5) ((void)0)
+#endif /* !HAVE_USDT */
+
+#endif /* NGTCP2_PROBE_H */
@@ -25,6 +25,7 @@
 #include "ngtcp2_qlog.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include "ngtcp2_str.h"
 #include "ngtcp2_vec.h"
@@ -32,12 +33,219 @@
 #include "ngtcp2_net.h"
 #include "ngtcp2_unreachable.h"
 #include "ngtcp2_conn_stat.h"
+#include "ngtcp2_macro.h"
 
 void ngtcp2_qlog_init(ngtcp2_qlog *qlog, ngtcp2_qlog_write write,
-                      ngtcp2_tstamp ts, void *user_data) {
+                      ngtcp2_qlog_format format, ngtcp2_tstamp ts,
+                      void *user_data) {
   qlog->write = write;
+  qlog->format = format;
   qlog->ts = qlog->last_ts = ts;
   qlog->user_data = user_data;
+  memset(&qlog->rec, 0, sizeof(qlog->rec));
+  qlog->filter = NGTCP2_QLOG_FILTER_NONE;
+  qlog->metrics_interval = 0;
+  qlog->last_metrics_ts = UINT64_MAX;
+  qlog->pkt_sample_rate = 0;
+  qlog->pkt_count = 0;
+  qlog->flags = NGTCP2_QLOG_FLAG_NONE;
+}
+
+void ngtcp2_qlog_set_filter(ngtcp2_qlog *qlog, uint32_t filter,
+                            ngtcp2_duration metrics_interval,
+                            size_t pkt_sample_rate) {
+  qlog->filter = filter;
+  qlog->metrics_interval = metrics_interval;
+  qlog->pkt_sample_rate = pkt_sample_rate;
+}
+
+void ngtcp2_qlog_set_recorder(ngtcp2_qlog *qlog, uint8_t *buf, size_t buflen) {
+  ngtcp2_qlog_recorder *rec = &qlog->rec;
+
+  memset(rec, 0, sizeof(*rec));
+  rec->buf = buf;
+  rec->buflen = buflen;
+}
+
+/*
+ * qlog_rec_evict discards the oldest event in |rec|.
+ */
+static void qlog_rec_evict(ngtcp2_qlog_recorder *rec) {
+  uint16_t len;
+
+  ngtcp2_get_uint16(&len, rec->buf + rec->head);
+
+  rec->head += sizeof(len) + len;
+
+  if (rec->wrapped && rec->head == rec->end) {
+    rec->head = 0;
+    rec->wrapped = 0;
+  }
+}
+
+/*
+ * qlog_rec_push stores an event |data| of length |datalen| in |rec|,
+ * discarding the oldest events as needed.  An event which does not
+ * fit in the ring buffer at all is dropped.
+ */
+static void qlog_rec_push(ngtcp2_qlog_recorder *rec, const uint8_t *data,
+                          size_t datalen) {
+  size_t n = sizeof(uint16_t) + datalen;
+  uint8_t *p;
+
+  if (datalen > UINT16_MAX || n > rec->buflen) {
+    return;
+  }
+
+  for (;;) {
+    if (!rec->wrapped) {
+      if (rec->head == rec->tail) {
+        rec->head = rec->tail = 0;
+      }
+
+      if (rec->buflen - rec->tail >= n) {
+        break;
+      }
+
+      rec->end = rec->tail;
+      rec->tail = 0;
+      rec->wrapped = 1;
+    }
+
+    if (rec->head - rec->tail >= n) {
+      break;
+    }
+
+    qlog_rec_evict(rec);
+  }
+
+  p = ngtcp2_put_uint16be(rec->buf + rec->tail, (uint16_t)datalen);
+  ngtcp2_cpymem(p, data, datalen);
+
+  rec->tail += n;
+}
+
+static void qlog_rec_write_events(ngtcp2_qlog *qlog, size_t begin,
+                                  size_t end) {
+  const uint8_t *p = qlog->rec.buf + begin;
+  const uint8_t *last = qlog->rec.buf + end;
+  uint16_t len;
+
+  for (; p != last; p += len) {
+    p = ngtcp2_get_uint16(&len, p);
+
+    qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, p, len);
+  }
+}
+
+void ngtcp2_qlog_flush(ngtcp2_qlog *qlog) {
+  ngtcp2_qlog_recorder *rec = &qlog->rec;
+
+  if (!qlog->write || !rec->buf) {
+    return;
+  }
+
+  if (rec->preamblelen) {
+    qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE,
+                rec->buf - rec->preamblelen, rec->preamblelen);
+  }
+
+  if (rec->wrapped) {
+    qlog_rec_write_events(qlog, rec->head, rec->end);
+    qlog_rec_write_events(qlog, 0, rec->tail);
+  } else {
+    qlog_rec_write_events(qlog, rec->head, rec->tail);
+  }
+
+  rec->buf = NULL;
+}
+
+/*
+ * qlog_emit sends qlog event |data| of length |datalen| to
+ * qlog->write callback.  If flight recorder is enabled, the event is
+ * stored in its ring buffer instead.
+ */
+static void qlog_emit(ngtcp2_qlog *qlog, const uint8_t *data,
+                      size_t datalen) {
+  if (qlog->rec.buf) {
+    qlog_rec_push(&qlog->rec, data, datalen);
+    return;
+  }
+
+  qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, data, datalen);
+}
+
+/* NGTCP2_QLOG_BIN_MAX_RECLEN is the maximum length of binary qlog
+   record excluding its length prefix.  The length is encoded in 2
+   bytes variable-length integer. */
+#define NGTCP2_QLOG_BIN_MAX_RECLEN 16383
+
+/*
+ * qlog_bin_write_record fills the length prefix of binary qlog
+ * record [|begin|, |end|), and writes it.  The first 2 bytes of the
+ * record must be reserved for the length.
+ */
+static void qlog_bin_write_record(ngtcp2_qlog *qlog, uint8_t *begin,
+                                  uint8_t *end) {
+  size_t len = (size_t)(end - begin) - 2;
+
+  assert(len <= NGTCP2_QLOG_BIN_MAX_RECLEN);
+
+  ngtcp2_put_uint16be(begin, (uint16_t)len);
+  *begin |= 0x40;
+
+  qlog_emit(qlog, begin, (size_t)(end - begin));
+}
+
+/*
+ * qlog_wrap_json returns the beginning of the bytes to write for
+ * JSON-SEQ text [|data|, |end|).  If binary format is chosen, the
+ * text is wrapped into |ev| record.  |data| must be preceded by
+ * NGTCP2_QLOG_BIN_HEADROOM bytes which this function can overwrite.
+ */
+static uint8_t *qlog_wrap_json(ngtcp2_qlog *qlog, uint8_t ev, uint8_t *data,
+                               uint8_t *end) {
+  uint8_t *begin, *p;
+  size_t len;
+
+  if (qlog->format == NGTCP2_QLOG_FORMAT_JSON_SEQ) {
+    return data;
+  }
+
+  begin = p = data - (ev == NGTCP2_QLOG_BIN_EV_PREAMBLE ? 4 : 3);
+  len = (size_t)(end - begin) - 2;
+
+  assert(len <= NGTCP2_QLOG_BIN_MAX_RECLEN);
+
+  p = ngtcp2_put_uint16be(p, (uint16_t)len);
+  *begin |= 0x40;
+  *p++ = ev;
+  if (ev == NGTCP2_QLOG_BIN_EV_PREAMBLE) {
+    *p++ = NGTCP2_QLOG_BIN_VERSION;
+  }
+
+  assert(p == data);
+
+  return begin;
+}
+
+/*
+ * qlog_write_json writes JSON-SEQ text [|data|, |end|).  See
+ * qlog_wrap_json for the requirement of |data|.
+ */
+static void qlog_write_json(ngtcp2_qlog *qlog, uint8_t ev, uint8_t *data,
+                            uint8_t *end) {
+  uint8_t *begin = qlog_wrap_json(qlog, ev, data, end);
+
+  qlog_emit(qlog, begin, (size_t)(end - begin));
+}
+
+/*
+ * qlog_bin_put_duration writes |d| in variable-length integer.
+ * Values which do not fit into variable-length integer are clamped.
+ */
+static uint8_t *qlog_bin_put_duration(uint8_t *p, ngtcp2_duration d) {
+  return ngtcp2_put_uvarint(p, ngtcp2_min_uint64(d, NGTCP2_MAX_VARINT));
 }
 
 #define write_verbatim(DEST, S) ngtcp2_cpymem((DEST), (S), sizeof(S) - 1)
@@ -211,8 +419,11 @@ static uint8_t *write_trace(uint8_t *p, int server, const ngtcp2_cid *odcid) {
 }
 
 void ngtcp2_qlog_start(ngtcp2_qlog *qlog, const ngtcp2_cid *odcid, int server) {
-  uint8_t buf[1024];
-  uint8_t *p = buf;
+  uint8_t rawbuf[NGTCP2_QLOG_BIN_HEADROOM + 1024];
+  uint8_t *buf = rawbuf + NGTCP2_QLOG_BIN_HEADROOM;
+  uint8_t *p = buf, *begin;
+  ngtcp2_qlog_recorder *rec = &qlog->rec;
+  size_t len;
 
   if (!qlog->write) {
     return;
@@ -223,8 +434,21 @@ void ngtcp2_qlog_start(ngtcp2_qlog *qlog, const ngtcp2_cid *odcid, int server) {
   p = write_trace(p, server, odcid);
   p = write_verbatim(p, "}\n");
 
-  qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, buf,
-              (size_t)(p - buf));
+  begin = qlog_wrap_json(qlog, NGTCP2_QLOG_BIN_EV_PREAMBLE, buf, p);
+  len = (size_t)(p - begin);
+
+  /* Keep the preamble out of the ring buffer of flight recorder so
+     that it is never discarded. */
+  if (rec->buf && rec->head == rec->tail && len <= rec->buflen / 2) {
+    memcpy(rec->buf, begin, len);
+    rec->buf += len;
+    rec->buflen -= len;
+    rec->preamblelen = len;
+
+    return;
+  }
+
+  qlog_emit(qlog, begin, len);
 }
 
 void ngtcp2_qlog_end(ngtcp2_qlog *qlog) {
@@ -234,6 +458,10 @@ void ngtcp2_qlog_end(ngtcp2_qlog *qlog) {
     return;
   }
 
+  /* Discard the events kept by flight recorder because nothing
+     triggered the flush. */
+  qlog->rec.buf = NULL;
+
   qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_FIN, &buf, 0);
 }
 
@@ -681,10 +909,68 @@ static uint8_t *write_datagram_frame(uint8_t *p, const ngtcp2_datagram *fr) {
   return p;
 }
 
+static void qlog_bin_pkt_write_start(ngtcp2_qlog *qlog, int sent) {
+  uint8_t *p;
+
+  ngtcp2_buf_reset(&qlog->buf);
+  p = qlog->buf.last;
+
+  /* The record length is filled in qlog_bin_pkt_write_end. */
+  p += 2;
+  *p++ = sent ? NGTCP2_QLOG_BIN_EV_PKT_SENT : NGTCP2_QLOG_BIN_EV_PKT_RECEIVED;
+  p = ngtcp2_put_uvarint(p, qlog->last_ts - qlog->ts);
+
+  qlog->buf.last = p;
+}
+
+static void qlog_bin_pkt_write_end(ngtcp2_qlog *qlog, const ngtcp2_pkt_hd *hd,
+                                   size_t pktlen) {
+  uint8_t *p = qlog->buf.last;
+  size_t tokenlen = hd->type == NGTCP2_PKT_INITIAL ? hd->tokenlen : 0;
+
+  /*
+   * frame end (1), packet type (1), flags (1), packet number (8),
+   * token length (8) and token, packet length (8)
+   */
+  if (ngtcp2_buf_left(&qlog->buf) < 27 + tokenlen) {
+    return;
+  }
+
+  *p++ = NGTCP2_QLOG_BIN_FRAME_END;
+  *p++ = hd->type;
+  *p++ = hd->flags & NGTCP2_PKT_FLAG_LONG_FORM;
+  p = ngtcp2_put_uvarint(p, (uint64_t)hd->pkt_num);
+  p = ngtcp2_put_uvarint(p, tokenlen);
+  if (tokenlen) {
+    p = ngtcp2_cpymem(p, hd->token, tokenlen);
+  }
+  p = ngtcp2_put_uvarint(p, pktlen);
+
+  qlog->buf.last = p;
+
+  qlog_bin_write_record(qlog, qlog->buf.pos, qlog->buf.last);
+}
+
 static uint8_t *qlog_write_time(ngtcp2_qlog *qlog, uint8_t *p) {
   return write_pair_tstamp(p, "time", qlog->last_ts - qlog->ts);
 }
 
+/*
+ * qlog_pkt_skip returns nonzero if the packet event which is about to
+ * be written should be filtered out or sampled out.
+ */
+static int qlog_pkt_skip(ngtcp2_qlog *qlog) {
+  if (qlog->filter & NGTCP2_QLOG_FILTER_PKT) {
+    return 1;
+  }
+
+  if (qlog->pkt_sample_rate > 1) {
+    return qlog->pkt_count++ % qlog->pkt_sample_rate != 0;
+  }
+
+  return 0;
+}
+
 static void qlog_pkt_write_start(ngtcp2_qlog *qlog, int sent) {
   uint8_t *p;
 
@@ -692,6 +978,18 @@ static void qlog_pkt_write_start(ngtcp2_qlog *qlog, int sent) {
     return;
   }
 
+  if (qlog_pkt_skip(qlog)) {
+    qlog->flags |= NGTCP2_QLOG_FLAG_PKT_SKIPPED;
+    return;
+  }
+
+  qlog->flags &= (uint32_t)~NGTCP2_QLOG_FLAG_PKT_SKIPPED;
+
+  if (qlog->format == NGTCP2_QLOG_FORMAT_BINARY) {
+    qlog_bin_pkt_write_start(qlog, sent);
+    return;
+  }
+
   ngtcp2_buf_reset(&qlog->buf);
   p = qlog->buf.last;
 
@@ -712,7 +1010,12 @@ static void qlog_pkt_write_end(ngtcp2_qlog *qlog, const ngtcp2_pkt_hd *hd,
                                size_t pktlen) {
   uint8_t *p = qlog->buf.last;
 
-  if (!qlog->write) {
+  if (!qlog->write || (qlog->flags & NGTCP2_QLOG_FLAG_PKT_SKIPPED)) {
+    return;
+  }
+
+  if (qlog->format == NGTCP2_QLOG_FORMAT_BINARY) {
+    qlog_bin_pkt_write_end(qlog, hd, pktlen);
     return;
   }
 
@@ -744,14 +1047,203 @@ static void qlog_pkt_write_end(ngtcp2_qlog *qlog, const ngtcp2_pkt_hd *hd,
 
   qlog->buf.last = p;
 
-  qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, qlog->buf.pos,
-              ngtcp2_buf_len(&qlog->buf));
+  qlog_emit(qlog, qlog->buf.pos, ngtcp2_buf_len(&qlog->buf));
+}
+
+static void qlog_bin_write_frame(ngtcp2_qlog *qlog, const ngtcp2_frame *fr) {
+  uint8_t *p = qlog->buf.last;
+  size_t i;
+
+  /* Each integer field takes at most 8 bytes.  1 byte is for frame
+     type. */
+  switch (fr->type) {
+  case NGTCP2_FRAME_PADDING:
+  case NGTCP2_FRAME_PING:
+  case NGTCP2_FRAME_HANDSHAKE_DONE:
+    if (ngtcp2_buf_left(&qlog->buf) < 1) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    break;
+  case NGTCP2_FRAME_ACK:
+  case NGTCP2_FRAME_ACK_ECN:
+    if (ngtcp2_buf_left(&qlog->buf) <
+        1 + 8 * 4 + 16 * fr->ack.rangecnt +
+            (size_t)(fr->type == NGTCP2_FRAME_ACK_ECN ? 24 : 0)) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = qlog_bin_put_duration(p, fr->ack.ack_delay_unscaled);
+    p = ngtcp2_put_uvarint(p, (uint64_t)fr->ack.largest_ack);
+    p = ngtcp2_put_uvarint(p, fr->ack.first_ack_range);
+    p = ngtcp2_put_uvarint(p, fr->ack.rangecnt);
+    for (i = 0; i < fr->ack.rangecnt; ++i) {
+      p = ngtcp2_put_uvarint(p, fr->ack.ranges[i].gap);
+      p = ngtcp2_put_uvarint(p, fr->ack.ranges[i].len);
+    }
+    if (fr->type == NGTCP2_FRAME_ACK_ECN) {
+      p = ngtcp2_put_uvarint(p, fr->ack.ecn.ect1);
+      p = ngtcp2_put_uvarint(p, fr->ack.ecn.ect0);
+      p = ngtcp2_put_uvarint(p, fr->ack.ecn.ce);
+    }
+    break;
+  case NGTCP2_FRAME_RESET_STREAM:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8 * 3) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, (uint64_t)fr->reset_stream.stream_id);
+    p = ngtcp2_put_uvarint(p, fr->reset_stream.app_error_code);
+    p = ngtcp2_put_uvarint(p, fr->reset_stream.final_size);
+    break;
+  case NGTCP2_FRAME_STOP_SENDING:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8 * 2) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, (uint64_t)fr->stop_sending.stream_id);
+    p = ngtcp2_put_uvarint(p, fr->stop_sending.app_error_code);
+    break;
+  case NGTCP2_FRAME_CRYPTO:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8 * 2) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, fr->stream.offset);
+    p = ngtcp2_put_uvarint(p,
+                           ngtcp2_vec_len(fr->stream.data, fr->stream.datacnt));
+    break;
+  case NGTCP2_FRAME_NEW_TOKEN:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8 + fr->new_token.tokenlen) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, fr->new_token.tokenlen);
+    if (fr->new_token.tokenlen) {
+      p = ngtcp2_cpymem(p, fr->new_token.token, fr->new_token.tokenlen);
+    }
+    break;
+  case NGTCP2_FRAME_STREAM:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 1 + 8 * 3) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    *p++ = fr->stream.fin;
+    p = ngtcp2_put_uvarint(p, (uint64_t)fr->stream.stream_id);
+    p = ngtcp2_put_uvarint(p, fr->stream.offset);
+    p = ngtcp2_put_uvarint(p,
+                           ngtcp2_vec_len(fr->stream.data, fr->stream.datacnt));
+    break;
+  case NGTCP2_FRAME_MAX_DATA:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, fr->max_data.max_data);
+    break;
+  case NGTCP2_FRAME_MAX_STREAM_DATA:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8 * 2) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, (uint64_t)fr->max_stream_data.stream_id);
+    p = ngtcp2_put_uvarint(p, fr->max_stream_data.max_stream_data);
+    break;
+  case NGTCP2_FRAME_MAX_STREAMS_BIDI:
+  case NGTCP2_FRAME_MAX_STREAMS_UNI:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, fr->max_streams.max_streams);
+    break;
+  case NGTCP2_FRAME_DATA_BLOCKED:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, fr->data_blocked.offset);
+    break;
+  case NGTCP2_FRAME_STREAM_DATA_BLOCKED:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8 * 2) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, (uint64_t)fr->stream_data_blocked.stream_id);
+    p = ngtcp2_put_uvarint(p, fr->stream_data_blocked.offset);
+    break;
+  case NGTCP2_FRAME_STREAMS_BLOCKED_BIDI:
+  case NGTCP2_FRAME_STREAMS_BLOCKED_UNI:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, fr->streams_blocked.max_streams);
+    break;
+  case NGTCP2_FRAME_NEW_CONNECTION_ID:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8 * 2 + 1 + NGTCP2_MAX_CIDLEN +
+                                          NGTCP2_STATELESS_RESET_TOKENLEN) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, fr->new_connection_id.seq);
+    p = ngtcp2_put_uvarint(p, fr->new_connection_id.retire_prior_to);
+    *p++ = (uint8_t)fr->new_connection_id.cid.datalen;
+    p = ngtcp2_cpymem(p, fr->new_connection_id.cid.data,
+                      fr->new_connection_id.cid.datalen);
+    p = ngtcp2_cpymem(p, fr->new_connection_id.stateless_reset_token,
+                      NGTCP2_STATELESS_RESET_TOKENLEN);
+    break;
+  case NGTCP2_FRAME_RETIRE_CONNECTION_ID:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, fr->retire_connection_id.seq);
+    break;
+  case NGTCP2_FRAME_PATH_CHALLENGE:
+  case NGTCP2_FRAME_PATH_RESPONSE:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + NGTCP2_PATH_CHALLENGE_DATALEN) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_cpymem(p, fr->path_challenge.data,
+                      NGTCP2_PATH_CHALLENGE_DATALEN);
+    break;
+  case NGTCP2_FRAME_CONNECTION_CLOSE:
+  case NGTCP2_FRAME_CONNECTION_CLOSE_APP:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(p, fr->connection_close.error_code);
+    break;
+  case NGTCP2_FRAME_DATAGRAM:
+  case NGTCP2_FRAME_DATAGRAM_LEN:
+    if (ngtcp2_buf_left(&qlog->buf) < 1 + 8) {
+      return;
+    }
+    *p++ = (uint8_t)fr->type;
+    p = ngtcp2_put_uvarint(
+        p, ngtcp2_vec_len(fr->datagram.data, fr->datagram.datacnt));
+    break;
+  default:
+    ngtcp2_unreachable();
+  }
+
+  qlog->buf.last = p;
 }
 
 void ngtcp2_qlog_write_frame(ngtcp2_qlog *qlog, const ngtcp2_frame *fr) {
   uint8_t *p = qlog->buf.last;
 
-  if (!qlog->write) {
+  if (!qlog->write || (qlog->filter & NGTCP2_QLOG_FILTER_FRAME) ||
+      (qlog->flags & NGTCP2_QLOG_FLAG_PKT_SKIPPED)) {
+    return;
+  }
+
+  if (qlog->format == NGTCP2_QLOG_FORMAT_BINARY) {
+    qlog_bin_write_frame(qlog, fr);
     return;
   }
 
@@ -936,7 +1428,8 @@ void ngtcp2_qlog_pkt_sent_end(ngtcp2_qlog *qlog, const ngtcp2_pkt_hd *hd,
 void ngtcp2_qlog_parameters_set_transport_params(
     ngtcp2_qlog *qlog, const ngtcp2_transport_params *params, int server,
     ngtcp2_qlog_side side) {
-  uint8_t buf[1024];
+  uint8_t rawbuf[NGTCP2_QLOG_BIN_HEADROOM + 1024];
+  uint8_t *buf = rawbuf + NGTCP2_QLOG_BIN_HEADROOM;
   uint8_t *p = buf;
   const ngtcp2_preferred_addr *paddr;
   const ngtcp2_sockaddr_in *sa_in;
@@ -1049,8 +1542,47 @@ void ngtcp2_qlog_parameters_set_transport_params(
   p = write_pair_bool(p, "grease_quic_bit", params->grease_quic_bit);
   p = write_verbatim(p, "}}\n");
 
-  qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, buf,
-              (size_t)(p - buf));
+  qlog_write_json(qlog, NGTCP2_QLOG_BIN_EV_JSON, buf, p);
+}
+
+/* NGTCP2_QLOG_BIN_METRICS_FLAG_MIN_RTT indicates that min_rtt is
+   present in NGTCP2_QLOG_BIN_EV_METRICS_UPDATED record. */
+#define NGTCP2_QLOG_BIN_METRICS_FLAG_MIN_RTT 0x01u
+/* NGTCP2_QLOG_BIN_METRICS_FLAG_SSTHRESH indicates that ssthresh is
+   present in NGTCP2_QLOG_BIN_EV_METRICS_UPDATED record. */
+#define NGTCP2_QLOG_BIN_METRICS_FLAG_SSTHRESH 0x02u
+
+static void qlog_bin_metrics_updated(ngtcp2_qlog *qlog,
+                                     const ngtcp2_conn_stat *cstat) {
+  /* length (2), event type (1), time (8), flags (1), and 8 fields */
+  uint8_t buf[2 + 1 + 8 + 1 + 8 * 8];
+  uint8_t *p = buf + 2;
+  uint8_t flags = 0;
+
+  if (cstat->min_rtt != UINT64_MAX) {
+    flags |= NGTCP2_QLOG_BIN_METRICS_FLAG_MIN_RTT;
+  }
+  if (cstat->ssthresh != UINT64_MAX) {
+    flags |= NGTCP2_QLOG_BIN_METRICS_FLAG_SSTHRESH;
+  }
+
+  *p++ = NGTCP2_QLOG_BIN_EV_METRICS_UPDATED;
+  p = ngtcp2_put_uvarint(p, qlog->last_ts - qlog->ts);
+  *p++ = flags;
+  if (flags & NGTCP2_QLOG_BIN_METRICS_FLAG_MIN_RTT) {
+    p = qlog_bin_put_duration(p, cstat->min_rtt);
+  }
+  p = qlog_bin_put_duration(p, cstat->smoothed_rtt);
+  p = qlog_bin_put_duration(p, cstat->latest_rtt);
+  p = qlog_bin_put_duration(p, cstat->rttvar);
+  p = ngtcp2_put_uvarint(p, cstat->pto_count);
+  p = ngtcp2_put_uvarint(p, cstat->cwnd);
+  p = ngtcp2_put_uvarint(p, cstat->bytes_in_flight);
+  if (flags & NGTCP2_QLOG_BIN_METRICS_FLAG_SSTHRESH) {
+    p = ngtcp2_put_uvarint(p, cstat->ssthresh);
+  }
+
+  qlog_bin_write_record(qlog, buf, p);
 }
 
 void ngtcp2_qlog_metrics_updated(ngtcp2_qlog *qlog,
@@ -1062,6 +1594,20 @@ void ngtcp2_qlog_metrics_updated(ngtcp2_qlog *qlog,
     return;
   }
 
+  if (qlog->metrics_interval) {
+    if (qlog->last_metrics_ts != UINT64_MAX &&
+        qlog->last_ts - qlog->last_metrics_ts < qlog->metrics_interval) {
+      return;
+    }
+
+    qlog->last_metrics_ts = qlog->last_ts;
+  }
+
+  if (qlog->format == NGTCP2_QLOG_FORMAT_BINARY) {
+    qlog_bin_metrics_updated(qlog, cstat);
+    return;
+  }
+
   *p++ = '\x1e';
   *p++ = '{';
   p = qlog_write_time(qlog, p);
@@ -1089,8 +1635,22 @@ void ngtcp2_qlog_metrics_updated(ngtcp2_qlog *qlog,
 
   p = write_verbatim(p, "}}\n");
 
-  qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, buf,
-              (size_t)(p - buf));
+  qlog_emit(qlog, buf, (size_t)(p - buf));
+}
+
+static void qlog_bin_pkt_lost(ngtcp2_qlog *qlog, ngtcp2_rtb_entry *ent) {
+  /* length (2), event type (1), time (8), packet type (1), flags
+     (1), packet number (8) */
+  uint8_t buf[2 + 1 + 8 + 1 + 1 + 8];
+  uint8_t *p = buf + 2;
+
+  *p++ = NGTCP2_QLOG_BIN_EV_PKT_LOST;
+  p = ngtcp2_put_uvarint(p, qlog->last_ts - qlog->ts);
+  *p++ = ent->hd.type;
+  *p++ = ent->hd.flags & NGTCP2_PKT_FLAG_LONG_FORM;
+  p = ngtcp2_put_uvarint(p, (uint64_t)ent->hd.pkt_num);
+
+  qlog_bin_write_record(qlog, buf, p);
 }
 
 void ngtcp2_qlog_pkt_lost(ngtcp2_qlog *qlog, ngtcp2_rtb_entry *ent) {
@@ -1102,6 +1662,11 @@ void ngtcp2_qlog_pkt_lost(ngtcp2_qlog *qlog, ngtcp2_rtb_entry *ent) {
     return;
   }
 
+  if (qlog->format == NGTCP2_QLOG_FORMAT_BINARY) {
+    qlog_bin_pkt_lost(qlog, ent);
+    return;
+  }
+
   *p++ = '\x1e';
   *p++ = '{';
   p = qlog_write_time(qlog, p);
@@ -1115,20 +1680,20 @@ void ngtcp2_qlog_pkt_lost(ngtcp2_qlog *qlog, ngtcp2_rtb_entry *ent) {
   p = write_pkt_hd(p, &hd);
   p = write_verbatim(p, "}}\n");
 
-  qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, buf,
-              (size_t)(p - buf));
+  qlog_emit(qlog, buf, (size_t)(p - buf));
 }
 
 void ngtcp2_qlog_retry_pkt_received(ngtcp2_qlog *qlog, const ngtcp2_pkt_hd *hd,
                                     const ngtcp2_pkt_retry *retry) {
-  uint8_t rawbuf[1024];
+  uint8_t rawbuf[NGTCP2_QLOG_BIN_HEADROOM + 1024];
   ngtcp2_buf buf;
 
   if (!qlog->write) {
     return;
   }
 
-  ngtcp2_buf_init(&buf, rawbuf, sizeof(rawbuf));
+  ngtcp2_buf_init(&buf, rawbuf + NGTCP2_QLOG_BIN_HEADROOM,
+                  sizeof(rawbuf) - NGTCP2_QLOG_BIN_HEADROOM);
 
   *buf.last++ = '\x1e';
   *buf.last++ = '{';
@@ -1149,13 +1714,13 @@ void ngtcp2_qlog_retry_pkt_received(ngtcp2_qlog *qlog, const ngtcp2_pkt_hd *hd,
   buf.last = write_pair_hex(buf.last, "data", retry->token, retry->tokenlen);
   buf.last = write_verbatim(buf.last, "}}}\n");
 
-  qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, buf.pos,
-              ngtcp2_buf_len(&buf));
+  qlog_write_json(qlog, NGTCP2_QLOG_BIN_EV_JSON, buf.pos, buf.last);
 }
 
 void ngtcp2_qlog_stateless_reset_pkt_received(
     ngtcp2_qlog *qlog, const ngtcp2_pkt_stateless_reset *sr) {
-  uint8_t buf[256];
+  uint8_t rawbuf[NGTCP2_QLOG_BIN_HEADROOM + 256];
+  uint8_t *buf = rawbuf + NGTCP2_QLOG_BIN_HEADROOM;
   uint8_t *p = buf;
   ngtcp2_pkt_hd hd = {0};
 
@@ -1176,15 +1741,14 @@ void ngtcp2_qlog_stateless_reset_pkt_received(
                      NGTCP2_STATELESS_RESET_TOKENLEN);
   p = write_verbatim(p, "}}\n");
 
-  qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, buf,
-              (size_t)(p - buf));
+  qlog_write_json(qlog, NGTCP2_QLOG_BIN_EV_JSON, buf, p);
 }
 
 void ngtcp2_qlog_version_negotiation_pkt_received(ngtcp2_qlog *qlog,
                                                   const ngtcp2_pkt_hd *hd,
                                                   const uint32_t *sv,
                                                   size_t nsv) {
-  uint8_t rawbuf[512];
+  uint8_t rawbuf[NGTCP2_QLOG_BIN_HEADROOM + 512];
   ngtcp2_buf buf;
   size_t i;
   uint32_t v;
@@ -1193,7 +1757,8 @@ void ngtcp2_qlog_version_negotiation_pkt_received(ngtcp2_qlog *qlog,
     return;
   }
 
-  ngtcp2_buf_init(&buf, rawbuf, sizeof(rawbuf));
+  ngtcp2_buf_init(&buf, rawbuf + NGTCP2_QLOG_BIN_HEADROOM,
+                  sizeof(rawbuf) - NGTCP2_QLOG_BIN_HEADROOM);
 
   *buf.last++ = '\x1e';
   *buf.last++ = '{';
@@ -1222,6 +1787,488 @@ void ngtcp2_qlog_version_negotiation_pkt_received(ngtcp2_qlog *qlog,
 
   buf.last = write_verbatim(buf.last, "]}}\n");
 
-  qlog->write(qlog->user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, buf.pos,
-              ngtcp2_buf_len(&buf));
+  qlog_write_json(qlog, NGTCP2_QLOG_BIN_EV_JSON, buf.pos, buf.last);
+}
+
+/*
+ * qlog_bin_get_uvarints reads |n| variable-length integers from
+ * [|p|, |end|) into |dest|.  It returns the pointer to the position
+ * after the last integer, or NULL if the input is truncated.
+ */
+static const uint8_t *qlog_bin_get_uvarints(uint64_t *dest, size_t n,
+                                            const uint8_t *p,
+                                            const uint8_t *end) {
+  for (; n; --n) {
+    if (p == end || (size_t)(end - p) < ngtcp2_get_uvarintlen(p)) {
+      return NULL;
+    }
+
+    p = ngtcp2_get_uvarint(dest++, p);
+  }
+
+  return p;
+}
+
+/*
+ * qlog_bin_decode_frame decodes a frame from [|p|, |end|) into |fr|.
+ * |fr| must have room for NGTCP2_MAX_ACK_RANGES ACK ranges.  It
+ * returns the pointer to the position after the frame, or NULL if
+ * the input is malformed.
+ */
+static const uint8_t *qlog_bin_decode_frame(ngtcp2_frame *fr,
+                                            const uint8_t *p,
+                                            const uint8_t *end) {
+  uint64_t v[4];
+  size_t i, len;
+
+  fr->type = *p++;
+
+  switch (fr->type) {
+  case NGTCP2_FRAME_PADDING:
+    fr->padding.len = 1;
+    return p;
+  case NGTCP2_FRAME_PING:
+  case NGTCP2_FRAME_HANDSHAKE_DONE:
+    return p;
+  case NGTCP2_FRAME_ACK:
+  case NGTCP2_FRAME_ACK_ECN:
+    p = qlog_bin_get_uvarints(v, 4, p, end);
+    if (p == NULL || v[3] > NGTCP2_MAX_ACK_RANGES) {
+      return NULL;
+    }
+
+    fr->ack.ack_delay_unscaled = v[0];
+    fr->ack.largest_ack = (int64_t)v[1];
+    fr->ack.first_ack_range = v[2];
+    fr->ack.rangecnt = (size_t)v[3];
+
+    for (i = 0; i < fr->ack.rangecnt; ++i) {
+      p = qlog_bin_get_uvarints(v, 2, p, end);
+      if (p == NULL) {
+        return NULL;
+      }
+
+      fr->ack.ranges[i].gap = v[0];
+      fr->ack.ranges[i].len = v[1];
+    }
+
+    if (fr->type == NGTCP2_FRAME_ACK_ECN) {
+      p = qlog_bin_get_uvarints(v, 3, p, end);
+      if (p == NULL) {
+        return NULL;
+      }
+
+      fr->ack.ecn.ect1 = v[0];
+      fr->ack.ecn.ect0 = v[1];
+      fr->ack.ecn.ce = v[2];
+    }
+
+    return p;
+  case NGTCP2_FRAME_RESET_STREAM:
+    p = qlog_bin_get_uvarints(v, 3, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->reset_stream.stream_id = (int64_t)v[0];
+    fr->reset_stream.app_error_code = v[1];
+    fr->reset_stream.final_size = v[2];
+
+    return p;
+  case NGTCP2_FRAME_STOP_SENDING:
+    p = qlog_bin_get_uvarints(v, 2, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->stop_sending.stream_id = (int64_t)v[0];
+    fr->stop_sending.app_error_code = v[1];
+
+    return p;
+  case NGTCP2_FRAME_CRYPTO:
+  case NGTCP2_FRAME_STREAM:
+    fr->stream.fin = 0;
+    fr->stream.stream_id = 0;
+
+    if (fr->type == NGTCP2_FRAME_STREAM) {
+      if (p == end) {
+        return NULL;
+      }
+
+      fr->stream.fin = *p++ != 0;
+
+      p = qlog_bin_get_uvarints(v, 1, p, end);
+      if (p == NULL) {
+        return NULL;
+      }
+
+      fr->stream.stream_id = (int64_t)v[0];
+    }
+
+    p = qlog_bin_get_uvarints(v, 2, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->stream.offset = v[0];
+    fr->stream.datacnt = 1;
+    fr->stream.data[0].base = NULL;
+    fr->stream.data[0].len = (size_t)v[1];
+
+    return p;
+  case NGTCP2_FRAME_NEW_TOKEN:
+    p = qlog_bin_get_uvarints(v, 1, p, end);
+    if (p == NULL || (uint64_t)(end - p) < v[0]) {
+      return NULL;
+    }
+
+    fr->new_token.token = (uint8_t *)p;
+    fr->new_token.tokenlen = (size_t)v[0];
+
+    return p + fr->new_token.tokenlen;
+  case NGTCP2_FRAME_MAX_DATA:
+    p = qlog_bin_get_uvarints(v, 1, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->max_data.max_data = v[0];
+
+    return p;
+  case NGTCP2_FRAME_MAX_STREAM_DATA:
+    p = qlog_bin_get_uvarints(v, 2, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->max_stream_data.stream_id = (int64_t)v[0];
+    fr->max_stream_data.max_stream_data = v[1];
+
+    return p;
+  case NGTCP2_FRAME_MAX_STREAMS_BIDI:
+  case NGTCP2_FRAME_MAX_STREAMS_UNI:
+    p = qlog_bin_get_uvarints(v, 1, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->max_streams.max_streams = v[0];
+
+    return p;
+  case NGTCP2_FRAME_DATA_BLOCKED:
+    p = qlog_bin_get_uvarints(v, 1, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->data_blocked.offset = v[0];
+
+    return p;
+  case NGTCP2_FRAME_STREAM_DATA_BLOCKED:
+    p = qlog_bin_get_uvarints(v, 2, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->stream_data_blocked.stream_id = (int64_t)v[0];
+    fr->stream_data_blocked.offset = v[1];
+
+    return p;
+  case NGTCP2_FRAME_STREAMS_BLOCKED_BIDI:
+  case NGTCP2_FRAME_STREAMS_BLOCKED_UNI:
+    p = qlog_bin_get_uvarints(v, 1, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->streams_blocked.max_streams = v[0];
+
+    return p;
+  case NGTCP2_FRAME_NEW_CONNECTION_ID:
+    p = qlog_bin_get_uvarints(v, 2, p, end);
+    if (p == NULL || p == end) {
+      return NULL;
+    }
+
+    fr->new_connection_id.seq = v[0];
+    fr->new_connection_id.retire_prior_to = v[1];
+
+    len = *p++;
+    if (len > NGTCP2_MAX_CIDLEN ||
+        (size_t)(end - p) < len + NGTCP2_STATELESS_RESET_TOKENLEN) {
+      return NULL;
+    }
+
+    ngtcp2_cid_init(&fr->new_connection_id.cid, p, len);
+    p += len;
+    memcpy(fr->new_connection_id.stateless_reset_token, p,
+           NGTCP2_STATELESS_RESET_TOKENLEN);
+
+    return p + NGTCP2_STATELESS_RESET_TOKENLEN;
+  case NGTCP2_FRAME_RETIRE_CONNECTION_ID:
+    p = qlog_bin_get_uvarints(v, 1, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->retire_connection_id.seq = v[0];
+
+    return p;
+  case NGTCP2_FRAME_PATH_CHALLENGE:
+  case NGTCP2_FRAME_PATH_RESPONSE:
+    if ((size_t)(end - p) < NGTCP2_PATH_CHALLENGE_DATALEN) {
+      return NULL;
+    }
+
+    memcpy(fr->path_challenge.data, p, NGTCP2_PATH_CHALLENGE_DATALEN);
+
+    return p + NGTCP2_PATH_CHALLENGE_DATALEN;
+  case NGTCP2_FRAME_CONNECTION_CLOSE:
+  case NGTCP2_FRAME_CONNECTION_CLOSE_APP:
+    p = qlog_bin_get_uvarints(v, 1, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->connection_close.error_code = v[0];
+
+    return p;
+  case NGTCP2_FRAME_DATAGRAM:
+  case NGTCP2_FRAME_DATAGRAM_LEN:
+    p = qlog_bin_get_uvarints(v, 1, p, end);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    fr->datagram.datacnt = 1;
+    fr->datagram.data = fr->datagram.rdata;
+    fr->datagram.rdata[0].base = NULL;
+    fr->datagram.rdata[0].len = (size_t)v[0];
+
+    return p;
+  default:
+    return NULL;
+  }
+}
+
+static int qlog_bin_decode_pkt(ngtcp2_qlog *qlog, int sent, const uint8_t *p,
+                               const uint8_t *end) {
+  uint8_t buf[NGTCP2_QLOG_BUFLEN];
+  union {
+    ngtcp2_frame fr;
+    struct {
+      ngtcp2_ack ack;
+      /* ack includes 1 ngtcp2_ack_range. */
+      ngtcp2_ack_range ranges[NGTCP2_MAX_ACK_RANGES - 1];
+    } ackfr;
+  } mfr;
+  ngtcp2_pkt_hd hd = {0};
+  uint64_t v[2];
+
+  p = qlog_bin_get_uvarints(v, 1, p, end);
+  if (p == NULL) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  qlog->last_ts = v[0];
+
+  ngtcp2_buf_init(&qlog->buf, buf, sizeof(buf));
+
+  qlog_pkt_write_start(qlog, sent);
+
+  for (;;) {
+    if (p == end) {
+      return NGTCP2_ERR_INVALID_ARGUMENT;
+    }
+
+    if (*p == NGTCP2_QLOG_BIN_FRAME_END) {
+      ++p;
+      break;
+    }
+
+    p = qlog_bin_decode_frame(&mfr.fr, p, end);
+    if (p == NULL) {
+      return NGTCP2_ERR_INVALID_ARGUMENT;
+    }
+
+    ngtcp2_qlog_write_frame(qlog, &mfr.fr);
+  }
+
+  if (end - p < 2) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  hd.type = *p++;
+  hd.flags = *p++;
+
+  p = qlog_bin_get_uvarints(v, 2, p, end);
+  if (p == NULL || (uint64_t)(end - p) < v[1]) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  hd.pkt_num = (int64_t)v[0];
+  hd.token = p;
+  hd.tokenlen = (size_t)v[1];
+  p += hd.tokenlen;
+
+  p = qlog_bin_get_uvarints(v, 1, p, end);
+  if (p != end) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  qlog_pkt_write_end(qlog, &hd, (size_t)v[0]);
+
+  return 0;
+}
+
+static int qlog_bin_decode_metrics_updated(ngtcp2_qlog *qlog, const uint8_t *p,
+                                           const uint8_t *end) {
+  ngtcp2_conn_stat cstat = {0};
+  uint64_t v[8];
+  uint64_t *pv = v;
+  size_t n = 6;
+  uint8_t flags;
+
+  p = qlog_bin_get_uvarints(v, 1, p, end);
+  if (p == NULL || p == end) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  qlog->last_ts = v[0];
+  flags = *p++;
+
+  if (flags & NGTCP2_QLOG_BIN_METRICS_FLAG_MIN_RTT) {
+    ++n;
+  }
+  if (flags & NGTCP2_QLOG_BIN_METRICS_FLAG_SSTHRESH) {
+    ++n;
+  }
+
+  p = qlog_bin_get_uvarints(v, n, p, end);
+  if (p != end) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  cstat.min_rtt =
+      flags & NGTCP2_QLOG_BIN_METRICS_FLAG_MIN_RTT ? *pv++ : UINT64_MAX;
+  cstat.smoothed_rtt = *pv++;
+  cstat.latest_rtt = *pv++;
+  cstat.rttvar = *pv++;
+  cstat.pto_count = (size_t)*pv++;
+  cstat.cwnd = *pv++;
+  cstat.bytes_in_flight = *pv++;
+  cstat.ssthresh =
+      flags & NGTCP2_QLOG_BIN_METRICS_FLAG_SSTHRESH ? *pv : UINT64_MAX;
+
+  ngtcp2_qlog_metrics_updated(qlog, &cstat);
+
+  return 0;
+}
+
+static int qlog_bin_decode_pkt_lost(ngtcp2_qlog *qlog, const uint8_t *p,
+                                    const uint8_t *end) {
+  ngtcp2_rtb_entry ent;
+  uint64_t v;
+
+  p = qlog_bin_get_uvarints(&v, 1, p, end);
+  if (p == NULL || end - p < 2) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  qlog->last_ts = v;
+
+  memset(&ent, 0, sizeof(ent));
+
+  ent.hd.type = *p++;
+  ent.hd.flags = *p++;
+
+  p = qlog_bin_get_uvarints(&v, 1, p, end);
+  if (p != end) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  ent.hd.pkt_num = (int64_t)v;
+
+  ngtcp2_qlog_pkt_lost(qlog, &ent);
+
+  return 0;
+}
+
+ngtcp2_ssize ngtcp2_qlog_decode_binary(ngtcp2_qlog_write write,
+                                       void *user_data, const uint8_t *data,
+                                       size_t datalen) {
+  ngtcp2_qlog qlog;
+  const uint8_t *p, *end;
+  uint64_t len;
+  size_t nlen;
+  int rv;
+
+  if (datalen == 0) {
+    return 0;
+  }
+
+  nlen = ngtcp2_get_uvarintlen(data);
+  if (datalen < nlen) {
+    return 0;
+  }
+
+  p = ngtcp2_get_uvarint(&len, data);
+  if (datalen - nlen < len) {
+    return 0;
+  }
+
+  if (len == 0) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  end = p + len;
+
+  ngtcp2_qlog_init(&qlog, write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0, user_data);
+
+  switch (*p++) {
+  case NGTCP2_QLOG_BIN_EV_PREAMBLE:
+    if (p == end || *p++ != NGTCP2_QLOG_BIN_VERSION) {
+      return NGTCP2_ERR_INVALID_ARGUMENT;
+    }
+
+    write(user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, p, (size_t)(end - p));
+
+    break;
+  case NGTCP2_QLOG_BIN_EV_JSON:
+    write(user_data, NGTCP2_QLOG_WRITE_FLAG_NONE, p, (size_t)(end - p));
+
+    break;
+  case NGTCP2_QLOG_BIN_EV_PKT_SENT:
+    rv = qlog_bin_decode_pkt(&qlog, /* sent = */ 1, p, end);
+    if (rv != 0) {
+      return rv;
+    }
+
+    break;
+  case NGTCP2_QLOG_BIN_EV_PKT_RECEIVED:
+    rv = qlog_bin_decode_pkt(&qlog, /* sent = */ 0, p, end);
+    if (rv != 0) {
+      return rv;
+    }
+
+    break;
+  case NGTCP2_QLOG_BIN_EV_METRICS_UPDATED:
+    rv = qlog_bin_decode_metrics_updated(&qlog, p, end);
+    if (rv != 0) {
+      return rv;
+    }
+
+    break;
+  case NGTCP2_QLOG_BIN_EV_PKT_LOST:
+    rv = qlog_bin_decode_pkt_lost(&qlog, p, end);
+    if (rv != 0) {
+      return rv;
+    }
+
+    break;
+  default:
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  return (ngtcp2_ssize)(nlen + len);
 }
@@ -40,14 +40,90 @@
    qlog. */
 #define NGTCP2_QLOG_BUFLEN 4096
 
+/*
+ * The following macros define the binary qlog encoding
+ * (NGTCP2_QLOG_FORMAT_BINARY).  Each record starts with its length
+ * encoded in 2 bytes variable-length integer, followed by 1 byte
+ * event type.  Events which are produced a few times per connection
+ * carry their JSON-SEQ text verbatim.  Events on the hot path are
+ * encoded as fixed layout of variable-length integers, and expanded
+ * to JSON by ngtcp2_qlog_decode_binary.
+ */
+
+/* NGTCP2_QLOG_BIN_VERSION is the version of binary qlog encoding.
+   It is written in NGTCP2_QLOG_BIN_EV_PREAMBLE record. */
+#define NGTCP2_QLOG_BIN_VERSION 1
+
+/* NGTCP2_QLOG_BIN_EV_PREAMBLE is the first record which contains
+   NGTCP2_QLOG_BIN_VERSION (1 byte) and JSON-SEQ qlog preamble. */
+#define NGTCP2_QLOG_BIN_EV_PREAMBLE 0x00
+/* NGTCP2_QLOG_BIN_EV_JSON is a record which contains a single
+   JSON-SEQ event. */
+#define NGTCP2_QLOG_BIN_EV_JSON 0x01
+/* NGTCP2_QLOG_BIN_EV_PKT_SENT is packet_sent event.  It contains
+   time, frames terminated by NGTCP2_QLOG_BIN_FRAME_END, and packet
+   header. */
+#define NGTCP2_QLOG_BIN_EV_PKT_SENT 0x02
+/* NGTCP2_QLOG_BIN_EV_PKT_RECEIVED is packet_received event.  Its
+   layout is the same as NGTCP2_QLOG_BIN_EV_PKT_SENT. */
+#define NGTCP2_QLOG_BIN_EV_PKT_RECEIVED 0x03
+/* NGTCP2_QLOG_BIN_EV_METRICS_UPDATED is metrics_updated event. */
+#define NGTCP2_QLOG_BIN_EV_METRICS_UPDATED 0x04
+/* NGTCP2_QLOG_BIN_EV_PKT_LOST is packet_lost event. */
+#define NGTCP2_QLOG_BIN_EV_PKT_LOST 0x05
+
+/* NGTCP2_QLOG_BIN_FRAME_END terminates the list of frames in
+   NGTCP2_QLOG_BIN_EV_PKT_SENT and NGTCP2_QLOG_BIN_EV_PKT_RECEIVED.
+   The other frames are identified by their QUIC frame type. */
+#define NGTCP2_QLOG_BIN_FRAME_END 0xff
+
+/* NGTCP2_QLOG_BIN_HEADROOM is the number of bytes that a buffer
+   must reserve in front of JSON-SEQ text in order to turn it into
+   NGTCP2_QLOG_BIN_EV_PREAMBLE or NGTCP2_QLOG_BIN_EV_JSON record. */
+#define NGTCP2_QLOG_BIN_HEADROOM 4
+
 typedef enum ngtcp2_qlog_side {
   NGTCP2_QLOG_SIDE_LOCAL,
   NGTCP2_QLOG_SIDE_REMOTE,
 } ngtcp2_qlog_side;
 
+/*
+ * ngtcp2_qlog_recorder is a flight recorder which keeps recent qlog
+ * events in a ring buffer.  Each event is stored with 2 bytes length
+ * prefix, and never wraps around the end of the buffer.
+ */
+typedef struct ngtcp2_qlog_recorder {
+  /* buf points to the ring buffer.  If it is NULL, flight recorder
+     is disabled. */
+  uint8_t *buf;
+  /* buflen is the length of buf. */
+  size_t buflen;
+  /* head is the offset to the oldest event. */
+  size_t head;
+  /* tail is the offset where the next event is stored. */
+  size_t tail;
+  /* end is the offset just past the last event before the wrap
+     point.  It is only meaningful if wrapped is nonzero. */
+  size_t end;
+  /* wrapped is nonzero if events are stored in [head, end) and [0,
+     tail). */
+  int wrapped;
+  /* preamblelen is the length of qlog preamble which is stored
+     right before buf. */
+  size_t preamblelen;
+} ngtcp2_qlog_recorder;
+
+/* NGTCP2_QLOG_FLAG_NONE indicates no flag set. */
+#define NGTCP2_QLOG_FLAG_NONE 0x00u
+/* NGTCP2_QLOG_FLAG_PKT_SKIPPED indicates that the packet event
+   currently being written is filtered out or sampled out. */
+#define NGTCP2_QLOG_FLAG_PKT_SKIPPED 0x01u
+
 typedef struct ngtcp2_qlog {
   /* write is a callback function to write qlog. */
   ngtcp2_qlog_write write;
+  /* format is the encoding of qlog. */
+  ngtcp2_qlog_format format;
   /* ts is the initial timestamp */
   ngtcp2_tstamp ts;
   /* last_ts is the timestamp observed last time. */
@@ -58,13 +134,32 @@ typedef struct ngtcp2_qlog {
   /* user_data is an opaque pointer which is passed to write
      callback. */
   void *user_data;
+  /* rec is the flight recorder. */
+  ngtcp2_qlog_recorder rec;
+  /* filter is bitwise OR of zero or more of NGTCP2_QLOG_FILTER_*. */
+  uint32_t filter;
+  /* metrics_interval is the minimum interval between
+     metrics_updated events. */
+  ngtcp2_duration metrics_interval;
+  /* last_metrics_ts is the timestamp when the last metrics_updated
+     event was written. */
+  ngtcp2_tstamp last_metrics_ts;
+  /* pkt_sample_rate, if it is larger than 1, makes only 1 in
+     pkt_sample_rate packet events written. */
+  size_t pkt_sample_rate;
+  /* pkt_count is the number of packet events seen so far.  It is
+     used for sampling. */
+  size_t pkt_count;
+  /* flags is bitwise OR of zero or more of NGTCP2_QLOG_FLAG_*. */
+  uint32_t flags;
 } ngtcp2_qlog;
 
 /*
  * ngtcp2_qlog_init initializes |qlog|.
  */
 void ngtcp2_qlog_init(ngtcp2_qlog *qlog, ngtcp2_qlog_write write,
-                      ngtcp2_tstamp ts, void *user_data);
+                      ngtcp2_qlog_format format, ngtcp2_tstamp ts,
+                      void *user_data);
 
 /*
  * ngtcp2_qlog_start writes qlog preamble.
@@ -72,7 +167,36 @@ void ngtcp2_qlog_init(ngtcp2_qlog *qlog, ngtcp2_qlog_write write,
 void ngtcp2_qlog_start(ngtcp2_qlog *qlog, const ngtcp2_cid *odcid, int server);
 
 /*
- * ngtcp2_qlog_end writes closing part of qlog.
+ * ngtcp2_qlog_set_recorder enables flight recorder which uses |buf|
+ * of length |buflen| as a ring buffer.  qlog events are kept in |buf|
+ * until ngtcp2_qlog_flush is called, and the oldest events are
+ * discarded when it is full.  The qlog preamble is never discarded.
+ * This function must be called before ngtcp2_qlog_start.
+ */
+void ngtcp2_qlog_set_recorder(ngtcp2_qlog *qlog, uint8_t *buf, size_t buflen);
+
+/*
+ * ngtcp2_qlog_set_filter sets qlog event filter.  |filter| is bitwise
+ * OR of zero or more of NGTCP2_QLOG_FILTER_*.  metrics_updated events
+ * are written at most once in |metrics_interval|.  If
+ * |pkt_sample_rate| is larger than 1, only 1 in |pkt_sample_rate|
+ * packet events is written.
+ */
+void ngtcp2_qlog_set_filter(ngtcp2_qlog *qlog, uint32_t filter,
+                            ngtcp2_duration metrics_interval,
+                            size_t pkt_sample_rate);
+
+/*
+ * ngtcp2_qlog_flush writes the qlog events kept by flight recorder to
+ * qlog->write callback, and disables flight recorder.  The
+ * subsequent events are written directly.  If flight recorder is not
+ * enabled, this function does nothing.
+ */
+void ngtcp2_qlog_flush(ngtcp2_qlog *qlog);
+
+/*
+ * ngtcp2_qlog_end writes closing part of qlog.  If flight recorder is
+ * enabled, the events kept in it are discarded.
  */
 void ngtcp2_qlog_end(ngtcp2_qlog *qlog);
 
@@ -37,6 +37,7 @@
 #include "ngtcp2_unreachable.h"
 #include "ngtcp2_tstamp.h"
 #include "ngtcp2_frame_chain.h"
+#include "ngtcp2_probe.h"
 
 ngtcp2_objalloc_def(rtb_entry, ngtcp2_rtb_entry, oplent);
 
@@ -445,15 +446,31 @@ static int rtb_on_pkt_lost(ngtcp2_rtb *rtb, ngtcp2_ksl_it *it,
     ngtcp2_qlog_pkt_lost(rtb->qlog, ent);
   }
 
+  NGTCP2_PROBE5(pkt_lost, rtb->log->scid, rtb->pktns_id, ent->hd.pkt_num,
+                ent->pktlen, cstat->cwnd);
+
   if (ent->flags & NGTCP2_RTB_ENTRY_FLAG_PMTUD_PROBE) {
     ++rtb->num_lost_pmtud_pkts;
-  } else if (rtb->cc->on_pkt_lost) {
-    cc->on_pkt_lost(cc, cstat,
-                    ngtcp2_cc_pkt_init(&pkt, ent->hd.pkt_num, ent->pktlen,
-                                       rtb->pktns_id, ent->ts, ent->rst.lost,
-                                       ent->rst.tx_in_flight,
-                                       ent->rst.is_app_limited),
-                    ts);
+  } else {
+    ++cstat->pkt_lost;
+    cstat->bytes_lost += ent->pktlen;
+
+    if (rtb->cc->on_pkt_lost) {
+      cc->on_pkt_lost(cc, cstat,
+                      ngtcp2_cc_pkt_init(&pkt, ent->hd.pkt_num, ent->pktlen,
+                                         rtb->pktns_id, ent->ts, ent->rst.lost,
+                                         ent->rst.tx_in_flight,
+                                         ent->rst.is_app_limited),
+                      ts);
+    }
+  }
+
+  if (!(ent->flags & NGTCP2_RTB_ENTRY_FLAG_PMTUD_PROBE) &&
+      rtb->pktns_id == NGTCP2_PKTNS_ID_APPLICATION) {
+    rv = ngtcp2_conn_pmtud_on_pkt_lost(conn, ent);
+    if (rv != 0) {
+      return rv;
+    }
   }
 
   if (ent->flags & NGTCP2_RTB_ENTRY_FLAG_PTO_RECLAIMED) {
@@ -529,6 +546,14 @@ static void rtb_remove(ngtcp2_rtb *rtb, ngtcp2_ksl_it *it,
 
   rv = ngtcp2_ksl_remove_hint(&rtb->ents, it, it, &ent->hd.pkt_num);
   assert(0 == rv);
+
+  /* The packet which has been declared lost is acknowledged. */
+  if ((ent->flags & (NGTCP2_RTB_ENTRY_FLAG_LOST_RETRANSMITTED |
+                     NGTCP2_RTB_ENTRY_FLAG_PMTUD_PROBE)) ==
+      NGTCP2_RTB_ENTRY_FLAG_LOST_RETRANSMITTED) {
+    ++cstat->pkt_spurious_lost;
+  }
+
   rtb_on_remove(rtb, ent, cstat);
 
   assert(ent->next == NULL);
@@ -583,6 +608,18 @@ static int rtb_process_acked_pkt(ngtcp2_rtb *rtb, ngtcp2_rtb_entry *ent,
       conn->dcid.current.max_udp_payload_size = ent->pktlen;
       conn->cstat.max_tx_udp_payload_size =
           ngtcp2_conn_get_path_max_tx_udp_payload_size(conn);
+
+      /* RFC 9002 7.2: If the maximum datagram size changes during the
+         connection, the initial congestion window SHOULD be
+         recalculated with the new size.  Otherwise a path that
+         supports jumbo frames starts with less than 2 full sized
+         packets worth of window.  Do this only until the first
+         congestion event. */
+      if (conn->cstat.congestion_recovery_start_ts == UINT64_MAX) {
+        conn->cstat.cwnd = ngtcp2_max_uint64(
+            conn->cstat.cwnd,
+            ngtcp2_cc_compute_initcwnd(conn->cstat.max_tx_udp_payload_size));
+      }
     }
 
     if (ngtcp2_pmtud_finished(conn->pmtud)) {
@@ -590,6 +627,10 @@ static int rtb_process_acked_pkt(ngtcp2_rtb *rtb, ngtcp2_rtb_entry *ent,
     }
   }
 
+  if (rtb->pktns_id == NGTCP2_PKTNS_ID_APPLICATION) {
+    ngtcp2_conn_pmtud_on_pkt_acked(conn, ent);
+  }
+
   for (frc = ent->frc; frc; frc = frc->next) {
     if (frc->binder) {
       if (frc->binder->flags & NGTCP2_FRAME_CHAIN_BINDER_FLAG_ACK) {
@@ -762,9 +803,15 @@ static void conn_verify_ecn(ngtcp2_conn *conn, ngtcp2_pktns *pktns,
   }
 
   if (fr->type == NGTCP2_FRAME_ACK_ECN) {
-    if (cc->congestion_event && largest_pkt_sent_ts != UINT64_MAX &&
-        fr->ecn.ce > pktns->rx.ecn.ack.ce) {
-      cc->congestion_event(cc, cstat, largest_pkt_sent_ts, ts);
+    if (fr->ecn.ce > pktns->rx.ecn.ack.ce) {
+      cstat->ecn_ce_acked += fr->ecn.ce - pktns->rx.ecn.ack.ce;
+
+      if (cc->congestion_event && largest_pkt_sent_ts != UINT64_MAX) {
+        cc->congestion_event(cc, cstat, largest_pkt_sent_ts, ts);
+
+        NGTCP2_PROBE4(congestion_event, conn->log.scid, cstat->cwnd,
+                      cstat->ssthresh, cstat->bytes_in_flight);
+      }
     }
 
     pktns->rx.ecn.ack.ect0 = fr->ecn.ect0;
@@ -878,7 +925,11 @@ ngtcp2_ssize ngtcp2_rtb_recv_ack(ngtcp2_rtb *rtb, const ngtcp2_ack *fr,
   }
 
   if (largest_pkt_sent_ts != UINT64_MAX && ack_eliciting_pkt_acked) {
-    cc_ack.rtt = pkt_ts - largest_pkt_sent_ts;
+    /* pkt_ts may come from a different clock (e.g., kernel receive
+       timestamp), and it might be slightly earlier than the time when
+       the packet was sent.  Fall back to ts in that case. */
+    cc_ack.rtt = (pkt_ts >= largest_pkt_sent_ts ? pkt_ts : ts) -
+                 largest_pkt_sent_ts;
 
     rv = ngtcp2_conn_update_rtt(conn, cc_ack.rtt, fr->ack_delay_unscaled, ts);
     if (rv == 0 && cc->new_rtt_sample) {
@@ -928,6 +979,8 @@ ngtcp2_ssize ngtcp2_rtb_recv_ack(ngtcp2_rtb *rtb, const ngtcp2_ack *fr,
   if (rtb->cc->on_spurious_congestion && num_lost_pkts &&
       rtb->num_lost_pkts - rtb->num_lost_pmtud_pkts == 0) {
     rtb->cc->on_spurious_congestion(cc, cstat, ts);
+
+    NGTCP2_PROBE2(spurious_congestion, rtb->log->scid, cstat->cwnd);
   }
 
   ngtcp2_rst_on_ack_recv(rtb->rst, cstat, cc_ack.pkt_delivered);
@@ -1123,6 +1176,9 @@ static int rtb_detect_lost_pkt(ngtcp2_rtb *rtb, uint64_t *ppkt_lost,
 
       if (cc->congestion_event) {
         cc->congestion_event(cc, cstat, latest_ts, ts);
+
+        NGTCP2_PROBE4(congestion_event, rtb->log->scid, cstat->cwnd,
+                      cstat->ssthresh, cstat->bytes_in_flight);
       }
 
       loss_window = latest_ts - oldest_ts;
@@ -1150,6 +1206,12 @@ static int rtb_detect_lost_pkt(ngtcp2_rtb *rtb, uint64_t *ppkt_lost,
           if (cc->on_persistent_congestion) {
             cc->on_persistent_congestion(cc, cstat, ts);
           }
+
+          NGTCP2_PROBE2(persistent_congestion, rtb->log->scid, cstat->cwnd);
+
+          if (rtb->qlog) {
+            ngtcp2_qlog_flush(rtb->qlog);
+          }
         }
       }
 
@@ -1250,7 +1312,10 @@ ngtcp2_tstamp ngtcp2_rtb_lost_pkt_ts(ngtcp2_rtb *rtb) {
   ngtcp2_ksl_it it;
   ngtcp2_rtb_entry *ent;
 
-  if (ngtcp2_ksl_len(&rtb->ents) == 0) {
+  /* This is called whenever the expiry of a connection is computed.
+     Avoid looking up the oldest entry in the common case where no
+     packet has been lost. */
+  if (rtb->num_lost_pkts == 0) {
     return UINT64_MAX;
   }
 
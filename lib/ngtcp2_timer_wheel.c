@@ -0,0 +1,421 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_timer_wheel.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "ngtcp2_mem.h"
+#include "ngtcp2_macro.h"
+#include "ngtcp2_conn.h"
+
+#define NGTCP2_TIMER_WHEEL_SLOT_MASK (NGTCP2_TIMER_WHEEL_NUM_SLOTS - 1)
+
+/*
+ * timer_wheel_ctz returns the number of trailing zero bits in |x|.
+ * |x| must not be 0.
+ */
+static size_t timer_wheel_ctz(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return (size_t)__builtin_ctzll(x);
+#else  /* !(defined(__GNUC__) || defined(__clang__)) */
+  size_t n = 0;
+
+  for (; !(x & 1); x >>= 1, ++n)
+    ;
+
+  return n;
+#endif /* !(defined(__GNUC__) || defined(__clang__)) */
+}
+
+void ngtcp2_timer_wheel_entry_init(ngtcp2_timer_wheel_entry *ent) {
+  ent->next = NULL;
+  ent->pprev = NULL;
+  ent->expiry = UINT64_MAX;
+  ent->level = 0;
+  ent->slot = 0;
+  ent->attached_next = NULL;
+  ent->attached_pprev = NULL;
+}
+
+void ngtcp2_timer_wheel_init(ngtcp2_timer_wheel *tw, ngtcp2_duration tick,
+                             ngtcp2_tstamp ts, const ngtcp2_mem *mem) {
+  assert(tick);
+
+  memset(tw, 0, sizeof(*tw));
+
+  tw->mem = mem;
+  tw->tick = tick;
+  tw->now = ts / tick;
+}
+
+/*
+ * timer_wheel_expiry_tick returns the tick at which |expiry| is
+ * reached.  It is rounded up so that an entry never expires early.
+ */
+static uint64_t timer_wheel_expiry_tick(const ngtcp2_timer_wheel *tw,
+                                        ngtcp2_tstamp expiry) {
+  return expiry / tw->tick + (expiry % tw->tick != 0);
+}
+
+static void timer_wheel_link(ngtcp2_timer_wheel_entry **phead,
+                             ngtcp2_timer_wheel_entry *ent) {
+  ent->next = *phead;
+  if (ent->next) {
+    ent->next->pprev = &ent->next;
+  }
+
+  ent->pprev = phead;
+  *phead = ent;
+}
+
+static void timer_wheel_unlink(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent) {
+  *ent->pprev = ent->next;
+  if (ent->next) {
+    ent->next->pprev = ent->pprev;
+  }
+
+  if (ent->level < NGTCP2_TIMER_WHEEL_NUM_LEVELS &&
+      tw->slots[ent->level][ent->slot] == NULL) {
+    tw->bitmap[ent->level] &= ~(1ull << ent->slot);
+  }
+
+  ent->next = NULL;
+  ent->pprev = NULL;
+}
+
+/*
+ * timer_wheel_insert links |ent|, which is not in |tw|, to the slot
+ * which corresponds to ent->expiry.
+ */
+static void timer_wheel_insert(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent) {
+  uint64_t expiry_tick = timer_wheel_expiry_tick(tw, ent->expiry);
+  uint64_t delta;
+  size_t level = 0;
+
+  if (expiry_tick <= tw->now) {
+    ent->level = NGTCP2_TIMER_WHEEL_NUM_LEVELS;
+    ent->slot = 0;
+    timer_wheel_link(&tw->expired, ent);
+
+    return;
+  }
+
+  delta = expiry_tick - tw->now;
+  if (delta > NGTCP2_TIMER_WHEEL_MAX_TICKS) {
+    delta = NGTCP2_TIMER_WHEEL_MAX_TICKS;
+    expiry_tick = tw->now + delta;
+  }
+
+  for (; level < NGTCP2_TIMER_WHEEL_NUM_LEVELS - 1 &&
+         (delta >> (NGTCP2_TIMER_WHEEL_SLOT_BITS * (level + 1)));
+       ++level)
+    ;
+
+  ent->level = (uint8_t)level;
+  ent->slot = (uint8_t)((expiry_tick >> (NGTCP2_TIMER_WHEEL_SLOT_BITS * level)) &
+                        NGTCP2_TIMER_WHEEL_SLOT_MASK);
+
+  timer_wheel_link(&tw->slots[level][ent->slot], ent);
+  tw->bitmap[level] |= 1ull << ent->slot;
+}
+
+void ngtcp2_timer_wheel_remove(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent) {
+  if (ent->pprev == NULL) {
+    return;
+  }
+
+  timer_wheel_unlink(tw, ent);
+
+  ent->expiry = UINT64_MAX;
+
+  assert(tw->len);
+
+  --tw->len;
+}
+
+void ngtcp2_timer_wheel_attach(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent) {
+  assert(ent->attached_pprev == NULL);
+
+  ent->attached_next = tw->attached;
+  if (ent->attached_next) {
+    ent->attached_next->attached_pprev = &ent->attached_next;
+  }
+
+  ent->attached_pprev = &tw->attached;
+  tw->attached = ent;
+}
+
+void ngtcp2_timer_wheel_detach(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent) {
+  assert(ent->attached_pprev);
+
+  ngtcp2_timer_wheel_remove(tw, ent);
+
+  *ent->attached_pprev = ent->attached_next;
+  if (ent->attached_next) {
+    ent->attached_next->attached_pprev = ent->attached_pprev;
+  }
+
+  ent->attached_next = NULL;
+  ent->attached_pprev = NULL;
+}
+
+void ngtcp2_timer_wheel_update(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent,
+                               ngtcp2_tstamp expiry) {
+  assert(ent->attached_pprev);
+
+  if (ent->pprev) {
+    if (ent->expiry == expiry) {
+      return;
+    }
+
+    ngtcp2_timer_wheel_remove(tw, ent);
+  }
+
+  if (expiry == UINT64_MAX) {
+    return;
+  }
+
+  ent->expiry = expiry;
+
+  timer_wheel_insert(tw, ent);
+
+  ++tw->len;
+}
+
+/*
+ * timer_wheel_take_slot detaches the list of entries in the slot
+ * |slot| of the level |level|, and returns it.
+ */
+static ngtcp2_timer_wheel_entry *
+timer_wheel_take_slot(ngtcp2_timer_wheel *tw, size_t level, size_t slot) {
+  ngtcp2_timer_wheel_entry *head = tw->slots[level][slot];
+
+  tw->slots[level][slot] = NULL;
+  tw->bitmap[level] &= ~(1ull << slot);
+
+  return head;
+}
+
+/*
+ * timer_wheel_reinsert inserts the entries in the list |head| again.
+ */
+static void timer_wheel_reinsert(ngtcp2_timer_wheel *tw,
+                                 ngtcp2_timer_wheel_entry *head) {
+  ngtcp2_timer_wheel_entry *ent;
+
+  for (; head;) {
+    ent = head;
+    head = head->next;
+
+    timer_wheel_insert(tw, ent);
+  }
+}
+
+static int timer_wheel_empty(const ngtcp2_timer_wheel *tw) {
+  size_t i;
+
+  for (i = 0; i < NGTCP2_TIMER_WHEEL_NUM_LEVELS; ++i) {
+    if (tw->bitmap[i]) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+void ngtcp2_timer_wheel_advance(ngtcp2_timer_wheel *tw, ngtcp2_tstamp ts) {
+  uint64_t target = ts / tw->tick;
+  size_t level, shift;
+
+  for (; tw->now < target;) {
+    if (!tw->bitmap[0]) {
+      if (timer_wheel_empty(tw)) {
+        tw->now = target;
+        return;
+      }
+
+      /* Nothing expires until the next cascade. */
+      if ((tw->now | NGTCP2_TIMER_WHEEL_SLOT_MASK) >= target) {
+        tw->now = target;
+        return;
+      }
+
+      tw->now |= NGTCP2_TIMER_WHEEL_SLOT_MASK;
+    }
+
+    ++tw->now;
+
+    for (level = 1; level < NGTCP2_TIMER_WHEEL_NUM_LEVELS; ++level) {
+      shift = NGTCP2_TIMER_WHEEL_SLOT_BITS * level;
+
+      if (tw->now & ((1ull << shift) - 1)) {
+        break;
+      }
+
+      timer_wheel_reinsert(
+          tw, timer_wheel_take_slot(tw, level,
+                                    (tw->now >> shift) &
+                                        NGTCP2_TIMER_WHEEL_SLOT_MASK));
+    }
+
+    timer_wheel_reinsert(
+        tw, timer_wheel_take_slot(tw, 0,
+                                  tw->now & NGTCP2_TIMER_WHEEL_SLOT_MASK));
+  }
+}
+
+ngtcp2_timer_wheel_entry *
+ngtcp2_timer_wheel_pop_expired(ngtcp2_timer_wheel *tw) {
+  ngtcp2_timer_wheel_entry *ent = tw->expired;
+
+  if (ent == NULL) {
+    return NULL;
+  }
+
+  ngtcp2_timer_wheel_remove(tw, ent);
+
+  return ent;
+}
+
+/*
+ * timer_wheel_next_slot returns the distance in [1, 64] from |slot|
+ * to the next non-empty slot in |bitmap|.  |bitmap| must not be 0.
+ */
+static uint64_t timer_wheel_next_slot(uint64_t bitmap, size_t slot) {
+  size_t s = (slot + 1) & NGTCP2_TIMER_WHEEL_SLOT_MASK;
+
+  if (s) {
+    bitmap = (bitmap >> s) | (bitmap << (NGTCP2_TIMER_WHEEL_NUM_SLOTS - s));
+  }
+
+  return timer_wheel_ctz(bitmap) + 1;
+}
+
+static ngtcp2_tstamp timer_wheel_get_expiry(const ngtcp2_timer_wheel *tw) {
+  uint64_t res = UINT64_MAX, t, base;
+  size_t level, shift;
+
+  if (tw->expired) {
+    return tw->now * tw->tick;
+  }
+
+  for (level = 0; level < NGTCP2_TIMER_WHEEL_NUM_LEVELS; ++level) {
+    if (!tw->bitmap[level]) {
+      continue;
+    }
+
+    shift = NGTCP2_TIMER_WHEEL_SLOT_BITS * level;
+    base = tw->now >> shift;
+
+    /* For the upper levels, this is the tick when the slot is
+       cascaded, which is not later than the expiry of its
+       entries. */
+    t = (base + timer_wheel_next_slot(
+                    tw->bitmap[level],
+                    (size_t)(base & NGTCP2_TIMER_WHEEL_SLOT_MASK)))
+        << shift;
+
+    res = ngtcp2_min_uint64(res, t);
+  }
+
+  if (res == UINT64_MAX) {
+    return UINT64_MAX;
+  }
+
+  return res * tw->tick;
+}
+
+int ngtcp2_timer_wheel_new(ngtcp2_timer_wheel **ptw, ngtcp2_duration tick,
+                           ngtcp2_tstamp ts, const ngtcp2_mem *mem) {
+  ngtcp2_timer_wheel *tw;
+
+  if (tick == 0) {
+    return NGTCP2_ERR_INVALID_ARGUMENT;
+  }
+
+  if (mem == NULL) {
+    mem = ngtcp2_mem_default();
+  }
+
+  tw = ngtcp2_mem_malloc(mem, sizeof(*tw));
+  if (tw == NULL) {
+    return NGTCP2_ERR_NOMEM;
+  }
+
+  ngtcp2_timer_wheel_init(tw, tick, ts, mem);
+
+  *ptw = tw;
+
+  return 0;
+}
+
+void ngtcp2_timer_wheel_del(ngtcp2_timer_wheel *tw) {
+  ngtcp2_timer_wheel_entry *ent;
+  ngtcp2_conn *conn;
+
+  if (tw == NULL) {
+    return;
+  }
+
+  /* A connection which is attached, but not scheduled, is not in any
+     slot.  Walk the list of the attached entries so that no
+     connection keeps a pointer to the freed wheel. */
+  for (; tw->attached;) {
+    ent = tw->attached;
+    tw->attached = ent->attached_next;
+
+    ngtcp2_timer_wheel_entry_init(ent);
+
+    conn = ngtcp2_struct_of(ent, ngtcp2_conn, tw_ent);
+    conn->tw = NULL;
+  }
+
+  ngtcp2_mem_free(tw->mem, tw);
+}
+
+ngtcp2_tstamp ngtcp2_timer_wheel_get_expiry(const ngtcp2_timer_wheel *tw) {
+  return timer_wheel_get_expiry(tw);
+}
+
+ngtcp2_conn *ngtcp2_timer_wheel_expire(ngtcp2_timer_wheel *tw,
+                                       ngtcp2_tstamp ts) {
+  ngtcp2_timer_wheel_entry *ent;
+
+  ngtcp2_timer_wheel_advance(tw, ts);
+
+  ent = ngtcp2_timer_wheel_pop_expired(tw);
+  if (ent == NULL) {
+    return NULL;
+  }
+
+  return ngtcp2_struct_of(ent, ngtcp2_conn, tw_ent);
+}
@@ -0,0 +1,171 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef NGTCP2_TIMER_WHEEL_H
+#define NGTCP2_TIMER_WHEEL_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <ngtcp2/ngtcp2.h>
+
+/* NGTCP2_TIMER_WHEEL_NUM_LEVELS is the number of levels of
+   ngtcp2_timer_wheel. */
+#define NGTCP2_TIMER_WHEEL_NUM_LEVELS 4
+/* NGTCP2_TIMER_WHEEL_SLOT_BITS is the number of bits to address a
+   slot in a level. */
+#define NGTCP2_TIMER_WHEEL_SLOT_BITS 6
+/* NGTCP2_TIMER_WHEEL_NUM_SLOTS is the number of slots in a level.
+   The occupancy of slots in a level is tracked by a single 64 bits
+   bitmap. */
+#define NGTCP2_TIMER_WHEEL_NUM_SLOTS (1u << NGTCP2_TIMER_WHEEL_SLOT_BITS)
+/* NGTCP2_TIMER_WHEEL_MAX_TICKS is the maximum number of ticks ahead
+   that ngtcp2_timer_wheel can represent.  The entry which expires
+   later than that is stored as if it expires at that tick, and it is
+   re-scheduled when it is reached. */
+#define NGTCP2_TIMER_WHEEL_MAX_TICKS                                           \
+  ((1ull << (NGTCP2_TIMER_WHEEL_SLOT_BITS * NGTCP2_TIMER_WHEEL_NUM_LEVELS)) -  \
+   1)
+
+typedef struct ngtcp2_timer_wheel_entry ngtcp2_timer_wheel_entry;
+
+/*
+ * ngtcp2_timer_wheel_entry is an entry of ngtcp2_timer_wheel.  It is
+ * intended to be embedded in the object whose expiry is tracked, so
+ * that adding it to ngtcp2_timer_wheel does not allocate memory.
+ */
+struct ngtcp2_timer_wheel_entry {
+  /* next points to the next entry in the same slot. */
+  ngtcp2_timer_wheel_entry *next;
+  /* pprev points to the pointer which points to this entry.  It is
+     NULL if this entry is not in ngtcp2_timer_wheel. */
+  ngtcp2_timer_wheel_entry **pprev;
+  /* expiry is the timestamp when this entry expires.  UINT64_MAX
+     means this entry is not in ngtcp2_timer_wheel. */
+  ngtcp2_tstamp expiry;
+  /* level is the level of the slot this entry is in.
+     NGTCP2_TIMER_WHEEL_NUM_LEVELS means this entry has expired and is
+     in the expired list. */
+  uint8_t level;
+  /* slot is the index of the slot this entry is in. */
+  uint8_t slot;
+  /* attached_next points to the next entry in the list of the
+     entries attached to ngtcp2_timer_wheel. */
+  ngtcp2_timer_wheel_entry *attached_next;
+  /* attached_pprev points to the pointer which points to this entry
+     in the list of the attached entries.  It is NULL if this entry
+     is not attached. */
+  ngtcp2_timer_wheel_entry **attached_pprev;
+};
+
+/*
+ * ngtcp2_timer_wheel_entry_init initializes |ent|.
+ */
+void ngtcp2_timer_wheel_entry_init(ngtcp2_timer_wheel_entry *ent);
+
+/*
+ * ngtcp2_timer_wheel is a hierarchical timer wheel.  The expiry is
+ * rounded up to the tick, so that an entry never expires early.  An
+ * entry which is far from the current tick is kept in the upper
+ * level, and it is moved to the lower level as the wheel advances.
+ */
+struct ngtcp2_timer_wheel {
+  const ngtcp2_mem *mem;
+  /* tick is the duration of a single tick. */
+  ngtcp2_duration tick;
+  /* now is the current tick.  All entries whose expiry is at or
+     before this tick have been moved to expired. */
+  uint64_t now;
+  /* slots is the array of the lists of entries per level. */
+  ngtcp2_timer_wheel_entry *slots[NGTCP2_TIMER_WHEEL_NUM_LEVELS]
+                                 [NGTCP2_TIMER_WHEEL_NUM_SLOTS];
+  /* bitmap tracks non-empty slots per level. */
+  uint64_t bitmap[NGTCP2_TIMER_WHEEL_NUM_LEVELS];
+  /* expired is the list of expired entries. */
+  ngtcp2_timer_wheel_entry *expired;
+  /* attached is the list of the attached entries.  An entry is
+     attached whether or not it is scheduled, so that all of them are
+     detached when this wheel is freed. */
+  ngtcp2_timer_wheel_entry *attached;
+  /* len is the number of entries in this wheel, including the expired
+     ones. */
+  size_t len;
+};
+
+/*
+ * ngtcp2_timer_wheel_init initializes |tw|.  |tick| is the
+ * granularity of the timer, and it must not be 0.  |ts| is the
+ * current timestamp.
+ */
+void ngtcp2_timer_wheel_init(ngtcp2_timer_wheel *tw, ngtcp2_duration tick,
+                             ngtcp2_tstamp ts, const ngtcp2_mem *mem);
+
+/*
+ * ngtcp2_timer_wheel_attach adds |ent| to the list of the entries
+ * attached to |tw|.  |ent| must not be attached to any wheel.  It
+ * does not schedule |ent|.
+ */
+void ngtcp2_timer_wheel_attach(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent);
+
+/*
+ * ngtcp2_timer_wheel_detach removes |ent| from |tw|, and from the list
+ * of the entries attached to |tw|.  |ent| must be attached to |tw|.
+ */
+void ngtcp2_timer_wheel_detach(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent);
+
+/*
+ * ngtcp2_timer_wheel_update schedules |ent| to expire at |expiry|.
+ * |ent| must be attached to |tw|.
+ * If |ent| is already in |tw|, it is re-scheduled.  If |expiry| is
+ * UINT64_MAX, |ent| is removed from |tw|.  If |expiry| is at or
+ * before the current tick, |ent| is moved to the expired list.
+ */
+void ngtcp2_timer_wheel_update(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent,
+                               ngtcp2_tstamp expiry);
+
+/*
+ * ngtcp2_timer_wheel_remove removes |ent| from |tw|.  It does nothing
+ * if |ent| is not in |tw|.
+ */
+void ngtcp2_timer_wheel_remove(ngtcp2_timer_wheel *tw,
+                               ngtcp2_timer_wheel_entry *ent);
+
+/*
+ * ngtcp2_timer_wheel_advance advances the current tick of |tw| to
+ * |ts|, and moves the entries which have expired to the expired list.
+ */
+void ngtcp2_timer_wheel_advance(ngtcp2_timer_wheel *tw, ngtcp2_tstamp ts);
+
+/*
+ * ngtcp2_timer_wheel_pop_expired removes an entry from the expired
+ * list, and returns it.  It returns NULL if the list is empty.
+ */
+ngtcp2_timer_wheel_entry *
+ngtcp2_timer_wheel_pop_expired(ngtcp2_timer_wheel *tw);
+
+#endif /* NGTCP2_TIMER_WHEEL_H */
@@ -0,0 +1,913 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * bench measures the performance of the data structures and codecs
+ * on the hot paths of the library.  Each benchmark is run for a
+ * number of rounds, and the result is written to stdout as a JSON
+ * object per line:
+ *
+ * {"name":"ksl_insert","ops":100000,"rounds":5,"ns_per_op_min":...,
+ *  "ns_per_op_median":...}
+ *
+ * Usage: bench [-r ROUNDS] [FILTER]
+ *
+ * If FILTER is given, only the benchmarks whose name contains FILTER
+ * are run.
+ */
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#include "ngtcp2_ksl.h"
+#include "ngtcp2_map.h"
+#include "ngtcp2_pq.h"
+#include "ngtcp2_rob.h"
+#include "ngtcp2_gaptr.h"
+#include "ngtcp2_acktr.h"
+#include "ngtcp2_rtb.h"
+#include "ngtcp2_conn.h"
+#include "ngtcp2_conv.h"
+#include "ngtcp2_pkt.h"
+#include "ngtcp2_log.h"
+#include "ngtcp2_macro.h"
+#include "ngtcp2_test_helper.h"
+#include "sim.h"
+
+/* BENCH_MAX_ROUNDS is the maximum number of rounds per benchmark. */
+#define BENCH_MAX_ROUNDS 64
+
+typedef struct bench_timer {
+  uint64_t start;
+  /* elapsed is the accumulated time in nanoseconds between
+     bench_start and bench_stop. */
+  uint64_t elapsed;
+} bench_timer;
+
+typedef struct bench {
+  const char *name;
+  /* run runs the benchmark once, and returns the number of
+     operations performed.  It must only measure the hot loop by
+     calling bench_start and bench_stop. */
+  size_t (*run)(bench_timer *t);
+} bench;
+
+/* sink is updated by benchmarks so that the compiler does not
+   eliminate the measured code. */
+static volatile uint64_t sink;
+
+static uint64_t bench_now(void) {
+  struct timespec tp;
+
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+
+  return (uint64_t)tp.tv_sec * NGTCP2_SECONDS + (uint64_t)tp.tv_nsec;
+}
+
+static void bench_start(bench_timer *t) { t->start = bench_now(); }
+
+static void bench_stop(bench_timer *t) { t->elapsed += bench_now() - t->start; }
+
+/*
+ * bench_rand returns a pseudo random number.  The sequence is fixed
+ * so that each run measures the same workload.
+ */
+static uint64_t bench_rand(uint64_t *state) {
+  uint64_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+
+  return *state = x;
+}
+
+/* BENCH_KSL_N is the number of keys used by ksl benchmarks. */
+#define BENCH_KSL_N 100000
+
+static int bench_ksl_less(const ngtcp2_ksl_key *lhs,
+                          const ngtcp2_ksl_key *rhs) {
+  return *(const int64_t *)lhs < *(const int64_t *)rhs;
+}
+
+static int64_t ksl_keys[BENCH_KSL_N];
+
+static void bench_ksl_setup(ngtcp2_ksl *ksl) {
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+  size_t i;
+
+  ngtcp2_ksl_init(ksl, bench_ksl_less, sizeof(int64_t),
+                  ngtcp2_mem_default());
+
+  for (i = 0; i < BENCH_KSL_N; ++i) {
+    ksl_keys[i] = (int64_t)(bench_rand(&state) >> 1);
+  }
+}
+
+static size_t bench_ksl_insert(bench_timer *t) {
+  ngtcp2_ksl ksl;
+  size_t i;
+
+  bench_ksl_setup(&ksl);
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_KSL_N; ++i) {
+    ngtcp2_ksl_insert(&ksl, NULL, &ksl_keys[i], NULL);
+  }
+
+  bench_stop(t);
+
+  sink += ngtcp2_ksl_len(&ksl);
+
+  ngtcp2_ksl_free(&ksl);
+
+  return BENCH_KSL_N;
+}
+
+static size_t bench_ksl_remove(bench_timer *t) {
+  ngtcp2_ksl ksl;
+  size_t i;
+
+  bench_ksl_setup(&ksl);
+
+  for (i = 0; i < BENCH_KSL_N; ++i) {
+    ngtcp2_ksl_insert(&ksl, NULL, &ksl_keys[i], NULL);
+  }
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_KSL_N; ++i) {
+    ngtcp2_ksl_remove(&ksl, NULL, &ksl_keys[i]);
+  }
+
+  bench_stop(t);
+
+  sink += ngtcp2_ksl_len(&ksl);
+
+  ngtcp2_ksl_free(&ksl);
+
+  return BENCH_KSL_N;
+}
+
+static size_t bench_ksl_lower_bound(bench_timer *t) {
+  ngtcp2_ksl ksl;
+  ngtcp2_ksl_it it;
+  size_t i;
+
+  bench_ksl_setup(&ksl);
+
+  for (i = 0; i < BENCH_KSL_N; ++i) {
+    ngtcp2_ksl_insert(&ksl, NULL, &ksl_keys[i], NULL);
+  }
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_KSL_N; ++i) {
+    it = ngtcp2_ksl_lower_bound(&ksl, &ksl_keys[BENCH_KSL_N - i - 1]);
+    sink += (uint64_t)*(int64_t *)ngtcp2_ksl_it_key(&it);
+  }
+
+  bench_stop(t);
+
+  ngtcp2_ksl_free(&ksl);
+
+  return BENCH_KSL_N;
+}
+
+/* BENCH_MAP_N is the number of keys used by map benchmarks.  Keys are
+   client initiated bidirectional stream IDs. */
+#define BENCH_MAP_N 100000
+
+static size_t bench_map_insert(bench_timer *t) {
+  ngtcp2_map map;
+  size_t i;
+
+  ngtcp2_map_init(&map, ngtcp2_mem_default());
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_MAP_N; ++i) {
+    ngtcp2_map_insert(&map, (ngtcp2_map_key_type)(i * 4), &map);
+  }
+
+  bench_stop(t);
+
+  sink += ngtcp2_map_size(&map);
+
+  ngtcp2_map_free(&map);
+
+  return BENCH_MAP_N;
+}
+
+static size_t bench_map_find(bench_timer *t) {
+  ngtcp2_map map;
+  size_t i;
+
+  ngtcp2_map_init(&map, ngtcp2_mem_default());
+
+  for (i = 0; i < BENCH_MAP_N; ++i) {
+    ngtcp2_map_insert(&map, (ngtcp2_map_key_type)(i * 4), &map);
+  }
+
+  bench_start(t);
+
+  /* Half of the lookups miss. */
+  for (i = 0; i < BENCH_MAP_N; ++i) {
+    sink += ngtcp2_map_find(&map, (ngtcp2_map_key_type)(i * 2)) != NULL;
+  }
+
+  bench_stop(t);
+
+  ngtcp2_map_free(&map);
+
+  return BENCH_MAP_N;
+}
+
+/* BENCH_PQ_N is the number of entries used by pq benchmark. */
+#define BENCH_PQ_N 100000
+
+typedef struct bench_pq_entry {
+  ngtcp2_pq_entry pe;
+  uint64_t key;
+} bench_pq_entry;
+
+static int bench_pq_less(const ngtcp2_pq_entry *lhs,
+                         const ngtcp2_pq_entry *rhs) {
+  return ngtcp2_struct_of(lhs, bench_pq_entry, pe)->key <
+         ngtcp2_struct_of(rhs, bench_pq_entry, pe)->key;
+}
+
+static bench_pq_entry pq_ents[BENCH_PQ_N];
+
+static size_t bench_pq_push_pop(bench_timer *t) {
+  ngtcp2_pq pq;
+  uint64_t state = 0x2545f4914f6cdd1dULL;
+  size_t i;
+
+  ngtcp2_pq_init(&pq, bench_pq_less, ngtcp2_mem_default());
+
+  for (i = 0; i < BENCH_PQ_N; ++i) {
+    pq_ents[i].key = bench_rand(&state);
+  }
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_PQ_N; ++i) {
+    ngtcp2_pq_push(&pq, &pq_ents[i].pe);
+  }
+
+  for (; !ngtcp2_pq_empty(&pq);) {
+    sink += ngtcp2_struct_of(ngtcp2_pq_top(&pq), bench_pq_entry, pe)->key;
+    ngtcp2_pq_pop(&pq);
+  }
+
+  bench_stop(t);
+
+  ngtcp2_pq_free(&pq);
+
+  return BENCH_PQ_N * 2;
+}
+
+/* BENCH_STREAM_N is the number of chunks pushed by rob and gaptr
+   benchmarks. */
+#define BENCH_STREAM_N 100000
+/* BENCH_STREAM_CHUNKLEN is the length of a chunk, which is roughly
+   the size of STREAM data in a full sized packet. */
+#define BENCH_STREAM_CHUNKLEN 1200
+
+/*
+ * bench_reorder returns the index of the chunk that is delivered at
+ * |i|th position.  Every 8th pair of chunks is swapped, and every
+ * 64th chunk is delayed by 16 positions to simulate a loss and its
+ * retransmission.
+ */
+static size_t bench_reorder(size_t i, size_t n) {
+  if (i % 64 == 0 && i + 16 < n) {
+    return i + 16;
+  }
+
+  if (i % 64 == 16 && i >= 16) {
+    return i - 16;
+  }
+
+  if (i % 8 == 2 && i + 1 < n) {
+    return i + 1;
+  }
+
+  if (i % 8 == 3) {
+    return i - 1;
+  }
+
+  return i;
+}
+
+/* BENCH_STREAM_JUMBO_CHUNKLEN is the length of a chunk, which is
+   roughly the size of STREAM data in a packet of 9000 bytes MTU. */
+#define BENCH_STREAM_JUMBO_CHUNKLEN 8900
+
+/*
+ * bench_rob_push_pop_chunklen pushes BENCH_STREAM_N chunks of length
+ * |chunklen| to ngtcp2_rob out of order, and pops them in order.  The
+ * buffer size of ngtcp2_rob is the same as ngtcp2_strm uses.
+ */
+static size_t bench_rob_push_pop_chunklen(bench_timer *t, size_t chunklen) {
+  static uint8_t data[BENCH_STREAM_JUMBO_CHUNKLEN];
+  ngtcp2_rob rob;
+  const uint8_t *p;
+  uint64_t offset = 0;
+  size_t i, len;
+
+  assert(chunklen <= sizeof(data));
+
+  ngtcp2_rob_init(&rob, 8 * 1024, ngtcp2_mem_default());
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_STREAM_N; ++i) {
+    ngtcp2_rob_push(&rob, (uint64_t)bench_reorder(i, BENCH_STREAM_N) * chunklen,
+                    data, chunklen);
+
+    for (;;) {
+      len = ngtcp2_rob_data_at(&rob, &p, offset);
+      if (len == 0) {
+        break;
+      }
+
+      sink += p[0];
+      ngtcp2_rob_pop(&rob, offset, len);
+      offset += len;
+    }
+  }
+
+  bench_stop(t);
+
+  assert(offset == (uint64_t)BENCH_STREAM_N * chunklen);
+
+  ngtcp2_rob_free(&rob);
+
+  return BENCH_STREAM_N;
+}
+
+static size_t bench_rob_push_pop(bench_timer *t) {
+  return bench_rob_push_pop_chunklen(t, BENCH_STREAM_CHUNKLEN);
+}
+
+static size_t bench_rob_push_pop_jumbo(bench_timer *t) {
+  return bench_rob_push_pop_chunklen(t, BENCH_STREAM_JUMBO_CHUNKLEN);
+}
+
+static size_t bench_gaptr_push(bench_timer *t) {
+  ngtcp2_gaptr gaptr;
+  size_t i;
+
+  ngtcp2_gaptr_init(&gaptr, ngtcp2_mem_default());
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_STREAM_N; ++i) {
+    ngtcp2_gaptr_push(&gaptr,
+                      (uint64_t)bench_reorder(i, BENCH_STREAM_N) *
+                          BENCH_STREAM_CHUNKLEN,
+                      BENCH_STREAM_CHUNKLEN);
+    sink += ngtcp2_gaptr_first_gap_offset(&gaptr);
+  }
+
+  bench_stop(t);
+
+  ngtcp2_gaptr_free(&gaptr);
+
+  return BENCH_STREAM_N;
+}
+
+/* BENCH_PKT_N is the number of packets used by acktr and rtb
+   benchmarks. */
+#define BENCH_PKT_N 100000
+
+/*
+ * bench_build_ack builds ACK frame from |acktr| in the same way that
+ * ngtcp2_conn does.
+ */
+static void bench_build_ack(ngtcp2_max_frame *mfr, ngtcp2_acktr *acktr) {
+  ngtcp2_ack *ack = &mfr->ackfr.ack;
+  ngtcp2_ksl_it it = ngtcp2_acktr_get(acktr);
+  ngtcp2_acktr_entry *rpkt;
+  ngtcp2_ack_range *range;
+  int64_t last_pkt_num;
+
+  rpkt = ngtcp2_ksl_it_get(&it);
+  last_pkt_num = rpkt->pkt_num - (int64_t)(rpkt->len - 1);
+  ack->largest_ack = rpkt->pkt_num;
+  ack->first_ack_range = rpkt->len - 1;
+  ack->rangecnt = 0;
+
+  for (ngtcp2_ksl_it_next(&it);
+       !ngtcp2_ksl_it_end(&it) && ack->rangecnt < NGTCP2_MAX_ACK_RANGES;
+       ngtcp2_ksl_it_next(&it)) {
+    rpkt = ngtcp2_ksl_it_get(&it);
+    range = &ack->ranges[ack->rangecnt++];
+    range->gap = (uint64_t)(last_pkt_num - rpkt->pkt_num - 2);
+    range->len = rpkt->len - 1;
+    last_pkt_num = rpkt->pkt_num - (int64_t)(rpkt->len - 1);
+  }
+}
+
+static size_t bench_acktr_add_ack(bench_timer *t) {
+  ngtcp2_acktr acktr;
+  ngtcp2_log log;
+  ngtcp2_max_frame mfr;
+  size_t i;
+
+  ngtcp2_log_init(&log, NULL, NULL, 0, NULL);
+  ngtcp2_acktr_init(&acktr, &log, ngtcp2_mem_default());
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_PKT_N; ++i) {
+    ngtcp2_acktr_add(&acktr, (int64_t)bench_reorder(i, BENCH_PKT_N), 1,
+                     (ngtcp2_tstamp)i);
+
+    /* Build ACK frame every 2 packets. */
+    if (i & 1) {
+      bench_build_ack(&mfr, &acktr);
+      sink += mfr.ackfr.ack.rangecnt;
+    }
+  }
+
+  bench_stop(t);
+
+  ngtcp2_acktr_free(&acktr);
+
+  return BENCH_PKT_N;
+}
+
+static size_t bench_rtb_add_recv_ack(bench_timer *t) {
+  const ngtcp2_mem *mem = ngtcp2_mem_default();
+  ngtcp2_rtb rtb;
+  ngtcp2_rtb_entry *ent;
+  ngtcp2_max_frame mfr;
+  ngtcp2_ack *ack = &mfr.ackfr.ack;
+  ngtcp2_log log;
+  ngtcp2_conn_stat cstat;
+  ngtcp2_cc_reno cc;
+  ngtcp2_pkt_hd hd;
+  ngtcp2_strm crypto;
+  ngtcp2_rst rst;
+  ngtcp2_objalloc frc_objalloc;
+  ngtcp2_objalloc rtb_entry_objalloc;
+  size_t i;
+
+  ngtcp2_objalloc_init(&frc_objalloc, 1024, mem);
+  ngtcp2_objalloc_init(&rtb_entry_objalloc, 1024, mem);
+  ngtcp2_strm_init(&crypto, 0, NGTCP2_STRM_FLAG_NONE, 0, 0, NULL, &frc_objalloc,
+                   mem);
+  ngtcp2_log_init(&log, NULL, NULL, 0, NULL);
+  memset(&cstat, 0, sizeof(cstat));
+  cstat.max_tx_udp_payload_size = NGTCP2_MAX_UDP_PAYLOAD_SIZE;
+  cstat.min_rtt = UINT64_MAX;
+  cstat.smoothed_rtt = NGTCP2_DEFAULT_INITIAL_RTT;
+  cstat.cwnd = ngtcp2_cc_compute_initcwnd(cstat.max_tx_udp_payload_size);
+  cstat.ssthresh = UINT64_MAX;
+  ngtcp2_rst_init(&rst);
+  ngtcp2_cc_reno_init(&cc, &log);
+  ngtcp2_rtb_init(&rtb, NGTCP2_PKTNS_ID_HANDSHAKE, &crypto, &rst, &cc.cc, 0,
+                  &log, NULL, &rtb_entry_objalloc, &frc_objalloc, mem);
+
+  bench_start(t);
+
+  /* Keep 2 packets in flight, and acknowledge them together.  The
+     packets are not ack-eliciting because RTT sample requires
+     ngtcp2_conn. */
+  for (i = 0; i < BENCH_PKT_N; ++i) {
+    ngtcp2_pkt_hd_init(&hd, NGTCP2_PKT_FLAG_NONE, NGTCP2_PKT_1RTT, NULL, NULL,
+                       (int64_t)i, 1, NGTCP2_PROTO_VER_V1, 0);
+    ngtcp2_rtb_entry_objalloc_new(&ent, &hd, NULL, (ngtcp2_tstamp)i * 1000,
+                                  1200, NGTCP2_RTB_ENTRY_FLAG_NONE,
+                                  &rtb_entry_objalloc);
+    ngtcp2_rtb_add(&rtb, ent, &cstat);
+
+    if (i & 1) {
+      ack->largest_ack = (int64_t)i;
+      ack->first_ack_range = 1;
+      ack->rangecnt = 0;
+      ack->ack_delay = 0;
+      ack->ack_delay_unscaled = 0;
+
+      sink += (uint64_t)ngtcp2_rtb_recv_ack(&rtb, ack, &cstat, NULL, NULL,
+                                            (ngtcp2_tstamp)i * 1000 + 1000000,
+                                            (ngtcp2_tstamp)i * 1000 + 1000000);
+    }
+  }
+
+  bench_stop(t);
+
+  ngtcp2_rtb_free(&rtb);
+  ngtcp2_strm_free(&crypto);
+  ngtcp2_objalloc_free(&rtb_entry_objalloc);
+  ngtcp2_objalloc_free(&frc_objalloc);
+
+  return BENCH_PKT_N;
+}
+
+/* BENCH_VARINT_N is the number of integers used by varint
+   benchmarks. */
+#define BENCH_VARINT_N 100000
+
+static uint64_t varint_vals[BENCH_VARINT_N];
+static uint8_t varint_buf[BENCH_VARINT_N * 8];
+
+/*
+ * bench_varint_setup fills varint_vals with integers of mixed
+ * encoding lengths, encodes them to varint_buf, and returns the
+ * pointer to the end of the encoded data.
+ */
+static uint8_t *bench_varint_setup(void) {
+  static const uint64_t masks[] = {0x3f, 0x3fff, 0x3fffffff,
+                                   0x3fffffffffffffffULL};
+  uint64_t state = 0xd1b54a32d192ed03ULL;
+  uint8_t *p = varint_buf;
+  size_t i;
+
+  for (i = 0; i < BENCH_VARINT_N; ++i) {
+    varint_vals[i] = bench_rand(&state) & masks[i % ngtcp2_arraylen(masks)];
+    p = ngtcp2_put_uvarint(p, varint_vals[i]);
+  }
+
+  return p;
+}
+
+static size_t bench_varint_encode(bench_timer *t) {
+  uint8_t *p = varint_buf;
+  size_t i;
+
+  bench_varint_setup();
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_VARINT_N; ++i) {
+    p = ngtcp2_put_uvarint(p, varint_vals[i]);
+  }
+
+  bench_stop(t);
+
+  sink += (uint64_t)(p - varint_buf);
+
+  return BENCH_VARINT_N;
+}
+
+static size_t bench_varint_decode(bench_timer *t) {
+  const uint8_t *p = varint_buf;
+  uint64_t n;
+  size_t i;
+
+  bench_varint_setup();
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_VARINT_N; ++i) {
+    p = ngtcp2_get_uvarint(&n, p);
+    sink += n;
+  }
+
+  bench_stop(t);
+
+  return BENCH_VARINT_N;
+}
+
+/* BENCH_FRAME_N is the number of times the frame sequence is
+   decoded. */
+#define BENCH_FRAME_N 20000
+
+static size_t bench_decode_frame(bench_timer *t) {
+  static uint8_t data[1024];
+  uint8_t buf[2048];
+  ngtcp2_max_frame mfr;
+  ngtcp2_frame *fr = &mfr.fr;
+  ngtcp2_ack_range *ranges;
+  ngtcp2_ssize nwrite;
+  size_t buflen = 0, nfr = 0, i, j;
+  const uint8_t *p;
+
+  /* The payload of a typical 1RTT packet: ACK, MAX_STREAM_DATA, and
+     STREAM. */
+  fr->type = NGTCP2_FRAME_ACK;
+  fr->ack.largest_ack = 1000000;
+  fr->ack.ack_delay = 25;
+  fr->ack.first_ack_range = 10;
+  fr->ack.rangecnt = 3;
+
+  ranges = fr->ack.ranges;
+
+  for (i = 0; i < fr->ack.rangecnt; ++i) {
+    ranges[i].gap = 1;
+    ranges[i].len = 7;
+  }
+
+  nwrite = ngtcp2_pkt_encode_frame(buf + buflen, sizeof(buf) - buflen, fr);
+  assert(nwrite > 0);
+  buflen += (size_t)nwrite;
+  ++nfr;
+
+  fr->type = NGTCP2_FRAME_MAX_STREAM_DATA;
+  fr->max_stream_data.stream_id = 4;
+  fr->max_stream_data.max_stream_data = 1000000000;
+
+  nwrite = ngtcp2_pkt_encode_frame(buf + buflen, sizeof(buf) - buflen, fr);
+  assert(nwrite > 0);
+  buflen += (size_t)nwrite;
+  ++nfr;
+
+  fr->type = NGTCP2_FRAME_STREAM;
+  fr->stream.flags = 0;
+  fr->stream.fin = 0;
+  fr->stream.stream_id = 4;
+  fr->stream.offset = 1000000;
+  fr->stream.datacnt = 1;
+  fr->stream.data[0].base = data;
+  fr->stream.data[0].len = sizeof(data);
+
+  nwrite = ngtcp2_pkt_encode_frame(buf + buflen, sizeof(buf) - buflen, fr);
+  assert(nwrite > 0);
+  buflen += (size_t)nwrite;
+  ++nfr;
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_FRAME_N; ++i) {
+    p = buf;
+
+    for (j = 0; j < nfr; ++j) {
+      nwrite = ngtcp2_pkt_decode_frame(fr, p, buflen - (size_t)(p - buf));
+      sink += fr->type;
+      p += nwrite;
+    }
+  }
+
+  bench_stop(t);
+
+  return BENCH_FRAME_N * nfr;
+}
+
+/* BENCH_CONN_TOTAL is the number of stream bytes which conn
+   benchmarks transfer. */
+#define BENCH_CONN_TOTAL (4 * 1024 * 1024)
+/* BENCH_CONN_WARMUP is the number of iterations which conn_get_expiry
+   benchmark runs before measurement, so that the connections have
+   packets in flight. */
+#define BENCH_CONN_WARMUP 256
+/* BENCH_EXPIRY_N is the number of ngtcp2_conn_get_expiry calls
+   measured by conn_get_expiry benchmark. */
+#define BENCH_EXPIRY_N 1000000
+
+/*
+ * bench_conn runs a bulk transfer from a client to a server over a
+ * 1Gbps link with 1ms one-way delay on a virtual clock, in the same
+ * way that loopback does.
+ */
+typedef struct bench_conn {
+  ngtcp2_path_storage ps;
+  sim_endpoint client, server;
+  sim_link c2s, s2c;
+  sim_sender s;
+  ngtcp2_tstamp ts;
+} bench_conn;
+
+static void bench_conn_init(bench_conn *bc) {
+  static const sim_link_config config = {
+    .bandwidth = 1000 * 1000 * 1000,
+    .delay = NGTCP2_MILLISECONDS,
+    .queue = 1024 * 1024,
+  };
+  int rv;
+
+  memset(bc, 0, sizeof(*bc));
+
+  path_init(&bc->ps, 0, 0, 0, 0);
+
+  rv = sim_link_init(&bc->c2s, &config, 0);
+  assert(0 == rv);
+
+  rv = sim_link_init(&bc->s2c, &config, 1);
+  assert(0 == rv);
+
+  rv = sim_endpoint_init(&bc->client, /* server = */ 0, NGTCP2_CC_ALGO_CUBIC,
+                         NGTCP2_MAX_UDP_PAYLOAD_SIZE, &bc->ps.path, &bc->ts);
+  assert(0 == rv);
+
+  rv = sim_endpoint_init(&bc->server, /* server = */ 1, NGTCP2_CC_ALGO_CUBIC,
+                         NGTCP2_MAX_UDP_PAYLOAD_SIZE, &bc->ps.path, &bc->ts);
+  assert(0 == rv);
+
+  rv = sim_sender_init(&bc->s, &bc->client, BENCH_CONN_TOTAL);
+  assert(0 == rv);
+}
+
+static void bench_conn_free(bench_conn *bc) {
+  sim_endpoint_free(&bc->server);
+  sim_endpoint_free(&bc->client);
+  sim_link_free(&bc->s2c);
+  sim_link_free(&bc->c2s);
+}
+
+static void bench_conn_read(bench_conn *bc, sim_endpoint *ep, sim_link *l) {
+  sim_pkt *pkt;
+  int rv;
+
+  while (sim_link_next_arrival(l) <= bc->ts) {
+    pkt = sim_link_top(l);
+    rv = sim_endpoint_read(ep, &bc->ps.path, pkt->data, pkt->len, bc->ts);
+    assert(0 == rv);
+
+    sim_link_pop(l);
+
+    sink += ngtcp2_conn_get_expiry(ep->conn);
+  }
+}
+
+/*
+ * bench_conn_step runs one iteration of the event loop.  Like an
+ * application, it gets the expiry after every read and write.  It
+ * returns nonzero if the transfer has finished.
+ */
+static int bench_conn_step(bench_conn *bc) {
+  ngtcp2_ssize nwrite;
+  ngtcp2_tstamp next;
+  int rv;
+
+  nwrite = sim_endpoint_write(&bc->client, &bc->s, &bc->c2s, 0, bc->ts);
+  assert(nwrite >= 0);
+
+  nwrite = sim_endpoint_write(&bc->server, NULL, &bc->s2c, 0, bc->ts);
+  assert(nwrite >= 0);
+
+  if (bc->server.fin_ts != UINT64_MAX) {
+    return 1;
+  }
+
+  next = ngtcp2_min_uint64(sim_link_next_arrival(&bc->c2s),
+                           sim_link_next_arrival(&bc->s2c));
+  next = ngtcp2_min_uint64(next, ngtcp2_conn_get_expiry(bc->client.conn));
+  next = ngtcp2_min_uint64(next, ngtcp2_conn_get_expiry(bc->server.conn));
+
+  assert(next != UINT64_MAX);
+
+  bc->ts = ngtcp2_max_uint64(bc->ts, next);
+
+  bench_conn_read(bc, &bc->server, &bc->c2s);
+  bench_conn_read(bc, &bc->client, &bc->s2c);
+
+  rv = sim_endpoint_handle_expiry(&bc->client, bc->ts);
+  assert(0 == rv);
+
+  rv = sim_endpoint_handle_expiry(&bc->server, bc->ts);
+  assert(0 == rv);
+
+  return 0;
+}
+
+static size_t bench_conn_loop(bench_timer *t) {
+  bench_conn bc;
+  size_t n = 0;
+
+  bench_conn_init(&bc);
+
+  bench_start(t);
+
+  for (; !bench_conn_step(&bc); ++n)
+    ;
+
+  bench_stop(t);
+
+  bench_conn_free(&bc);
+
+  return n;
+}
+
+static size_t bench_conn_get_expiry(bench_timer *t) {
+  bench_conn bc;
+  size_t i;
+  int rv;
+
+  bench_conn_init(&bc);
+
+  for (i = 0; i < BENCH_CONN_WARMUP; ++i) {
+    rv = bench_conn_step(&bc);
+    assert(0 == rv);
+  }
+
+  bench_start(t);
+
+  for (i = 0; i < BENCH_EXPIRY_N; ++i) {
+    sink += ngtcp2_conn_get_expiry(bc.client.conn);
+  }
+
+  bench_stop(t);
+
+  bench_conn_free(&bc);
+
+  return BENCH_EXPIRY_N;
+}
+
+static const bench benches[] = {
+    {"ksl_insert", bench_ksl_insert},
+    {"ksl_remove", bench_ksl_remove},
+    {"ksl_lower_bound", bench_ksl_lower_bound},
+    {"map_insert", bench_map_insert},
+    {"map_find", bench_map_find},
+    {"pq_push_pop", bench_pq_push_pop},
+    {"rob_push_pop", bench_rob_push_pop},
+    {"rob_push_pop_jumbo", bench_rob_push_pop_jumbo},
+    {"gaptr_push", bench_gaptr_push},
+    {"acktr_add_ack", bench_acktr_add_ack},
+    {"rtb_add_recv_ack", bench_rtb_add_recv_ack},
+    {"varint_encode", bench_varint_encode},
+    {"varint_decode", bench_varint_decode},
+    {"decode_frame", bench_decode_frame},
+    {"conn_get_expiry", bench_conn_get_expiry},
+    {"conn_loop", bench_conn_loop},
+};
+
+static int bench_compar_uint64(const void *lhs, const void *rhs) {
+  uint64_t a = *(const uint64_t *)lhs, b = *(const uint64_t *)rhs;
+
+  return a < b ? -1 : a > b;
+}
+
+static void bench_run(const bench *b, size_t rounds) {
+  uint64_t elapsed[BENCH_MAX_ROUNDS];
+  bench_timer t;
+  size_t i, ops = 0;
+
+  for (i = 0; i < rounds; ++i) {
+    t.elapsed = 0;
+    ops = b->run(&t);
+    elapsed[i] = t.elapsed;
+  }
+
+  qsort(elapsed, rounds, sizeof(elapsed[0]), bench_compar_uint64);
+
+  printf("{\"name\":\"%s\",\"ops\":%zu,\"rounds\":%zu,"
+         "\"ns_per_op_min\":%.3f,\"ns_per_op_median\":%.3f}\n",
+         b->name, ops, rounds, (double)elapsed[0] / (double)ops,
+         (double)elapsed[rounds / 2] / (double)ops);
+  fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+  size_t rounds = 5;
+  const char *filter = NULL;
+  size_t i;
+  int n;
+
+  for (n = 1; n < argc; ++n) {
+    if (strcmp(argv[n], "-r") == 0 && n + 1 < argc) {
+      rounds = (size_t)strtoul(argv[++n], NULL, 10);
+      if (rounds == 0 || rounds > BENCH_MAX_ROUNDS) {
+        fprintf(stderr, "-r: ROUNDS must be in [1, %d]\n", BENCH_MAX_ROUNDS);
+        return EXIT_FAILURE;
+      }
+
+      continue;
+    }
+
+    filter = argv[n];
+  }
+
+  for (i = 0; i < ngtcp2_arraylen(benches); ++i) {
+    if (filter && !strstr(benches[i].name, filter)) {
+      continue;
+    }
+
+    bench_run(&benches[i], rounds);
+  }
+
+  return EXIT_SUCCESS;
+}
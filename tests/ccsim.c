@@ -0,0 +1,801 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * ccsim is a discrete event simulator for congestion controllers.  It
+ * runs one or more flows, each of which is a client connection
+ * sending a stream to a server connection, through a scenario
+ * described in a file.  All flows share the same bottleneck link from
+ * client to server, and the same path from server to client.
+ *
+ * The simulation runs on a virtual clock, and the link emulator is
+ * driven by a fixed seed.  The output therefore only depends on the
+ * scenario and on the library, and two runs produce byte-for-byte
+ * identical output.  Diffing the output before and after a change to
+ * a congestion controller shows its effect.
+ *
+ * Usage: ccsim [-c CC] [-s SEED] [-t TRACE] [-T TRACE] SCENARIO
+ *
+ * -c overrides the congestion controller of all flows, and -s
+ * overrides the seed of the scenario.  -t and -T record the inputs of
+ * the client and the server of the first flow respectively in TRACE,
+ * which replay can feed to a single connection later.
+ *
+ * A scenario file contains one directive per line.  "#" starts a
+ * comment.
+ *
+ *   seed N                    Seed of the link emulator.
+ *   duration MS               Length of the simulation (default: 10000).
+ *   sample MS                 Sampling interval (default: 100).
+ *   link KEY=VALUE...         Client to server bottleneck.
+ *   ack_link KEY=VALUE...     Server to client path.
+ *   flow cc=CC [start=MS] [bytes=KB]
+ *                             Adds a flow.  Without bytes, the flow
+ *                             sends until the end of the simulation.
+ *   at MS link|ack_link KEY=VALUE...
+ *                             Changes the link at the given time.
+ *                             Changes must be listed in time order.
+ *
+ * The link keys are bandwidth (Mbps, 0 for unlimited), delay, jitter,
+ * aggregation (ms), loss, reorder (%), queue (KB, 0 for unlimited),
+ * policer_rate (Mbps, 0 to disable), and policer_burst (KB).  See
+ * sim_link_config for their meaning.  The link defaults to 10 Mbps,
+ * 20 ms delay, and a 64 KB queue.  The ack_link is unlimited, and its
+ * delay defaults to the initial delay of the link.
+ *
+ * The output is a JSON object per line.  For each sampling interval
+ * and each running flow:
+ *
+ * {"event":"sample","t_ms":...,"flow":0,"cc":"cubic","cwnd":...,
+ *  "ssthresh":...,"bytes_in_flight":...,"pacing_rate_mbps":...,
+ *  "srtt_ms":...,"min_rtt_ms":...,"throughput_mbps":...}
+ *
+ * "throughput_mbps" is the rate at which the server received stream
+ * data during the interval.  At the end, for each flow:
+ *
+ * {"event":"summary","flow":0,"cc":"cubic","bytes":...,
+ *  "goodput_mbps":...,"pkt_lost":...,"finish_ms":...}
+ *
+ * "finish_ms" is -1 if the flow did not finish.
+ */
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "ngtcp2_conn.h"
+#include "ngtcp2_macro.h"
+#include "ngtcp2_test_helper.h"
+#include "sim.h"
+
+/* CCSIM_MAX_FLOWS is the maximum number of flows in a scenario. */
+#define CCSIM_MAX_FLOWS 16
+
+/* CCSIM_MAX_CHANGES is the maximum number of link changes in a
+   scenario. */
+#define CCSIM_MAX_CHANGES 256
+
+typedef struct ccsim_flow {
+  ngtcp2_cc_algo cc_algo;
+  ngtcp2_tstamp start;
+  /* bytes is the number of bytes to send, or 0 to send until the end
+     of the simulation. */
+  uint64_t bytes;
+  int started;
+  int done;
+  sim_endpoint client, server;
+  sim_sender sender;
+  /* last_received is the number of bytes received by the server as
+     of the last sample. */
+  uint64_t last_received;
+} ccsim_flow;
+
+typedef struct ccsim_change {
+  ngtcp2_tstamp ts;
+  /* ack_link is nonzero if this change applies to the server to
+     client path. */
+  int ack_link;
+  char key[32];
+  double value;
+} ccsim_change;
+
+typedef struct ccsim_scenario {
+  uint64_t seed;
+  ngtcp2_duration duration;
+  ngtcp2_duration sample;
+  sim_link_config link, ack_link;
+  ccsim_flow flows[CCSIM_MAX_FLOWS];
+  size_t nflows;
+  ccsim_change changes[CCSIM_MAX_CHANGES];
+  size_t nchanges;
+} ccsim_scenario;
+
+/*
+ * link_config_set sets the member of |config| named |key| to |value|
+ * in the units used by scenario files.  It returns 0 if it succeeds,
+ * or -1 if |key| is unknown or |value| is out of range.
+ */
+static int link_config_set(sim_link_config *config, const char *key,
+                           double value) {
+  if (value < 0) {
+    return -1;
+  }
+
+  if (strcmp(key, "bandwidth") == 0) {
+    config->bandwidth = (uint64_t)(value * 1000 * 1000);
+  } else if (strcmp(key, "delay") == 0) {
+    config->delay = (ngtcp2_duration)(value * NGTCP2_MILLISECONDS);
+  } else if (strcmp(key, "jitter") == 0) {
+    config->jitter = (ngtcp2_duration)(value * NGTCP2_MILLISECONDS);
+  } else if (strcmp(key, "aggregation") == 0) {
+    config->aggregation = (ngtcp2_duration)(value * NGTCP2_MILLISECONDS);
+  } else if (strcmp(key, "loss") == 0) {
+    if (value >= 100) {
+      return -1;
+    }
+    config->loss = (uint32_t)(value * 10000);
+  } else if (strcmp(key, "reorder") == 0) {
+    if (value > 100) {
+      return -1;
+    }
+    config->reorder = (uint32_t)(value * 10000);
+  } else if (strcmp(key, "queue") == 0) {
+    config->queue = (size_t)(value * 1024);
+  } else if (strcmp(key, "policer_rate") == 0) {
+    config->policer_rate = (uint64_t)(value * 1000 * 1000);
+  } else if (strcmp(key, "policer_burst") == 0) {
+    config->policer_burst = (size_t)(value * 1024);
+  } else {
+    return -1;
+  }
+
+  return 0;
+}
+
+/*
+ * parse_number parses |s| as a non-negative number.  It returns 0 if
+ * it succeeds, or -1.
+ */
+static int parse_number(double *pvalue, const char *s) {
+  char *end;
+  double value = strtod(s, &end);
+
+  if (end == s || *end != '\0' || value < 0) {
+    return -1;
+  }
+
+  *pvalue = value;
+
+  return 0;
+}
+
+/*
+ * parse_seed parses |s| as an unsigned 64-bit integer.  It returns 0
+ * if it succeeds, or -1.
+ */
+static int parse_seed(uint64_t *pseed, const char *s) {
+  char *end;
+  unsigned long long seed;
+
+  if (!isdigit((unsigned char)*s)) {
+    return -1;
+  }
+
+  seed = strtoull(s, &end, 0);
+  if (*end != '\0') {
+    return -1;
+  }
+
+  *pseed = (uint64_t)seed;
+
+  return 0;
+}
+
+/*
+ * split_kv splits |token| of the form KEY=VALUE.  It returns 0 if it
+ * succeeds, or -1.
+ */
+static int split_kv(char **pkey, double *pvalue, char *token) {
+  char *eq = strchr(token, '=');
+
+  if (!eq || eq == token) {
+    return -1;
+  }
+
+  *eq = '\0';
+  *pkey = token;
+
+  return parse_number(pvalue, eq + 1);
+}
+
+static int parse_link(sim_link_config *config, int *pdelay_set) {
+  char *token, *key;
+  double value;
+
+  while ((token = strtok(NULL, " \t")) != NULL) {
+    if (split_kv(&key, &value, token) != 0 ||
+        link_config_set(config, key, value) != 0) {
+      return -1;
+    }
+
+    if (pdelay_set && strcmp(key, "delay") == 0) {
+      *pdelay_set = 1;
+    }
+  }
+
+  return 0;
+}
+
+static int parse_flow(ccsim_scenario *sc) {
+  ccsim_flow *flow;
+  char *token, *key;
+  double value;
+  int cc_set = 0;
+
+  if (sc->nflows == CCSIM_MAX_FLOWS) {
+    return -1;
+  }
+
+  flow = &sc->flows[sc->nflows];
+
+  while ((token = strtok(NULL, " \t")) != NULL) {
+    if (strncmp(token, "cc=", 3) == 0) {
+      if (sim_cc_algo_from_name(&flow->cc_algo, token + 3) != 0) {
+        return -1;
+      }
+
+      cc_set = 1;
+
+      continue;
+    }
+
+    if (split_kv(&key, &value, token) != 0) {
+      return -1;
+    }
+
+    if (strcmp(key, "start") == 0) {
+      flow->start = (ngtcp2_tstamp)(value * NGTCP2_MILLISECONDS);
+    } else if (strcmp(key, "bytes") == 0) {
+      flow->bytes = (uint64_t)(value * 1024);
+    } else {
+      return -1;
+    }
+  }
+
+  if (!cc_set) {
+    return -1;
+  }
+
+  ++sc->nflows;
+
+  return 0;
+}
+
+static int parse_change(ccsim_scenario *sc) {
+  char *token, *key;
+  double value;
+  ngtcp2_tstamp ts;
+  int ack_link;
+  ccsim_change *change;
+  sim_link_config scratch;
+
+  token = strtok(NULL, " \t");
+  if (!token || parse_number(&value, token) != 0) {
+    return -1;
+  }
+
+  ts = (ngtcp2_tstamp)(value * NGTCP2_MILLISECONDS);
+
+  if (sc->nchanges && sc->changes[sc->nchanges - 1].ts > ts) {
+    return -1;
+  }
+
+  token = strtok(NULL, " \t");
+  if (!token) {
+    return -1;
+  }
+
+  if (strcmp(token, "link") == 0) {
+    ack_link = 0;
+  } else if (strcmp(token, "ack_link") == 0) {
+    ack_link = 1;
+  } else {
+    return -1;
+  }
+
+  while ((token = strtok(NULL, " \t")) != NULL) {
+    if (sc->nchanges == CCSIM_MAX_CHANGES ||
+        split_kv(&key, &value, token) != 0 ||
+        strlen(key) >= sizeof(change->key) ||
+        link_config_set(&scratch, key, value) != 0) {
+      return -1;
+    }
+
+    change = &sc->changes[sc->nchanges++];
+    change->ts = ts;
+    change->ack_link = ack_link;
+    strcpy(change->key, key);
+    change->value = value;
+  }
+
+  return 0;
+}
+
+/*
+ * ccsim_load reads the scenario in |path|.  It returns 0 if it
+ * succeeds, or -1.
+ */
+static int ccsim_load(ccsim_scenario *sc, const char *path) {
+  FILE *fp;
+  char line[1024];
+  char *p, *directive;
+  size_t lineno = 0;
+  double value;
+  int ack_delay_set = 0;
+  int rv = 0;
+
+  memset(sc, 0, sizeof(*sc));
+
+  sc->duration = 10 * NGTCP2_SECONDS;
+  sc->sample = 100 * NGTCP2_MILLISECONDS;
+  sc->link.bandwidth = 10 * 1000 * 1000;
+  sc->link.delay = 20 * NGTCP2_MILLISECONDS;
+  sc->link.queue = 64 * 1024;
+
+  fp = fopen(path, "r");
+  if (!fp) {
+    fprintf(stderr, "%s: could not open\n", path);
+    return -1;
+  }
+
+  while (fgets(line, sizeof(line), fp)) {
+    ++lineno;
+
+    p = strchr(line, '#');
+    if (p) {
+      *p = '\0';
+    }
+
+    for (p = line + strlen(line); p != line && isspace((unsigned char)p[-1]);
+         --p)
+      ;
+    *p = '\0';
+
+    directive = strtok(line, " \t");
+    if (!directive) {
+      continue;
+    }
+
+    if (strcmp(directive, "seed") == 0) {
+      p = strtok(NULL, " \t");
+      rv = !p || parse_seed(&sc->seed, p) != 0 ? -1 : 0;
+    } else if (strcmp(directive, "duration") == 0) {
+      p = strtok(NULL, " \t");
+      rv = !p || parse_number(&value, p) != 0 ? -1 : 0;
+      sc->duration = (ngtcp2_duration)(value * NGTCP2_MILLISECONDS);
+    } else if (strcmp(directive, "sample") == 0) {
+      p = strtok(NULL, " \t");
+      rv = !p || parse_number(&value, p) != 0 || value == 0 ? -1 : 0;
+      sc->sample = (ngtcp2_duration)(value * NGTCP2_MILLISECONDS);
+    } else if (strcmp(directive, "link") == 0) {
+      rv = parse_link(&sc->link, NULL);
+    } else if (strcmp(directive, "ack_link") == 0) {
+      rv = parse_link(&sc->ack_link, &ack_delay_set);
+    } else if (strcmp(directive, "flow") == 0) {
+      rv = parse_flow(sc);
+    } else if (strcmp(directive, "at") == 0) {
+      rv = parse_change(sc);
+    } else {
+      rv = -1;
+    }
+
+    if (rv != 0) {
+      fprintf(stderr, "%s:%zu: invalid directive\n", path, lineno);
+      break;
+    }
+  }
+
+  fclose(fp);
+
+  if (rv != 0) {
+    return -1;
+  }
+
+  if (sc->nflows == 0) {
+    fprintf(stderr, "%s: no flow\n", path);
+    return -1;
+  }
+
+  if (!ack_delay_set) {
+    sc->ack_link.delay = sc->link.delay;
+  }
+
+  return 0;
+}
+
+static double to_ms(ngtcp2_duration d) {
+  return (double)d / NGTCP2_MILLISECONDS;
+}
+
+/*
+ * pacing_rate returns the pacing rate of |conn| in Mbps.  It mirrors
+ * the computation in ngtcp2_conn_update_pkt_tx_time.
+ */
+static double pacing_rate(ngtcp2_conn *conn) {
+  const ngtcp2_conn_stat *cstat = &conn->cstat;
+
+  if (cstat->pacing_interval) {
+    return 8. * NGTCP2_SECONDS / (double)cstat->pacing_interval / 1000000;
+  }
+
+  if (cstat->first_rtt_sample_ts == UINT64_MAX || cstat->smoothed_rtt == 0) {
+    return 0;
+  }
+
+  return (double)cstat->cwnd * 8 * 125 / 100 * NGTCP2_SECONDS /
+         (double)cstat->smoothed_rtt / 1000000;
+}
+
+static void ccsim_sample(ccsim_scenario *sc, ngtcp2_tstamp ts) {
+  ngtcp2_conn_info cinfo;
+  ccsim_flow *flow;
+  size_t i;
+
+  for (i = 0; i < sc->nflows; ++i) {
+    flow = &sc->flows[i];
+
+    if (!flow->started) {
+      continue;
+    }
+
+    ngtcp2_conn_get_conn_info(flow->client.conn, &cinfo);
+
+    printf("{\"event\":\"sample\",\"t_ms\":%.3f,\"flow\":%zu,\"cc\":\"%s\","
+           "\"cwnd\":%llu,\"ssthresh\":%llu,\"bytes_in_flight\":%llu,"
+           "\"pacing_rate_mbps\":%.3f,\"srtt_ms\":%.3f,\"min_rtt_ms\":%.3f,"
+           "\"throughput_mbps\":%.3f}\n",
+           to_ms(ts), i, sim_cc_algo_name(flow->cc_algo),
+           (unsigned long long)cinfo.cwnd,
+           (unsigned long long)ngtcp2_min_uint64(cinfo.ssthresh,
+                                                 NGTCP2_MAX_VARINT),
+           (unsigned long long)cinfo.bytes_in_flight,
+           pacing_rate(flow->client.conn), to_ms(cinfo.smoothed_rtt),
+           cinfo.min_rtt == UINT64_MAX ? 0. : to_ms(cinfo.min_rtt),
+           (double)(flow->server.received - flow->last_received) * 8 /
+             (double)sc->sample * NGTCP2_SECONDS / 1000000);
+
+    flow->last_received = flow->server.received;
+  }
+}
+
+static void ccsim_summary(ccsim_scenario *sc) {
+  ngtcp2_conn_stats stats;
+  ccsim_flow *flow;
+  ngtcp2_tstamp end;
+  size_t i;
+
+  for (i = 0; i < sc->nflows; ++i) {
+    flow = &sc->flows[i];
+
+    if (!flow->started) {
+      continue;
+    }
+
+    ngtcp2_conn_get_stats(flow->client.conn, &stats);
+
+    end = flow->server.fin_ts == UINT64_MAX ? sc->duration
+                                            : flow->server.fin_ts;
+
+    printf("{\"event\":\"summary\",\"flow\":%zu,\"cc\":\"%s\",\"bytes\":%llu,"
+           "\"goodput_mbps\":%.3f,\"pkt_lost\":%llu,\"finish_ms\":%.3f}\n",
+           i, sim_cc_algo_name(flow->cc_algo),
+           (unsigned long long)flow->server.received,
+           end > flow->start ? (double)flow->server.received * 8 /
+                                 (double)(end - flow->start) * NGTCP2_SECONDS /
+                                 1000000
+                             : 0.,
+           (unsigned long long)stats.pkt_lost,
+           flow->server.fin_ts == UINT64_MAX ? -1. : to_ms(end));
+  }
+}
+
+/*
+ * ccsim_deliver delivers all packets on |l| which have arrived by
+ * |ts|.  If |to_server| is nonzero, packets are delivered to the
+ * server of each flow, otherwise to the client.
+ */
+static int ccsim_deliver(ccsim_scenario *sc, sim_link *l, int to_server,
+                         const ngtcp2_path *path, ngtcp2_tstamp ts) {
+  ccsim_flow *flow;
+  sim_pkt *pkt;
+  int rv = 0;
+
+  while (sim_link_next_arrival(l) <= ts) {
+    pkt = sim_link_top(l);
+    flow = &sc->flows[pkt->flow];
+
+    if (!flow->done) {
+      rv = sim_endpoint_read(to_server ? &flow->server : &flow->client, path,
+                             pkt->data, pkt->len, ts);
+    }
+
+    sim_link_pop(l);
+
+    if (rv != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static int ccsim_run(ccsim_scenario *sc, const char *client_trace_path,
+                     const char *server_trace_path) {
+  ngtcp2_path_storage ps;
+  sim_trace client_trace = {0}, server_trace = {0};
+  sim_link link, ack_link;
+  ccsim_flow *flow;
+  ccsim_change *change;
+  size_t i, nchanges = 0;
+  ngtcp2_tstamp ts = 0, next, next_sample = sc->sample;
+  int rv = -1;
+
+  path_init(&ps, 0, 0, 0, 0);
+
+  if (sim_link_init(&link, &sc->link, sc->seed) != 0) {
+    fprintf(stderr, "out of memory\n");
+    return -1;
+  }
+
+  if (sim_link_init(&ack_link, &sc->ack_link,
+                    sc->seed ^ 0xa5a5a5a5a5a5a5a5ULL) != 0) {
+    fprintf(stderr, "out of memory\n");
+    sim_link_free(&link);
+    return -1;
+  }
+
+  for (;;) {
+    for (; nchanges < sc->nchanges && sc->changes[nchanges].ts <= ts;
+         ++nchanges) {
+      change = &sc->changes[nchanges];
+
+      link_config_set(change->ack_link ? &sc->ack_link : &sc->link,
+                      change->key, change->value);
+    }
+
+    for (i = 0; i < sc->nflows; ++i) {
+      flow = &sc->flows[i];
+
+      if (flow->started || flow->start > ts) {
+        continue;
+      }
+
+      if (sim_endpoint_init(&flow->client, /* server = */ 0, flow->cc_algo,
+                            NGTCP2_MAX_UDP_PAYLOAD_SIZE, &ps.path,
+                            &ts) != 0 ||
+          sim_endpoint_init(&flow->server, /* server = */ 1, flow->cc_algo,
+                            NGTCP2_MAX_UDP_PAYLOAD_SIZE, &ps.path,
+                            &ts) != 0 ||
+          sim_sender_init(&flow->sender, &flow->client,
+                          flow->bytes ? flow->bytes : NGTCP2_MAX_VARINT) !=
+            0) {
+        fprintf(stderr, "flow %zu: could not create connections\n", i);
+        flow->started = 1;
+        goto fin;
+      }
+
+      flow->started = 1;
+
+      if (i != 0) {
+        continue;
+      }
+
+      if (client_trace_path) {
+        if (sim_trace_open(&client_trace, client_trace_path,
+                           /* server = */ 0, flow->cc_algo,
+                           flow->sender.total) != 0) {
+          goto fin;
+        }
+
+        flow->client.trace = &client_trace;
+      }
+
+      if (server_trace_path) {
+        if (sim_trace_open(&server_trace, server_trace_path,
+                           /* server = */ 1, flow->cc_algo, 0) != 0) {
+          goto fin;
+        }
+
+        flow->server.trace = &server_trace;
+      }
+    }
+
+    for (i = 0; i < sc->nflows; ++i) {
+      flow = &sc->flows[i];
+
+      if (!flow->started || flow->done) {
+        continue;
+      }
+
+      if (sim_endpoint_write(&flow->client, &flow->sender, &link, i, ts) < 0 ||
+          sim_endpoint_write(&flow->server, NULL, &ack_link, i, ts) < 0) {
+        fprintf(stderr, "flow %zu: could not write packets\n", i);
+        goto fin;
+      }
+
+      if (flow->server.fin_ts != UINT64_MAX) {
+        flow->done = 1;
+      }
+    }
+
+    for (; next_sample <= ts && next_sample <= sc->duration;
+         next_sample += sc->sample) {
+      ccsim_sample(sc, next_sample);
+    }
+
+    if (ts >= sc->duration) {
+      break;
+    }
+
+    next = ngtcp2_min_uint64(sim_link_next_arrival(&link),
+                             sim_link_next_arrival(&ack_link));
+    next = ngtcp2_min_uint64(next, next_sample);
+    next = ngtcp2_min_uint64(next, sc->duration);
+
+    if (nchanges < sc->nchanges) {
+      next = ngtcp2_min_uint64(next, sc->changes[nchanges].ts);
+    }
+
+    for (i = 0; i < sc->nflows; ++i) {
+      flow = &sc->flows[i];
+
+      if (!flow->started) {
+        next = ngtcp2_min_uint64(next, flow->start);
+        continue;
+      }
+
+      if (flow->done) {
+        continue;
+      }
+
+      next = ngtcp2_min_uint64(next, ngtcp2_conn_get_expiry(flow->client.conn));
+      next = ngtcp2_min_uint64(next, ngtcp2_conn_get_expiry(flow->server.conn));
+    }
+
+    ts = ngtcp2_max_uint64(ts, next);
+
+    if (ccsim_deliver(sc, &link, /* to_server = */ 1, &ps.path, ts) != 0 ||
+        ccsim_deliver(sc, &ack_link, /* to_server = */ 0, &ps.path, ts) !=
+          0) {
+      goto fin;
+    }
+
+    for (i = 0; i < sc->nflows; ++i) {
+      flow = &sc->flows[i];
+
+      if (!flow->started || flow->done) {
+        continue;
+      }
+
+      if (sim_endpoint_handle_expiry(&flow->client, ts) != 0 ||
+          sim_endpoint_handle_expiry(&flow->server, ts) != 0) {
+        fprintf(stderr, "flow %zu: timer failed\n", i);
+        goto fin;
+      }
+    }
+  }
+
+  ccsim_summary(sc);
+
+  rv = 0;
+
+fin:
+  for (i = 0; i < sc->nflows; ++i) {
+    flow = &sc->flows[i];
+
+    if (flow->started) {
+      sim_endpoint_free(&flow->server);
+      sim_endpoint_free(&flow->client);
+    }
+  }
+
+  sim_trace_close(&server_trace);
+  sim_trace_close(&client_trace);
+  sim_link_free(&ack_link);
+  sim_link_free(&link);
+
+  return rv;
+}
+
+int main(int argc, char **argv) {
+  static ccsim_scenario sc;
+  const char *path = NULL;
+  const char *cc = NULL;
+  const char *seed = NULL;
+  const char *client_trace = NULL;
+  const char *server_trace = NULL;
+  ngtcp2_cc_algo cc_algo;
+  size_t i;
+  int n;
+
+  for (n = 1; n < argc; ++n) {
+    if (strcmp(argv[n], "-c") == 0 && n + 1 < argc) {
+      cc = argv[++n];
+      continue;
+    }
+
+    if (strcmp(argv[n], "-s") == 0 && n + 1 < argc) {
+      seed = argv[++n];
+      continue;
+    }
+
+    if (strcmp(argv[n], "-t") == 0 && n + 1 < argc) {
+      client_trace = argv[++n];
+      continue;
+    }
+
+    if (strcmp(argv[n], "-T") == 0 && n + 1 < argc) {
+      server_trace = argv[++n];
+      continue;
+    }
+
+    path = argv[n];
+  }
+
+  if (!path) {
+    fprintf(stderr,
+            "Usage: ccsim [-c CC] [-s SEED] [-t TRACE] [-T TRACE] SCENARIO\n");
+    return EXIT_FAILURE;
+  }
+
+  if (ccsim_load(&sc, path) != 0) {
+    return EXIT_FAILURE;
+  }
+
+  if (cc) {
+    if (sim_cc_algo_from_name(&cc_algo, cc) != 0) {
+      fprintf(stderr, "-c: unknown congestion controller %s\n", cc);
+      return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < sc.nflows; ++i) {
+      sc.flows[i].cc_algo = cc_algo;
+    }
+  }
+
+  if (seed) {
+    if (parse_seed(&sc.seed, seed) != 0) {
+      fprintf(stderr, "-s: invalid seed %s\n", seed);
+      return EXIT_FAILURE;
+    }
+  }
+
+  return ccsim_run(&sc, client_trace, server_trace) == 0 ? EXIT_SUCCESS
+                                                         : EXIT_FAILURE;
+}
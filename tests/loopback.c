@@ -0,0 +1,338 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * loopback runs a client and a server connection in a single process,
+ * connected by an emulated link, and measures a bulk transfer from
+ * the client to the server for each congestion controller.  Both
+ * endpoints start in post-handshake state with null crypto, so that
+ * only the transport is measured.
+ *
+ * The link is deterministic.  It models a bottleneck of the given
+ * bandwidth with a tail-drop queue, a one-way propagation delay, and
+ * random loss and reordering driven by a fixed seed.  The simulation
+ * runs on a virtual clock, so the results do not depend on the speed
+ * of the host except for the CPU cost.
+ *
+ * The link drops packets larger than its MTU.  Both endpoints run
+ * PMTUD up to the MTU of the link, so that jumbo frames are exercised
+ * with -m 9000.
+ *
+ * The result is written to stdout as a JSON object per congestion
+ * controller:
+ *
+ * {"cc":"cubic","mtu":1500,"max_udp_payload_size":1452,"bytes":...,
+ *  "duration_ms":...,"goodput_mbps":...,"cpu_ns_per_byte":...,
+ *  "cycles_per_byte":...,"pkts_per_ack":...,
+ *  "retransmission_ratio":...,"pkt_lost":...,"link_drops":...}
+ *
+ * "max_udp_payload_size" is the UDP payload size that the client has
+ * reached by PMTUD at the end of the transfer.
+ * "cycles_per_byte" is only reported on x86 where the time stamp
+ * counter is available.  "pkts_per_ack" is the number of packets sent
+ * by the client divided by the number of packets sent by the server,
+ * which are all ACK-only packets.
+ *
+ * Usage: loopback [-b MBPS] [-d DELAY_MS] [-l LOSS_PCT] [-o REORDER_PCT]
+ *                 [-q QUEUE_KB] [-m MTU] [-n MBYTES] [-s SEED] [CC]
+ *
+ * If CC is given, only that congestion controller (reno, cubic, or
+ * bbr) is run.
+ */
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#  define LOOPBACK_HAVE_TSC 1
+#endif /* __x86_64__ || __i386__ */
+
+#include "ngtcp2_macro.h"
+#include "ngtcp2_test_helper.h"
+#include "sim.h"
+
+/* LOOPBACK_DEADLINE is the virtual time after which a transfer is
+   abandoned. */
+#define LOOPBACK_DEADLINE (600 * NGTCP2_SECONDS)
+
+/*
+ * loopback_read delivers all packets on |l| which have arrived by
+ * |ts| to |ep|.
+ */
+static int loopback_read(sim_endpoint *ep, sim_link *l,
+                         const ngtcp2_path *path, ngtcp2_tstamp ts) {
+  sim_pkt *pkt;
+  int rv;
+
+  while (sim_link_next_arrival(l) <= ts) {
+    pkt = sim_link_top(l);
+    rv = sim_endpoint_read(ep, path, pkt->data, pkt->len, ts);
+
+    sim_link_pop(l);
+
+    if (rv != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static uint64_t cpu_now(void) {
+  struct timespec tp;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tp);
+
+  return (uint64_t)tp.tv_sec * NGTCP2_SECONDS + (uint64_t)tp.tv_nsec;
+}
+
+static uint64_t cycles_now(void) {
+#ifdef LOOPBACK_HAVE_TSC
+  return __rdtsc();
+#else  /* !LOOPBACK_HAVE_TSC */
+  return 0;
+#endif /* !LOOPBACK_HAVE_TSC */
+}
+
+/*
+ * loopback_run transfers |total| bytes from client to server over a
+ * link configured by |config|, and prints the result.
+ */
+static int loopback_run(ngtcp2_cc_algo cc_algo,
+                        const sim_link_config *config, uint64_t total,
+                        uint64_t seed) {
+  ngtcp2_path_storage ps;
+  sim_endpoint client, server;
+  sim_link c2s, s2c;
+  sim_sender s;
+  ngtcp2_conn_stats cstats, sstats;
+  ngtcp2_tstamp ts = 0, next;
+  uint64_t cpu_start, cycles_start, cpu, cycles;
+  int rv = -1;
+
+  memset(&client, 0, sizeof(client));
+  memset(&server, 0, sizeof(server));
+
+  path_init(&ps, 0, 0, 0, 0);
+
+  if (sim_link_init(&c2s, config, seed) != 0) {
+    fprintf(stderr, "out of memory\n");
+    return -1;
+  }
+
+  if (sim_link_init(&s2c, config, seed ^ 0xa5a5a5a5a5a5a5a5ULL) != 0) {
+    fprintf(stderr, "out of memory\n");
+    sim_link_free(&c2s);
+    return -1;
+  }
+
+  if (sim_endpoint_init(&client, /* server = */ 0, cc_algo,
+                        config->mtu - SIM_PKT_OVERHEAD, &ps.path, &ts) != 0 ||
+      sim_endpoint_init(&server, /* server = */ 1, cc_algo,
+                        config->mtu - SIM_PKT_OVERHEAD, &ps.path, &ts) != 0) {
+    fprintf(stderr, "could not create connections\n");
+    goto fin;
+  }
+
+  if (sim_sender_init(&s, &client, total) != 0) {
+    fprintf(stderr, "could not open stream\n");
+    goto fin;
+  }
+
+  cpu_start = cpu_now();
+  cycles_start = cycles_now();
+
+  for (;;) {
+    if (sim_endpoint_write(&client, &s, &c2s, 0, ts) < 0 ||
+        sim_endpoint_write(&server, NULL, &s2c, 0, ts) < 0) {
+      goto fin;
+    }
+
+    if (server.fin_ts != UINT64_MAX) {
+      break;
+    }
+
+    next = ngtcp2_min_uint64(sim_link_next_arrival(&c2s),
+                             sim_link_next_arrival(&s2c));
+    next = ngtcp2_min_uint64(next, ngtcp2_conn_get_expiry(client.conn));
+    next = ngtcp2_min_uint64(next, ngtcp2_conn_get_expiry(server.conn));
+
+    if (next >= LOOPBACK_DEADLINE) {
+      fprintf(stderr, "%s: transfer did not finish\n",
+              sim_cc_algo_name(cc_algo));
+      goto fin;
+    }
+
+    ts = ngtcp2_max_uint64(ts, next);
+
+    if (loopback_read(&server, &c2s, &ps.path, ts) != 0 ||
+        loopback_read(&client, &s2c, &ps.path, ts) != 0 ||
+        sim_endpoint_handle_expiry(&client, ts) != 0 ||
+        sim_endpoint_handle_expiry(&server, ts) != 0) {
+      goto fin;
+    }
+  }
+
+  cpu = cpu_now() - cpu_start;
+  cycles = cycles_now() - cycles_start;
+
+  ngtcp2_conn_get_stats(client.conn, &cstats);
+  ngtcp2_conn_get_stats(server.conn, &sstats);
+
+  printf("{\"cc\":\"%s\",\"mtu\":%zu,\"max_udp_payload_size\":%zu,"
+         "\"bytes\":%llu,\"duration_ms\":%.3f,"
+         "\"goodput_mbps\":%.3f,\"cpu_ns_per_byte\":%.3f,",
+         sim_cc_algo_name(cc_algo), config->mtu,
+         ngtcp2_conn_get_path_max_tx_udp_payload_size(client.conn),
+         (unsigned long long)server.received,
+         (double)server.fin_ts / NGTCP2_MILLISECONDS,
+         server.fin_ts ? (double)server.received * 8 * 1000 /
+                           (double)server.fin_ts
+                       : 0.,
+         (double)cpu / (double)server.received);
+#ifdef LOOPBACK_HAVE_TSC
+  printf("\"cycles_per_byte\":%.3f,", (double)cycles / (double)server.received);
+#else  /* !LOOPBACK_HAVE_TSC */
+  (void)cycles;
+#endif /* !LOOPBACK_HAVE_TSC */
+  printf("\"pkts_per_ack\":%.3f,\"retransmission_ratio\":%.6f,"
+         "\"pkt_lost\":%llu,\"link_drops\":%llu}\n",
+         sstats.pkt_sent ? (double)cstats.pkt_sent / (double)sstats.pkt_sent
+                         : 0.,
+         (double)cstats.stream_bytes_retransmitted / (double)total,
+         (unsigned long long)cstats.pkt_lost,
+         (unsigned long long)(c2s.drops + s2c.drops));
+
+  rv = 0;
+
+fin:
+  sim_endpoint_free(&server);
+  sim_endpoint_free(&client);
+  sim_link_free(&s2c);
+  sim_link_free(&c2s);
+
+  return rv;
+}
+
+int main(int argc, char **argv) {
+  sim_link_config config = {
+    .bandwidth = 100 * 1000 * 1000,
+    .delay = 10 * NGTCP2_MILLISECONDS,
+    .loss = 0,
+    .reorder = 0,
+    .queue = 256 * 1024,
+    .mtu = SIM_DEFAULT_MTU,
+  };
+  static const ngtcp2_cc_algo cc_algos[] = {
+    NGTCP2_CC_ALGO_RENO,
+    NGTCP2_CC_ALGO_CUBIC,
+    NGTCP2_CC_ALGO_BBR,
+  };
+  uint64_t total = 16 * 1024 * 1024;
+  uint64_t seed = 0;
+  const char *filter = NULL;
+  const char *opt;
+  double v;
+  size_t i;
+  int n;
+  int rv = EXIT_SUCCESS;
+
+  for (n = 1; n < argc; ++n) {
+    if (argv[n][0] != '-' || argv[n][1] == '\0' || argv[n][2] != '\0') {
+      filter = argv[n];
+      continue;
+    }
+
+    if (n + 1 == argc) {
+      fprintf(stderr, "%s: missing argument\n", argv[n]);
+      return EXIT_FAILURE;
+    }
+
+    opt = argv[n];
+    v = strtod(argv[++n], NULL);
+
+    if (v < 0) {
+      fprintf(stderr, "%s: argument must not be negative\n", opt);
+      return EXIT_FAILURE;
+    }
+
+    switch (opt[1]) {
+    case 'b':
+      config.bandwidth = (uint64_t)(v * 1000 * 1000);
+      break;
+    case 'd':
+      config.delay = (ngtcp2_duration)(v * NGTCP2_MILLISECONDS);
+      break;
+    case 'l':
+      config.loss = (uint32_t)(v * 10000);
+      break;
+    case 'o':
+      config.reorder = (uint32_t)(v * 10000);
+      break;
+    case 'q':
+      config.queue = (size_t)(v * 1024);
+      break;
+    case 'm':
+      config.mtu = (size_t)v;
+      break;
+    case 'n':
+      total = (uint64_t)(v * 1024 * 1024);
+      break;
+    case 's':
+      seed = (uint64_t)v;
+      break;
+    default:
+      fprintf(stderr, "%s: unknown option\n", opt);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (config.bandwidth == 0 || total == 0 ||
+      config.mtu < NGTCP2_MAX_UDP_PAYLOAD_SIZE + SIM_PKT_OVERHEAD ||
+      config.mtu > SIM_MAX_MTU || config.queue < config.mtu ||
+      config.loss >= 1000000) {
+    fprintf(stderr, "invalid link configuration\n");
+    return EXIT_FAILURE;
+  }
+
+  for (i = 0; i < ngtcp2_arraylen(cc_algos); ++i) {
+    if (filter && strcmp(sim_cc_algo_name(cc_algos[i]), filter) != 0) {
+      continue;
+    }
+
+    if (loopback_run(cc_algos[i], &config, total, seed) != 0) {
+      rv = EXIT_FAILURE;
+    }
+  }
+
+  return rv;
+}
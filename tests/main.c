@@ -54,6 +54,8 @@
 #include "ngtcp2_window_filter_test.h"
 #include "ngtcp2_settings_test.h"
 #include "ngtcp2_ppe_test.h"
+#include "ngtcp2_timer_wheel_test.h"
+#include "ngtcp2_histogram_test.h"
 
 int main(int argc, char *argv[]) {
   const MunitSuite suites[] = {
@@ -81,6 +83,8 @@ int main(int argc, char *argv[]) {
       window_filter_suite,
       settings_suite,
       ppe_suite,
+      timer_wheel_suite,
+      histogram_suite,
       {NULL, NULL, NULL, 0, MUNIT_SUITE_OPTION_NONE},
   };
   const MunitSuite suite = {
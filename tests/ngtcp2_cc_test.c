@@ -26,12 +26,14 @@
 
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
 
 #include "ngtcp2_cc.h"
 #include "ngtcp2_test_helper.h"
 
 static const MunitTest tests[] = {
     munit_void_test(test_ngtcp2_cbrt),
+    munit_void_test(test_ngtcp2_cc_cr),
     munit_test_end(),
 };
 
@@ -53,3 +55,148 @@ void test_ngtcp2_cbrt(void) {
   assert_uint64(2642245, ==, ngtcp2_cbrt(UINT64_MAX));
   assert_uint64(0, ==, ngtcp2_cbrt(0));
 }
+
+static void cc_cr_conn_stat_init(ngtcp2_conn_stat *cstat) {
+  memset(cstat, 0, sizeof(*cstat));
+
+  cstat->cwnd = 12000;
+  cstat->ssthresh = UINT64_MAX;
+  cstat->min_rtt = UINT64_MAX;
+  cstat->max_tx_udp_payload_size = 1200;
+  cstat->congestion_recovery_start_ts = UINT64_MAX;
+}
+
+void test_ngtcp2_cc_cr(void) {
+  ngtcp2_log log;
+  ngtcp2_cc_reno reno;
+  ngtcp2_cc_cr cr;
+  ngtcp2_cc *cc = &cr.cc;
+  ngtcp2_conn_stat cstat;
+  ngtcp2_cc_pkt pkt;
+
+  ngtcp2_log_init(&log, NULL, NULL, 0, NULL);
+
+  /* Jump is validated */
+  cc_cr_conn_stat_init(&cstat);
+  ngtcp2_cc_reno_init(&reno, &log);
+  ngtcp2_cc_cr_init(&cr, &reno.cc, &log, 100000, 50 * NGTCP2_MILLISECONDS);
+
+  /* No RTT sample yet */
+  cstat.bytes_in_flight = 12000;
+  cc->on_pkt_sent(cc, &cstat,
+                  ngtcp2_cc_pkt_init(&pkt, 0, 1200,
+                                     NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0));
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_RECONNAISSANCE, ==,
+              cr.phase);
+  assert_uint64(12000, ==, cstat.cwnd);
+
+  cstat.min_rtt = 40 * NGTCP2_MILLISECONDS;
+  cc->on_pkt_sent(cc, &cstat,
+                  ngtcp2_cc_pkt_init(&pkt, 9, 1200,
+                                     NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0));
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_UNVALIDATED, ==,
+              cr.phase);
+  assert_uint64(50000, ==, cstat.cwnd);
+  assert_uint64(12000, ==, cr.pipesize);
+  assert_int64(10, ==, cr.first_unvalidated_pkt_num);
+
+  cstat.bytes_in_flight = 20000;
+  cc->on_pkt_sent(cc, &cstat,
+                  ngtcp2_cc_pkt_init(&pkt, 10, 1200,
+                                     NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0));
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_UNVALIDATED, ==,
+              cr.phase);
+  assert_int64(10, ==, cr.last_unvalidated_pkt_num);
+
+  /* The congestion window does not grow in unvalidated phase. */
+  cc->on_pkt_acked(cc, &cstat,
+                   ngtcp2_cc_pkt_init(&pkt, 0, 1200,
+                                      NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0),
+                   0);
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_UNVALIDATED, ==,
+              cr.phase);
+  assert_uint64(50000, ==, cstat.cwnd);
+  assert_uint64(13200, ==, cr.pipesize);
+
+  cstat.bytes_in_flight = 50000;
+  cc->on_pkt_sent(cc, &cstat,
+                  ngtcp2_cc_pkt_init(&pkt, 11, 1200,
+                                     NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0));
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_VALIDATING, ==,
+              cr.phase);
+  assert_int64(11, ==, cr.last_unvalidated_pkt_num);
+
+  cc->on_pkt_acked(cc, &cstat,
+                   ngtcp2_cc_pkt_init(&pkt, 11, 1200,
+                                      NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0),
+                   0);
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_NORMAL, ==, cr.phase);
+  assert_uint64(14400, ==, cr.pipesize);
+
+  /* Congestion during validation */
+  cc_cr_conn_stat_init(&cstat);
+  ngtcp2_cc_reno_init(&reno, &log);
+  ngtcp2_cc_cr_init(&cr, &reno.cc, &log, 100000, 50 * NGTCP2_MILLISECONDS);
+
+  cstat.min_rtt = 60 * NGTCP2_MILLISECONDS;
+  cstat.bytes_in_flight = 12000;
+  cc->on_pkt_sent(cc, &cstat,
+                  ngtcp2_cc_pkt_init(&pkt, 9, 1200,
+                                     NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0));
+  cc->on_pkt_sent(cc, &cstat,
+                  ngtcp2_cc_pkt_init(&pkt, 10, 1200,
+                                     NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0));
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_UNVALIDATED, ==,
+              cr.phase);
+
+  cc->congestion_event(cc, &cstat, 0, 1);
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_SAFE_RETREAT, ==,
+              cr.phase);
+  assert_uint64(6000, ==, cstat.cwnd);
+  assert_uint64(6000, ==, cstat.ssthresh);
+
+  cc->on_pkt_acked(cc, &cstat,
+                   ngtcp2_cc_pkt_init(&pkt, 10, 1200,
+                                      NGTCP2_PKTNS_ID_APPLICATION, 2, 0, 0, 0),
+                   3);
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_NORMAL, ==, cr.phase);
+  assert_uint64(6000, ==, cstat.cwnd);
+  assert_uint64(13200, ==, cstat.ssthresh);
+
+  /* RTT has changed significantly */
+  cc_cr_conn_stat_init(&cstat);
+  ngtcp2_cc_reno_init(&reno, &log);
+  ngtcp2_cc_cr_init(&cr, &reno.cc, &log, 100000, 50 * NGTCP2_MILLISECONDS);
+
+  cstat.min_rtt = 10 * NGTCP2_MILLISECONDS;
+  cstat.bytes_in_flight = 12000;
+  cc->on_pkt_sent(cc, &cstat,
+                  ngtcp2_cc_pkt_init(&pkt, 0, 1200,
+                                     NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0));
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_NORMAL, ==, cr.phase);
+  assert_uint64(12000, ==, cstat.cwnd);
+
+  /* Saved capacity is too small to gain anything */
+  cc_cr_conn_stat_init(&cstat);
+  ngtcp2_cc_reno_init(&reno, &log);
+  ngtcp2_cc_cr_init(&cr, &reno.cc, &log, 20000, 50 * NGTCP2_MILLISECONDS);
+
+  cstat.min_rtt = 50 * NGTCP2_MILLISECONDS;
+  cstat.bytes_in_flight = 12000;
+  cc->on_pkt_sent(cc, &cstat,
+                  ngtcp2_cc_pkt_init(&pkt, 0, 1200,
+                                     NGTCP2_PKTNS_ID_APPLICATION, 0, 0, 0, 0));
+
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_NORMAL, ==, cr.phase);
+  assert_uint64(12000, ==, cstat.cwnd);
+}
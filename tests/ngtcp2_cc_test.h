@@ -36,5 +36,6 @@
 extern const MunitSuite cc_suite;
 
 munit_void_test_decl(test_ngtcp2_cbrt);
+munit_void_test_decl(test_ngtcp2_cc_cr);
 
 #endif /* NGTCP2_CC_TEST_H */
@@ -95,7 +95,9 @@ static const MunitTest tests[] = {
     munit_void_test(test_ngtcp2_conn_write_application_close),
     munit_void_test(test_ngtcp2_conn_rtb_reclaim_on_pto),
     munit_void_test(test_ngtcp2_conn_rtb_reclaim_on_pto_datagram),
+    munit_void_test(test_ngtcp2_conn_qlog_flight_recorder),
     munit_void_test(test_ngtcp2_conn_validate_ecn),
+    munit_void_test(test_ngtcp2_conn_read_timestamped_pkt),
     munit_void_test(test_ngtcp2_conn_path_validation),
     munit_void_test(test_ngtcp2_conn_early_data_sync_stream_data_limit),
     munit_void_test(test_ngtcp2_conn_tls_early_data_rejected),
@@ -106,9 +108,17 @@ static const MunitTest tests[] = {
     munit_void_test(test_ngtcp2_conn_buffer_pkt),
     munit_void_test(test_ngtcp2_conn_handshake_timeout),
     munit_void_test(test_ngtcp2_conn_get_ccerr),
+    munit_void_test(test_ngtcp2_conn_path_capacity),
+    munit_void_test(test_ngtcp2_conn_get_stats),
+    munit_void_test(test_ngtcp2_conn_histogram),
     munit_void_test(test_ngtcp2_conn_version_negotiation),
     munit_void_test(test_ngtcp2_conn_server_negotiate_version),
     munit_void_test(test_ngtcp2_conn_pmtud_loss),
+    munit_void_test(test_ngtcp2_conn_pmtud_black_hole),
+    munit_void_test(test_ngtcp2_conn_pmtud_hint),
+    munit_void_test(test_ngtcp2_conn_pmtud_jumbo),
+    munit_void_test(test_ngtcp2_conn_timer_wheel),
+    munit_void_test(test_ngtcp2_conn_timer_wheel_update),
     munit_void_test(test_ngtcp2_conn_amplification),
     munit_void_test(test_ngtcp2_conn_encode_0rtt_transport_params),
     munit_void_test(test_ngtcp2_conn_create_ack_frame),
@@ -9475,6 +9485,111 @@ void test_ngtcp2_conn_rtb_reclaim_on_pto(void) {
   ngtcp2_conn_del(conn);
 }
 
+static void count_qlog_write(void *user_data, uint32_t flags,
+                             const void *data, size_t datalen) {
+  size_t *pwritten = user_data;
+  (void)flags;
+  (void)data;
+
+  *pwritten += datalen;
+}
+
+void test_ngtcp2_conn_qlog_flight_recorder(void) {
+  ngtcp2_conn *conn;
+  ngtcp2_settings settings;
+  ngtcp2_transport_params params;
+  int rv;
+  int64_t stream_id;
+  uint8_t buf[2048];
+  ngtcp2_ssize nwrite;
+  ngtcp2_ssize spktlen;
+  size_t written;
+
+  /* Flush on consecutive PTOs */
+  client_default_settings(&settings);
+  client_default_transport_params(&params);
+  settings.qlog_write = count_qlog_write;
+  settings.qlog_flight_recorder_size = 4096;
+  settings.qlog_flight_recorder_pto_count = 2;
+
+  setup_default_client_settings(&conn, &null_path.path, &settings, &params);
+
+  written = 0;
+  conn->qlog.user_data = &written;
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                     &nwrite, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                     stream_id, null_data, 1024, 1);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  rv = ngtcp2_conn_on_loss_detection_timer(conn, 3 * NGTCP2_SECONDS);
+
+  assert_int(0, ==, rv);
+  assert_size(1, ==, conn->cstat.pto_count);
+  assert_size(0, ==, written);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf),
+                                  3 * NGTCP2_SECONDS);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  rv = ngtcp2_conn_on_loss_detection_timer(conn, 6 * NGTCP2_SECONDS);
+
+  assert_int(0, ==, rv);
+  assert_size(2, ==, conn->cstat.pto_count);
+  assert_size(0, <, written);
+
+  ngtcp2_conn_del(conn);
+
+  /* Flush by application */
+  setup_default_client_settings(&conn, &null_path.path, &settings, &params);
+
+  written = 0;
+  conn->qlog.user_data = &written;
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                     &nwrite, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                     stream_id, null_data, 1024, 1);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_size(0, ==, written);
+
+  ngtcp2_conn_flush_qlog(conn);
+
+  assert_size(0, <, written);
+
+  ngtcp2_conn_del(conn);
+
+  /* Nothing is written if flush is not triggered. */
+  setup_default_client_settings(&conn, &null_path.path, &settings, &params);
+
+  written = 0;
+  conn->qlog.user_data = &written;
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                     &nwrite, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                     stream_id, null_data, 1024, 1);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  ngtcp2_conn_del(conn);
+
+  assert_size(0, ==, written);
+}
+
 void test_ngtcp2_conn_rtb_reclaim_on_pto_datagram(void) {
   ngtcp2_conn *conn;
   int rv;
@@ -9849,6 +9964,74 @@ void test_ngtcp2_conn_validate_ecn(void) {
   ngtcp2_conn_del(conn);
 }
 
+void test_ngtcp2_conn_read_timestamped_pkt(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[2048];
+  ngtcp2_ssize spktlen;
+  size_t pktlen;
+  int rv;
+  ngtcp2_frame fr;
+  int64_t stream_id;
+  ngtcp2_ssize nwrite;
+  int64_t pkt_num = 0;
+  ngtcp2_tstamp t = 0;
+
+  setup_default_client(&conn);
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                     &nwrite, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                     stream_id, null_data, 1024, t);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  /* RTT sample is taken from the time when ACK is received, not when
+     it is processed. */
+  fr.type = NGTCP2_FRAME_ACK;
+  fr.ack.largest_ack = conn->pktns.tx.last_pkt_num;
+  fr.ack.ack_delay = 0;
+  fr.ack.first_ack_range = 0;
+  fr.ack.rangecnt = 0;
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, ++pkt_num, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+  rv = ngtcp2_conn_read_timestamped_pkt(conn, &null_path.path, &null_pi, buf,
+                                        pktlen, t + 10 * NGTCP2_MILLISECONDS,
+                                        t + 30 * NGTCP2_MILLISECONDS);
+
+  assert_int(0, ==, rv);
+  assert_uint64(10 * NGTCP2_MILLISECONDS, ==, conn->cstat.latest_rtt);
+  assert_uint64(t + 10 * NGTCP2_MILLISECONDS, ==,
+                conn->pktns.rx.max_pkt_ts);
+
+  t += 30 * NGTCP2_MILLISECONDS;
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                     &nwrite, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                     stream_id, null_data, 1024, t);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  /* Receive timestamp in the future is capped by the current time. */
+  fr.ack.largest_ack = conn->pktns.tx.last_pkt_num;
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, ++pkt_num, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+  rv = ngtcp2_conn_read_timestamped_pkt(conn, &null_path.path, &null_pi, buf,
+                                        pktlen, t + 50 * NGTCP2_MILLISECONDS,
+                                        t + 20 * NGTCP2_MILLISECONDS);
+
+  assert_int(0, ==, rv);
+  assert_uint64(20 * NGTCP2_MILLISECONDS, ==, conn->cstat.latest_rtt);
+  assert_uint64(t + 20 * NGTCP2_MILLISECONDS, ==,
+                conn->pktns.rx.max_pkt_ts);
+
+  ngtcp2_conn_del(conn);
+}
+
 void test_ngtcp2_conn_path_validation(void) {
   ngtcp2_conn *conn;
   uint8_t buf[2048];
@@ -10907,6 +11090,202 @@ void test_ngtcp2_conn_get_ccerr(void) {
   ngtcp2_conn_del(conn);
 }
 
+void test_ngtcp2_conn_path_capacity(void) {
+  ngtcp2_conn *conn;
+  ngtcp2_path_capacity cap;
+  int rv;
+
+  /* No RTT sample */
+  setup_default_server(&conn);
+
+  rv = ngtcp2_conn_get_path_capacity(conn, &cap);
+
+  assert_int(NGTCP2_ERR_INVALID_STATE, ==, rv);
+
+  conn->cstat.min_rtt = 30 * NGTCP2_MILLISECONDS;
+  conn->cstat.cwnd = 1000000;
+  conn->cstat.delivery_rate_sec = 1000000000;
+
+  rv = ngtcp2_conn_get_path_capacity(conn, &cap);
+
+  assert_int(0, ==, rv);
+  assert_uint64(1000000, ==, cap.cwnd);
+  assert_uint64(30 * NGTCP2_MILLISECONDS, ==, cap.min_rtt);
+  assert_uint64(1000000000, ==, cap.delivery_rate_sec);
+
+  /* Handshake has completed */
+  rv = ngtcp2_conn_set_path_capacity(conn, &cap);
+
+  assert_int(NGTCP2_ERR_INVALID_STATE, ==, rv);
+
+  ngtcp2_conn_del(conn);
+
+  /* Import path capacity during handshake */
+  setup_handshake_server(&conn);
+
+  cap.cwnd = 0;
+
+  rv = ngtcp2_conn_set_path_capacity(conn, &cap);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==, rv);
+
+  cap.cwnd = 1000000;
+  cap.min_rtt = UINT64_MAX;
+
+  rv = ngtcp2_conn_set_path_capacity(conn, &cap);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==, rv);
+
+  cap.min_rtt = 30 * NGTCP2_MILLISECONDS;
+
+  rv = ngtcp2_conn_set_path_capacity(conn, &cap);
+
+  assert_int(0, ==, rv);
+  assert_true(conn->flags & NGTCP2_CONN_FLAG_CAREFUL_RESUME);
+  assert_ptr_equal(&conn->cr.cc, conn->in_pktns->rtb.cc);
+  assert_ptr_equal(&conn->cr.cc, conn->hs_pktns->rtb.cc);
+  assert_ptr_equal(&conn->cr.cc, conn->pktns.rtb.cc);
+  assert_ptr_equal(&conn->cc, conn->cr.inner);
+  assert_enum(ngtcp2_cc_cr_phase, NGTCP2_CC_CR_PHASE_RECONNAISSANCE, ==,
+              conn->cr.phase);
+
+  rv = ngtcp2_conn_set_path_capacity(conn, &cap);
+
+  assert_int(NGTCP2_ERR_INVALID_STATE, ==, rv);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_get_stats(void) {
+  ngtcp2_conn *conn;
+  int rv;
+  int64_t stream_id;
+  uint8_t buf[2048];
+  ngtcp2_ssize nwrite;
+  ngtcp2_ssize spktlen;
+  ngtcp2_conn_stats stats;
+
+  setup_default_client(&conn);
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                     &nwrite, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                     stream_id, null_data, 1024, 0);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  /* Nothing to send */
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf),
+                                  NGTCP2_MILLISECONDS);
+
+  assert_ptrdiff(0, ==, spktlen);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf),
+                                  5 * NGTCP2_MILLISECONDS);
+
+  assert_ptrdiff(0, ==, spktlen);
+
+  rv = ngtcp2_conn_on_loss_detection_timer(conn, 3 * NGTCP2_SECONDS);
+
+  assert_int(0, ==, rv);
+
+  ngtcp2_conn_get_stats(conn, &stats);
+
+  assert_uint64(1, ==, stats.pkt_sent);
+  assert_uint64(0, <, stats.bytes_sent);
+  assert_uint64(0, ==, stats.pkt_recv);
+  assert_uint64(0, ==, stats.pkt_lost);
+  assert_uint64(1, ==, stats.pto_count);
+  assert_uint64(0, ==, stats.cwnd_limited_duration);
+  assert_uint64(4 * NGTCP2_MILLISECONDS, ==, stats.app_limited_duration);
+  assert_uint64(0, ==, stats.flow_control_limited_duration);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_histogram(void) {
+  ngtcp2_conn *conn;
+  ngtcp2_settings settings;
+  ngtcp2_transport_params params;
+  int rv;
+  int64_t stream_id;
+  uint8_t buf[2048];
+  ngtcp2_ssize nwrite;
+  ngtcp2_ssize spktlen;
+  size_t pktlen;
+  ngtcp2_frame fr;
+  const ngtcp2_histogram *h;
+
+  /* Histograms are not collected by default. */
+  setup_default_client(&conn);
+
+  assert_null(ngtcp2_conn_get_histogram(conn, NGTCP2_HISTOGRAM_TYPE_RTT));
+
+  ngtcp2_conn_del(conn);
+
+  client_default_settings(&settings);
+  client_default_transport_params(&params);
+  settings.histograms = 1;
+
+  setup_default_client_settings(&conn, &null_path.path, &settings, &params);
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                     &nwrite, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                     stream_id, null_data, 1024, 0);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  fr.type = NGTCP2_FRAME_ACK;
+  fr.ack.largest_ack = conn->pktns.tx.last_pkt_num;
+  /* The ack_delay_exponent of the remote endpoint is 0. */
+  fr.ack.ack_delay = 1000;
+  fr.ack.first_ack_range = 0;
+  fr.ack.rangecnt = 0;
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, 0, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, &null_pi, buf, pktlen,
+                            30 * NGTCP2_MILLISECONDS);
+
+  assert_int(0, ==, rv);
+
+  fr.type = NGTCP2_FRAME_PING;
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, 1, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, &null_pi, buf, pktlen,
+                            35 * NGTCP2_MILLISECONDS);
+
+  assert_int(0, ==, rv);
+
+  h = ngtcp2_conn_get_histogram(conn, NGTCP2_HISTOGRAM_TYPE_RTT);
+
+  assert_not_null(h);
+  assert_uint64(1, ==, h->count);
+  assert_uint64(30 * NGTCP2_MILLISECONDS, ==, h->max);
+
+  h = ngtcp2_conn_get_histogram(conn, NGTCP2_HISTOGRAM_TYPE_ACK_DELAY);
+
+  assert_not_null(h);
+  assert_uint64(1, ==, h->count);
+  assert_uint64(NGTCP2_MILLISECONDS, ==, h->max);
+
+  h = ngtcp2_conn_get_histogram(conn, NGTCP2_HISTOGRAM_TYPE_RX_GAP);
+
+  assert_not_null(h);
+  assert_uint64(1, ==, h->count);
+  assert_uint64(5 * NGTCP2_MILLISECONDS, ==, h->max);
+
+  ngtcp2_conn_del(conn);
+}
+
 void test_ngtcp2_conn_version_negotiation(void) {
   ngtcp2_conn *conn;
   uint8_t buf[2048];
@@ -11192,6 +11571,459 @@ void test_ngtcp2_conn_pmtud_loss(void) {
   ngtcp2_conn_del(conn);
 }
 
+void test_ngtcp2_conn_pmtud_black_hole(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[2048];
+  ngtcp2_ssize spktlen;
+  uint64_t t = 0;
+  ngtcp2_frame fr;
+  int64_t pkt_num = 0;
+  size_t pktlen;
+  int rv;
+  int64_t stream_id;
+  size_t i;
+  ngtcp2_settings settings;
+  ngtcp2_transport_params params;
+
+  client_default_settings(&settings);
+  settings.max_tx_udp_payload_size = 1452;
+  settings.no_tx_udp_payload_size_shaping = 0;
+  client_default_transport_params(&params);
+
+  setup_default_client_settings(&conn, &null_path.path, &settings, &params);
+
+  /* Pretend that PMTUD has discovered 1406 bytes. */
+  conn->dcid.current.max_udp_payload_size = 1406;
+  conn->cstat.max_tx_udp_payload_size = 1406;
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  for (i = 0; i < 3; ++i) {
+    spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                       NULL, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                       stream_id, null_data, 1406, ++t);
+
+    assert_ptrdiff(1406, ==, spktlen);
+  }
+
+  for (i = 0; i < 3; ++i) {
+    spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                       NULL, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                       stream_id, null_data, 100, ++t);
+
+    assert_ptrdiff(NGTCP2_MAX_UDP_PAYLOAD_SIZE, >, spktlen);
+  }
+
+  /* Only small packets get through. */
+  fr.type = NGTCP2_FRAME_ACK;
+  fr.ack.largest_ack = conn->pktns.tx.last_pkt_num;
+  fr.ack.ack_delay = 0;
+  fr.ack.first_ack_range = 2;
+  fr.ack.rangecnt = 0;
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, ++pkt_num, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, &null_pi, buf, pktlen, ++t);
+
+  assert_int(0, ==, rv);
+  assert_size(3, ==, conn->pktns.rtb.num_lost_pkts);
+  assert_size(NGTCP2_MAX_UDP_PAYLOAD_SIZE, ==,
+              conn->dcid.current.max_udp_payload_size);
+  assert_size(NGTCP2_MAX_UDP_PAYLOAD_SIZE, ==,
+              conn->cstat.max_tx_udp_payload_size);
+  assert_size(1405, ==, conn->pmtud_bh.max_udp_payload_size);
+  assert_not_null(conn->pmtud);
+  assert_size(1390 - 48, ==, ngtcp2_pmtud_probelen(conn->pmtud));
+
+  ngtcp2_conn_del(conn);
+
+  /* Acknowledging a large packet resets the counter. */
+  setup_default_client_settings(&conn, &null_path.path, &settings, &params);
+
+  conn->dcid.current.max_udp_payload_size = 1406;
+  conn->cstat.max_tx_udp_payload_size = 1406;
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  for (i = 0; i < 4; ++i) {
+    spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                       NULL, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                       stream_id, null_data, 1406, ++t);
+
+    assert_ptrdiff(1406, ==, spktlen);
+  }
+
+  for (i = 0; i < 3; ++i) {
+    spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf),
+                                       NULL, NGTCP2_WRITE_STREAM_FLAG_NONE,
+                                       stream_id, null_data, 100, ++t);
+
+    assert_ptrdiff(NGTCP2_MAX_UDP_PAYLOAD_SIZE, >, spktlen);
+  }
+
+  fr.type = NGTCP2_FRAME_ACK;
+  fr.ack.largest_ack = conn->pktns.tx.last_pkt_num;
+  fr.ack.ack_delay = 0;
+  fr.ack.first_ack_range = 3;
+  fr.ack.rangecnt = 0;
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, ++pkt_num, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, &null_pi, buf, pktlen, ++t);
+
+  assert_int(0, ==, rv);
+  assert_size(3, ==, conn->pktns.rtb.num_lost_pkts);
+  assert_size(1406, ==, conn->dcid.current.max_udp_payload_size);
+  assert_size(0, ==, conn->pmtud_bh.num_lost_pkts);
+  assert_null(conn->pmtud);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_pmtud_hint(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[2048];
+  ngtcp2_ssize spktlen;
+  uint64_t t = 0;
+  int rv;
+
+  setup_handshake_client(&conn);
+
+  rv = ngtcp2_conn_set_pmtud_hint(conn, NGTCP2_MAX_UDP_PAYLOAD_SIZE);
+
+  assert_int(NGTCP2_ERR_INVALID_ARGUMENT, ==, rv);
+
+  rv = ngtcp2_conn_set_pmtud_hint(conn, 1440);
+
+  assert_int(0, ==, rv);
+  assert_size(1440, ==, conn->pmtud_hint);
+
+  ngtcp2_conn_del(conn);
+
+  setup_default_client(&conn);
+
+  rv = ngtcp2_conn_set_pmtud_hint(conn, 1440);
+
+  assert_int(NGTCP2_ERR_INVALID_STATE, ==, rv);
+
+  /* The hint is probed first. */
+  conn->pmtud_hint = 1440;
+
+  ngtcp2_conn_start_pmtud(conn);
+
+  assert_size(0, ==, conn->pmtud_hint);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+
+  assert_ptrdiff(1440, ==, spktlen);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_pmtud_jumbo(void) {
+  ngtcp2_conn *conn;
+  uint8_t buf[9000];
+  ngtcp2_ssize spktlen;
+  uint64_t t = 0;
+  ngtcp2_frame fr;
+  int64_t pkt_num = 0;
+  size_t pktlen;
+  int rv;
+  ngtcp2_settings settings;
+  ngtcp2_transport_params params;
+
+  client_default_settings(&settings);
+  settings.max_tx_udp_payload_size = 9000 - 48;
+  settings.no_tx_udp_payload_size_shaping = 0;
+  client_default_transport_params(&params);
+
+  setup_default_client_settings(&conn, &null_path.path, &settings, &params);
+
+  assert_uint64(ngtcp2_cc_compute_initcwnd(NGTCP2_MAX_UDP_PAYLOAD_SIZE), ==,
+                conn->cstat.cwnd);
+
+  ngtcp2_conn_start_pmtud(conn);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+
+  assert_ptrdiff(1454 - 48, ==, spktlen);
+
+  fr.type = NGTCP2_FRAME_ACK;
+  fr.ack.largest_ack = conn->pktns.tx.last_pkt_num;
+  fr.ack.ack_delay = 0;
+  fr.ack.first_ack_range = 0;
+  fr.ack.rangecnt = 0;
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, ++pkt_num, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, &null_pi, buf, pktlen, ++t);
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), ++t);
+
+  assert_ptrdiff(9000 - 48, ==, spktlen);
+
+  fr.type = NGTCP2_FRAME_ACK;
+  fr.ack.largest_ack = conn->pktns.tx.last_pkt_num;
+  fr.ack.ack_delay = 0;
+  fr.ack.first_ack_range = 0;
+  fr.ack.rangecnt = 0;
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, ++pkt_num, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, &null_pi, buf, pktlen, ++t);
+
+  assert_int(0, ==, rv);
+  assert_null(conn->pmtud);
+  assert_size(9000 - 48, ==, conn->cstat.max_tx_udp_payload_size);
+  /* Initial window is recalculated with the new size. */
+  assert_uint64(2 * (9000 - 48), <=, conn->cstat.cwnd);
+
+  ngtcp2_conn_del(conn);
+}
+
+void test_ngtcp2_conn_timer_wheel(void) {
+  ngtcp2_conn *conn;
+  ngtcp2_timer_wheel *tw;
+  uint8_t buf[2048];
+  ngtcp2_ssize spktlen;
+  ngtcp2_tstamp expiry;
+  int rv;
+
+  rv = ngtcp2_timer_wheel_new(&tw, NGTCP2_MILLISECONDS, 0, NULL);
+
+  assert_int(0, ==, rv);
+
+  setup_handshake_client(&conn);
+  ngtcp2_conn_set_timer_wheel(conn, tw);
+
+  assert_ptr_equal(tw, conn->tw);
+  assert_uint64(ngtcp2_conn_get_expiry(conn), ==, conn->tw_ent.expiry);
+  assert_size(1, ==, tw->len);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), 0);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  /* Writing a packet arms loss detection timer. */
+  expiry = ngtcp2_conn_get_expiry(conn);
+
+  assert_uint64(expiry, ==, conn->tw_ent.expiry);
+  assert_null(ngtcp2_timer_wheel_expire(tw, expiry - 1));
+  assert_ptr_equal(conn, ngtcp2_timer_wheel_expire(tw, expiry));
+  assert_null(ngtcp2_timer_wheel_expire(tw, expiry));
+  assert_size(0, ==, tw->len);
+
+  rv = ngtcp2_conn_handle_expiry(conn, expiry);
+
+  assert_int(0, ==, rv);
+  assert_size(1, ==, tw->len);
+  assert_uint64(ngtcp2_conn_get_expiry(conn), ==, conn->tw_ent.expiry);
+
+  /* Deleting connection detaches it from the wheel. */
+  ngtcp2_conn_del(conn);
+
+  assert_size(0, ==, tw->len);
+
+  /* Deleting the wheel detaches the connections. */
+  setup_handshake_client(&conn);
+  ngtcp2_conn_set_timer_wheel(conn, tw);
+  ngtcp2_timer_wheel_del(tw);
+
+  assert_null(conn->tw);
+
+  ngtcp2_conn_del(conn);
+
+  /* The connection which has been returned by
+     ngtcp2_timer_wheel_expire is still attached. */
+  rv = ngtcp2_timer_wheel_new(&tw, NGTCP2_MILLISECONDS, 0, NULL);
+
+  assert_int(0, ==, rv);
+
+  setup_handshake_client(&conn);
+  ngtcp2_conn_set_timer_wheel(conn, tw);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), 0);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  expiry = ngtcp2_conn_get_expiry(conn);
+
+  assert_ptr_equal(conn, ngtcp2_timer_wheel_expire(tw, expiry));
+
+  ngtcp2_timer_wheel_del(tw);
+
+  assert_null(conn->tw);
+
+  rv = ngtcp2_conn_handle_expiry(conn, expiry);
+
+  assert_int(0, ==, rv);
+
+  ngtcp2_conn_del(conn);
+
+  /* The connection which has no expiry is still attached. */
+  rv = ngtcp2_timer_wheel_new(&tw, NGTCP2_MILLISECONDS, 0, NULL);
+
+  assert_int(0, ==, rv);
+
+  setup_handshake_client(&conn);
+  conn->local.settings.handshake_timeout = UINT64_MAX;
+  conn->local.transport_params.max_idle_timeout = 0;
+  ngtcp2_conn_set_timer_wheel(conn, tw);
+
+  assert_uint64(UINT64_MAX, ==, ngtcp2_conn_get_expiry(conn));
+  assert_size(0, ==, tw->len);
+
+  ngtcp2_timer_wheel_del(tw);
+
+  assert_null(conn->tw);
+
+  spktlen = ngtcp2_conn_write_pkt(conn, NULL, NULL, buf, sizeof(buf), 0);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  ngtcp2_conn_del(conn);
+}
+
+/*
+ * timer_wheel_expiry returns the expiry of |conn| that the timer wheel
+ * has been told.
+ */
+static ngtcp2_tstamp timer_wheel_expiry(ngtcp2_conn *conn) {
+  return conn->tw_ent.expiry;
+}
+
+void test_ngtcp2_conn_timer_wheel_update(void) {
+  ngtcp2_conn *conn;
+  ngtcp2_timer_wheel *tw;
+  uint8_t buf[2048];
+  size_t pktlen;
+  ngtcp2_ssize spktlen;
+  ngtcp2_tstamp t = 0;
+  int64_t pkt_num = 0;
+  int64_t stream_id;
+  ngtcp2_frame fr;
+  ngtcp2_ccerr ccerr;
+  ngtcp2_path_storage to_path;
+  const uint8_t raw_cid[] = {0x0f, 0x00, 0x00, 0x00};
+  const uint8_t token[NGTCP2_STATELESS_RESET_TOKENLEN] = {0xff};
+  const uint8_t data[1024] = {0};
+  int rv;
+
+  rv = ngtcp2_timer_wheel_new(&tw, NGTCP2_NANOSECONDS, 0, NULL);
+
+  assert_int(0, ==, rv);
+
+  /* ngtcp2_conn_tls_handshake_completed */
+  setup_handshake_client(&conn);
+  ngtcp2_conn_set_timer_wheel(conn, tw);
+
+  ngtcp2_conn_tls_handshake_completed(conn);
+
+  assert_uint64(ngtcp2_conn_get_expiry(conn), ==, timer_wheel_expiry(conn));
+
+  ngtcp2_conn_del(conn);
+
+  /* ngtcp2_conn_update_pkt_tx_time */
+  setup_default_client(&conn);
+  ngtcp2_conn_set_timer_wheel(conn, tw);
+
+  rv = ngtcp2_conn_open_bidi_stream(conn, &stream_id, NULL);
+
+  assert_int(0, ==, rv);
+
+  spktlen = ngtcp2_conn_write_stream(conn, NULL, NULL, buf, sizeof(buf), NULL,
+                                     NGTCP2_WRITE_STREAM_FLAG_NONE, stream_id,
+                                     data, sizeof(data), ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+
+  ngtcp2_conn_update_pkt_tx_time(conn, t);
+
+  /* The pacing timer is the earliest one. */
+  assert_uint64(conn->tx.pacing.next_ts, ==, timer_wheel_expiry(conn));
+  assert_uint64(ngtcp2_conn_get_expiry(conn), ==, timer_wheel_expiry(conn));
+
+  /* ngtcp2_conn_set_keep_alive_timeout */
+  ngtcp2_conn_set_keep_alive_timeout(conn, NGTCP2_NANOSECONDS);
+
+  assert_uint64(ngtcp2_conn_get_expiry(conn), ==, timer_wheel_expiry(conn));
+
+  /* ngtcp2_conn_initiate_key_update */
+  t += 10 * NGTCP2_SECONDS;
+
+  rv = ngtcp2_conn_initiate_key_update(conn, t);
+
+  assert_int(0, ==, rv);
+  assert_uint64(ngtcp2_conn_get_expiry(conn), ==, timer_wheel_expiry(conn));
+
+  /* ngtcp2_conn_write_connection_close */
+  ngtcp2_ccerr_set_application_error(&ccerr, 0, NULL, 0);
+
+  spktlen = ngtcp2_conn_write_connection_close(conn, NULL, NULL, buf,
+                                               sizeof(buf), &ccerr, ++t);
+
+  assert_ptrdiff(0, <, spktlen);
+  assert_uint64(ngtcp2_conn_get_expiry(conn), ==, timer_wheel_expiry(conn));
+
+  ngtcp2_conn_del(conn);
+
+  /* ngtcp2_conn_initiate_migration */
+  setup_default_client(&conn);
+  ngtcp2_conn_set_timer_wheel(conn, tw);
+
+  fr.type = NGTCP2_FRAME_NEW_CONNECTION_ID;
+  fr.new_connection_id.seq = 1;
+  fr.new_connection_id.retire_prior_to = 0;
+  ngtcp2_cid_init(&fr.new_connection_id.cid, raw_cid, sizeof(raw_cid));
+  memcpy(fr.new_connection_id.stateless_reset_token, token, sizeof(token));
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, ++pkt_num, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, &null_pi, buf, pktlen, ++t);
+
+  assert_int(0, ==, rv);
+
+  ngtcp2_path_storage_init2(&to_path, &new_path.path);
+
+  rv = ngtcp2_conn_initiate_migration(conn, &to_path.path, ++t);
+
+  assert_int(0, ==, rv);
+  assert_uint64(ngtcp2_conn_get_expiry(conn), ==, timer_wheel_expiry(conn));
+
+  ngtcp2_conn_del(conn);
+
+  /* ngtcp2_conn_initiate_immediate_migration */
+  setup_default_client(&conn);
+  ngtcp2_conn_set_timer_wheel(conn, tw);
+
+  pktlen = write_pkt(buf, sizeof(buf), &conn->oscid, ++pkt_num, &fr, 1,
+                     conn->pktns.crypto.rx.ckm);
+
+  rv = ngtcp2_conn_read_pkt(conn, &null_path.path, &null_pi, buf, pktlen, ++t);
+
+  assert_int(0, ==, rv);
+
+  rv = ngtcp2_conn_initiate_immediate_migration(conn, &to_path.path, ++t);
+
+  assert_int(0, ==, rv);
+  assert_uint64(ngtcp2_conn_get_expiry(conn), ==, timer_wheel_expiry(conn));
+
+  ngtcp2_conn_del(conn);
+
+  ngtcp2_timer_wheel_del(tw);
+}
+
 void test_ngtcp2_conn_amplification(void) {
   ngtcp2_conn *conn;
   ngtcp2_frame fr;
@@ -90,7 +90,9 @@ munit_void_test_decl(test_ngtcp2_conn_write_connection_close);
 munit_void_test_decl(test_ngtcp2_conn_write_application_close);
 munit_void_test_decl(test_ngtcp2_conn_rtb_reclaim_on_pto);
 munit_void_test_decl(test_ngtcp2_conn_rtb_reclaim_on_pto_datagram);
+munit_void_test_decl(test_ngtcp2_conn_qlog_flight_recorder);
 munit_void_test_decl(test_ngtcp2_conn_validate_ecn);
+munit_void_test_decl(test_ngtcp2_conn_read_timestamped_pkt);
 munit_void_test_decl(test_ngtcp2_conn_path_validation);
 munit_void_test_decl(test_ngtcp2_conn_early_data_sync_stream_data_limit);
 munit_void_test_decl(test_ngtcp2_conn_tls_early_data_rejected);
@@ -101,9 +103,17 @@ munit_void_test_decl(test_ngtcp2_conn_stream_close);
 munit_void_test_decl(test_ngtcp2_conn_buffer_pkt);
 munit_void_test_decl(test_ngtcp2_conn_handshake_timeout);
 munit_void_test_decl(test_ngtcp2_conn_get_ccerr);
+munit_void_test_decl(test_ngtcp2_conn_path_capacity);
+munit_void_test_decl(test_ngtcp2_conn_get_stats);
+munit_void_test_decl(test_ngtcp2_conn_histogram);
 munit_void_test_decl(test_ngtcp2_conn_version_negotiation);
 munit_void_test_decl(test_ngtcp2_conn_server_negotiate_version);
 munit_void_test_decl(test_ngtcp2_conn_pmtud_loss);
+munit_void_test_decl(test_ngtcp2_conn_pmtud_black_hole);
+munit_void_test_decl(test_ngtcp2_conn_pmtud_hint);
+munit_void_test_decl(test_ngtcp2_conn_pmtud_jumbo);
+munit_void_test_decl(test_ngtcp2_conn_timer_wheel);
+munit_void_test_decl(test_ngtcp2_conn_timer_wheel_update);
 munit_void_test_decl(test_ngtcp2_conn_amplification);
 munit_void_test_decl(test_ngtcp2_conn_encode_0rtt_transport_params);
 munit_void_test_decl(test_ngtcp2_conn_create_ack_frame);
@@ -0,0 +1,144 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_histogram_test.h"
+
+#include <stdio.h>
+
+#include "ngtcp2_histogram.h"
+#include "ngtcp2_test_helper.h"
+
+static const MunitTest tests[] = {
+    munit_void_test(test_ngtcp2_histogram_bucket_index),
+    munit_void_test(test_ngtcp2_histogram_quantile),
+    munit_void_test(test_ngtcp2_histogram_merge),
+    munit_test_end(),
+};
+
+const MunitSuite histogram_suite = {
+    "/histogram", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE,
+};
+
+void test_ngtcp2_histogram_bucket_index(void) {
+  size_t i;
+  ngtcp2_duration lb;
+
+  assert_size(0, ==, ngtcp2_histogram_bucket_index(0));
+  assert_size(0, ==, ngtcp2_histogram_bucket_index(NGTCP2_MICROSECONDS - 1));
+  assert_size(7, ==, ngtcp2_histogram_bucket_index(7 * NGTCP2_MICROSECONDS));
+  assert_size(8, ==, ngtcp2_histogram_bucket_index(8 * NGTCP2_MICROSECONDS));
+  assert_size(15, ==, ngtcp2_histogram_bucket_index(15 * NGTCP2_MICROSECONDS));
+  assert_size(16, ==, ngtcp2_histogram_bucket_index(16 * NGTCP2_MICROSECONDS));
+  assert_size(16, ==, ngtcp2_histogram_bucket_index(17 * NGTCP2_MICROSECONDS));
+  assert_size(17, ==, ngtcp2_histogram_bucket_index(18 * NGTCP2_MICROSECONDS));
+  assert_size(NGTCP2_HISTOGRAM_BUCKETLEN - 1, ==,
+              ngtcp2_histogram_bucket_index(UINT64_MAX));
+
+  /* The lower bound of each bucket falls into the bucket, and the
+     duration just below it falls into the previous one. */
+  for (i = 1; i < NGTCP2_HISTOGRAM_BUCKETLEN; ++i) {
+    lb = ngtcp2_histogram_bucket_lower_bound(i);
+
+    assert_size(i, ==, ngtcp2_histogram_bucket_index(lb));
+    assert_size(i - 1, ==, ngtcp2_histogram_bucket_index(lb - 1));
+  }
+
+  assert_uint64(((1ULL << 32) - (1ULL << 28)) * NGTCP2_MICROSECONDS, ==,
+                ngtcp2_histogram_bucket_lower_bound(
+                    NGTCP2_HISTOGRAM_BUCKETLEN - 1));
+}
+
+void test_ngtcp2_histogram_quantile(void) {
+  ngtcp2_histogram h;
+  size_t i;
+
+  ngtcp2_histogram_init(&h);
+
+  assert_uint64(0, ==, h.count);
+  assert_uint64(UINT64_MAX, ==, h.min);
+  assert_uint64(0, ==, ngtcp2_histogram_quantile(&h, 500));
+
+  /* 99 samples of 10ms and 1 sample of 200ms */
+  for (i = 0; i < 99; ++i) {
+    ngtcp2_histogram_add(&h, 10 * NGTCP2_MILLISECONDS);
+  }
+
+  ngtcp2_histogram_add(&h, 200 * NGTCP2_MILLISECONDS);
+
+  assert_uint64(100, ==, h.count);
+  assert_uint64(1190 * NGTCP2_MILLISECONDS, ==, h.sum);
+  assert_uint64(10 * NGTCP2_MILLISECONDS, ==, h.min);
+  assert_uint64(200 * NGTCP2_MILLISECONDS, ==, h.max);
+
+  /* 10ms falls into [9216us, 10240us). */
+  assert_uint64(10240 * NGTCP2_MICROSECONDS - 1, ==,
+                ngtcp2_histogram_quantile(&h, 0));
+  assert_uint64(10240 * NGTCP2_MICROSECONDS - 1, ==,
+                ngtcp2_histogram_quantile(&h, 500));
+  assert_uint64(10240 * NGTCP2_MICROSECONDS - 1, ==,
+                ngtcp2_histogram_quantile(&h, 990));
+  assert_uint64(200 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_histogram_quantile(&h, 991));
+  assert_uint64(200 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_histogram_quantile(&h, 1000));
+  assert_uint64(200 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_histogram_quantile(&h, 2000));
+
+  /* The estimate never exceeds max. */
+  ngtcp2_histogram_init(&h);
+  ngtcp2_histogram_add(&h, 9 * NGTCP2_MILLISECONDS);
+
+  assert_uint64(9 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_histogram_quantile(&h, 500));
+}
+
+void test_ngtcp2_histogram_merge(void) {
+  ngtcp2_histogram a, b;
+
+  ngtcp2_histogram_init(&a);
+  ngtcp2_histogram_init(&b);
+
+  ngtcp2_histogram_add(&a, 3 * NGTCP2_MICROSECONDS);
+  ngtcp2_histogram_add(&b, 100 * NGTCP2_MILLISECONDS);
+  ngtcp2_histogram_add(&b, 100 * NGTCP2_MILLISECONDS);
+
+  ngtcp2_histogram_merge(&a, &b);
+
+  assert_uint64(3, ==, a.count);
+  assert_uint64(3 * NGTCP2_MICROSECONDS + 200 * NGTCP2_MILLISECONDS, ==,
+                a.sum);
+  assert_uint64(3 * NGTCP2_MICROSECONDS, ==, a.min);
+  assert_uint64(100 * NGTCP2_MILLISECONDS, ==, a.max);
+  assert_uint64(1, ==, a.buckets[3]);
+  assert_uint64(
+      2, ==,
+      a.buckets[ngtcp2_histogram_bucket_index(100 * NGTCP2_MILLISECONDS)]);
+
+  /* Merging empty histogram does not change min. */
+  ngtcp2_histogram_init(&b);
+  ngtcp2_histogram_merge(&a, &b);
+
+  assert_uint64(3, ==, a.count);
+  assert_uint64(3 * NGTCP2_MICROSECONDS, ==, a.min);
+}
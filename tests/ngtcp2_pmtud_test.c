@@ -31,6 +31,7 @@
 
 static const MunitTest tests[] = {
     munit_void_test(test_ngtcp2_pmtud_probe),
+    munit_void_test(test_ngtcp2_pmtud_hint),
     munit_test_end(),
 };
 
@@ -43,16 +44,20 @@ void test_ngtcp2_pmtud_probe(void) {
   ngtcp2_pmtud *pmtud;
   int rv;
   static const uint16_t probes[] = {
-      3000 - 48,
       9000 - 48,
+      3000 - 48,
+      5000 - 48,
+      4000 - 48,
+      3000 - 48,
   };
 
   /* Send probe and get success */
-  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 1452, 0, NULL, 0,
-                        mem);
+  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 1452, 0, 0, NULL,
+                        0, mem);
 
   assert_int(0, ==, rv);
-  assert_size(0, ==, pmtud->mtu_idx);
+  assert_size(4, ==, pmtud->probeslen);
+  assert_size(2, ==, pmtud->mtu_idx);
   assert_false(ngtcp2_pmtud_finished(pmtud));
   assert_true(ngtcp2_pmtud_require_probe(pmtud));
   assert_size(1454 - 48, ==, ngtcp2_pmtud_probelen(pmtud));
@@ -108,8 +113,8 @@ void test_ngtcp2_pmtud_probe(void) {
   ngtcp2_pmtud_del(pmtud);
 
   /* Failing 2nd probe should skip the third probe */
-  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 1452, 0, NULL, 0,
-                        mem);
+  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 1452, 0, 0, NULL,
+                        0, mem);
 
   ngtcp2_pmtud_probe_sent(pmtud, 2, 0);
   ngtcp2_pmtud_handle_expiry(pmtud, 2);
@@ -129,7 +134,7 @@ void test_ngtcp2_pmtud_probe(void) {
   ngtcp2_pmtud_handle_expiry(pmtud, 20);
 
   assert_size(1390 - 48, ==, pmtud->min_fail_udp_payload_size);
-  assert_size(2, ==, pmtud->mtu_idx);
+  assert_size(0, ==, pmtud->mtu_idx);
 
   ngtcp2_pmtud_probe_sent(pmtud, 2, 10);
   ngtcp2_pmtud_probe_success(pmtud, 1280 - 48);
@@ -138,9 +143,29 @@ void test_ngtcp2_pmtud_probe(void) {
 
   ngtcp2_pmtud_del(pmtud);
 
+  /* Jumbo frame is probed if hard max allows it. */
+  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 9000 - 48, 0, 0,
+                        NULL, 0, mem);
+
+  assert_int(0, ==, rv);
+  assert_size(5, ==, pmtud->probeslen);
+  assert_size(1454 - 48, ==, ngtcp2_pmtud_probelen(pmtud));
+
+  ngtcp2_pmtud_probe_sent(pmtud, 2, 0);
+  ngtcp2_pmtud_probe_success(pmtud, 1454 - 48);
+
+  assert_size(9000 - 48, ==, ngtcp2_pmtud_probelen(pmtud));
+
+  ngtcp2_pmtud_probe_sent(pmtud, 2, 2);
+  ngtcp2_pmtud_probe_success(pmtud, 9000 - 48);
+
+  assert_true(ngtcp2_pmtud_finished(pmtud));
+
+  ngtcp2_pmtud_del(pmtud);
+
   /* Skip 1st probe because it is larger than hard max. */
   rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 1454 - 48 - 1, 0,
-                        NULL, 0, mem);
+                        0, NULL, 0, mem);
 
   assert_int(0, ==, rv);
   assert_size(1, ==, pmtud->mtu_idx);
@@ -149,7 +174,7 @@ void test_ngtcp2_pmtud_probe(void) {
 
   /* PMTUD finishes immediately because we know that all candidates
      are lower than the current maximum. */
-  rv = ngtcp2_pmtud_new(&pmtud, 1492 - 48, 1452, 0, NULL, 0, mem);
+  rv = ngtcp2_pmtud_new(&pmtud, 1492 - 48, 1452, 0, 0, NULL, 0, mem);
 
   assert_int(0, ==, rv);
   assert_true(ngtcp2_pmtud_finished(pmtud));
@@ -159,30 +184,99 @@ void test_ngtcp2_pmtud_probe(void) {
   /* PMTUD finishes immediately because the hard maximum size is lower
      than the candidates. */
   rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE,
-                        NGTCP2_MAX_UDP_PAYLOAD_SIZE, 0, NULL, 0, mem);
+                        NGTCP2_MAX_UDP_PAYLOAD_SIZE, 0, 0, NULL, 0, mem);
 
   assert_int(0, ==, rv);
   assert_true(ngtcp2_pmtud_finished(pmtud));
 
   ngtcp2_pmtud_del(pmtud);
 
-  /* Custom probes */
-  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 9000 - 48, 0,
+  /* Custom probes are searched from the middle of the sorted
+     candidates. */
+  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 9000 - 48, 0, 0,
                         probes, ngtcp2_arraylen(probes), mem);
 
   assert_int(0, ==, rv);
-  assert_size(3000 - 48, ==, ngtcp2_pmtud_probelen(pmtud));
+  assert_size(4, ==, pmtud->probeslen);
+  assert_size(5000 - 48, ==, ngtcp2_pmtud_probelen(pmtud));
 
   ngtcp2_pmtud_probe_sent(pmtud, 230, 7);
+  ngtcp2_pmtud_handle_expiry(pmtud, 237);
+  ngtcp2_pmtud_probe_sent(pmtud, 230, 237);
+  ngtcp2_pmtud_handle_expiry(pmtud, 467);
+  ngtcp2_pmtud_probe_sent(pmtud, 230, 467);
+  ngtcp2_pmtud_handle_expiry(pmtud, 1157);
+
+  assert_size(5000 - 48, ==, pmtud->min_fail_udp_payload_size);
+  assert_false(ngtcp2_pmtud_finished(pmtud));
+  assert_size(4000 - 48, ==, ngtcp2_pmtud_probelen(pmtud));
+
+  ngtcp2_pmtud_probe_sent(pmtud, 230, 1157);
+  ngtcp2_pmtud_probe_success(pmtud, 4000 - 48);
+
+  assert_true(ngtcp2_pmtud_finished(pmtud));
+  assert_size(4000 - 48, ==, pmtud->max_udp_payload_size);
+
+  ngtcp2_pmtud_del(pmtud);
+
+  /* Acknowledgement of the smaller probe which was sent before does
+     not change the current probe. */
+  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 9000 - 48, 0, 0,
+                        probes, ngtcp2_arraylen(probes), mem);
+
+  assert_int(0, ==, rv);
+
   ngtcp2_pmtud_probe_success(pmtud, 3000 - 48);
 
+  assert_size(1, ==, pmtud->lo);
+  assert_size(5000 - 48, ==, ngtcp2_pmtud_probelen(pmtud));
+
+  ngtcp2_pmtud_del(pmtud);
+}
+
+void test_ngtcp2_pmtud_hint(void) {
+  const ngtcp2_mem *mem = ngtcp2_mem_default();
+  ngtcp2_pmtud *pmtud;
+  int rv;
+
+  /* The hint is probed first */
+  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 1452, 1400, 0,
+                        NULL, 0, mem);
+
+  assert_int(0, ==, rv);
+  assert_size(5, ==, pmtud->probeslen);
+  assert_size(1400, ==, ngtcp2_pmtud_probelen(pmtud));
+
+  ngtcp2_pmtud_probe_sent(pmtud, 2, 0);
+  ngtcp2_pmtud_probe_success(pmtud, 1400);
+
   assert_false(ngtcp2_pmtud_finished(pmtud));
-  assert_size(9000 - 48, ==, ngtcp2_pmtud_probelen(pmtud));
+  assert_size(1444, ==, ngtcp2_pmtud_probelen(pmtud));
 
-  ngtcp2_pmtud_probe_sent(pmtud, 230, 9);
-  ngtcp2_pmtud_probe_success(pmtud, 9000 - 48);
+  ngtcp2_pmtud_del(pmtud);
+
+  /* The hint which is already in the candidates */
+  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 1452, 1444, 0,
+                        NULL, 0, mem);
+
+  assert_int(0, ==, rv);
+  assert_size(4, ==, pmtud->probeslen);
+  assert_size(1444, ==, ngtcp2_pmtud_probelen(pmtud));
+
+  ngtcp2_pmtud_probe_sent(pmtud, 2, 0);
+  ngtcp2_pmtud_probe_success(pmtud, 1444);
 
   assert_true(ngtcp2_pmtud_finished(pmtud));
 
   ngtcp2_pmtud_del(pmtud);
+
+  /* The hint larger than the hard maximum is ignored. */
+  rv = ngtcp2_pmtud_new(&pmtud, NGTCP2_MAX_UDP_PAYLOAD_SIZE, 1452, 1472, 0,
+                        NULL, 0, mem);
+
+  assert_int(0, ==, rv);
+  assert_size(4, ==, pmtud->probeslen);
+  assert_size(1406, ==, ngtcp2_pmtud_probelen(pmtud));
+
+  ngtcp2_pmtud_del(pmtud);
 }
@@ -36,5 +36,6 @@
 extern const MunitSuite pmtud_suite;
 
 munit_void_test_decl(test_ngtcp2_pmtud_probe);
+munit_void_test_decl(test_ngtcp2_pmtud_hint);
 
 #endif /* NGTCP2_PMTUD_TEST_H */
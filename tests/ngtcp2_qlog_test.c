@@ -31,6 +31,9 @@
 
 static const MunitTest tests[] = {
     munit_void_test(test_ngtcp2_qlog_write_frame),
+    munit_void_test(test_ngtcp2_qlog_decode_binary),
+    munit_void_test(test_ngtcp2_qlog_flight_recorder),
+    munit_void_test(test_ngtcp2_qlog_filter),
     munit_test_end(),
 };
 
@@ -55,7 +58,8 @@ void test_ngtcp2_qlog_write_frame(void) {
   } exfr;
   ngtcp2_frame *fr = &exfr.fr;
 
-  ngtcp2_qlog_init(&qlog, null_qlog_write, 0, NULL);
+  ngtcp2_qlog_init(&qlog, null_qlog_write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0,
+                   NULL);
   ngtcp2_buf_init(&qlog.buf, buf, sizeof(buf));
 
   {
@@ -550,3 +554,444 @@ void test_ngtcp2_qlog_write_frame(void) {
                         (const char *)qlog.buf.begin);
   }
 }
+
+static void buf_qlog_write(void *user_data, uint32_t flags, const void *data,
+                           size_t datalen) {
+  ngtcp2_buf *buf = user_data;
+  (void)flags;
+
+  assert_size(datalen, <=, ngtcp2_buf_left(buf));
+
+  if (datalen) {
+    buf->last = ngtcp2_cpymem(buf->last, data, datalen);
+  }
+}
+
+static void write_qlog_events(ngtcp2_qlog *qlog) {
+  ngtcp2_cid odcid, cid;
+  ngtcp2_transport_params params;
+  struct {
+    ngtcp2_frame fr;
+    ngtcp2_ack_range extra_ranges[1];
+  } exfr;
+  ngtcp2_frame *fr = &exfr.fr;
+  ngtcp2_vec datav[2] = {{NULL, 1000}, {NULL, 111}};
+  uint8_t token[] = "new token";
+  ngtcp2_pkt_hd hd;
+  ngtcp2_conn_stat cstat;
+  ngtcp2_rtb_entry ent;
+  ngtcp2_pkt_stateless_reset sr;
+  const uint32_t sv[] = {0x1, 0xff00001d};
+
+  dcid_init(&odcid);
+  scid_init(&cid);
+
+  ngtcp2_qlog_start(qlog, &odcid, /* server = */ 1);
+
+  ngtcp2_transport_params_default(&params);
+  params.initial_scid = cid;
+  params.initial_scid_present = 1;
+  params.original_dcid = odcid;
+  params.original_dcid_present = 1;
+  params.initial_max_data = 1000000007;
+
+  ngtcp2_qlog_parameters_set_transport_params(qlog, &params, /* server = */ 1,
+                                              NGTCP2_QLOG_SIDE_LOCAL);
+
+  qlog->last_ts += 11 * NGTCP2_MILLISECONDS;
+
+  ngtcp2_qlog_pkt_sent_start(qlog);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_ACK_ECN;
+  fr->ack.ack_delay_unscaled = 31 * NGTCP2_MILLISECONDS;
+  fr->ack.largest_ack = 1000000007;
+  fr->ack.first_ack_range = 11;
+  fr->ack.rangecnt = 2;
+  fr->ack.ranges[0].gap = 17;
+  fr->ack.ranges[0].len = 73;
+  fr->ack.ranges[1].gap = 0;
+  fr->ack.ranges[1].len = 3;
+  fr->ack.ecn.ect1 = 678912;
+  fr->ack.ecn.ect0 = 892363;
+  fr->ack.ecn.ce = 956923;
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_CRYPTO;
+  fr->stream.offset = 1000000009;
+  fr->stream.datacnt = 1;
+  fr->stream.data[0] = datav[0];
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_NEW_TOKEN;
+  fr->new_token.token = token;
+  fr->new_token.tokenlen = sizeof(token) - 1;
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_NEW_CONNECTION_ID;
+  fr->new_connection_id.seq = 1000000009;
+  fr->new_connection_id.retire_prior_to = 7;
+  fr->new_connection_id.cid = cid;
+  memset(fr->new_connection_id.stateless_reset_token, 0xf1,
+         sizeof(fr->new_connection_id.stateless_reset_token));
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_PATH_CHALLENGE;
+  memset(fr->path_challenge.data, 0xe7, sizeof(fr->path_challenge.data));
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_MAX_STREAMS_UNI;
+  fr->max_streams.max_streams = 1000000007;
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_PADDING;
+  fr->padding.len = 122;
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  ngtcp2_pkt_hd_init(&hd, NGTCP2_PKT_FLAG_LONG_FORM, NGTCP2_PKT_INITIAL, &odcid,
+                     &cid, 1000000007, 4, NGTCP2_PROTO_VER_V1, 0);
+  hd.token = token;
+  hd.tokenlen = sizeof(token) - 1;
+
+  ngtcp2_qlog_pkt_sent_end(qlog, &hd, 1200);
+
+  qlog->last_ts += 3 * NGTCP2_MILLISECONDS;
+
+  ngtcp2_qlog_pkt_received_start(qlog);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_STREAM;
+  fr->stream.fin = 1;
+  fr->stream.stream_id = 1000000009;
+  fr->stream.offset = 1000000007;
+  fr->stream.datacnt = 1;
+  fr->stream.data[0] = datav[1];
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_CONNECTION_CLOSE_APP;
+  fr->connection_close.error_code = 1069447711149177103;
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  memset(&exfr, 0, sizeof(exfr));
+  fr->type = NGTCP2_FRAME_DATAGRAM_LEN;
+  fr->datagram.datacnt = 2;
+  fr->datagram.data = datav;
+  ngtcp2_qlog_write_frame(qlog, fr);
+
+  ngtcp2_pkt_hd_init(&hd, NGTCP2_PKT_FLAG_NONE, NGTCP2_PKT_1RTT, &cid, NULL,
+                     19, 1, 0, 0);
+
+  ngtcp2_qlog_pkt_received_end(qlog, &hd, 1252);
+
+  memset(&cstat, 0, sizeof(cstat));
+  cstat.min_rtt = UINT64_MAX;
+  cstat.smoothed_rtt = 333 * NGTCP2_MILLISECONDS;
+  cstat.latest_rtt = 333 * NGTCP2_MILLISECONDS;
+  cstat.rttvar = 166 * NGTCP2_MILLISECONDS;
+  cstat.cwnd = 12000;
+  cstat.ssthresh = UINT64_MAX;
+
+  ngtcp2_qlog_metrics_updated(qlog, &cstat);
+
+  cstat.min_rtt = 25 * NGTCP2_MILLISECONDS;
+  cstat.latest_rtt = 27 * NGTCP2_MILLISECONDS;
+  cstat.pto_count = 2;
+  cstat.bytes_in_flight = 3000;
+  cstat.ssthresh = 80000;
+
+  ngtcp2_qlog_metrics_updated(qlog, &cstat);
+
+  memset(&ent, 0, sizeof(ent));
+  ent.hd.type = NGTCP2_PKT_HANDSHAKE;
+  ent.hd.flags = NGTCP2_PKT_FLAG_LONG_FORM;
+  ent.hd.pkt_num = 1000000009;
+
+  ngtcp2_qlog_pkt_lost(qlog, &ent);
+
+  memset(&sr, 0, sizeof(sr));
+  memset(sr.stateless_reset_token, 0xab, sizeof(sr.stateless_reset_token));
+
+  ngtcp2_qlog_stateless_reset_pkt_received(qlog, &sr);
+
+  ngtcp2_pkt_hd_init(&hd, NGTCP2_PKT_FLAG_LONG_FORM,
+                     NGTCP2_PKT_VERSION_NEGOTIATION, &cid, &odcid, 0, 0, 0, 0);
+
+  ngtcp2_qlog_version_negotiation_pkt_received(qlog, &hd, sv,
+                                               ngtcp2_arraylen(sv));
+
+  ngtcp2_qlog_end(qlog);
+}
+
+void test_ngtcp2_qlog_decode_binary(void) {
+  ngtcp2_qlog qlog;
+  uint8_t qlogbuf[NGTCP2_QLOG_BUFLEN];
+  uint8_t jsondata[8192], bindata[8192], decodeddata[8192];
+  ngtcp2_buf json, bin, decoded;
+  const uint8_t *p, *end;
+  ngtcp2_ssize nread;
+  uint8_t badrec[] = {0x01, 0xfe};
+
+  ngtcp2_buf_init(&json, jsondata, sizeof(jsondata));
+  ngtcp2_buf_init(&bin, bindata, sizeof(bindata));
+  ngtcp2_buf_init(&decoded, decodeddata, sizeof(decodeddata));
+
+  ngtcp2_qlog_init(&qlog, buf_qlog_write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0,
+                   &json);
+  ngtcp2_buf_init(&qlog.buf, qlogbuf, sizeof(qlogbuf));
+
+  write_qlog_events(&qlog);
+
+  ngtcp2_qlog_init(&qlog, buf_qlog_write, NGTCP2_QLOG_FORMAT_BINARY, 0, &bin);
+  ngtcp2_buf_init(&qlog.buf, qlogbuf, sizeof(qlogbuf));
+
+  write_qlog_events(&qlog);
+
+  assert_size(ngtcp2_buf_len(&json), >, ngtcp2_buf_len(&bin) * 2);
+
+  p = bin.pos;
+  end = bin.last;
+
+  /* Incomplete record */
+  assert_ptrdiff(0, ==, ngtcp2_qlog_decode_binary(buf_qlog_write, &decoded, p,
+                                                  1));
+  assert_size(0, ==, ngtcp2_buf_len(&decoded));
+
+  for (; p != end;) {
+    nread = ngtcp2_qlog_decode_binary(buf_qlog_write, &decoded, p,
+                                      (size_t)(end - p));
+
+    assert_ptrdiff(0, <, nread);
+
+    p += nread;
+  }
+
+  assert_size(ngtcp2_buf_len(&json), ==, ngtcp2_buf_len(&decoded));
+  assert_memory_equal(ngtcp2_buf_len(&json), json.pos, decoded.pos);
+
+  /* Unknown event type */
+  assert_ptrdiff(NGTCP2_ERR_INVALID_ARGUMENT, ==,
+                 ngtcp2_qlog_decode_binary(buf_qlog_write, &decoded, badrec,
+                                           sizeof(badrec)));
+
+  /* Truncated packet_sent record */
+  bindata[0] = 0x40;
+  bindata[1] = 0x02;
+  bindata[2] = NGTCP2_QLOG_BIN_EV_PKT_SENT;
+  bindata[3] = 0;
+
+  assert_ptrdiff(NGTCP2_ERR_INVALID_ARGUMENT, ==,
+                 ngtcp2_qlog_decode_binary(buf_qlog_write, &decoded, bindata,
+                                           4));
+}
+
+static void write_metrics_updated_events(ngtcp2_qlog *qlog, size_t n) {
+  ngtcp2_conn_stat cstat;
+  size_t i;
+
+  memset(&cstat, 0, sizeof(cstat));
+  cstat.min_rtt = UINT64_MAX;
+  cstat.ssthresh = UINT64_MAX;
+
+  for (i = 0; i < n; ++i) {
+    cstat.cwnd = 1000000 + i;
+
+    ngtcp2_qlog_metrics_updated(qlog, &cstat);
+  }
+}
+
+void test_ngtcp2_qlog_flight_recorder(void) {
+  ngtcp2_qlog qlog;
+  uint8_t qlogbuf[NGTCP2_QLOG_BUFLEN];
+  uint8_t recbuf[1024];
+  uint8_t refdata[16384], outdata[16384];
+  ngtcp2_buf ref, out;
+  ngtcp2_cid odcid;
+  size_t preamblelen, taillen, len;
+
+  dcid_init(&odcid);
+
+  ngtcp2_buf_init(&ref, refdata, sizeof(refdata));
+  ngtcp2_buf_init(&out, outdata, sizeof(outdata));
+
+  ngtcp2_qlog_init(&qlog, buf_qlog_write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0,
+                   &ref);
+  ngtcp2_buf_init(&qlog.buf, qlogbuf, sizeof(qlogbuf));
+
+  ngtcp2_qlog_start(&qlog, &odcid, /* server = */ 1);
+
+  preamblelen = ngtcp2_buf_len(&ref);
+
+  write_metrics_updated_events(&qlog, 50);
+
+  /* Events are kept in ring buffer, and only the most recent ones are
+     written on flush. */
+  ngtcp2_qlog_init(&qlog, buf_qlog_write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0,
+                   &out);
+  ngtcp2_buf_init(&qlog.buf, qlogbuf, sizeof(qlogbuf));
+  ngtcp2_qlog_set_recorder(&qlog, recbuf, sizeof(recbuf));
+
+  ngtcp2_qlog_start(&qlog, &odcid, /* server = */ 1);
+  write_metrics_updated_events(&qlog, 50);
+
+  assert_size(0, ==, ngtcp2_buf_len(&out));
+
+  ngtcp2_qlog_flush(&qlog);
+
+  assert_size(preamblelen, <, ngtcp2_buf_len(&out));
+  assert_size(ngtcp2_buf_len(&ref), >, ngtcp2_buf_len(&out));
+  assert_memory_equal(preamblelen, ref.pos, out.pos);
+
+  taillen = ngtcp2_buf_len(&out) - preamblelen;
+
+  assert_uint8('\x1e', ==, out.pos[preamblelen]);
+  assert_memory_equal(taillen, ref.last - taillen, out.pos + preamblelen);
+
+  /* Subsequent events are written immediately. */
+  len = ngtcp2_buf_len(&out);
+
+  write_metrics_updated_events(&qlog, 1);
+
+  assert_size(len, <, ngtcp2_buf_len(&out));
+
+  /* Events are discarded if nothing triggers flush. */
+  ngtcp2_buf_reset(&out);
+
+  ngtcp2_qlog_init(&qlog, buf_qlog_write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0,
+                   &out);
+  ngtcp2_buf_init(&qlog.buf, qlogbuf, sizeof(qlogbuf));
+  ngtcp2_qlog_set_recorder(&qlog, recbuf, sizeof(recbuf));
+
+  ngtcp2_qlog_start(&qlog, &odcid, /* server = */ 1);
+  write_metrics_updated_events(&qlog, 50);
+  ngtcp2_qlog_end(&qlog);
+
+  assert_size(0, ==, ngtcp2_buf_len(&out));
+
+  ngtcp2_qlog_flush(&qlog);
+
+  assert_size(0, ==, ngtcp2_buf_len(&out));
+}
+
+static size_t count_qlog_events(const ngtcp2_buf *buf) {
+  const uint8_t *p;
+  size_t n = 0;
+
+  for (p = buf->pos; p != buf->last; ++p) {
+    if (*p == '\x1e') {
+      ++n;
+    }
+  }
+
+  return n;
+}
+
+static void write_pkt_sent_events(ngtcp2_qlog *qlog, size_t n) {
+  ngtcp2_frame fr;
+  ngtcp2_pkt_hd hd;
+  ngtcp2_cid cid;
+  size_t i;
+
+  scid_init(&cid);
+
+  for (i = 0; i < n; ++i) {
+    ngtcp2_qlog_pkt_sent_start(qlog);
+
+    fr.type = NGTCP2_FRAME_PING;
+    ngtcp2_qlog_write_frame(qlog, &fr);
+
+    ngtcp2_pkt_hd_init(&hd, NGTCP2_PKT_FLAG_NONE, NGTCP2_PKT_1RTT, &cid, NULL,
+                       (int64_t)i, 1, 0, 0);
+
+    ngtcp2_qlog_pkt_sent_end(qlog, &hd, 1200);
+  }
+}
+
+void test_ngtcp2_qlog_filter(void) {
+  ngtcp2_qlog qlog;
+  uint8_t qlogbuf[NGTCP2_QLOG_BUFLEN];
+  uint8_t outdata[16384];
+  ngtcp2_buf out;
+  ngtcp2_rtb_entry ent;
+  ngtcp2_conn_stat cstat;
+
+  ngtcp2_buf_init(&out, outdata, sizeof(outdata));
+
+  /* Frames are filtered out. */
+  ngtcp2_qlog_init(&qlog, buf_qlog_write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0,
+                   &out);
+  ngtcp2_buf_init(&qlog.buf, qlogbuf, sizeof(qlogbuf));
+  ngtcp2_qlog_set_filter(&qlog, NGTCP2_QLOG_FILTER_FRAME, 0, 0);
+
+  write_pkt_sent_events(&qlog, 1);
+  *out.last = '\0';
+
+  assert_size(1, ==, count_qlog_events(&out));
+  assert_not_null(strstr((const char *)out.pos, "\"frames\":[],"));
+  assert_null(strstr((const char *)out.pos, "ping"));
+
+  /* Packet events are filtered out. */
+  ngtcp2_buf_reset(&out);
+
+  ngtcp2_qlog_init(&qlog, buf_qlog_write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0,
+                   &out);
+  ngtcp2_buf_init(&qlog.buf, qlogbuf, sizeof(qlogbuf));
+  ngtcp2_qlog_set_filter(&qlog, NGTCP2_QLOG_FILTER_PKT, 0, 0);
+
+  write_pkt_sent_events(&qlog, 3);
+
+  assert_size(0, ==, ngtcp2_buf_len(&out));
+
+  memset(&ent, 0, sizeof(ent));
+  ent.hd.type = NGTCP2_PKT_1RTT;
+  ent.hd.pkt_num = 1;
+
+  ngtcp2_qlog_pkt_lost(&qlog, &ent);
+
+  assert_size(1, ==, count_qlog_events(&out));
+
+  /* 1 in 3 packets are sampled. */
+  ngtcp2_buf_reset(&out);
+
+  ngtcp2_qlog_init(&qlog, buf_qlog_write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0,
+                   &out);
+  ngtcp2_buf_init(&qlog.buf, qlogbuf, sizeof(qlogbuf));
+  ngtcp2_qlog_set_filter(&qlog, NGTCP2_QLOG_FILTER_NONE, 0, 3);
+
+  write_pkt_sent_events(&qlog, 7);
+
+  assert_size(3, ==, count_qlog_events(&out));
+
+  /* metrics_updated is rate limited. */
+  ngtcp2_buf_reset(&out);
+
+  ngtcp2_qlog_init(&qlog, buf_qlog_write, NGTCP2_QLOG_FORMAT_JSON_SEQ, 0,
+                   &out);
+  ngtcp2_buf_init(&qlog.buf, qlogbuf, sizeof(qlogbuf));
+  ngtcp2_qlog_set_filter(&qlog, NGTCP2_QLOG_FILTER_NONE,
+                         10 * NGTCP2_MILLISECONDS, 0);
+
+  memset(&cstat, 0, sizeof(cstat));
+  cstat.min_rtt = UINT64_MAX;
+  cstat.ssthresh = UINT64_MAX;
+
+  ngtcp2_qlog_metrics_updated(&qlog, &cstat);
+
+  assert_size(1, ==, count_qlog_events(&out));
+
+  qlog.last_ts += 9 * NGTCP2_MILLISECONDS;
+  ngtcp2_qlog_metrics_updated(&qlog, &cstat);
+
+  assert_size(1, ==, count_qlog_events(&out));
+
+  qlog.last_ts += NGTCP2_MILLISECONDS;
+  ngtcp2_qlog_metrics_updated(&qlog, &cstat);
+
+  assert_size(2, ==, count_qlog_events(&out));
+}
@@ -36,5 +36,8 @@
 extern const MunitSuite qlog_suite;
 
 munit_void_test_decl(test_ngtcp2_qlog_write_frame);
+munit_void_test_decl(test_ngtcp2_qlog_decode_binary);
+munit_void_test_decl(test_ngtcp2_qlog_flight_recorder);
+munit_void_test_decl(test_ngtcp2_qlog_filter);
 
 #endif /* NGTCP2_QLOG_TEST_H */
@@ -358,6 +358,7 @@ void test_ngtcp2_rtb_lost_pkt_ts(void) {
   ent = ngtcp2_ksl_it_get(&it);
   ent->flags |= NGTCP2_RTB_ENTRY_FLAG_LOST_RETRANSMITTED;
   ent->lost_ts = 16777217;
+  ++rtb.num_lost_pkts;
 
   assert_uint64(16777217, ==, ngtcp2_rtb_lost_pkt_ts(&rtb));
 
@@ -127,6 +127,14 @@ void test_ngtcp2_settings_convert_to_latest(void) {
   assert_uint32(srcbuf.initial_pkt_num, ==, dest->initial_pkt_num);
   assert_null(dest->pmtud_probes);
   assert_size(0, ==, dest->pmtud_probeslen);
+  assert_enum(ngtcp2_qlog_format, NGTCP2_QLOG_FORMAT_JSON_SEQ, ==,
+              dest->qlog_format);
+  assert_size(0, ==, dest->qlog_flight_recorder_size);
+  assert_size(0, ==, dest->qlog_flight_recorder_pto_count);
+  assert_uint32(NGTCP2_QLOG_FILTER_NONE, ==, dest->qlog_filter);
+  assert_uint64(0, ==, dest->qlog_metrics_interval);
+  assert_size(0, ==, dest->qlog_pkt_sample_rate);
+  assert_uint8(0, ==, dest->histograms);
 }
 
 void test_ngtcp2_settings_convert_to_old(void) {
@@ -162,6 +170,13 @@ void test_ngtcp2_settings_convert_to_old(void) {
   src.initial_pkt_num = 918608434;
   src.pmtud_probes = pmtud_probes;
   src.pmtud_probeslen = ngtcp2_arraylen(pmtud_probes);
+  src.qlog_format = NGTCP2_QLOG_FORMAT_BINARY;
+  src.qlog_flight_recorder_size = 65536;
+  src.qlog_flight_recorder_pto_count = 3;
+  src.qlog_filter = NGTCP2_QLOG_FILTER_FRAME;
+  src.qlog_metrics_interval = 100 * NGTCP2_MILLISECONDS;
+  src.qlog_pkt_sample_rate = 10;
+  src.histograms = 1;
 
   ngtcp2_settings_convert_to_old(NGTCP2_SETTINGS_V1, dest, &src);
 
@@ -0,0 +1,198 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "ngtcp2_timer_wheel_test.h"
+
+#include <stdio.h>
+
+#include "ngtcp2_timer_wheel.h"
+#include "ngtcp2_test_helper.h"
+
+static const MunitTest tests[] = {
+    munit_void_test(test_ngtcp2_timer_wheel_update),
+    munit_void_test(test_ngtcp2_timer_wheel_advance),
+    munit_test_end(),
+};
+
+const MunitSuite timer_wheel_suite = {
+    "/timer_wheel", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE,
+};
+
+void test_ngtcp2_timer_wheel_update(void) {
+  const ngtcp2_mem *mem = ngtcp2_mem_default();
+  ngtcp2_timer_wheel tw;
+  ngtcp2_timer_wheel_entry ents[4];
+  size_t i;
+
+  ngtcp2_timer_wheel_init(&tw, NGTCP2_MILLISECONDS, 0, mem);
+
+  for (i = 0; i < ngtcp2_arraylen(ents); ++i) {
+    ngtcp2_timer_wheel_entry_init(&ents[i]);
+    ngtcp2_timer_wheel_attach(&tw, &ents[i]);
+  }
+
+  assert_uint64(UINT64_MAX, ==, ngtcp2_timer_wheel_get_expiry(&tw));
+
+  /* The expiry is rounded up to the tick. */
+  ngtcp2_timer_wheel_update(&tw, &ents[0], 5 * NGTCP2_MILLISECONDS - 1);
+
+  assert_size(1, ==, tw.len);
+  assert_uint8(0, ==, ents[0].level);
+  assert_uint8(5, ==, ents[0].slot);
+  assert_uint64(5 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_timer_wheel_get_expiry(&tw));
+
+  ngtcp2_timer_wheel_update(&tw, &ents[1], 100 * NGTCP2_MILLISECONDS);
+
+  assert_size(2, ==, tw.len);
+  assert_uint8(1, ==, ents[1].level);
+  assert_uint8(1, ==, ents[1].slot);
+
+  ngtcp2_timer_wheel_update(&tw, &ents[2], 10 * NGTCP2_SECONDS);
+
+  assert_size(3, ==, tw.len);
+  assert_uint8(2, ==, ents[2].level);
+
+  /* Too far in the future */
+  ngtcp2_timer_wheel_update(&tw, &ents[3], 365 * 24 * 3600 * NGTCP2_SECONDS);
+
+  assert_size(4, ==, tw.len);
+  assert_uint8(NGTCP2_TIMER_WHEEL_NUM_LEVELS - 1, ==, ents[3].level);
+
+  /* UINT64_MAX removes the entry. */
+  ngtcp2_timer_wheel_update(&tw, &ents[3], UINT64_MAX);
+
+  assert_size(3, ==, tw.len);
+  assert_null(ents[3].pprev);
+  assert_uint64(UINT64_MAX, ==, ents[3].expiry);
+
+  /* Re-schedule */
+  ngtcp2_timer_wheel_update(&tw, &ents[0], 200 * NGTCP2_MILLISECONDS);
+
+  assert_size(3, ==, tw.len);
+  assert_uint8(1, ==, ents[0].level);
+  assert_uint8(3, ==, ents[0].slot);
+  assert_uint64(0, ==, tw.bitmap[0]);
+  /* The upper level reports the tick when the slot is cascaded. */
+  assert_uint64(64 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_timer_wheel_get_expiry(&tw));
+
+  ngtcp2_timer_wheel_remove(&tw, &ents[1]);
+  ngtcp2_timer_wheel_remove(&tw, &ents[1]);
+
+  assert_size(2, ==, tw.len);
+  assert_uint64(1u << 3, ==, tw.bitmap[1]);
+
+  /* The expiry in the past expires immediately. */
+  tw.now = 10;
+  ngtcp2_timer_wheel_update(&tw, &ents[1], 10 * NGTCP2_MILLISECONDS);
+
+  assert_uint8(NGTCP2_TIMER_WHEEL_NUM_LEVELS, ==, ents[1].level);
+  assert_uint64(10 * NGTCP2_MILLISECONDS, ==,
+                ngtcp2_timer_wheel_get_expiry(&tw));
+  assert_ptr_equal(&ents[1], ngtcp2_timer_wheel_pop_expired(&tw));
+  assert_null(ngtcp2_timer_wheel_pop_expired(&tw));
+  assert_size(2, ==, tw.len);
+
+  /* Detaching removes the scheduled entry too. */
+  ngtcp2_timer_wheel_detach(&tw, &ents[0]);
+
+  assert_size(1, ==, tw.len);
+  assert_null(ents[0].pprev);
+  assert_null(ents[0].attached_pprev);
+
+  /* The popped entry is not scheduled, but still attached. */
+  ngtcp2_timer_wheel_detach(&tw, &ents[1]);
+
+  assert_size(1, ==, tw.len);
+  assert_null(ents[1].attached_pprev);
+  assert_ptr_equal(&ents[3], tw.attached);
+  assert_ptr_equal(&ents[2], ents[3].attached_next);
+  assert_null(ents[2].attached_next);
+}
+
+void test_ngtcp2_timer_wheel_advance(void) {
+  const ngtcp2_mem *mem = ngtcp2_mem_default();
+  ngtcp2_timer_wheel tw;
+  ngtcp2_timer_wheel_entry ents[1024], *ent;
+  ngtcp2_tstamp ts, expiry, exp_expiry;
+  size_t i, nexpired = 0;
+  uint64_t x = 0x1234567890abcdefull;
+
+  ngtcp2_timer_wheel_init(&tw, NGTCP2_MILLISECONDS, 1000 * NGTCP2_SECONDS,
+                          mem);
+
+  for (i = 0; i < ngtcp2_arraylen(ents); ++i) {
+    ngtcp2_timer_wheel_entry_init(&ents[i]);
+    ngtcp2_timer_wheel_attach(&tw, &ents[i]);
+
+    /* xorshift64 */
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    /* Spread the expiry over all levels. */
+    expiry = 1000 * NGTCP2_SECONDS + (x % (1ull << (i % 40)));
+
+    ngtcp2_timer_wheel_update(&tw, &ents[i], expiry);
+  }
+
+  assert_size(ngtcp2_arraylen(ents), ==, tw.len);
+
+  for (ts = 1000 * NGTCP2_SECONDS; tw.len;) {
+    exp_expiry = UINT64_MAX;
+
+    for (i = 0; i < ngtcp2_arraylen(ents); ++i) {
+      if (ents[i].pprev) {
+        exp_expiry = ngtcp2_min_uint64(exp_expiry, ents[i].expiry);
+      }
+    }
+
+    expiry = ngtcp2_timer_wheel_get_expiry(&tw);
+
+    /* Never later than the earliest expiry rounded up to the tick. */
+    assert_uint64(expiry, <=,
+                  (exp_expiry + NGTCP2_MILLISECONDS - 1) /
+                      NGTCP2_MILLISECONDS * NGTCP2_MILLISECONDS);
+
+    ts = ngtcp2_max_uint64(ts, expiry);
+
+    ngtcp2_timer_wheel_advance(&tw, ts);
+
+    for (; (ent = ngtcp2_timer_wheel_pop_expired(&tw)) != NULL;) {
+      assert_null(ent->pprev);
+
+      ++nexpired;
+    }
+
+    /* Nothing which has expired is left in the wheel. */
+    for (i = 0; i < ngtcp2_arraylen(ents); ++i) {
+      if (ents[i].pprev) {
+        assert_uint64(ts, <, ents[i].expiry);
+      }
+    }
+  }
+
+  assert_size(ngtcp2_arraylen(ents), ==, nexpired);
+}
@@ -0,0 +1,395 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * replay feeds a trace recorded by ccsim (-t or -T) to a single
+ * connection, and measures the time spent in the library.  There is
+ * no link and no peer: received packets come from the trace, and
+ * written packets are discarded.  The clock is taken from the trace
+ * as well, so each round performs exactly the same work, which makes
+ * this program suitable for running under perf or callgrind.
+ *
+ * The number of bytes written by each write call is compared with
+ * the trace.  A mismatch means that the library no longer behaves the
+ * same as when the trace was recorded, and the replay stops.
+ *
+ * Only the sim endpoints can record a trace.  They use null crypto,
+ * and their only nondeterministic input is the link.  A connection
+ * which uses TLS cannot be replayed from its datagrams and secrets
+ * alone.  The received ACK frames acknowledge the packets which the
+ * original connection sent.  The replayed connection has to send
+ * exactly the same packets, or it rejects those ACK frames.  That
+ * requires recording every input to the connection, which includes
+ * the handshake messages produced by the TLS stack, the output of the
+ * rand callback, and every application call.
+ *
+ * The result is written to stdout as a JSON object:
+ *
+ * {"trace":"...","records":...,"pkts":...,"rounds":5,
+ *  "ns_per_pkt_min":...,"ns_per_pkt_median":...}
+ *
+ * "pkts" is the number of packets read.
+ *
+ * Usage: replay [-r ROUNDS] TRACE
+ */
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ngtcp2_conv.h"
+#include "ngtcp2_macro.h"
+#include "ngtcp2_test_helper.h"
+#include "sim.h"
+
+/* REPLAY_MAX_ROUNDS is the maximum number of rounds. */
+#define REPLAY_MAX_ROUNDS 64
+
+typedef struct replay_record {
+  sim_trace_type type;
+  ngtcp2_tstamp ts;
+  /* n is the length of data for SIM_TRACE_READ_PKT, and the number of
+     bytes written for SIM_TRACE_WRITE. */
+  uint64_t n;
+  const uint8_t *data;
+} replay_record;
+
+typedef struct replay_trace {
+  uint8_t *buf;
+  int server;
+  ngtcp2_cc_algo cc_algo;
+  uint64_t total;
+  replay_record *records;
+  size_t nrecords;
+  size_t npkts;
+} replay_trace;
+
+static uint64_t replay_now(void) {
+  struct timespec tp;
+
+  clock_gettime(CLOCK_MONOTONIC, &tp);
+
+  return (uint64_t)tp.tv_sec * NGTCP2_SECONDS + (uint64_t)tp.tv_nsec;
+}
+
+/*
+ * replay_get_uvarint decodes a variable-length integer at |*pp| into
+ * |*pdest|, and advances |*pp|.  It returns -1 if the integer does
+ * not fit in [*pp, end).
+ */
+static int replay_get_uvarint(uint64_t *pdest, const uint8_t **pp,
+                              const uint8_t *end) {
+  if (*pp == end || (size_t)(end - *pp) < ngtcp2_get_uvarintlen(*pp)) {
+    return -1;
+  }
+
+  *pp = ngtcp2_get_uvarint(pdest, *pp);
+
+  return 0;
+}
+
+/*
+ * replay_load reads and parses the trace file at |path|.
+ */
+static int replay_load(replay_trace *t, const char *path) {
+  FILE *fp;
+  long size;
+  const uint8_t *p, *end;
+  uint64_t version, server, cc_algo, type;
+  replay_record *rec;
+  size_t max_records;
+
+  memset(t, 0, sizeof(*t));
+
+  fp = fopen(path, "rb");
+  if (!fp) {
+    fprintf(stderr, "%s: could not open\n", path);
+    return -1;
+  }
+
+  if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 ||
+      fseek(fp, 0, SEEK_SET) != 0) {
+    fprintf(stderr, "%s: could not read\n", path);
+    fclose(fp);
+    return -1;
+  }
+
+  t->buf = malloc((size_t)size + 1);
+  if (!t->buf) {
+    fprintf(stderr, "out of memory\n");
+    fclose(fp);
+    return -1;
+  }
+
+  if (fread(t->buf, 1, (size_t)size, fp) != (size_t)size) {
+    fprintf(stderr, "%s: could not read\n", path);
+    fclose(fp);
+    return -1;
+  }
+
+  fclose(fp);
+
+  p = t->buf;
+  end = t->buf + size;
+
+  if ((size_t)(end - p) < sizeof(SIM_TRACE_MAGIC) - 1 ||
+      memcmp(p, SIM_TRACE_MAGIC, sizeof(SIM_TRACE_MAGIC) - 1) != 0) {
+    fprintf(stderr, "%s: not a trace file\n", path);
+    return -1;
+  }
+
+  p += sizeof(SIM_TRACE_MAGIC) - 1;
+
+  if (replay_get_uvarint(&version, &p, end) != 0 ||
+      replay_get_uvarint(&server, &p, end) != 0 ||
+      replay_get_uvarint(&cc_algo, &p, end) != 0 ||
+      replay_get_uvarint(&t->total, &p, end) != 0) {
+    fprintf(stderr, "%s: truncated header\n", path);
+    return -1;
+  }
+
+  if (version != SIM_TRACE_VERSION) {
+    fprintf(stderr, "%s: unsupported version %llu\n", path,
+            (unsigned long long)version);
+    return -1;
+  }
+
+  t->server = server != 0;
+  t->cc_algo = (ngtcp2_cc_algo)cc_algo;
+
+  /* Each record takes at least 2 bytes. */
+  max_records = (size_t)(end - p) / 2 + 1;
+
+  t->records = malloc(sizeof(t->records[0]) * max_records);
+  if (!t->records) {
+    fprintf(stderr, "out of memory\n");
+    return -1;
+  }
+
+  while (p != end) {
+    rec = &t->records[t->nrecords];
+
+    if (replay_get_uvarint(&type, &p, end) != 0 ||
+        replay_get_uvarint(&rec->ts, &p, end) != 0) {
+      goto truncated;
+    }
+
+    rec->n = 0;
+    rec->data = NULL;
+
+    switch (type) {
+    case SIM_TRACE_READ_PKT:
+      if (replay_get_uvarint(&rec->n, &p, end) != 0 ||
+          (uint64_t)(end - p) < rec->n) {
+        goto truncated;
+      }
+
+      rec->data = p;
+      p += rec->n;
+      ++t->npkts;
+
+      break;
+    case SIM_TRACE_WRITE:
+      if (replay_get_uvarint(&rec->n, &p, end) != 0) {
+        goto truncated;
+      }
+
+      break;
+    case SIM_TRACE_EXPIRY:
+      break;
+    default:
+      fprintf(stderr, "%s: unknown record type %llu\n", path,
+              (unsigned long long)type);
+      return -1;
+    }
+
+    rec->type = (sim_trace_type)type;
+    ++t->nrecords;
+  }
+
+  return 0;
+
+truncated:
+  fprintf(stderr, "%s: truncated record %zu\n", path, t->nrecords);
+
+  return -1;
+}
+
+static void replay_free(replay_trace *t) {
+  free(t->records);
+  free(t->buf);
+}
+
+/*
+ * replay_run feeds all records in |t| to a fresh endpoint, and stores
+ * the time spent in |*pelapsed|.
+ */
+static int replay_run(const replay_trace *t, uint64_t *pelapsed) {
+  ngtcp2_path_storage ps;
+  sim_endpoint ep;
+  sim_sender s, *sp = NULL;
+  const replay_record *rec;
+  ngtcp2_tstamp ts = 0;
+  ngtcp2_ssize nwrite;
+  uint64_t start;
+  size_t i;
+  int rv = -1;
+
+  memset(&ep, 0, sizeof(ep));
+
+  path_init(&ps, 0, 0, 0, 0);
+
+  if (sim_endpoint_init(&ep, t->server, t->cc_algo,
+                        NGTCP2_MAX_UDP_PAYLOAD_SIZE, &ps.path, &ts) != 0) {
+    fprintf(stderr, "could not create connection\n");
+    goto fin;
+  }
+
+  if (!t->server) {
+    if (sim_sender_init(&s, &ep, t->total) != 0) {
+      fprintf(stderr, "could not open stream\n");
+      goto fin;
+    }
+
+    sp = &s;
+  }
+
+  start = replay_now();
+
+  for (i = 0; i < t->nrecords; ++i) {
+    rec = &t->records[i];
+    ts = rec->ts;
+
+    switch (rec->type) {
+    case SIM_TRACE_READ_PKT:
+      if (sim_endpoint_read(&ep, &ps.path, rec->data, (size_t)rec->n, ts) !=
+          0) {
+        goto diverged;
+      }
+
+      break;
+    case SIM_TRACE_WRITE:
+      nwrite = sim_endpoint_write(&ep, sp, NULL, 0, ts);
+      if (nwrite < 0) {
+        goto diverged;
+      }
+
+      if ((uint64_t)nwrite != rec->n) {
+        fprintf(stderr, "wrote %td bytes, but trace has %llu\n", nwrite,
+                (unsigned long long)rec->n);
+        goto diverged;
+      }
+
+      break;
+    case SIM_TRACE_EXPIRY:
+      if (sim_endpoint_handle_expiry(&ep, ts) != 0) {
+        goto diverged;
+      }
+
+      break;
+    }
+  }
+
+  *pelapsed = replay_now() - start;
+
+  rv = 0;
+
+  goto fin;
+
+diverged:
+  fprintf(stderr, "replay diverged at record %zu (ts=%llu)\n", i,
+          (unsigned long long)ts);
+
+fin:
+  sim_endpoint_free(&ep);
+
+  return rv;
+}
+
+static int replay_compar_uint64(const void *lhs, const void *rhs) {
+  uint64_t a = *(const uint64_t *)lhs, b = *(const uint64_t *)rhs;
+
+  return a < b ? -1 : a > b;
+}
+
+int main(int argc, char **argv) {
+  uint64_t elapsed[REPLAY_MAX_ROUNDS];
+  replay_trace t;
+  size_t rounds = 5, npkts;
+  const char *path = NULL;
+  size_t i;
+  int n;
+  int rv = EXIT_FAILURE;
+
+  for (n = 1; n < argc; ++n) {
+    if (strcmp(argv[n], "-r") == 0 && n + 1 < argc) {
+      rounds = (size_t)strtoul(argv[++n], NULL, 10);
+      if (rounds == 0 || rounds > REPLAY_MAX_ROUNDS) {
+        fprintf(stderr, "-r: ROUNDS must be in [1, %d]\n", REPLAY_MAX_ROUNDS);
+        return EXIT_FAILURE;
+      }
+
+      continue;
+    }
+
+    path = argv[n];
+  }
+
+  if (!path) {
+    fprintf(stderr, "Usage: replay [-r ROUNDS] TRACE\n");
+    return EXIT_FAILURE;
+  }
+
+  if (replay_load(&t, path) != 0) {
+    goto fin;
+  }
+
+  for (i = 0; i < rounds; ++i) {
+    if (replay_run(&t, &elapsed[i]) != 0) {
+      goto fin;
+    }
+  }
+
+  qsort(elapsed, rounds, sizeof(elapsed[0]), replay_compar_uint64);
+
+  npkts = ngtcp2_max_size(t.npkts, 1);
+
+  printf("{\"trace\":\"%s\",\"records\":%zu,\"pkts\":%zu,\"rounds\":%zu,"
+         "\"ns_per_pkt_min\":%.3f,\"ns_per_pkt_median\":%.3f}\n",
+         path, t.nrecords, t.npkts, rounds,
+         (double)elapsed[0] / (double)npkts,
+         (double)elapsed[rounds / 2] / (double)npkts);
+
+  rv = EXIT_SUCCESS;
+
+fin:
+  replay_free(&t);
+
+  return rv;
+}
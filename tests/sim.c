@@ -0,0 +1,791 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "ngtcp2_conn.h"
+#include "ngtcp2_conv.h"
+#include "ngtcp2_transport_params.h"
+#include "ngtcp2_macro.h"
+#include "ngtcp2_str.h"
+#include "ngtcp2_test_helper.h"
+
+static int sim_pkt_less(const ngtcp2_pq_entry *lhs,
+                        const ngtcp2_pq_entry *rhs) {
+  const sim_pkt *a = ngtcp2_struct_of(lhs, sim_pkt, pe);
+  const sim_pkt *b = ngtcp2_struct_of(rhs, sim_pkt, pe);
+
+  if (a->arrival == b->arrival) {
+    return a->seq < b->seq;
+  }
+
+  return a->arrival < b->arrival;
+}
+
+uint64_t sim_rand(uint64_t *state) {
+  uint64_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+
+  return *state = x;
+}
+
+int sim_link_init(sim_link *l, const sim_link_config *config, uint64_t seed) {
+  size_t i;
+
+  assert(config->mtu <= SIM_MAX_MTU);
+  assert(config->mtu == 0 ||
+         config->mtu >= NGTCP2_MAX_UDP_PAYLOAD_SIZE + SIM_PKT_OVERHEAD);
+
+  memset(l, 0, sizeof(*l));
+
+  l->config = config;
+  l->rand_state = seed ? seed : 0x9e3779b97f4a7c15ULL;
+  l->policer_tokens = config->policer_burst;
+  l->max_pktlen =
+    (config->mtu ? config->mtu : SIM_DEFAULT_MTU) - SIM_PKT_OVERHEAD;
+
+  l->pkts = malloc(sizeof(l->pkts[0]) * SIM_LINK_CAPACITY);
+  l->buf = malloc(l->max_pktlen * SIM_LINK_CAPACITY);
+  l->freelist = malloc(sizeof(l->freelist[0]) * SIM_LINK_CAPACITY);
+
+  if (!l->pkts || !l->buf || !l->freelist) {
+    free(l->freelist);
+    free(l->buf);
+    free(l->pkts);
+
+    return -1;
+  }
+
+  ngtcp2_pq_init(&l->pq, sim_pkt_less, ngtcp2_mem_default());
+
+  for (i = 0; i < SIM_LINK_CAPACITY; ++i) {
+    l->pkts[i].data = l->buf + i * l->max_pktlen;
+    l->freelist[i] = SIM_LINK_CAPACITY - i - 1;
+  }
+
+  l->freelen = SIM_LINK_CAPACITY;
+
+  return 0;
+}
+
+void sim_link_free(sim_link *l) {
+  ngtcp2_pq_free(&l->pq);
+  free(l->freelist);
+  free(l->buf);
+  free(l->pkts);
+}
+
+static int sim_link_chance(sim_link *l, uint32_t ppm) {
+  return ppm && sim_rand(&l->rand_state) % 1000000 < ppm;
+}
+
+/*
+ * sim_link_police returns nonzero if the policer of |l| admits a
+ * packet of length |len| at |ts|.
+ */
+static int sim_link_police(sim_link *l, size_t len, ngtcp2_tstamp ts) {
+  const sim_link_config *config = l->config;
+  uint64_t refill;
+
+  if (config->policer_rate == 0) {
+    return 1;
+  }
+
+  refill = (ts - l->policer_ts) * config->policer_rate / (8 * NGTCP2_SECONDS);
+  if (refill) {
+    /* Only consume the time which has been converted to tokens, so
+       that no fraction of a byte is lost. */
+    l->policer_ts += refill * 8 * NGTCP2_SECONDS / config->policer_rate;
+    l->policer_tokens = ngtcp2_min_uint64(l->policer_tokens + refill,
+                                          config->policer_burst);
+  }
+
+  if (l->policer_tokens < len) {
+    return 0;
+  }
+
+  l->policer_tokens -= len;
+
+  return 1;
+}
+
+void sim_link_send(sim_link *l, size_t flow, const uint8_t *data, size_t len,
+                   ngtcp2_tstamp ts) {
+  const sim_link_config *config = l->config;
+  sim_pkt *pkt;
+  ngtcp2_tstamp start, arrival;
+  uint64_t queued;
+
+  assert(len <= SIM_MAX_PKTLEN);
+
+  if (len > l->max_pktlen || sim_link_chance(l, config->loss) || !sim_link_police(l, len, ts) ||
+      l->freelen == 0) {
+    ++l->drops;
+    return;
+  }
+
+  if (config->bandwidth) {
+    start = ngtcp2_max_uint64(ts, l->busy_until);
+    queued = (start - ts) * config->bandwidth / (8 * NGTCP2_SECONDS);
+
+    if (config->queue && queued + len > config->queue) {
+      ++l->drops;
+      return;
+    }
+
+    l->busy_until =
+      start + (uint64_t)len * 8 * NGTCP2_SECONDS / config->bandwidth;
+    arrival = l->busy_until + config->delay;
+  } else {
+    arrival = ts + config->delay;
+  }
+
+  if (config->jitter) {
+    arrival += sim_rand(&l->rand_state) % (config->jitter + 1);
+  }
+
+  if (config->aggregation) {
+    arrival = (arrival + config->aggregation - 1) / config->aggregation *
+              config->aggregation;
+  }
+
+  if (sim_link_chance(l, config->reorder)) {
+    arrival += ngtcp2_max_uint64(config->delay / 2, NGTCP2_MILLISECONDS);
+  } else {
+    arrival = ngtcp2_max_uint64(arrival, l->last_arrival);
+    l->last_arrival = arrival;
+  }
+
+  pkt = &l->pkts[l->freelist[--l->freelen]];
+  pkt->arrival = arrival;
+  pkt->seq = l->seq++;
+  pkt->flow = flow;
+  pkt->len = len;
+  memcpy(pkt->data, data, len);
+
+  ngtcp2_pq_push(&l->pq, &pkt->pe);
+}
+
+ngtcp2_tstamp sim_link_next_arrival(sim_link *l) {
+  if (ngtcp2_pq_empty(&l->pq)) {
+    return UINT64_MAX;
+  }
+
+  return sim_link_top(l)->arrival;
+}
+
+sim_pkt *sim_link_top(sim_link *l) {
+  return ngtcp2_struct_of(ngtcp2_pq_top(&l->pq), sim_pkt, pe);
+}
+
+void sim_link_pop(sim_link *l) {
+  sim_pkt *pkt = sim_link_top(l);
+
+  ngtcp2_pq_pop(&l->pq);
+
+  l->freelist[l->freelen++] = (size_t)(pkt - l->pkts);
+}
+
+static uint8_t null_secret[32];
+static uint8_t null_iv[16];
+static uint8_t null_data[SIM_MAX_PKTLEN];
+
+/*
+ * The handshake callbacks are required by ngtcp2_conn_client_new and
+ * ngtcp2_conn_server_new, but they are never called because the
+ * connections start in post-handshake state.
+ */
+static int client_initial(ngtcp2_conn *conn, void *user_data) {
+  (void)conn;
+  (void)user_data;
+
+  return NGTCP2_ERR_CALLBACK_FAILURE;
+}
+
+static int recv_client_initial(ngtcp2_conn *conn, const ngtcp2_cid *dcid,
+                               void *user_data) {
+  (void)conn;
+  (void)dcid;
+  (void)user_data;
+
+  return NGTCP2_ERR_CALLBACK_FAILURE;
+}
+
+static int recv_crypto_data(ngtcp2_conn *conn,
+                            ngtcp2_encryption_level encryption_level,
+                            uint64_t offset, const uint8_t *data,
+                            size_t datalen, void *user_data) {
+  (void)conn;
+  (void)encryption_level;
+  (void)offset;
+  (void)data;
+  (void)datalen;
+  (void)user_data;
+
+  return NGTCP2_ERR_CALLBACK_FAILURE;
+}
+
+static int recv_retry(ngtcp2_conn *conn, const ngtcp2_pkt_hd *hd,
+                      void *user_data) {
+  (void)conn;
+  (void)hd;
+  (void)user_data;
+
+  return NGTCP2_ERR_CALLBACK_FAILURE;
+}
+
+/*
+ * null_encrypt does not encrypt, but writes the nonce as the tag, so
+ * that null_decrypt fails if the packet number is decoded wrongly.  A
+ * real AEAD fails in that case, too.  Packets which are delayed by
+ * reordering might be decoded with the wrong packet number.
+ */
+static int null_encrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                        const ngtcp2_crypto_aead_ctx *aead_ctx,
+                        const uint8_t *plaintext, size_t plaintextlen,
+                        const uint8_t *nonce, size_t noncelen,
+                        const uint8_t *aad, size_t aadlen) {
+  (void)aead;
+  (void)aead_ctx;
+  (void)aad;
+  (void)aadlen;
+
+  if (plaintextlen && plaintext != dest) {
+    memcpy(dest, plaintext, plaintextlen);
+  }
+  memset(dest + plaintextlen, 0, NGTCP2_FAKE_AEAD_OVERHEAD);
+  memcpy(dest + plaintextlen, nonce,
+         ngtcp2_min_size(noncelen, NGTCP2_FAKE_AEAD_OVERHEAD));
+
+  return 0;
+}
+
+static int null_decrypt(uint8_t *dest, const ngtcp2_crypto_aead *aead,
+                        const ngtcp2_crypto_aead_ctx *aead_ctx,
+                        const uint8_t *ciphertext, size_t ciphertextlen,
+                        const uint8_t *nonce, size_t noncelen,
+                        const uint8_t *aad, size_t aadlen) {
+  size_t plaintextlen;
+  (void)aead;
+  (void)aead_ctx;
+  (void)aad;
+  (void)aadlen;
+
+  assert(ciphertextlen >= NGTCP2_FAKE_AEAD_OVERHEAD);
+
+  plaintextlen = ciphertextlen - NGTCP2_FAKE_AEAD_OVERHEAD;
+
+  if (memcmp(ciphertext + plaintextlen, nonce,
+             ngtcp2_min_size(noncelen, NGTCP2_FAKE_AEAD_OVERHEAD)) != 0) {
+    return NGTCP2_ERR_DECRYPT;
+  }
+
+  memmove(dest, ciphertext, plaintextlen);
+
+  return 0;
+}
+
+static int null_hp_mask(uint8_t *dest, const ngtcp2_crypto_cipher *hp,
+                        const ngtcp2_crypto_cipher_ctx *hp_ctx,
+                        const uint8_t *sample) {
+  (void)hp;
+  (void)hp_ctx;
+  (void)sample;
+
+  memcpy(dest, NGTCP2_FAKE_HP_MASK, sizeof(NGTCP2_FAKE_HP_MASK) - 1);
+
+  return 0;
+}
+
+static void genrand(uint8_t *dest, size_t destlen,
+                    const ngtcp2_rand_ctx *rand_ctx) {
+  (void)rand_ctx;
+
+  memset(dest, 0, destlen);
+}
+
+static int get_new_connection_id(ngtcp2_conn *conn, ngtcp2_cid *cid,
+                                 uint8_t *token, size_t cidlen,
+                                 void *user_data) {
+  (void)user_data;
+
+  memset(cid->data, 0, cidlen);
+  cid->data[0] = (uint8_t)(conn->scid.last_seq + 1);
+  cid->data[cidlen - 1] = (uint8_t)conn->server;
+  cid->datalen = cidlen;
+  memset(token, 0, NGTCP2_STATELESS_RESET_TOKENLEN);
+
+  return 0;
+}
+
+static int update_key(ngtcp2_conn *conn, uint8_t *rx_secret, uint8_t *tx_secret,
+                      ngtcp2_crypto_aead_ctx *rx_aead_ctx, uint8_t *rx_iv,
+                      ngtcp2_crypto_aead_ctx *tx_aead_ctx, uint8_t *tx_iv,
+                      const uint8_t *current_rx_secret,
+                      const uint8_t *current_tx_secret, size_t secretlen,
+                      void *user_data) {
+  (void)conn;
+  (void)current_rx_secret;
+  (void)current_tx_secret;
+  (void)user_data;
+
+  memset(rx_secret, 0xff, secretlen);
+  memset(tx_secret, 0xff, secretlen);
+  rx_aead_ctx->native_handle = NULL;
+  memset(rx_iv, 0xff, sizeof(null_iv));
+  tx_aead_ctx->native_handle = NULL;
+  memset(tx_iv, 0xff, sizeof(null_iv));
+
+  return 0;
+}
+
+static void delete_crypto_aead_ctx(ngtcp2_conn *conn,
+                                   ngtcp2_crypto_aead_ctx *aead_ctx,
+                                   void *user_data) {
+  (void)conn;
+  (void)aead_ctx;
+  (void)user_data;
+}
+
+static void delete_crypto_cipher_ctx(ngtcp2_conn *conn,
+                                     ngtcp2_crypto_cipher_ctx *cipher_ctx,
+                                     void *user_data) {
+  (void)conn;
+  (void)cipher_ctx;
+  (void)user_data;
+}
+
+static int get_path_challenge_data(ngtcp2_conn *conn, uint8_t *data,
+                                   void *user_data) {
+  (void)conn;
+  (void)user_data;
+
+  memset(data, 0, NGTCP2_PATH_CHALLENGE_DATALEN);
+
+  return 0;
+}
+
+static int recv_stream_data(ngtcp2_conn *conn, uint32_t flags,
+                            int64_t stream_id, uint64_t offset,
+                            const uint8_t *data, size_t datalen,
+                            void *user_data, void *stream_user_data) {
+  sim_endpoint *ep = user_data;
+  (void)offset;
+  (void)data;
+  (void)stream_user_data;
+
+  ep->received += datalen;
+
+  ngtcp2_conn_extend_max_stream_offset(conn, stream_id, datalen);
+  ngtcp2_conn_extend_max_offset(conn, datalen);
+
+  if (flags & NGTCP2_STREAM_DATA_FLAG_FIN) {
+    ep->fin_ts = *ep->ts;
+  }
+
+  return 0;
+}
+
+static void sim_transport_params(ngtcp2_transport_params *params,
+                                      int server) {
+  ngtcp2_transport_params_default(params);
+  params->initial_max_stream_data_bidi_local = 16 * 1024 * 1024;
+  params->initial_max_stream_data_bidi_remote = 16 * 1024 * 1024;
+  params->initial_max_stream_data_uni = 16 * 1024 * 1024;
+  params->initial_max_data = 16 * 1024 * 1024;
+  params->initial_max_streams_bidi = 1;
+  params->initial_max_streams_uni = 0;
+  params->max_idle_timeout = 60 * NGTCP2_SECONDS;
+  params->active_connection_id_limit = 8;
+  if (server) {
+    params->original_dcid_present = 1;
+    params->stateless_reset_token_present = 1;
+  }
+}
+
+int sim_endpoint_init(sim_endpoint *ep, int server, ngtcp2_cc_algo cc_algo,
+                      size_t max_pktlen, const ngtcp2_path *path,
+                      const ngtcp2_tstamp *ts) {
+  ngtcp2_callbacks cb;
+  ngtcp2_settings settings;
+  ngtcp2_transport_params params, remote_params;
+  ngtcp2_cid client_cid, server_cid;
+  ngtcp2_crypto_aead_ctx aead_ctx = {0};
+  ngtcp2_crypto_cipher_ctx hp_ctx = {0};
+  ngtcp2_crypto_ctx crypto_ctx;
+  ngtcp2_conn *conn;
+  ngtcp2_scid *scid;
+  ngtcp2_ksl_it it;
+  int rv;
+
+  assert(max_pktlen <= SIM_MAX_PKTLEN);
+
+  memset(ep, 0, sizeof(*ep));
+  ep->ts = ts;
+  ep->fin_ts = UINT64_MAX;
+
+  dcid_init(&client_cid);
+  scid_init(&server_cid);
+
+  memset(&cb, 0, sizeof(cb));
+  cb.client_initial = client_initial;
+  cb.recv_client_initial = recv_client_initial;
+  cb.recv_crypto_data = recv_crypto_data;
+  cb.recv_retry = recv_retry;
+  cb.recv_stream_data = recv_stream_data;
+  cb.encrypt = null_encrypt;
+  cb.decrypt = null_decrypt;
+  cb.hp_mask = null_hp_mask;
+  cb.rand = genrand;
+  cb.get_new_connection_id = get_new_connection_id;
+  cb.update_key = update_key;
+  cb.delete_crypto_aead_ctx = delete_crypto_aead_ctx;
+  cb.delete_crypto_cipher_ctx = delete_crypto_cipher_ctx;
+  cb.get_path_challenge_data = get_path_challenge_data;
+
+  ngtcp2_settings_default(&settings);
+  settings.initial_ts = 0;
+  settings.cc_algo = cc_algo;
+  settings.max_tx_udp_payload_size =
+    ngtcp2_max_size(max_pktlen, NGTCP2_MAX_UDP_PAYLOAD_SIZE);
+  settings.no_pmtud = max_pktlen <= NGTCP2_MAX_UDP_PAYLOAD_SIZE;
+
+  sim_transport_params(&params, server);
+
+  if (server) {
+    params.original_dcid = server_cid;
+    rv = ngtcp2_conn_server_new(&ep->conn, &client_cid, &server_cid, path,
+                                NGTCP2_PROTO_VER_V1, &cb, &settings, &params,
+                                NULL, ep);
+  } else {
+    rv = ngtcp2_conn_client_new(&ep->conn, &server_cid, &client_cid, path,
+                                NGTCP2_PROTO_VER_V1, &cb, &settings, &params,
+                                NULL, ep);
+  }
+  if (rv != 0) {
+    return rv;
+  }
+
+  conn = ep->conn;
+
+  memset(&crypto_ctx, 0, sizeof(crypto_ctx));
+  crypto_ctx.aead.max_overhead = NGTCP2_FAKE_AEAD_OVERHEAD;
+  crypto_ctx.max_encryption = UINT64_MAX;
+  crypto_ctx.max_decryption_failure = UINT64_MAX;
+
+  ngtcp2_conn_set_initial_crypto_ctx(conn, &crypto_ctx);
+
+  /* Initial and Handshake keys are installed only to be discarded
+     right after. */
+  rv = ngtcp2_conn_install_initial_key(conn, &aead_ctx, null_iv, &hp_ctx,
+                                       &aead_ctx, null_iv, &hp_ctx,
+                                       sizeof(null_iv));
+  if (rv != 0) {
+    return rv;
+  }
+
+  ngtcp2_conn_set_crypto_ctx(conn, &crypto_ctx);
+
+  rv = ngtcp2_conn_install_rx_handshake_key(conn, &aead_ctx, null_iv,
+                                            sizeof(null_iv), &hp_ctx);
+  if (rv != 0) {
+    return rv;
+  }
+
+  rv = ngtcp2_conn_install_tx_handshake_key(conn, &aead_ctx, null_iv,
+                                            sizeof(null_iv), &hp_ctx);
+  if (rv != 0) {
+    return rv;
+  }
+
+  rv = ngtcp2_conn_install_rx_key(conn, null_secret, sizeof(null_secret),
+                                  &aead_ctx, null_iv, sizeof(null_iv), &hp_ctx);
+  if (rv != 0) {
+    return rv;
+  }
+
+  rv = ngtcp2_conn_install_tx_key(conn, null_secret, sizeof(null_secret),
+                                  &aead_ctx, null_iv, sizeof(null_iv), &hp_ctx);
+  if (rv != 0) {
+    return rv;
+  }
+
+  ngtcp2_conn_discard_initial_state(conn, 0);
+  ngtcp2_conn_discard_handshake_state(conn, 0);
+
+  conn->state = NGTCP2_CS_POST_HANDSHAKE;
+  conn->flags |= NGTCP2_CONN_FLAG_INITIAL_PKT_PROCESSED |
+                 NGTCP2_CONN_FLAG_TLS_HANDSHAKE_COMPLETED |
+                 NGTCP2_CONN_FLAG_HANDSHAKE_COMPLETED |
+                 NGTCP2_CONN_FLAG_HANDSHAKE_CONFIRMED;
+  conn->dcid.current.flags |= NGTCP2_DCID_FLAG_PATH_VALIDATED;
+
+  it = ngtcp2_ksl_begin(&conn->scid.set);
+  scid = ngtcp2_ksl_it_get(&it);
+  scid->flags |= NGTCP2_SCID_FLAG_USED;
+
+  rv = ngtcp2_pq_push(&conn->scid.used, &scid->pe);
+  if (rv != 0) {
+    return rv;
+  }
+
+  sim_transport_params(&remote_params, !server);
+
+  rv = ngtcp2_transport_params_copy_new(&conn->remote.transport_params,
+                                        &remote_params, conn->mem);
+  if (rv != 0) {
+    return rv;
+  }
+
+  conn->local.bidi.max_streams = remote_params.initial_max_streams_bidi;
+  conn->local.uni.max_streams = remote_params.initial_max_streams_uni;
+  conn->tx.max_offset = remote_params.initial_max_data;
+  conn->negotiated_version = conn->client_chosen_version;
+  conn->pktns.rtb.persistent_congestion_start_ts = 0;
+
+  if (!settings.no_pmtud) {
+    /* PMTUD is started on handshake completion, which is skipped
+       here. */
+    return ngtcp2_conn_start_pmtud(conn);
+  }
+
+  return 0;
+}
+
+void sim_endpoint_free(sim_endpoint *ep) { ngtcp2_conn_del(ep->conn); }
+
+int sim_sender_init(sim_sender *s, sim_endpoint *ep, uint64_t total) {
+  memset(s, 0, sizeof(*s));
+  s->total = total;
+
+  return ngtcp2_conn_open_bidi_stream(ep->conn, &s->stream_id, NULL);
+}
+
+int sim_trace_open(sim_trace *t, const char *path, int server,
+                   ngtcp2_cc_algo cc_algo, uint64_t total) {
+  uint8_t buf[64];
+  uint8_t *p = buf;
+
+  t->fp = fopen(path, "wb");
+  if (!t->fp) {
+    fprintf(stderr, "%s: could not open\n", path);
+    return -1;
+  }
+
+  p = ngtcp2_cpymem(p, SIM_TRACE_MAGIC, sizeof(SIM_TRACE_MAGIC) - 1);
+  p = ngtcp2_put_uvarint(p, SIM_TRACE_VERSION);
+  p = ngtcp2_put_uvarint(p, server != 0);
+  p = ngtcp2_put_uvarint(p, (uint64_t)cc_algo);
+  p = ngtcp2_put_uvarint(p, total);
+
+  if (fwrite(buf, 1, (size_t)(p - buf), t->fp) != (size_t)(p - buf)) {
+    fprintf(stderr, "%s: could not write\n", path);
+    sim_trace_close(t);
+    return -1;
+  }
+
+  return 0;
+}
+
+void sim_trace_close(sim_trace *t) {
+  if (t->fp) {
+    fclose(t->fp);
+    t->fp = NULL;
+  }
+}
+
+/*
+ * sim_trace_record writes a record of |type| at |ts|.  |n| is the
+ * number of bytes written or read, and |data| is the packet read.
+ * They are ignored for SIM_TRACE_EXPIRY.
+ */
+static void sim_trace_record(sim_trace *t, sim_trace_type type,
+                             ngtcp2_tstamp ts, uint64_t n,
+                             const uint8_t *data) {
+  uint8_t buf[32];
+  uint8_t *p = buf;
+
+  p = ngtcp2_put_uvarint(p, type);
+  p = ngtcp2_put_uvarint(p, ts);
+
+  if (type != SIM_TRACE_EXPIRY) {
+    p = ngtcp2_put_uvarint(p, n);
+  }
+
+  fwrite(buf, 1, (size_t)(p - buf), t->fp);
+
+  if (type == SIM_TRACE_READ_PKT) {
+    fwrite(data, 1, (size_t)n, t->fp);
+  }
+}
+
+ngtcp2_ssize sim_endpoint_write(sim_endpoint *ep, sim_sender *s, sim_link *l,
+                                size_t flow, ngtcp2_tstamp ts) {
+  ngtcp2_path_storage ps;
+  ngtcp2_pkt_info pi;
+  uint8_t buf[SIM_MAX_PKTLEN];
+  ngtcp2_vec datav;
+  ngtcp2_ssize nwrite, ndatalen;
+  int64_t stream_id;
+  uint32_t flags;
+  size_t datavcnt;
+  uint64_t nbytes = 0;
+  int blocked = 0;
+
+  ngtcp2_path_storage_zero(&ps);
+
+  for (;;) {
+    stream_id = -1;
+    flags = NGTCP2_WRITE_STREAM_FLAG_NONE;
+    datavcnt = 0;
+
+    if (s && !s->fin_sent && !blocked) {
+      stream_id = s->stream_id;
+      datav.base = null_data;
+      datav.len = (size_t)ngtcp2_min_uint64(sizeof(null_data),
+                                            s->total - s->offset);
+      datavcnt = 1;
+
+      if (s->offset + datav.len == s->total) {
+        flags |= NGTCP2_WRITE_STREAM_FLAG_FIN;
+      }
+    }
+
+    nwrite = ngtcp2_conn_writev_stream(ep->conn, &ps.path, &pi, buf,
+                                       sizeof(buf), &ndatalen, flags,
+                                       stream_id, &datav, datavcnt, ts);
+    if (nwrite < 0) {
+      if (nwrite == NGTCP2_ERR_STREAM_DATA_BLOCKED) {
+        blocked = 1;
+        continue;
+      }
+
+      fprintf(stderr, "ngtcp2_conn_writev_stream: %s\n",
+              ngtcp2_strerror((int)nwrite));
+
+      return -1;
+    }
+
+    if (nwrite == 0) {
+      break;
+    }
+
+    if (datavcnt && ndatalen >= 0) {
+      s->offset += (uint64_t)ndatalen;
+
+      if ((flags & NGTCP2_WRITE_STREAM_FLAG_FIN) && s->offset == s->total) {
+        s->fin_sent = 1;
+      }
+    }
+
+    nbytes += (uint64_t)nwrite;
+
+    if (l) {
+      sim_link_send(l, flow, buf, (size_t)nwrite, ts);
+    }
+  }
+
+  ngtcp2_conn_update_pkt_tx_time(ep->conn, ts);
+
+  if (ep->trace) {
+    sim_trace_record(ep->trace, SIM_TRACE_WRITE, ts, nbytes, NULL);
+  }
+
+  return (ngtcp2_ssize)nbytes;
+}
+
+int sim_endpoint_read(sim_endpoint *ep, const ngtcp2_path *path,
+                      const uint8_t *data, size_t len, ngtcp2_tstamp ts) {
+  ngtcp2_pkt_info pi = {0};
+  int rv;
+
+  if (ep->trace) {
+    sim_trace_record(ep->trace, SIM_TRACE_READ_PKT, ts, len, data);
+  }
+
+  rv = ngtcp2_conn_read_pkt(ep->conn, path, &pi, data, len, ts);
+  if (rv != 0) {
+    fprintf(stderr, "ngtcp2_conn_read_pkt: %s\n", ngtcp2_strerror(rv));
+
+    return -1;
+  }
+
+  return 0;
+}
+
+int sim_endpoint_handle_expiry(sim_endpoint *ep, ngtcp2_tstamp ts) {
+  int rv;
+
+  if (ngtcp2_conn_get_expiry(ep->conn) > ts) {
+    return 0;
+  }
+
+  if (ep->trace) {
+    sim_trace_record(ep->trace, SIM_TRACE_EXPIRY, ts, 0, NULL);
+  }
+
+  rv = ngtcp2_conn_handle_expiry(ep->conn, ts);
+  if (rv != 0) {
+    fprintf(stderr, "ngtcp2_conn_handle_expiry: %s\n", ngtcp2_strerror(rv));
+
+    return -1;
+  }
+
+  return 0;
+}
+
+const char *sim_cc_algo_name(ngtcp2_cc_algo cc_algo) {
+  switch (cc_algo) {
+  case NGTCP2_CC_ALGO_RENO:
+    return "reno";
+  case NGTCP2_CC_ALGO_CUBIC:
+    return "cubic";
+  case NGTCP2_CC_ALGO_BBR:
+    return "bbr";
+  default:
+    return "unknown";
+  }
+}
+
+int sim_cc_algo_from_name(ngtcp2_cc_algo *pcc_algo, const char *name) {
+  if (strcmp(name, "reno") == 0) {
+    *pcc_algo = NGTCP2_CC_ALGO_RENO;
+  } else if (strcmp(name, "cubic") == 0) {
+    *pcc_algo = NGTCP2_CC_ALGO_CUBIC;
+  } else if (strcmp(name, "bbr") == 0) {
+    *pcc_algo = NGTCP2_CC_ALGO_BBR;
+  } else {
+    return -1;
+  }
+
+  return 0;
+}
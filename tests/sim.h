@@ -0,0 +1,340 @@
+/*
+ * ngtcp2
+ *
+ * Copyright (c) 2024 ngtcp2 contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stdio.h>
+
+#include <ngtcp2/ngtcp2.h>
+
+#include "ngtcp2_pq.h"
+
+/*
+ * sim provides the building blocks of the programs which run client
+ * and server connections against each other on a virtual clock: an
+ * emulated link, and connections which start in post-handshake state
+ * with null crypto.  Everything is deterministic, so that the same
+ * inputs always produce the same packets.
+ */
+
+/* SIM_PKT_OVERHEAD is the size of IPv6 and UDP headers, which is
+   added to the UDP payload to get the size of an IP packet. */
+#define SIM_PKT_OVERHEAD 48
+/* SIM_DEFAULT_MTU is the MTU of a link unless configured
+   otherwise. */
+#define SIM_DEFAULT_MTU 1500
+/* SIM_MAX_MTU is the largest MTU that a link supports, which is the
+   typical size of jumbo frames. */
+#define SIM_MAX_MTU 9000
+/* SIM_MAX_PKTLEN is the maximum UDP payload size. */
+#define SIM_MAX_PKTLEN (SIM_MAX_MTU - SIM_PKT_OVERHEAD)
+
+/* SIM_LINK_CAPACITY is the maximum number of packets in flight on a
+   link, including the ones in the bottleneck queue.  Packets beyond
+   this limit are dropped. */
+#define SIM_LINK_CAPACITY 16384
+
+typedef struct sim_link_config {
+  /* bandwidth is the bottleneck bandwidth in bits per second.  0
+     means that packets are not serialized. */
+  uint64_t bandwidth;
+  /* delay is the one-way propagation delay. */
+  ngtcp2_duration delay;
+  /* jitter is the maximum random delay added to each packet.  Unlike
+     reorder, jitter never changes the order of packets. */
+  ngtcp2_duration jitter;
+  /* aggregation, if nonzero, holds packets back and delivers them in
+     a burst at the next multiple of aggregation. */
+  ngtcp2_duration aggregation;
+  /* loss is the probability that a packet is dropped, in parts per
+     million. */
+  uint32_t loss;
+  /* reorder is the probability that a packet is delayed by half of
+     delay, in parts per million. */
+  uint32_t reorder;
+  /* queue is the size of the bottleneck queue in bytes.  0 means
+     unlimited. */
+  size_t queue;
+  /* policer_rate, if nonzero, is the rate of a token bucket policer
+     in bits per second.  A packet which does not fit in the bucket is
+     dropped. */
+  uint64_t policer_rate;
+  /* policer_burst is the size of the token bucket in bytes. */
+  size_t policer_burst;
+  /* mtu is the maximum size of an IP packet that the link carries,
+     including SIM_PKT_OVERHEAD.  A larger packet is dropped.  0 means
+     SIM_DEFAULT_MTU.  It must not exceed SIM_MAX_MTU, and must not be
+     changed after sim_link_init. */
+  size_t mtu;
+} sim_link_config;
+
+typedef struct sim_pkt {
+  ngtcp2_pq_entry pe;
+  /* arrival is the virtual time when this packet is delivered to
+     the receiver. */
+  ngtcp2_tstamp arrival;
+  /* seq breaks ties between packets that arrive at the same time so
+     that they are delivered in the order they were sent. */
+  uint64_t seq;
+  /* flow identifies the receiver of this packet. */
+  size_t flow;
+  size_t len;
+  /* data points to the buffer of the largest packet that the link
+     carries. */
+  uint8_t *data;
+} sim_pkt;
+
+typedef struct sim_link {
+  /* config is the link configuration.  It is owned by the caller,
+     and may be changed between calls. */
+  const sim_link_config *config;
+  /* pq orders the packets in flight by arrival. */
+  ngtcp2_pq pq;
+  sim_pkt *pkts;
+  /* buf is the storage of packet data of pkts. */
+  uint8_t *buf;
+  /* max_pktlen is the maximum UDP payload size that the link
+     carries. */
+  size_t max_pktlen;
+  /* freelist is the stack of unused indices into pkts. */
+  size_t *freelist;
+  size_t freelen;
+  /* busy_until is the virtual time when the bottleneck finishes
+     serializing the last queued packet. */
+  ngtcp2_tstamp busy_until;
+  /* last_arrival is the arrival time of the last packet which was
+     not reordered. */
+  ngtcp2_tstamp last_arrival;
+  /* policer_tokens is the number of bytes in the token bucket as of
+     policer_ts. */
+  uint64_t policer_tokens;
+  ngtcp2_tstamp policer_ts;
+  uint64_t seq;
+  uint64_t rand_state;
+  /* drops is the number of packets dropped by the link. */
+  uint64_t drops;
+} sim_link;
+
+/*
+ * sim_rand returns a pseudo random number.  The sequence is fixed by
+ * the initial value of |*state|, which must not be 0.
+ */
+uint64_t sim_rand(uint64_t *state);
+
+/*
+ * sim_link_init initializes |l|.  |seed| determines the sequence of
+ * random events on the link.
+ *
+ * This function returns 0 if it succeeds, or -1 if it runs out of
+ * memory.
+ */
+int sim_link_init(sim_link *l, const sim_link_config *config, uint64_t seed);
+
+/*
+ * sim_link_free frees resources allocated for |l|.
+ */
+void sim_link_free(sim_link *l);
+
+/*
+ * sim_link_send enqueues a packet of length |len| which is sent at
+ * |ts| to the receiver identified by |flow|.
+ */
+void sim_link_send(sim_link *l, size_t flow, const uint8_t *data, size_t len,
+                   ngtcp2_tstamp ts);
+
+/*
+ * sim_link_next_arrival returns the arrival time of the next packet,
+ * or UINT64_MAX if there is no packet in flight.
+ */
+ngtcp2_tstamp sim_link_next_arrival(sim_link *l);
+
+/*
+ * sim_link_top returns the next packet to arrive.  The link must not
+ * be empty.
+ */
+sim_pkt *sim_link_top(sim_link *l);
+
+/*
+ * sim_link_pop removes the next packet to arrive.
+ */
+void sim_link_pop(sim_link *l);
+
+/*
+ * sim_trace records the inputs of an endpoint, so that replay can
+ * feed them to a fresh endpoint later.  Because the endpoints are
+ * deterministic, the replayed connection goes through exactly the
+ * same states as the recorded one.
+ *
+ * A trace file starts with the 8 bytes magic "NGTCP2TR", followed by
+ * the fields below, each encoded as QUIC variable-length integer:
+ *
+ *   version (1), server, cc_algo, total
+ *
+ * total is the number of bytes sent by the client, and 0 for the
+ * server.  A sequence of records follows.  Each record starts with
+ * type and ts as variable-length integers, followed by the type
+ * specific fields:
+ *
+ *   SIM_TRACE_READ_PKT: datalen, and datalen bytes of the packet.
+ *   SIM_TRACE_WRITE: the number of bytes written.
+ *   SIM_TRACE_EXPIRY: none.
+ */
+
+/* SIM_TRACE_MAGIC is the magic of a trace file. */
+#define SIM_TRACE_MAGIC "NGTCP2TR"
+
+/* SIM_TRACE_VERSION is the version of trace file format.  Version 2
+   carries the nonce in the AEAD tag of each packet. */
+#define SIM_TRACE_VERSION 2
+
+typedef enum sim_trace_type {
+  /* SIM_TRACE_READ_PKT records a call of sim_endpoint_read. */
+  SIM_TRACE_READ_PKT = 1,
+  /* SIM_TRACE_WRITE records a call of sim_endpoint_write. */
+  SIM_TRACE_WRITE = 2,
+  /* SIM_TRACE_EXPIRY records a call of ngtcp2_conn_handle_expiry. */
+  SIM_TRACE_EXPIRY = 3,
+} sim_trace_type;
+
+typedef struct sim_trace {
+  FILE *fp;
+} sim_trace;
+
+/*
+ * sim_trace_open creates a trace file at |path| for an endpoint.
+ * |server| is nonzero if the endpoint is a server.  |total| is the
+ * number of bytes the client sends.
+ *
+ * This function returns 0 if it succeeds, or -1.
+ */
+int sim_trace_open(sim_trace *t, const char *path, int server,
+                   ngtcp2_cc_algo cc_algo, uint64_t total);
+
+/*
+ * sim_trace_close closes the trace file.
+ */
+void sim_trace_close(sim_trace *t);
+
+typedef struct sim_endpoint {
+  ngtcp2_conn *conn;
+  /* trace, if not NULL, records the inputs of this endpoint. */
+  sim_trace *trace;
+  /* ts points to the current virtual time. */
+  const ngtcp2_tstamp *ts;
+  /* received is the number of stream bytes received. */
+  uint64_t received;
+  /* fin_ts is the virtual time when the final stream data was
+     received, or UINT64_MAX if it has not been received yet. */
+  ngtcp2_tstamp fin_ts;
+} sim_endpoint;
+
+/*
+ * sim_endpoint_init creates a connection which is in post-handshake
+ * state.  This is the same shortcut that the connection unit tests
+ * take.  The server extends flow control windows as it receives
+ * stream data.
+ *
+ * |max_pktlen| is the maximum UDP payload size that the connection
+ * sends, and it must not exceed SIM_MAX_PKTLEN.  If it is larger than
+ * NGTCP2_MAX_UDP_PAYLOAD_SIZE, PMTUD is started to find the largest
+ * size that the link carries.  Otherwise, the connection sends
+ * packets of NGTCP2_MAX_UDP_PAYLOAD_SIZE bytes without PMTUD.
+ *
+ * This function returns 0 if it succeeds, or one of ngtcp2 library
+ * error codes.
+ */
+int sim_endpoint_init(sim_endpoint *ep, int server, ngtcp2_cc_algo cc_algo,
+                      size_t max_pktlen, const ngtcp2_path *path,
+                      const ngtcp2_tstamp *ts);
+
+/*
+ * sim_endpoint_free frees resources allocated for |ep|.
+ */
+void sim_endpoint_free(sim_endpoint *ep);
+
+typedef struct sim_sender {
+  int64_t stream_id;
+  /* offset is the number of stream bytes accepted by the
+     connection. */
+  uint64_t offset;
+  /* total is the number of bytes to send. */
+  uint64_t total;
+  int fin_sent;
+} sim_sender;
+
+/*
+ * sim_sender_init opens a bidirectional stream on |ep| which sends
+ * |total| bytes.
+ *
+ * This function returns 0 if it succeeds, or one of ngtcp2 library
+ * error codes.
+ */
+int sim_sender_init(sim_sender *s, sim_endpoint *ep, uint64_t total);
+
+/*
+ * sim_endpoint_write writes packets to |l| until the connection has
+ * nothing to send, or it is limited by congestion control or pacing.
+ * If |s| is not NULL, it sends stream data described by |s|.  If |l|
+ * is NULL, packets are discarded.
+ *
+ * This function returns the number of bytes written if it succeeds,
+ * or -1.
+ */
+ngtcp2_ssize sim_endpoint_write(sim_endpoint *ep, sim_sender *s, sim_link *l,
+                                size_t flow, ngtcp2_tstamp ts);
+
+/*
+ * sim_endpoint_read feeds a packet of length |len| to |ep|.
+ *
+ * This function returns 0 if it succeeds, or -1.
+ */
+int sim_endpoint_read(sim_endpoint *ep, const ngtcp2_path *path,
+                      const uint8_t *data, size_t len, ngtcp2_tstamp ts);
+
+/*
+ * sim_endpoint_handle_expiry handles the timer of |ep| if it has
+ * expired by |ts|.
+ *
+ * This function returns 0 if it succeeds, or -1.
+ */
+int sim_endpoint_handle_expiry(sim_endpoint *ep, ngtcp2_tstamp ts);
+
+/*
+ * sim_cc_algo_name returns the name of |cc_algo|.
+ */
+const char *sim_cc_algo_name(ngtcp2_cc_algo cc_algo);
+
+/*
+ * sim_cc_algo_from_name stores the congestion controller named
+ * |name| in |*pcc_algo|.  It returns 0 if it succeeds, or -1 if
+ * |name| is unknown.
+ */
+int sim_cc_algo_from_name(ngtcp2_cc_algo *pcc_algo, const char *name);
+
+#endif /* SIM_H */